@@ -0,0 +1,302 @@
+#include "AssetWatcher.h"
+#include "Mesh.h"
+#include <fstream>
+
+// How long a file must go without changing before we reload it (ms)
+#define ASSET_SETTLE_TIME	250
+
+// --------------------------------------------------------
+// Constructor
+// --------------------------------------------------------
+AssetWatcher::AssetWatcher()
+{
+	stopEvent = 0;
+	meshFormat = VERTEX_STREAM_FULL;
+	occlusionRays = 0;
+	bakeThreads = 0;
+}
+
+// --------------------------------------------------------
+// Destructor
+// --------------------------------------------------------
+AssetWatcher::~AssetWatcher()
+{
+	Stop();
+	delete bakeThreads;
+}
+
+// --------------------------------------------------------
+// Registers a file to reload.  Paths use forward slashes and
+// are relative to the working directory, like everything else
+// the game loads (e.g. "Assets/Models/cube.obj").
+// --------------------------------------------------------
+void AssetWatcher::WatchFile(const std::wstring& path, AssetType type)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	files[path] = type;
+}
+
+// --------------------------------------------------------
+// Meshes are reloaded for a pool of this format, and get
+// this many occlusion rays per vertex (0 skips the bake)
+// --------------------------------------------------------
+void AssetWatcher::SetMeshSettings(VertexStreamFormat format, unsigned int occlusionRaysPerVertex)
+{
+	meshFormat = format;
+	occlusionRays = occlusionRaysPerVertex;
+}
+
+// --------------------------------------------------------
+// Opens each directory and starts the watcher thread
+//
+// Returns true if at least one directory is being watched
+// --------------------------------------------------------
+bool AssetWatcher::Start(const std::vector<std::wstring>& directoryPaths)
+{
+	if (watchThread.joinable())
+		return true;
+
+	for (unsigned int i = 0; i < directoryPaths.size(); i++)
+	{
+		HANDLE handle = CreateFileW(
+			directoryPaths[i].c_str(),
+			FILE_LIST_DIRECTORY,
+			FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+			0,
+			OPEN_EXISTING,
+			FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+			0);
+
+		// Not every directory exists in every setup (Debug/, for instance)
+		if (handle == INVALID_HANDLE_VALUE)
+			continue;
+
+		WatchedDirectory* dir = new WatchedDirectory();
+		dir->Path = directoryPaths[i];
+		dir->Handle = handle;
+		ZeroMemory(&dir->Overlapped, sizeof(OVERLAPPED));
+		dir->Overlapped.hEvent = CreateEventW(0, TRUE, FALSE, 0);
+
+		if (!IssueRead(dir))
+		{
+			CloseHandle(dir->Overlapped.hEvent);
+			CloseHandle(dir->Handle);
+			delete dir;
+			continue;
+		}
+
+		directories.push_back(dir);
+	}
+
+	if (directories.empty())
+		return false;
+
+	if (occlusionRays > 0 && !bakeThreads)
+		bakeThreads = new ThreadPool();
+
+	stopEvent = CreateEventW(0, TRUE, FALSE, 0);
+	watchThread = std::thread(&AssetWatcher::WatchLoop, this);
+	return true;
+}
+
+// --------------------------------------------------------
+// Stops the thread and closes every directory
+// --------------------------------------------------------
+void AssetWatcher::Stop()
+{
+	if (watchThread.joinable())
+	{
+		SetEvent(stopEvent);
+		watchThread.join();
+	}
+
+	for (unsigned int i = 0; i < directories.size(); i++)
+	{
+		// Cancel the outstanding read and wait for it to finish
+		// before the buffer it writes to goes away
+		DWORD bytes;
+		CancelIoEx(directories[i]->Handle, &directories[i]->Overlapped);
+		GetOverlappedResult(directories[i]->Handle, &directories[i]->Overlapped, &bytes, TRUE);
+
+		CloseHandle(directories[i]->Overlapped.hEvent);
+		CloseHandle(directories[i]->Handle);
+		delete directories[i];
+	}
+	directories.clear();
+
+	if (stopEvent)
+	{
+		CloseHandle(stopEvent);
+		stopEvent = 0;
+	}
+}
+
+// --------------------------------------------------------
+// Moves every finished reload over to the caller
+// --------------------------------------------------------
+void AssetWatcher::TakeReloads(std::vector<AssetReload>& reloads)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	reloads.swap(ready);
+	ready.clear();
+}
+
+// --------------------------------------------------------
+// Starts an asynchronous wait for changes in a directory
+// --------------------------------------------------------
+bool AssetWatcher::IssueRead(WatchedDirectory* dir)
+{
+	ResetEvent(dir->Overlapped.hEvent);
+	return ReadDirectoryChangesW(
+		dir->Handle,
+		dir->Buffer,
+		sizeof(dir->Buffer),
+		FALSE,	// Only this directory, not subdirectories
+		FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE,
+		0,
+		&dir->Overlapped,
+		0) != 0;
+}
+
+// --------------------------------------------------------
+// Walks a batch of change notifications, noting the time
+// of each change to a file we care about
+// --------------------------------------------------------
+void AssetWatcher::ReadNotifications(WatchedDirectory* dir, DWORD bytes)
+{
+	if (bytes == 0)
+		return; // Buffer overflowed - nothing we can do but wait for the next save
+
+	DWORD now = GetTickCount();
+	unsigned char* cursor = (unsigned char*)dir->Buffer;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	while (true)
+	{
+		FILE_NOTIFY_INFORMATION* info = (FILE_NOTIFY_INFORMATION*)cursor;
+		std::wstring name(info->FileName, info->FileNameLength / sizeof(WCHAR));
+
+		// Build the path the same way it was registered
+		std::wstring path = dir->Path == L"." ? name : dir->Path + L"/" + name;
+		if (files.count(path))
+			pending[path] = now;
+
+		if (info->NextEntryOffset == 0)
+			break;
+		cursor += info->NextEntryOffset;
+	}
+}
+
+// --------------------------------------------------------
+// The watcher thread.  Waits on every directory at once,
+// and wakes up regularly to load files that have settled.
+// --------------------------------------------------------
+void AssetWatcher::WatchLoop()
+{
+	std::vector<HANDLE> events;
+	events.push_back(stopEvent);
+	for (unsigned int i = 0; i < directories.size(); i++)
+		events.push_back(directories[i]->Overlapped.hEvent);
+
+	while (true)
+	{
+		DWORD result = WaitForMultipleObjects((DWORD)events.size(), &events[0], FALSE, 50);
+		if (result == WAIT_OBJECT_0)
+			break;
+
+		// A directory has changes waiting
+		if (result > WAIT_OBJECT_0 && result < WAIT_OBJECT_0 + events.size())
+		{
+			WatchedDirectory* dir = directories[result - WAIT_OBJECT_0 - 1];
+
+			DWORD bytes = 0;
+			if (GetOverlappedResult(dir->Handle, &dir->Overlapped, &bytes, FALSE))
+				ReadNotifications(dir, bytes);
+
+			IssueRead(dir);
+		}
+
+		// Load anything that's stopped changing
+		DWORD now = GetTickCount();
+		for (auto it = pending.begin(); it != pending.end();)
+		{
+			if (now - it->second < ASSET_SETTLE_TIME)
+			{
+				++it;
+				continue;
+			}
+
+			AssetType type;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				type = files[it->first];
+			}
+
+			LoadAsset(it->first, type);
+			it = pending.erase(it);
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Does as much of the reload as possible off the main
+// thread, then queues the result for TakeReloads()
+// --------------------------------------------------------
+void AssetWatcher::LoadAsset(const std::wstring& path, AssetType type)
+{
+	AssetReload reload;
+	reload.Type = type;
+	reload.Path = path;
+
+	switch (type)
+	{
+	case ASSET_MESH:
+	{
+		// Mesh looks in Assets/Models itself, so it only wants the file name
+		std::wstring wideName = path.substr(path.find_last_of(L'/') + 1);
+		std::string name(wideName.begin(), wideName.end());
+
+		std::vector<Vertex> verts;
+		std::vector<int> indices;
+		if (!Mesh::LoadOBJ(&name[0], verts, indices))
+			return;
+
+		// Everything but the upload, including the bake
+		if (!Mesh::Prepare(&verts[0], verts.size(), &indices[0], indices.size(), meshFormat, &reload.Geometry))
+			return;
+		if (occlusionRays > 0)
+		{
+			std::string cachePath = std::string(path.begin(), path.end()) + OCCLUSION_CACHE_EXTENSION;
+			Mesh::Bake(&reload.Geometry, bakeThreads, occlusionRays, cachePath.c_str());
+		}
+		break;
+	}
+
+	case ASSET_TEXTURE:
+	{
+		// Decoding and mip generation need the immediate context,
+		// so just get the file into memory here
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (!file.is_open())
+			return;
+
+		std::streamsize size = file.tellg();
+		if (size <= 0)
+			return;
+
+		reload.FileData.resize((size_t)size);
+		file.seekg(0, std::ios::beg);
+		if (!file.read((char*)&reload.FileData[0], size))
+			return;
+		break;
+	}
+
+	case ASSET_SHADER:
+		// Shaders are small, and reloading one rebuilds its
+		// buffers and tables, so the game does it all
+		break;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	ready.push_back(std::move(reload));
+}
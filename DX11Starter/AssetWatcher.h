@@ -0,0 +1,98 @@
+#pragma once
+
+#include <Windows.h>
+#include <d3d11.h>
+#include "Vertex.h"
+#include "Mesh.h"
+#include "ThreadPool.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+
+enum AssetType
+{
+	ASSET_MESH,
+	ASSET_TEXTURE,
+	ASSET_SHADER
+};
+
+// --------------------------------------------------------
+// A changed asset, prepared on the watcher thread and
+// waiting to be swapped in at the next frame boundary
+// --------------------------------------------------------
+struct AssetReload
+{
+	AssetType Type;
+	std::wstring Path;						// Exactly as passed to WatchFile()
+
+	MeshData Geometry;						// ASSET_MESH - prepared and baked
+	std::vector<unsigned char> FileData;	// ASSET_TEXTURE - the new image file
+};
+
+// --------------------------------------------------------
+// Watches asset directories for changes on a background
+// thread, using ReadDirectoryChangesW.
+//
+// Only files registered with WatchFile() are reloaded, and
+// only after they've been quiet for a moment (editors tend
+// to save in several writes).  Models are parsed, built and
+// baked, and image files read, on the watcher thread, so
+// only the GPU upload is left for the main thread.
+//
+// The game calls TakeReloads() once per frame and swaps
+// the results in itself, so nothing changes mid-frame.
+// --------------------------------------------------------
+class AssetWatcher
+{
+public:
+	AssetWatcher();
+	~AssetWatcher();
+
+	// Registers a file to reload when it changes (safe to call any time)
+	void WatchFile(const std::wstring& path, AssetType type);
+
+	// How reloaded meshes are prepared - call before Start()
+	void SetMeshSettings(VertexStreamFormat format, unsigned int occlusionRaysPerVertex);
+
+	// Starts watching these directories (missing ones are skipped)
+	bool Start(const std::vector<std::wstring>& directories);
+	void Stop();
+
+	// Hands over every reload that's ready - call at a frame boundary
+	void TakeReloads(std::vector<AssetReload>& reloads);
+
+private:
+	// One watched directory and its pending change notification
+	struct WatchedDirectory
+	{
+		std::wstring Path;
+		HANDLE Handle;
+		OVERLAPPED Overlapped;
+		DWORD Buffer[2048];		// Notifications must be DWORD aligned
+	};
+
+	std::vector<WatchedDirectory*> directories;
+	std::thread watchThread;
+	HANDLE stopEvent;
+
+	// Shared between the watcher thread and the game
+	std::mutex mutex;
+	std::unordered_map<std::wstring, AssetType> files;
+	std::vector<AssetReload> ready;
+
+	// Watcher thread only - changed files and when they last changed
+	std::unordered_map<std::wstring, DWORD> pending;
+
+	// Watcher thread only - for meshes.  Bakes get their own
+	// threads so they never wait on (or hold up) the game's.
+	VertexStreamFormat meshFormat;
+	unsigned int occlusionRays;
+	ThreadPool* bakeThreads;
+
+	void WatchLoop();
+	bool IssueRead(WatchedDirectory* dir);
+	void ReadNotifications(WatchedDirectory* dir, DWORD bytes);
+	void LoadAsset(const std::wstring& path, AssetType type);
+};
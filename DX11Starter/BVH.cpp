@@ -0,0 +1,457 @@
+#include "BVH.h"
+#include <algorithm>
+#include <cfloat>
+
+using namespace DirectX;
+
+///////////////////////////////////////////////////////////////////////////////
+// ------ BUILDING ------------------------------------------------------------
+///////////////////////////////////////////////////////////////////////////////
+
+static float SurfaceArea(FXMVECTOR min, FXMVECTOR max)
+{
+	XMFLOAT3 d;
+	XMStoreFloat3(&d, XMVectorSubtract(max, min));
+	return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+// --------------------------------------------------------
+// Top down, splitting each node where the surface area
+// heuristic says is cheapest.  Instead of trying every
+// primitive as a split, centroids are dropped into a few
+// bins per axis and only the bin boundaries are tried,
+// which is nearly as good and much faster to build.
+// --------------------------------------------------------
+void BuildBVH(const XMFLOAT3* boxMin, const XMFLOAT3* boxMax, unsigned int count, std::vector<BVHNode>& nodes, std::vector<unsigned int>& order)
+{
+	nodes.clear();
+	order.resize(count);
+	if (count == 0)
+		return;
+
+	std::vector<XMFLOAT3> centroids(count);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		order[i] = i;
+		XMStoreFloat3(&centroids[i], XMVectorScale(XMVectorAdd(XMLoadFloat3(&boxMin[i]), XMLoadFloat3(&boxMax[i])), 0.5f));
+	}
+
+	// A binary tree with single primitive leaves has 2n - 1 nodes
+	nodes.reserve(count * 2);
+	BVHNode root;
+	root.First = 0;
+	root.Count = count;
+	nodes.push_back(root);
+
+	// Nodes waiting to be split (each starts out as a leaf), and
+	// how deep each one is
+	std::vector<unsigned int> pending;
+	std::vector<unsigned int> pendingDepth;
+	pending.push_back(0);
+	pendingDepth.push_back(0);
+	while (!pending.empty())
+	{
+		unsigned int nodeIndex = pending.back();
+		unsigned int depth = pendingDepth.back();
+		pending.pop_back();
+		pendingDepth.pop_back();
+		unsigned int first = nodes[nodeIndex].First;
+		unsigned int n = nodes[nodeIndex].Count;
+
+		// Bounds of the boxes, and of their centroids
+		XMVECTOR nodeMin = XMLoadFloat3(&boxMin[order[first]]);
+		XMVECTOR nodeMax = XMLoadFloat3(&boxMax[order[first]]);
+		XMVECTOR centroidMin = XMLoadFloat3(&centroids[order[first]]);
+		XMVECTOR centroidMax = centroidMin;
+		for (unsigned int i = first + 1; i < first + n; i++)
+		{
+			nodeMin = XMVectorMin(nodeMin, XMLoadFloat3(&boxMin[order[i]]));
+			nodeMax = XMVectorMax(nodeMax, XMLoadFloat3(&boxMax[order[i]]));
+			centroidMin = XMVectorMin(centroidMin, XMLoadFloat3(&centroids[order[i]]));
+			centroidMax = XMVectorMax(centroidMax, XMLoadFloat3(&centroids[order[i]]));
+		}
+		XMStoreFloat3(&nodes[nodeIndex].Min, nodeMin);
+		XMStoreFloat3(&nodes[nodeIndex].Max, nodeMax);
+
+		if (n <= BVH_MAX_LEAF_SIZE)
+			continue;
+
+		XMFLOAT3 cMin, cMax;
+		XMStoreFloat3(&cMin, centroidMin);
+		XMStoreFloat3(&cMax, centroidMax);
+
+		// Too deep for SAH, which can peel off a few primitives at a
+		// time: halve along the widest axis instead
+		unsigned int mid = first + n / 2;
+		if (depth >= BVH_MEDIAN_DEPTH)
+		{
+			XMFLOAT3 extent;
+			XMStoreFloat3(&extent, XMVectorSubtract(XMLoadFloat3(&cMax), XMLoadFloat3(&cMin)));
+			int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+			std::nth_element(&order[first], &order[mid], &order[first] + n, [&](unsigned int a, unsigned int b)
+			{
+				return (&centroids[a].x)[axis] < (&centroids[b].x)[axis];
+			});
+		}
+
+		// Cost of each split is (area * count) of both sides
+		int bestAxis = -1;
+		unsigned int bestSplit = 0;
+		float bestCost = FLT_MAX;
+		for (int axis = 0; axis < 3 && depth < BVH_MEDIAN_DEPTH; axis++)
+		{
+			float axisMin = (&cMin.x)[axis];
+			float extent = (&cMax.x)[axis] - axisMin;
+			if (extent <= 0.0f)
+				continue;
+
+			XMVECTOR binMin[BVH_SAH_BINS];
+			XMVECTOR binMax[BVH_SAH_BINS];
+			unsigned int binCount[BVH_SAH_BINS];
+			for (unsigned int b = 0; b < BVH_SAH_BINS; b++)
+			{
+				binMin[b] = XMVectorReplicate(FLT_MAX);
+				binMax[b] = XMVectorReplicate(-FLT_MAX);
+				binCount[b] = 0;
+			}
+
+			float scale = BVH_SAH_BINS / extent;
+			for (unsigned int i = first; i < first + n; i++)
+			{
+				unsigned int b = (std::min)(BVH_SAH_BINS - 1, (int)(((&centroids[order[i]].x)[axis] - axisMin) * scale));
+				binMin[b] = XMVectorMin(binMin[b], XMLoadFloat3(&boxMin[order[i]]));
+				binMax[b] = XMVectorMax(binMax[b], XMLoadFloat3(&boxMax[order[i]]));
+				binCount[b]++;
+			}
+
+			// Sweep in from each side to get both halves of every split
+			float leftArea[BVH_SAH_BINS - 1], rightArea[BVH_SAH_BINS - 1];
+			unsigned int leftCount[BVH_SAH_BINS - 1], rightCount[BVH_SAH_BINS - 1];
+			XMVECTOR sweepMin = XMVectorReplicate(FLT_MAX);
+			XMVECTOR sweepMax = XMVectorReplicate(-FLT_MAX);
+			unsigned int sweepCount = 0;
+			for (unsigned int b = 0; b < BVH_SAH_BINS - 1; b++)
+			{
+				sweepMin = XMVectorMin(sweepMin, binMin[b]);
+				sweepMax = XMVectorMax(sweepMax, binMax[b]);
+				sweepCount += binCount[b];
+				leftCount[b] = sweepCount;
+				leftArea[b] = sweepCount > 0 ? SurfaceArea(sweepMin, sweepMax) : 0.0f;
+			}
+
+			sweepMin = XMVectorReplicate(FLT_MAX);
+			sweepMax = XMVectorReplicate(-FLT_MAX);
+			sweepCount = 0;
+			for (unsigned int b = BVH_SAH_BINS - 1; b > 0; b--)
+			{
+				sweepMin = XMVectorMin(sweepMin, binMin[b]);
+				sweepMax = XMVectorMax(sweepMax, binMax[b]);
+				sweepCount += binCount[b];
+				rightCount[b - 1] = sweepCount;
+				rightArea[b - 1] = sweepCount > 0 ? SurfaceArea(sweepMin, sweepMax) : 0.0f;
+			}
+
+			for (unsigned int s = 0; s < BVH_SAH_BINS - 1; s++)
+			{
+				if (leftCount[s] == 0 || rightCount[s] == 0)
+					continue;
+
+				float cost = leftArea[s] * leftCount[s] + rightArea[s] * rightCount[s];
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = s;
+				}
+			}
+		}
+
+		// Everything in bins up to the split goes left
+		if (bestAxis >= 0)
+		{
+			float axisMin = (&cMin.x)[bestAxis];
+			float scale = BVH_SAH_BINS / ((&cMax.x)[bestAxis] - axisMin);
+			unsigned int* split = std::partition(&order[first], &order[first] + n, [&](unsigned int i)
+			{
+				unsigned int b = (std::min)(BVH_SAH_BINS - 1, (int)(((&centroids[i].x)[bestAxis] - axisMin) * scale));
+				return b <= bestSplit;
+			});
+			mid = (unsigned int)(split - &order[0]);
+		}
+
+		// Every centroid in the same spot - any split is as good as another
+		if (mid == first || mid == first + n)
+			mid = first + n / 2;
+
+		unsigned int left = nodes.size();
+		BVHNode child;
+		child.First = first;
+		child.Count = mid - first;
+		nodes.push_back(child);
+		child.First = mid;
+		child.Count = first + n - mid;
+		nodes.push_back(child);
+
+		nodes[nodeIndex].First = left;
+		nodes[nodeIndex].Count = 0;
+		pending.push_back(left);
+		pending.push_back(left + 1);
+		pendingDepth.push_back(depth + 1);
+		pendingDepth.push_back(depth + 1);
+	}
+}
+
+// --------------------------------------------------------
+// Builds the tree over triangle bounds, then packs each
+// leaf's (up to four) triangles into one packet
+// --------------------------------------------------------
+bool TriangleBVH::Build(const Vertex* vertices, unsigned int vertexCount, const int* indices, unsigned int indexCount)
+{
+	nodes.clear();
+	packets.clear();
+
+	unsigned int triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+		return false;
+
+	std::vector<XMFLOAT3> boxMin(triangleCount);
+	std::vector<XMFLOAT3> boxMax(triangleCount);
+	for (unsigned int t = 0; t < triangleCount; t++)
+	{
+		for (unsigned int k = 0; k < 3; k++)
+		{
+			if (indices[t * 3 + k] < 0 || (unsigned int)indices[t * 3 + k] >= vertexCount)
+				return false;
+		}
+
+		XMVECTOR p0 = XMLoadFloat3(&vertices[indices[t * 3]].Position);
+		XMVECTOR p1 = XMLoadFloat3(&vertices[indices[t * 3 + 1]].Position);
+		XMVECTOR p2 = XMLoadFloat3(&vertices[indices[t * 3 + 2]].Position);
+		XMStoreFloat3(&boxMin[t], XMVectorMin(XMVectorMin(p0, p1), p2));
+		XMStoreFloat3(&boxMax[t], XMVectorMax(XMVectorMax(p0, p1), p2));
+	}
+
+	std::vector<unsigned int> order;
+	BuildBVH(&boxMin[0], &boxMax[0], triangleCount, nodes, order);
+
+	packets.reserve(triangleCount / 2);
+	for (unsigned int i = 0; i < nodes.size(); i++)
+	{
+		BVHNode& node = nodes[i];
+		if (node.Count == 0)
+			continue;
+
+		TrianglePacket packet = TrianglePacket();
+		for (unsigned int lane = 0; lane < node.Count; lane++)
+		{
+			unsigned int t = order[node.First + lane];
+			XMFLOAT3 v0 = vertices[indices[t * 3]].Position;
+			XMFLOAT3 v1 = vertices[indices[t * 3 + 1]].Position;
+			XMFLOAT3 v2 = vertices[indices[t * 3 + 2]].Position;
+
+			(&packet.V0[0].x)[lane] = v0.x;
+			(&packet.V0[1].x)[lane] = v0.y;
+			(&packet.V0[2].x)[lane] = v0.z;
+			(&packet.Edge1[0].x)[lane] = v1.x - v0.x;
+			(&packet.Edge1[1].x)[lane] = v1.y - v0.y;
+			(&packet.Edge1[2].x)[lane] = v1.z - v0.z;
+			(&packet.Edge2[0].x)[lane] = v2.x - v0.x;
+			(&packet.Edge2[1].x)[lane] = v2.y - v0.y;
+			(&packet.Edge2[2].x)[lane] = v2.z - v0.z;
+			packet.Triangle[lane] = t * 3;
+		}
+
+		// Leaves now point at their packet
+		node.First = packets.size();
+		packets.push_back(packet);
+	}
+
+	return true;
+}
+
+void TriangleBVH::GetBounds(XMFLOAT3* min, XMFLOAT3* max) const
+{
+	if (nodes.empty())
+	{
+		*min = XMFLOAT3(0, 0, 0);
+		*max = XMFLOAT3(0, 0, 0);
+		return;
+	}
+
+	*min = nodes[0].Min;
+	*max = nodes[0].Max;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ------ QUERIES -------------------------------------------------------------
+///////////////////////////////////////////////////////////////////////////////
+
+// --------------------------------------------------------
+// All three slabs at once.  A zero direction component
+// gives an infinite inverse, which the min/max sorts out.
+// --------------------------------------------------------
+float XM_CALLCONV IntersectBVHNode(const BVHNode& node, FXMVECTOR origin, FXMVECTOR invDirection, float maxDistance)
+{
+	XMVECTOR t1 = XMVectorMultiply(XMVectorSubtract(XMLoadFloat3(&node.Min), origin), invDirection);
+	XMVECTOR t2 = XMVectorMultiply(XMVectorSubtract(XMLoadFloat3(&node.Max), origin), invDirection);
+
+	XMFLOAT3 tNear, tFar;
+	XMStoreFloat3(&tNear, XMVectorMin(t1, t2));
+	XMStoreFloat3(&tFar, XMVectorMax(t1, t2));
+
+	float enter = (std::max)((std::max)(tNear.x, tNear.y), (std::max)(tNear.z, 0.0f));
+	float exit = (std::min)((std::min)(tFar.x, tFar.y), (std::min)(tFar.z, maxDistance));
+	return enter <= exit ? enter : -1.0f;
+}
+
+bool TriangleBVH::IntersectClosest(const Ray& ray, RayHit* hit) const
+{
+	return Traverse<false>(ray, hit);
+}
+
+bool TriangleBVH::IntersectAny(const Ray& ray) const
+{
+	return Traverse<true>(ray, 0);
+}
+
+// --------------------------------------------------------
+// Depth first, nearer child first, so the closest hit is
+// usually found early and prunes the rest of the tree.
+//
+// Leaves are tested with Moller-Trumbore, one triangle per
+// SIMD lane.
+// --------------------------------------------------------
+template <bool AnyHit>
+bool TriangleBVH::Traverse(const Ray& ray, RayHit* hit) const
+{
+	if (nodes.empty())
+		return false;
+
+	XMVECTOR origin = XMLoadFloat3(&ray.Origin);
+	XMVECTOR direction = XMLoadFloat3(&ray.Direction);
+	XMVECTOR invDirection = XMVectorReciprocal(direction);
+
+	// The ray again, splatted across all four lanes
+	XMVECTOR ox = XMVectorSplatX(origin), oy = XMVectorSplatY(origin), oz = XMVectorSplatZ(origin);
+	XMVECTOR dx = XMVectorSplatX(direction), dy = XMVectorSplatY(direction), dz = XMVectorSplatZ(direction);
+	const XMVECTOR zero = XMVectorZero();
+	const XMVECTOR one = XMVectorSplatOne();
+
+	float closest = ray.MaxDistance;
+	bool found = false;
+
+	// Nodes to visit, and how far along the ray each one starts.
+	// The tree's depth is bounded, so this can't overflow.
+	unsigned int stack[BVH_MAX_DEPTH];
+	float stackDistance[BVH_MAX_DEPTH];
+	unsigned int stackSize = 0;
+
+	float rootDistance = IntersectBVHNode(nodes[0], origin, invDirection, closest);
+	if (rootDistance < 0.0f)
+		return false;
+	stack[0] = 0;
+	stackDistance[0] = rootDistance;
+	stackSize = 1;
+
+	while (stackSize > 0)
+	{
+		stackSize--;
+		if (stackDistance[stackSize] > closest)
+			continue;
+		const BVHNode& node = nodes[stack[stackSize]];
+
+		if (node.Count == 0)
+		{
+			float leftDistance = IntersectBVHNode(nodes[node.First], origin, invDirection, closest);
+			float rightDistance = IntersectBVHNode(nodes[node.First + 1], origin, invDirection, closest);
+
+			// Push the farther one first so the nearer one is popped next
+			unsigned int nearChild = node.First, farChild = node.First + 1;
+			float nearDistance = leftDistance, farDistance = rightDistance;
+			if (nearDistance < 0.0f || (farDistance >= 0.0f && farDistance < nearDistance))
+			{
+				std::swap(nearChild, farChild);
+				std::swap(nearDistance, farDistance);
+			}
+
+			if (farDistance >= 0.0f)
+			{
+				stack[stackSize] = farChild;
+				stackDistance[stackSize++] = farDistance;
+			}
+			if (nearDistance >= 0.0f)
+			{
+				stack[stackSize] = nearChild;
+				stackDistance[stackSize++] = nearDistance;
+			}
+			continue;
+		}
+
+		const TrianglePacket& packet = packets[node.First];
+		XMVECTOR e1x = XMLoadFloat4(&packet.Edge1[0]), e1y = XMLoadFloat4(&packet.Edge1[1]), e1z = XMLoadFloat4(&packet.Edge1[2]);
+		XMVECTOR e2x = XMLoadFloat4(&packet.Edge2[0]), e2y = XMLoadFloat4(&packet.Edge2[1]), e2z = XMLoadFloat4(&packet.Edge2[2]);
+
+		// p = d x e2, det = e1 . p
+		XMVECTOR px = XMVectorSubtract(XMVectorMultiply(dy, e2z), XMVectorMultiply(dz, e2y));
+		XMVECTOR py = XMVectorSubtract(XMVectorMultiply(dz, e2x), XMVectorMultiply(dx, e2z));
+		XMVECTOR pz = XMVectorSubtract(XMVectorMultiply(dx, e2y), XMVectorMultiply(dy, e2x));
+		XMVECTOR det = XMVectorMultiplyAdd(e1x, px, XMVectorMultiplyAdd(e1y, py, XMVectorMultiply(e1z, pz)));
+		XMVECTOR invDet = XMVectorReciprocal(det);
+
+		// s = o - v0, u = (s . p) / det
+		XMVECTOR sx = XMVectorSubtract(ox, XMLoadFloat4(&packet.V0[0]));
+		XMVECTOR sy = XMVectorSubtract(oy, XMLoadFloat4(&packet.V0[1]));
+		XMVECTOR sz = XMVectorSubtract(oz, XMLoadFloat4(&packet.V0[2]));
+		XMVECTOR u = XMVectorMultiply(XMVectorMultiplyAdd(sx, px, XMVectorMultiplyAdd(sy, py, XMVectorMultiply(sz, pz))), invDet);
+
+		// q = s x e1, v = (d . q) / det, t = (e2 . q) / det
+		XMVECTOR qx = XMVectorSubtract(XMVectorMultiply(sy, e1z), XMVectorMultiply(sz, e1y));
+		XMVECTOR qy = XMVectorSubtract(XMVectorMultiply(sz, e1x), XMVectorMultiply(sx, e1z));
+		XMVECTOR qz = XMVectorSubtract(XMVectorMultiply(sx, e1y), XMVectorMultiply(sy, e1x));
+		XMVECTOR v = XMVectorMultiply(XMVectorMultiplyAdd(dx, qx, XMVectorMultiplyAdd(dy, qy, XMVectorMultiply(dz, qz))), invDet);
+		XMVECTOR t = XMVectorMultiply(XMVectorMultiplyAdd(e2x, qx, XMVectorMultiplyAdd(e2y, qy, XMVectorMultiply(e2z, qz))), invDet);
+
+		// Padding lanes (and edge-on triangles) have a zero det, and
+		// every comparison against their NaNs fails too
+		XMVECTOR mask = XMVectorGreater(XMVectorAbs(det), zero);
+		mask = XMVectorAndInt(mask, XMVectorGreaterOrEqual(u, zero));
+		mask = XMVectorAndInt(mask, XMVectorGreaterOrEqual(v, zero));
+		mask = XMVectorAndInt(mask, XMVectorLessOrEqual(XMVectorAdd(u, v), one));
+		mask = XMVectorAndInt(mask, XMVectorGreaterOrEqual(t, zero));
+		mask = XMVectorAndInt(mask, XMVectorLess(t, XMVectorReplicate(closest)));
+
+		XMFLOAT4 laneT;
+		XMStoreFloat4(&laneT, XMVectorSelect(XMVectorReplicate(FLT_MAX), t, mask));
+
+		int bestLane = -1;
+		for (int lane = 0; lane < 4; lane++)
+		{
+			if ((&laneT.x)[lane] < closest)
+			{
+				closest = (&laneT.x)[lane];
+				bestLane = lane;
+			}
+		}
+
+		if (bestLane < 0)
+			continue;
+
+		found = true;
+		if (AnyHit)
+			return true;
+
+		// det = -(d . (e1 x e2)), and e1 x e2 points out of the front face
+		XMFLOAT4 laneU, laneV, laneDet;
+		XMStoreFloat4(&laneU, u);
+		XMStoreFloat4(&laneV, v);
+		XMStoreFloat4(&laneDet, det);
+		hit->Distance = closest;
+		hit->Triangle = packet.Triangle[bestLane];
+		hit->U = (&laneU.x)[bestLane];
+		hit->V = (&laneV.x)[bestLane];
+		hit->FrontFace = (&laneDet.x)[bestLane] > 0.0f;
+	}
+
+	return found;
+}
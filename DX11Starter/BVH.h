@@ -0,0 +1,107 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+#include "Vertex.h"
+
+// Most primitives a leaf may hold.  Triangle leaves are
+// tested as one four-wide packet, so this is also the
+// SIMD width of the triangle tests.
+#define BVH_MAX_LEAF_SIZE	4
+
+// Candidate split planes per axis when binning
+#define BVH_SAH_BINS		12
+
+// Deepest a tree may go (the root is depth 0), which sizes
+// the traversal stacks: a depth first walk never holds more
+// than one node per level plus the two just pushed.  Below
+// BVH_MEDIAN_DEPTH nodes are split at the median instead of
+// by SAH, which halves them every level and so always
+// reaches leaves in time, however the primitives lie.
+#define BVH_MAX_DEPTH		64
+#define BVH_MEDIAN_DEPTH	(BVH_MAX_DEPTH - 32)
+
+// --------------------------------------------------------
+// A ray, and what it hit.  Distances are in units of the
+// direction's length (so world units if it's normalized).
+// --------------------------------------------------------
+struct Ray
+{
+	XMFLOAT3 Origin;
+	XMFLOAT3 Direction;
+	float MaxDistance;
+};
+
+struct RayHit
+{
+	float Distance;
+	unsigned int Triangle;		// Index of the triangle's first index
+	float U, V;					// Barycentrics of the hit on that triangle
+	bool FrontFace;				// Hit the outside (clockwise) face
+};
+
+// --------------------------------------------------------
+// One node of a binary BVH.  Interior nodes have Count 0
+// and their children at First and First + 1.  Leaves hold
+// Count primitives starting at First.
+// --------------------------------------------------------
+struct BVHNode
+{
+	XMFLOAT3 Min;
+	unsigned int First;
+	XMFLOAT3 Max;
+	unsigned int Count;
+};
+
+// Builds a BVH over boxes using binned SAH, no deeper than
+// BVH_MAX_DEPTH.  "order" gets the primitive indices in leaf
+// order (leaves index into it).
+void BuildBVH(
+	const XMFLOAT3* boxMin, const XMFLOAT3* boxMax, unsigned int count,
+	std::vector<BVHNode>& nodes,
+	std::vector<unsigned int>& order);
+
+// Slab test against a node's box.  Returns the entry distance,
+// or a negative value on a miss.
+float XM_CALLCONV IntersectBVHNode(const BVHNode& node, DirectX::FXMVECTOR origin, DirectX::FXMVECTOR invDirection, float maxDistance);
+
+// --------------------------------------------------------
+// BVH over a mesh's triangles for ray queries (picking,
+// gameplay raycasts, baking).
+//
+// Each leaf's triangles are stored as one packet, laid out
+// structure-of-arrays, so a ray is tested against all four
+// at once.  Built once when the mesh loads; it's only read
+// afterwards, so any number of threads can query it.
+// --------------------------------------------------------
+class TriangleBVH
+{
+public:
+	bool Build(const Vertex* vertices, unsigned int vertexCount, const int* indices, unsigned int indexCount);
+
+	// Nearest hit along the ray, if any
+	bool IntersectClosest(const Ray& ray, RayHit* hit) const;
+
+	// Whether anything at all is hit (shadow/occlusion rays) -
+	// stops at the first hit it finds
+	bool IntersectAny(const Ray& ray) const;
+
+	bool IsEmpty() const { return nodes.empty(); }
+	void GetBounds(XMFLOAT3* min, XMFLOAT3* max) const;
+
+private:
+	// Four triangles, one per lane.  Unused lanes have zero
+	// edges, which can never be hit.
+	struct TrianglePacket
+	{
+		XMFLOAT4 V0[3];			// x, y and z of each triangle's first vertex
+		XMFLOAT4 Edge1[3];		// v1 - v0
+		XMFLOAT4 Edge2[3];		// v2 - v0
+		unsigned int Triangle[4];
+	};
+
+	std::vector<BVHNode> nodes;
+	std::vector<TrianglePacket> packets;
+
+	template <bool AnyHit> bool Traverse(const Ray& ray, RayHit* hit) const;
+};
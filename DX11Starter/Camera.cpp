@@ -1,9 +1,9 @@
 #include "Camera.h"
-#include "DXCore.h"
+#include <cfloat>
 
 
 
-Camera::Camera(XMFLOAT3 newPos, float newMoveSpeed, int width, int height)
+Camera::Camera(XMFLOAT3 newPos, float newMoveSpeed, int width, int height, DepthMode newDepthMode)
 {
 	pos = newPos;
 	up = XMFLOAT3(0, 1, 0);
@@ -12,16 +12,14 @@ Camera::Camera(XMFLOAT3 newPos, float newMoveSpeed, int width, int height)
 	yRotation = 0;
 	moveSpeed = newMoveSpeed;
 	rotationSpeed = .003f;
-
-	// Create the Projection matrix
-	// - This should match the window's aspect ratio, and also update anytime
-	//   the window resizes (which is already happening in OnResize() below)
-	XMMATRIX P = XMMatrixPerspectiveFovLH(
-		0.25f * 3.1415926535f,		// Field of View Angle
-		(float)width / height,		// Aspect ratio
-		0.1f,						// Near clip plane distance
-		100.0f);					// Far clip plane distance
-	XMStoreFloat4x4(&projectionMatrix, XMMatrixTranspose(P)); // Transpose for HLSL!
+	aspectRatio = (float)width / height;
+	depthMode = newDepthMode;
+
+	// Nothing is built until something asks for it
+	forward = dir;
+	rotationDirty = true;
+	viewDirty = true;
+	projectionDirty = true;
 }
 
 
@@ -38,6 +36,9 @@ void Camera::RotateX(int additionalRotation)
 
 	if (xRotation < -XM_2PI)
 		xRotation += XM_2PI;
+
+	if (additionalRotation != 0)
+		rotationDirty = true;
 }
 
 void Camera::RotateY(int additionalRotation)
@@ -49,89 +50,187 @@ void Camera::RotateY(int additionalRotation)
 
 	if (yRotation < -XM_2PI)
 		yRotation += XM_2PI;
+
+	if (additionalRotation != 0)
+		rotationDirty = true;
+}
+
+void Camera::GetPose(XMFLOAT3* position, float* pitch, float* yaw)
+{
+	*position = pos;
+	*pitch = xRotation;
+	*yaw = yRotation;
+}
+
+void Camera::SetPose(XMFLOAT3 position, float pitch, float yaw)
+{
+	pos = position;
+	xRotation = pitch;
+	yRotation = yaw;
+	rotationDirty = true;
 }
 
 void Camera::Resize(int width, int height)
 {
-	// Update our projection matrix since the window size changed
-	XMMATRIX P = XMMatrixPerspectiveFovLH(
-		0.25f * 3.1415926535f,	// Field of View Angle
-		(float)width / height,	// Aspect ratio
-		0.1f,				  	// Near clip plane distance
-		100.0f);			  	// Far clip plane distance
-	XMStoreFloat4x4(&projectionMatrix, XMMatrixTranspose(P)); // Transpose for HLSL!
+	// The projection matrix has to match the window's aspect ratio
+	aspectRatio = (float)width / height;
+	projectionDirty = true;
 }
 
-void Camera::Update(float deltaTime)
+const XMFLOAT4X4& Camera::GetViewMatrix() { UpdateMatrices(); return viewMatrix; }
+const XMFLOAT4X4& Camera::GetProjectionMatrix() { UpdateMatrices(); return projectionMatrix; }
+const XMFLOAT4X4& Camera::GetViewProjectionMatrix() { UpdateMatrices(); return viewProjectionMatrix; }
+const XMFLOAT4X4& Camera::GetInverseViewMatrix() { UpdateMatrices(); return inverseViewMatrix; }
+const XMFLOAT4X4& Camera::GetInverseViewProjectionMatrix() { UpdateMatrices(); return inverseViewProjectionMatrix; }
+const XMFLOAT4* Camera::GetFrustumPlanes() { UpdateMatrices(); return frustumPlanes; }
+
+// --------------------------------------------------------
+// Turns the base direction by the current rotation.  Moving
+// needs this even when nothing asks for the matrices.
+// --------------------------------------------------------
+void Camera::UpdateForward()
 {
-	XMVECTOR upVec = XMVectorSet(up.x, up.y, up.z, 0);
-	XMVECTOR dirVec = XMVectorSet(dir.x, dir.y, dir.z, 0);
+	if (!rotationDirty)
+		return;
+
 	XMMATRIX rotation = XMMatrixRotationRollPitchYaw(xRotation, yRotation, 0);
-	dirVec = XMVector3Normalize(XMVector3Transform(dirVec, rotation));
+	XMStoreFloat3(&forward, XMVector3Normalize(XMVector3Transform(XMLoadFloat3(&dir), rotation)));
+	rotationDirty = false;
+	viewDirty = true;
+}
 
-	if (GetAsyncKeyState('W') & 0x8000)
-	{
-		float x = XMVectorGetX(dirVec) * (moveSpeed * deltaTime);
-		float y = XMVectorGetY(dirVec) * (moveSpeed * deltaTime);
-		float z = XMVectorGetZ(dirVec) * (moveSpeed * deltaTime);
-		pos.x += x;
-		pos.y += y;
-		pos.z += z;
-	}
+// --------------------------------------------------------
+// Rebuilds whichever matrices are out of date, and then
+// everything that depends on them
+// --------------------------------------------------------
+void Camera::UpdateMatrices()
+{
+	UpdateForward();
+	if (!viewDirty && !projectionDirty)
+		return;
 
-	if (GetAsyncKeyState('S') & 0x8000)
+	if (viewDirty)
 	{
-		float x = XMVectorGetX(dirVec) * (moveSpeed * deltaTime);
-		float y = XMVectorGetY(dirVec) * (moveSpeed * deltaTime);
-		float z = XMVectorGetZ(dirVec) * (moveSpeed * deltaTime);
-		pos.x -= x;
-		pos.y -= y;
-		pos.z -= z;
+		// Create the View matrix
+		// - We're using the LOOK TO function, which takes the position of the
+		//    camera and the direction vector along which to look (as well as "up")
+		// - Another option is the LOOK AT function, to look towards a specific
+		//    point in 3D space
+		XMMATRIX V = XMMatrixLookToLH(
+			XMLoadFloat3(&pos),		// The position of the "camera"
+			XMLoadFloat3(&forward),	// Direction the camera is looking
+			XMLoadFloat3(&up));		// "Up" direction in 3D space (prevents roll)
+		XMStoreFloat4x4(&viewMatrix, XMMatrixTranspose(V)); // Transpose for HLSL!
+		XMStoreFloat4x4(&inverseViewMatrix, XMMatrixTranspose(XMMatrixInverse(0, V)));
 	}
 
-	if (GetAsyncKeyState('A') & 0x8000)
+	if (projectionDirty)
 	{
-		XMVECTOR crossMovement = XMVector3Cross(upVec, dirVec);
-		float x = XMVectorGetX(crossMovement) * (moveSpeed * deltaTime);
-		float y = XMVectorGetY(crossMovement) * (moveSpeed * deltaTime);
-		float z = XMVectorGetZ(crossMovement) * (moveSpeed * deltaTime);
-		pos.x -= x;
-		pos.y -= y;
-		pos.z -= z;
+		XMMATRIX P = XMMatrixPerspectiveFovLH(
+			0.25f * 3.1415926535f,	// Field of View Angle
+			aspectRatio,			// Aspect ratio
+			0.1f,				  	// Near clip plane distance
+			100.0f);			  	// Far clip plane distance
+
+		// Reverse Z, infinite far plane: depth is near / z, so the near
+		// plane lands on 1 and depth falls towards 0 with distance
+		if (depthMode == DEPTH_REVERSE_Z)
+		{
+			P.r[2] = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+			P.r[3] = XMVectorSet(0.0f, 0.0f, 0.1f, 0.0f);
+		}
+		XMStoreFloat4x4(&projectionMatrix, XMMatrixTranspose(P)); // Transpose for HLSL!
 	}
 
-	if (GetAsyncKeyState('D') & 0x8000)
+	XMMATRIX V = XMMatrixTranspose(XMLoadFloat4x4(&viewMatrix));
+	XMMATRIX P = XMMatrixTranspose(XMLoadFloat4x4(&projectionMatrix));
+	XMMATRIX viewProj = XMMatrixMultiply(V, P);
+	XMStoreFloat4x4(&viewProjectionMatrix, XMMatrixTranspose(viewProj));
+	XMStoreFloat4x4(&inverseViewProjectionMatrix, XMMatrixTranspose(XMMatrixInverse(0, viewProj)));
+
+	// Gribb/Hartmann, from the columns of viewProj (the rows of
+	// the transposed copy we already have).  The clip volume is
+	// 0 <= z <= w either way; reverse Z only swaps which of those
+	// is the near plane.
+	XMMATRIX columns = XMLoadFloat4x4(&viewProjectionMatrix);
+	XMVECTOR planes[6] =
 	{
-		XMVECTOR crossMovement = XMVector3Cross(upVec, dirVec);
-		float x = XMVectorGetX(crossMovement) * (moveSpeed * deltaTime);
-		float y = XMVectorGetY(crossMovement) * (moveSpeed * deltaTime);
-		float z = XMVectorGetZ(crossMovement) * (moveSpeed * deltaTime);
-		pos.x += x;
-		pos.y += y;
-		pos.z += z;
-	}
-
-	if (GetAsyncKeyState('X') & 0x8000)
+		XMVectorAdd(columns.r[3], columns.r[0]),		// Left
+		XMVectorSubtract(columns.r[3], columns.r[0]),	// Right
+		XMVectorAdd(columns.r[3], columns.r[1]),		// Bottom
+		XMVectorSubtract(columns.r[3], columns.r[1]),	// Top
+		columns.r[2],									// Near (z >= 0 in D3D)
+		XMVectorSubtract(columns.r[3], columns.r[2]),	// Far
+	};
+	if (depthMode == DEPTH_REVERSE_Z)
 	{
-		pos.y += (moveSpeed * deltaTime);
+		XMVECTOR nearPlane = planes[5];
+		planes[5] = planes[4];
+		planes[4] = nearPlane;
 	}
+	for (unsigned int i = 0; i < 5; i++)
+		XMStoreFloat4(&frustumPlanes[i], XMPlaneNormalize(planes[i]));
 
-	if (GetAsyncKeyState(VK_SPACE) & 0x8000)
-	{
-		pos.y -= (moveSpeed * deltaTime);
-	}
-	// Create the View matrix
-	// - In an actual game, recreate this matrix every time the camera 
-	//    moves (potentially every frame)
-	// - We're using the LOOK TO function, which takes the position of the
-	//    camera and the direction vector along which to look (as well as "up")
-	// - Another option is the LOOK AT function, to look towards a specific
-	//    point in 3D space
-	XMVECTOR posVec = XMVectorSet(pos.x, pos.y, pos.z, 0);
-	
-	XMMATRIX V = XMMatrixLookToLH(
-		posVec,     // The position of the "camera"
-		dirVec,     // Direction the camera is looking
-		upVec);     // "Up" direction in 3D space (prevents roll)
-	XMStoreFloat4x4(&viewMatrix, XMMatrixTranspose(V)); // Transpose for HLSL!
+	// An infinite far plane has no normal, so nothing's outside it
+	if (depthMode == DEPTH_REVERSE_Z)
+		frustumPlanes[5] = XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+	else
+		XMStoreFloat4(&frustumPlanes[5], XMPlaneNormalize(planes[5]));
+
+	viewDirty = false;
+	projectionDirty = false;
+}
+
+// --------------------------------------------------------
+// Unprojects the pixel at both ends of the depth range.
+// --------------------------------------------------------
+Ray Camera::GetPickRay(int x, int y, int width, int height)
+{
+	// Pixel to normalized device coordinates (y points up)
+	float ndcX = 2.0f * (x + 0.5f) / width - 1.0f;
+	float ndcY = 1.0f - 2.0f * (y + 0.5f) / height;
+
+	XMMATRIX invViewProj = XMMatrixTranspose(XMLoadFloat4x4(&GetInverseViewProjectionMatrix()));
+
+	// Infinity (reverse Z's far plane) can't be unprojected, so aim
+	// through a point halfway along the depth range instead
+	float nearDepth = depthMode == DEPTH_REVERSE_Z ? 1.0f : 0.0f;
+	float farDepth = depthMode == DEPTH_REVERSE_Z ? 0.5f : 1.0f;
+
+	XMVECTOR nearPoint = XMVector3TransformCoord(XMVectorSet(ndcX, ndcY, nearDepth, 1.0f), invViewProj);
+	XMVECTOR farPoint = XMVector3TransformCoord(XMVectorSet(ndcX, ndcY, farDepth, 1.0f), invViewProj);
+	XMVECTOR toFar = XMVectorSubtract(farPoint, nearPoint);
+
+	Ray ray;
+	XMStoreFloat3(&ray.Origin, nearPoint);
+	XMStoreFloat3(&ray.Direction, XMVector3Normalize(toFar));
+	ray.MaxDistance = depthMode == DEPTH_REVERSE_Z ? FLT_MAX : XMVectorGetX(XMVector3Length(toFar));
+	return ray;
+}
+
+// --------------------------------------------------------
+// Each direction moves for exactly as long as its keys were
+// held during the frame, so a tap moves the same distance
+// no matter where it falls between frames
+// --------------------------------------------------------
+void Camera::Update(const InputSnapshot& input)
+{
+	RotateX(input.LookY);
+	RotateY(input.LookX);
+
+	float forwardAmount = moveSpeed * (input.HeldTime[ACTION_MOVE_FORWARD] - input.HeldTime[ACTION_MOVE_BACK]);
+	float right = moveSpeed * (input.HeldTime[ACTION_MOVE_RIGHT] - input.HeldTime[ACTION_MOVE_LEFT]);
+	float rise = moveSpeed * (input.HeldTime[ACTION_MOVE_UP] - input.HeldTime[ACTION_MOVE_DOWN]);
+	if (forwardAmount == 0.0f && right == 0.0f && rise == 0.0f)
+		return;
+
+	UpdateForward();
+	XMVECTOR upVec = XMLoadFloat3(&up);
+	XMVECTOR dirVec = XMLoadFloat3(&forward);
+
+	XMVECTOR move = XMVectorScale(dirVec, forwardAmount);
+	move = XMVectorAdd(move, XMVectorScale(XMVector3Cross(upVec, dirVec), right));
+	move = XMVectorAdd(move, XMVectorSet(0, rise, 0, 0));
+	XMStoreFloat3(&pos, XMVectorAdd(XMLoadFloat3(&pos), move));
+	viewDirty = true;
 }
@@ -1,28 +1,71 @@
 #include <DirectXMath.h>
+#include "BVH.h"
+#include "Input.h"
+#include "DepthMode.h"
 #pragma once
 
 using namespace DirectX;
+
+// --------------------------------------------------------
+// A free flying first person camera.
+//
+// Everything derived from the pose (view, projection, their
+// product and inverse, and the frustum planes) is rebuilt
+// only when asked for after the pose or the window's size
+// has changed, so an idle camera costs nothing per frame.
+// --------------------------------------------------------
 class Camera
 {
 public:
-	Camera(XMFLOAT3 pos, float moveSpeed, int width, int height);
+	Camera(XMFLOAT3 pos, float moveSpeed, int width, int height, DepthMode depthMode);
 	~Camera();
 	void RotateY(int pixels);
 	void RotateX(int pixels);
-	void Update(float deltaTime);
+	// Moves and turns by this frame's input
+	void Update(const InputSnapshot& input);
 	void Resize(int width, int height);
-	inline XMFLOAT4X4 GetViewMatrix() { return viewMatrix; };
-	inline XMFLOAT4X4 GetProjectionMatrix() { return projectionMatrix; };
+	// Matrices are transposed for HLSL
+	const XMFLOAT4X4& GetViewMatrix();
+	const XMFLOAT4X4& GetProjectionMatrix();
+	const XMFLOAT4X4& GetViewProjectionMatrix();
+	const XMFLOAT4X4& GetInverseViewMatrix();
+	const XMFLOAT4X4& GetInverseViewProjectionMatrix();
+	// World space, normalized and pointing inwards (left, right,
+	// bottom, top, near, far).  With reverse Z there's no far plane,
+	// and the last one never culls anything.
+	const XMFLOAT4* GetFrustumPlanes();
+	inline XMFLOAT3 GetPosition() { return pos; };
+	// Where the camera is and which way it's turned (for recordings)
+	void GetPose(XMFLOAT3* position, float* pitch, float* yaw);
+	void SetPose(XMFLOAT3 position, float pitch, float yaw);
+	// World space ray through a pixel, from the near plane to the far
+	// plane (or on forever, with reverse Z)
+	Ray GetPickRay(int x, int y, int width, int height);
 private:
 	XMFLOAT3 pos;
 	XMFLOAT3 dir;
 	XMFLOAT3 up;
-	XMFLOAT4X4 viewMatrix;
-	// The matrices to go from model space to screen space
-	XMFLOAT4X4 projectionMatrix;
 	float xRotation;
 	float yRotation;
 	float moveSpeed;
 	float rotationSpeed;
+	float aspectRatio;
+	DepthMode depthMode;
+
+	// The matrices to go from world space to screen space, and
+	// whether they're out of date
+	XMFLOAT4X4 viewMatrix;
+	XMFLOAT4X4 projectionMatrix;
+	XMFLOAT4X4 viewProjectionMatrix;
+	XMFLOAT4X4 inverseViewMatrix;
+	XMFLOAT4X4 inverseViewProjectionMatrix;
+	XMFLOAT4 frustumPlanes[6];
+	XMFLOAT3 forward;			// dir, turned by the current rotation
+	bool rotationDirty;
+	bool viewDirty;
+	bool projectionDirty;
+
+	void UpdateForward();
+	void UpdateMatrices();
 };
 
@@ -0,0 +1,109 @@
+#include "ClusterCuller.h"
+#include <cstring>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Constructor - The index buffer is created on first upload
+// --------------------------------------------------------
+ClusterCuller::ClusterCuller(ID3D11Device* device, ID3D11DeviceContext* context)
+{
+	this->device = device;
+	this->context = context;
+	indexBuffer = 0;
+	capacity = 0;
+	clustersTested = 0;
+	clustersVisible = 0;
+}
+
+// --------------------------------------------------------
+// Destructor
+// --------------------------------------------------------
+ClusterCuller::~ClusterCuller()
+{
+	if (indexBuffer) { indexBuffer->Release(); }
+}
+
+// --------------------------------------------------------
+// Clears last frame's indices and remembers the camera
+// --------------------------------------------------------
+void ClusterCuller::Begin(const XMFLOAT4X4& viewProjection, const XMFLOAT3& cameraPosition)
+{
+	XMStoreFloat4x4(&this->viewProjection, XMMatrixTranspose(XMLoadFloat4x4(&viewProjection)));
+	this->cameraPosition = cameraPosition;
+
+	indices.clear();
+	clustersTested = 0;
+	clustersVisible = 0;
+}
+
+// --------------------------------------------------------
+// Appends the instance's visible clusters to this frame's
+// indices
+// --------------------------------------------------------
+ClusterDraw ClusterCuller::Cull(Mesh* mesh, const XMFLOAT4X4& world)
+{
+	ClusterDraw draw;
+	draw.FirstIndex = indices.size();
+
+	const std::vector<Meshlet>& meshlets = mesh->GetMeshlets();
+	if (!meshlets.empty())
+	{
+		XMMATRIX W = XMMatrixTranspose(XMLoadFloat4x4(&world));
+		MeshletFrustum frustum = MakeMeshletFrustum(W, XMLoadFloat4x4(&viewProjection), XMLoadFloat3(&cameraPosition));
+
+		clustersTested += meshlets.size();
+		clustersVisible += CullMeshlets(&meshlets[0], meshlets.size(), &mesh->GetMeshletIndices()[0], frustum, indices);
+	}
+
+	draw.IndexCount = indices.size() - draw.FirstIndex;
+	return draw;
+}
+
+// --------------------------------------------------------
+// Writes every index culled this frame in one Map().  The
+// buffer doubles whenever a frame needs more room.
+// --------------------------------------------------------
+bool ClusterCuller::Upload()
+{
+	if (indices.empty())
+		return true;
+
+	if (indices.size() > capacity)
+	{
+		unsigned int newCapacity = capacity > 0 ? capacity : 64 * 1024;
+		while (newCapacity < indices.size())
+			newCapacity *= 2;
+
+		D3D11_BUFFER_DESC desc = {};
+		desc.Usage = D3D11_USAGE_DYNAMIC;
+		desc.ByteWidth = sizeof(int) * newCapacity;
+		desc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+		desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+		ID3D11Buffer* newBuffer = 0;
+		if (FAILED(device->CreateBuffer(&desc, 0, &newBuffer)))
+			return false;
+
+		if (indexBuffer) { indexBuffer->Release(); }
+		indexBuffer = newBuffer;
+		capacity = newCapacity;
+	}
+
+	D3D11_MAPPED_SUBRESOURCE mapped;
+	if (FAILED(context->Map(indexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))
+		return false;
+
+	memcpy(mapped.pData, &indices[0], sizeof(int) * indices.size());
+	context->Unmap(indexBuffer, 0);
+	return true;
+}
+
+// --------------------------------------------------------
+// Swaps in our index buffer, leaving the pool's vertex
+// buffer bound
+// --------------------------------------------------------
+void ClusterCuller::Bind()
+{
+	context->IASetIndexBuffer(indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+}
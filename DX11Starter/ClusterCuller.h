@@ -0,0 +1,62 @@
+#pragma once
+
+#include <d3d11.h>
+#include <DirectXMath.h>
+#include <vector>
+#include "Mesh.h"
+
+// --------------------------------------------------------
+// Where one instance's surviving triangles ended up in the
+// culler's index buffer
+// --------------------------------------------------------
+struct ClusterDraw
+{
+	unsigned int FirstIndex;
+	unsigned int IndexCount;
+};
+
+// --------------------------------------------------------
+// Culls each drawn instance's meshlets on the CPU and packs
+// the indices of what's left into one dynamic index buffer,
+// so hidden and back facing clusters never reach the GPU.
+//
+// Each frame: Begin(), Cull() every instance, Upload(), then
+// draw with Bind() in place of the pool's index buffer.
+// Indices stay relative to the mesh, so the pool's vertex
+// buffer and each mesh's base vertex work unchanged.
+// --------------------------------------------------------
+class ClusterCuller
+{
+public:
+	ClusterCuller(ID3D11Device* device, ID3D11DeviceContext* context);
+	~ClusterCuller();
+
+	// Starts a new frame (view * projection as stored for HLSL, transposed)
+	void Begin(const XMFLOAT4X4& viewProjection, const XMFLOAT3& cameraPosition);
+
+	// Culls one instance of a mesh
+	ClusterDraw Cull(Mesh* mesh, const XMFLOAT4X4& world);
+
+	// Copies this frame's indices to the GPU.  Call after every
+	// Cull() and before any draws.
+	bool Upload();
+	void Bind();
+
+	// Stats for the last frame
+	unsigned int GetClustersTested() { return clustersTested; }
+	unsigned int GetClustersVisible() { return clustersVisible; }
+
+private:
+	ID3D11Device* device;
+	ID3D11DeviceContext* context;
+
+	ID3D11Buffer* indexBuffer;
+	unsigned int capacity;			// In indices
+
+	std::vector<int> indices;		// This frame's, kept to reuse its memory
+	XMFLOAT4X4 viewProjection;
+	XMFLOAT3 cameraPosition;
+
+	unsigned int clustersTested;
+	unsigned int clustersVisible;
+};
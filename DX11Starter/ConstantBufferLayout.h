@@ -0,0 +1,97 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+
+// --------------------------------------------------------
+// Compile-time helpers for declaring C++ structs that
+// mirror HLSL cbuffers byte-for-byte.
+//
+// HLSL packs constant buffer members into 16-byte registers:
+//  - A member may not straddle a register boundary
+//  - Structs and matrices always start a new register
+// HlslPackOffset() applies those rules, and the macros below
+// static_assert that each C++ member lands where HLSL will
+// put it, so a layout mismatch is a compile error instead
+// of garbage on the GPU.
+// --------------------------------------------------------
+
+// HLSL size of a type and whether it must start a new register.
+// Left undefined so unsupported types fail to compile.
+template <typename T> struct HlslTypeInfo;
+
+template <> struct HlslTypeInfo<float>					{ static const unsigned int Size = 4;  static const bool StartsRegister = false; };
+template <> struct HlslTypeInfo<int>					{ static const unsigned int Size = 4;  static const bool StartsRegister = false; };
+template <> struct HlslTypeInfo<unsigned int>			{ static const unsigned int Size = 4;  static const bool StartsRegister = false; };
+template <> struct HlslTypeInfo<DirectX::XMFLOAT2>		{ static const unsigned int Size = 8;  static const bool StartsRegister = false; };
+template <> struct HlslTypeInfo<DirectX::XMFLOAT3>		{ static const unsigned int Size = 12; static const bool StartsRegister = false; };
+template <> struct HlslTypeInfo<DirectX::XMFLOAT4>		{ static const unsigned int Size = 16; static const bool StartsRegister = false; };
+template <> struct HlslTypeInfo<DirectX::XMFLOAT4X4>	{ static const unsigned int Size = 64; static const bool StartsRegister = true; };
+
+// Arrays start a new register and pad every element but the last
+// out to one.  Only element types already a whole number of
+// registers in C++ are allowed, so C++ and HLSL agree on the stride.
+template <typename T, std::size_t N> struct HlslTypeInfo<T[N]>
+{
+	static_assert(sizeof(T) % 16 == 0, "HLSL arrays need 16 byte aligned element types in C++");
+	static const unsigned int Size = (unsigned int)(N - 1) * ((HlslTypeInfo<T>::Size + 15) & ~15u) + HlslTypeInfo<T>::Size;
+	static const bool StartsRegister = true;
+};
+
+// Where HLSL places a member, given where the previous one ended
+inline constexpr unsigned int HlslPackOffset(unsigned int previousEnd, unsigned int size, bool startsRegister)
+{
+	return (startsRegister || (previousEnd % 16) + size > 16)
+		? (previousEnd + 15) & ~15u
+		: previousEnd;
+}
+
+// HLSL size of a whole cbuffer (always a multiple of 16)
+inline constexpr unsigned int HlslBufferSize(unsigned int lastMemberEnd)
+{
+	return (lastMemberEnd + 15) & ~15u;
+}
+
+#define HLSL_MEMBER_END(Struct, member) \
+	(offsetof(Struct, member) + HlslTypeInfo<decltype(Struct::member)>::Size)
+
+// Checks the first member of a layout
+#define HLSL_CHECK_FIRST(Struct, member) \
+	static_assert(offsetof(Struct, member) == 0, \
+		#Struct "::" #member " must be the first member")
+
+// Checks that a member sits where HLSL packing puts it after "previous"
+#define HLSL_CHECK_NEXT(Struct, previous, member) \
+	static_assert(offsetof(Struct, member) == HlslPackOffset( \
+		HLSL_MEMBER_END(Struct, previous), \
+		HlslTypeInfo<decltype(Struct::member)>::Size, \
+		HlslTypeInfo<decltype(Struct::member)>::StartsRegister), \
+		#Struct "::" #member " does not match HLSL packing")
+
+// Declares a struct usable as a member of other layouts.  Its HLSL
+// size ends at its last HLSL member (C++ padding is not counted).
+#define HLSL_STRUCT_TYPE(Struct, lastMember) \
+	template <> struct HlslTypeInfo<Struct> \
+	{ \
+		static const unsigned int Size = HLSL_MEMBER_END(Struct, lastMember); \
+		static const bool StartsRegister = true; \
+	}
+
+// --------------------------------------------------------
+// Runtime description of a layout, used to check a typed
+// struct against a shader's reflection data at load time
+// --------------------------------------------------------
+struct HlslMemberInfo
+{
+	const char* Name;
+	unsigned int ByteOffset;
+	unsigned int Size;
+};
+
+#define HLSL_MEMBER(Struct, member) \
+	{ #member, offsetof(Struct, member), HlslTypeInfo<decltype(Struct::member)>::Size }
+
+// Specialized for each typed cbuffer (see ConstantBuffers.h) with:
+//  - static const char* BufferName()
+//  - static const HlslMemberInfo* Members(unsigned int* count)
+template <typename T> struct ConstantBufferLayout;
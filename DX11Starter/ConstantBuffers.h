@@ -0,0 +1,89 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include "ConstantBufferLayout.h"
+#include "Lights.h"
+#include "LightProbes.h"
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Matches "cbuffer externalData" in VertexShader.hlsl
+// --------------------------------------------------------
+struct VertexShaderExternalData
+{
+	XMFLOAT4X4 world;
+	XMFLOAT4X4 worldViewProj;		// Multiplied out on the CPU, once per object
+};
+
+HLSL_CHECK_FIRST(VertexShaderExternalData, world);
+HLSL_CHECK_NEXT(VertexShaderExternalData, world, worldViewProj);
+static_assert(sizeof(VertexShaderExternalData) == HlslBufferSize(HLSL_MEMBER_END(VertexShaderExternalData, worldViewProj)),
+	"VertexShaderExternalData size does not match HLSL");
+
+template <> struct ConstantBufferLayout<VertexShaderExternalData>
+{
+	static const char* BufferName() { return "externalData"; }
+	static const HlslMemberInfo* Members(unsigned int* count)
+	{
+		static const HlslMemberInfo members[] =
+		{
+			HLSL_MEMBER(VertexShaderExternalData, world),
+			HLSL_MEMBER(VertexShaderExternalData, worldViewProj),
+		};
+		*count = sizeof(members) / sizeof(members[0]);
+		return members;
+	}
+};
+
+// --------------------------------------------------------
+// Matches "cbuffer externalData" in PixelShader.hlsl
+// (the default, two light permutation)
+// --------------------------------------------------------
+struct PixelShaderExternalData
+{
+	DirectionalLight lightOne;
+	DirectionalLight lightTwo;
+};
+
+HLSL_CHECK_FIRST(PixelShaderExternalData, lightOne);
+HLSL_CHECK_NEXT(PixelShaderExternalData, lightOne, lightTwo);
+static_assert(sizeof(PixelShaderExternalData) == HlslBufferSize(HLSL_MEMBER_END(PixelShaderExternalData, lightTwo)),
+	"PixelShaderExternalData size does not match HLSL");
+
+template <> struct ConstantBufferLayout<PixelShaderExternalData>
+{
+	static const char* BufferName() { return "externalData"; }
+	static const HlslMemberInfo* Members(unsigned int* count)
+	{
+		static const HlslMemberInfo members[] =
+		{
+			HLSL_MEMBER(PixelShaderExternalData, lightOne),
+			HLSL_MEMBER(PixelShaderExternalData, lightTwo),
+		};
+		*count = sizeof(members) / sizeof(members[0]);
+		return members;
+	}
+};
+
+// --------------------------------------------------------
+// Matches "cbuffer probes" in PixelShader.hlsl, where the
+// coefficients are called shCoefficients
+// --------------------------------------------------------
+HLSL_CHECK_FIRST(SHCoefficients, C);
+static_assert(sizeof(SHCoefficients) == HlslBufferSize(HLSL_MEMBER_END(SHCoefficients, C)),
+	"SHCoefficients size does not match HLSL");
+
+template <> struct ConstantBufferLayout<SHCoefficients>
+{
+	static const char* BufferName() { return "probes"; }
+	static const HlslMemberInfo* Members(unsigned int* count)
+	{
+		static const HlslMemberInfo members[] =
+		{
+			{ "shCoefficients", offsetof(SHCoefficients, C), HlslTypeInfo<decltype(SHCoefficients::C)>::Size },
+		};
+		*count = sizeof(members) / sizeof(members[0]);
+		return members;
+	}
+};
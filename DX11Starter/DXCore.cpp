@@ -1,7 +1,55 @@
 #include "DXCore.h"
 
 #include <WindowsX.h>
+#include <dxgi1_3.h>
 #include <sstream>
+#include <fstream>
+#include <algorithm>
+#include "FrameArena.h"
+
+// For timeBeginPeriod()
+#pragma comment(lib, "winmm.lib")
+
+// Seconds between frame time reports in the console
+#define PACING_STATS_INTERVAL	5.0
+
+// --------------------------------------------------------
+// The default clock - the high resolution performance counter
+// --------------------------------------------------------
+class PerformanceCounterClock : public GameClock
+{
+public:
+	PerformanceCounterClock()
+	{
+		__int64 perfFreq;
+		QueryPerformanceFrequency((LARGE_INTEGER*)&perfFreq);
+		perfCounterSeconds = 1.0 / (double)perfFreq;
+
+		// Sleep() is only as fine as the scheduler's tick, which
+		// defaults to ~15.6ms - far too coarse to pace frames with
+		timeBeginPeriod(1);
+	}
+
+	~PerformanceCounterClock()
+	{
+		timeEndPeriod(1);
+	}
+
+	double Now()
+	{
+		__int64 now;
+		QueryPerformanceCounter((LARGE_INTEGER*)&now);
+		return now * perfCounterSeconds;
+	}
+
+	void SleepFor(double seconds)
+	{
+		Sleep((DWORD)(seconds * 1000.0));
+	}
+
+private:
+	double perfCounterSeconds;
+};
 
 // Define the static instance variable so our OS-level 
 // message handling function below can talk to our object
@@ -33,6 +81,7 @@ DXCore::DXCore(
 	unsigned int windowWidth,	// Width of the window's client area
 	unsigned int windowHeight,	// Height of the window's client area
 	bool debugTitleBarStats)	// Show extra stats (fps) in title bar?
+	: timestep(60.0f, 8), pacer(0)
 {
 	// Save a static reference to this object.
 	//  - Since the OS-level message function must be a non-member (global) function, 
@@ -50,17 +99,33 @@ DXCore::DXCore(
 	// Initialize fields
 	fpsFrameCount = 0;
 	fpsTimeElapsed = 0.0f;
+	pacingStatsTime = 0.0;
 	
 	device = 0;
 	context = 0;
 	swapChain = 0;
 	backBufferRTV = 0;
-	depthStencilView = 0;
-
-	// Query performance counter for accurate timing information
-	__int64 perfFreq;
-	QueryPerformanceFrequency((LARGE_INTEGER*)&perfFreq);
-	perfCounterSeconds = 1.0 / (double)perfFreq;
+	swapChainBufferCount = 1;
+	swapChainFlags = 0;
+	frameLatencyWaitable = 0;
+	pacingMode = FRAME_PACING_LATENCY;
+	depthMode = DEPTH_STANDARD;
+
+	// Use the performance counter for accurate timing information
+	clock = new PerformanceCounterClock();
+	pacer.SetClock(clock);
+	clockOffset = 0.0;
+
+	recording = 0;
+	replay = 0;
+	replayFrame = 0;
+	benchmarking = false;
+	benchmarkFrameStart = 0.0;
+	totalTime = 0.0f;
+	deltaTime = 0.0f;
+	startTime = 0.0;
+	currentTime = 0.0;
+	previousTime = 0.0;
 }
 
 // --------------------------------------------------------
@@ -69,12 +134,26 @@ DXCore::DXCore(
 DXCore::~DXCore()
 {
 	// Release all DirectX resources
-	if (depthStencilView) { depthStencilView->Release(); }
 	if (backBufferRTV) { backBufferRTV->Release();}
 
+	if (frameLatencyWaitable) { CloseHandle(frameLatencyWaitable); }
 	if (swapChain) { swapChain->Release();}
 	if (context) { context->Release();}
 	if (device) { device->Release();}
+
+	delete recording;
+	delete replay;
+	delete clock;
+}
+
+// --------------------------------------------------------
+// Swaps in a different time source (a fake one for tests)
+// --------------------------------------------------------
+void DXCore::SetClock(GameClock* newClock)
+{
+	delete clock;
+	clock = newClock;
+	pacer.SetClock(clock);
 }
 
 // --------------------------------------------------------
@@ -174,9 +253,9 @@ HRESULT DXCore::InitDirectX()
 #endif
 
 	// Create a description of how our swap
-	// chain should work
+	// chain should work (the swap effect, buffer
+	// count and flags are filled in below)
 	DXGI_SWAP_CHAIN_DESC swapDesc = {};
-	swapDesc.BufferCount = 1;
 	swapDesc.BufferDesc.Width = width;
 	swapDesc.BufferDesc.Height = height;
 	swapDesc.BufferDesc.RefreshRate.Numerator = 60;
@@ -185,32 +264,72 @@ HRESULT DXCore::InitDirectX()
 	swapDesc.BufferDesc.ScanlineOrdering = DXGI_MODE_SCANLINE_ORDER_UNSPECIFIED;
 	swapDesc.BufferDesc.Scaling = DXGI_MODE_SCALING_UNSPECIFIED;
 	swapDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
-	swapDesc.Flags = 0;
 	swapDesc.OutputWindow = hWnd;
 	swapDesc.SampleDesc.Count = 1;
 	swapDesc.SampleDesc.Quality = 0;
-	swapDesc.SwapEffect = DXGI_SWAP_EFFECT_DISCARD;
 	swapDesc.Windowed = true;
 
+	// The flip model hands buffers straight to the compositor
+	// instead of copying them, and (from Windows 8.1) can give us
+	// an event to wait on until it's ready for another frame.
+	// Try the newest first, falling back to the old blt model.
+	UINT waitable = pacingMode == FRAME_PACING_LATENCY ? DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT : 0;
+	struct SwapChainOption
+	{
+		DXGI_SWAP_EFFECT SwapEffect;
+		UINT BufferCount;
+		UINT Flags;
+	};
+	SwapChainOption options[] =
+	{
+		{ DXGI_SWAP_EFFECT_FLIP_DISCARD,	2, waitable },	// Windows 10
+		{ DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL,	2, waitable },	// Windows 8.1
+		{ DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL,	2, 0 },			// Windows 8
+		{ DXGI_SWAP_EFFECT_DISCARD,			1, 0 },			// Windows 7
+	};
+
 	// Result variable for below function calls
-	HRESULT hr = S_OK;
+	HRESULT hr = E_FAIL;
 
 	// Attempt to initialize DirectX
-	hr = D3D11CreateDeviceAndSwapChain(
-		0,							// Video adapter (physical GPU) to use, or null for default
-		D3D_DRIVER_TYPE_HARDWARE,	// We want to use the hardware (GPU)
-		0,							// Used when doing software rendering
-		deviceFlags,				// Any special options
-		0,							// Optional array of possible verisons we want as fallbacks
-		0,							// The number of fallbacks in the above param
-		D3D11_SDK_VERSION,			// Current version of the SDK
-		&swapDesc,					// Address of swap chain options
-		&swapChain,					// Pointer to our Swap Chain pointer
-		&device,					// Pointer to our Device pointer
-		&dxFeatureLevel,			// This will hold the actual feature level the app will use
-		&context);					// Pointer to our Device Context pointer
+	for (unsigned int i = 0; i < ARRAYSIZE(options) && FAILED(hr); i++)
+	{
+		swapDesc.SwapEffect = options[i].SwapEffect;
+		swapDesc.BufferCount = options[i].BufferCount;
+		swapDesc.Flags = options[i].Flags;
+
+		hr = D3D11CreateDeviceAndSwapChain(
+			0,							// Video adapter (physical GPU) to use, or null for default
+			D3D_DRIVER_TYPE_HARDWARE,	// We want to use the hardware (GPU)
+			0,							// Used when doing software rendering
+			deviceFlags,				// Any special options
+			0,							// Optional array of possible verisons we want as fallbacks
+			0,							// The number of fallbacks in the above param
+			D3D11_SDK_VERSION,			// Current version of the SDK
+			&swapDesc,					// Address of swap chain options
+			&swapChain,					// Pointer to our Swap Chain pointer
+			&device,					// Pointer to our Device pointer
+			&dxFeatureLevel,			// This will hold the actual feature level the app will use
+			&context);					// Pointer to our Device Context pointer
+	}
 	if (FAILED(hr)) return hr;
 
+	swapChainBufferCount = swapDesc.BufferCount;
+	swapChainFlags = swapDesc.Flags;
+
+	// In latency mode, only let one frame queue up, and wait for it
+	// to be taken before starting the next (see Run())
+	if (swapChainFlags & DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT)
+	{
+		IDXGISwapChain2* swapChain2 = 0;
+		if (SUCCEEDED(swapChain->QueryInterface(__uuidof(IDXGISwapChain2), (void**)&swapChain2)))
+		{
+			swapChain2->SetMaximumFrameLatency(1);
+			frameLatencyWaitable = swapChain2->GetFrameLatencyWaitableObject();
+			swapChain2->Release();
+		}
+	}
+
 	// The above function created the back buffer render target
 	// for us, but we need a reference to it
 	ID3D11Texture2D* backBufferTexture;
@@ -228,30 +347,11 @@ HRESULT DXCore::InitDirectX()
 		&backBufferRTV);
 	backBufferTexture->Release();
 
-	// Set up the description of the texture to use for the depth buffer
-	D3D11_TEXTURE2D_DESC depthStencilDesc = {};
-	depthStencilDesc.Width				= width;
-	depthStencilDesc.Height				= height;
-	depthStencilDesc.MipLevels			= 1;
-	depthStencilDesc.ArraySize			= 1;
-	depthStencilDesc.Format				= DXGI_FORMAT_D24_UNORM_S8_UINT;
-	depthStencilDesc.Usage				= D3D11_USAGE_DEFAULT;
-	depthStencilDesc.BindFlags			= D3D11_BIND_DEPTH_STENCIL;
-	depthStencilDesc.CPUAccessFlags		= 0;
-	depthStencilDesc.MiscFlags			= 0;
-	depthStencilDesc.SampleDesc.Count	= 1;
-	depthStencilDesc.SampleDesc.Quality = 0;
-
-	// Create the depth buffer and its view, then 
-	// release our reference to the texture
-	ID3D11Texture2D* depthBufferTexture;
-	device->CreateTexture2D(&depthStencilDesc, 0, &depthBufferTexture);
-	device->CreateDepthStencilView(depthBufferTexture, 0, &depthStencilView);
-	depthBufferTexture->Release();
-
-	// Bind the views to the pipeline, so rendering properly 
-	// uses their underlying textures
-	context->OMSetRenderTargets(1, &backBufferRTV, depthStencilView);
+	// Bind the back buffer to the pipeline.  There's no depth
+	// buffer here: the scene's depth is a render graph texture
+	// (SceneDepth), sized to the render resolution rather than
+	// the window.
+	context->OMSetRenderTargets(1, &backBufferRTV, 0);
 
 	// Lastly, set up a viewport so we render into
 	// to correct portion of the window
@@ -278,17 +378,17 @@ HRESULT DXCore::InitDirectX()
 // --------------------------------------------------------
 void DXCore::OnResize()
 {
-	// Release existing DirectX views and buffers
-	if (depthStencilView) { depthStencilView->Release(); }
+	// Release the existing back buffer view
 	if (backBufferRTV) { backBufferRTV->Release(); }
 
-	// Resize the underlying swap chain buffers
+	// Resize the underlying swap chain buffers (with the same
+	// flags, which resizing isn't allowed to change)
 	swapChain->ResizeBuffers(
-		1,
+		swapChainBufferCount,
 		width,
 		height,
 		DXGI_FORMAT_R8G8B8A8_UNORM,
-		0);
+		swapChainFlags);
 
 	// Recreate the render target view for the back buffer
 	// texture, then release our local texture reference
@@ -297,30 +397,11 @@ void DXCore::OnResize()
 	device->CreateRenderTargetView(backBufferTexture, 0, &backBufferRTV);
 	backBufferTexture->Release();
 
-	// Set up the description of the texture to use for the depth buffer
-	D3D11_TEXTURE2D_DESC depthStencilDesc;
-	depthStencilDesc.Width				= width;
-	depthStencilDesc.Height				= height;
-	depthStencilDesc.MipLevels			= 1;
-	depthStencilDesc.ArraySize			= 1;
-	depthStencilDesc.Format				= DXGI_FORMAT_D24_UNORM_S8_UINT;
-	depthStencilDesc.Usage				= D3D11_USAGE_DEFAULT;
-	depthStencilDesc.BindFlags			= D3D11_BIND_DEPTH_STENCIL;
-	depthStencilDesc.CPUAccessFlags		= 0;
-	depthStencilDesc.MiscFlags			= 0;
-	depthStencilDesc.SampleDesc.Count	= 1;
-	depthStencilDesc.SampleDesc.Quality = 0;
-
-	// Create the depth buffer and its view, then 
-	// release our reference to the texture
-	ID3D11Texture2D* depthBufferTexture;
-	device->CreateTexture2D(&depthStencilDesc, 0, &depthBufferTexture);
-	device->CreateDepthStencilView(depthBufferTexture, 0, &depthStencilView);
-	depthBufferTexture->Release();
-
-	// Bind the views to the pipeline, so rendering properly 
-	// uses their underlying textures
-	context->OMSetRenderTargets(1, &backBufferRTV, depthStencilView);
+	// Bind the back buffer to the pipeline.  There's no depth
+	// buffer here: the scene's depth is a render graph texture
+	// (SceneDepth), sized to the render resolution rather than
+	// the window.
+	context->OMSetRenderTargets(1, &backBufferRTV, 0);
 
 	// Lastly, set up a viewport so we render into
 	// to correct portion of the window
@@ -342,17 +423,29 @@ void DXCore::OnResize()
 // --------------------------------------------------------
 HRESULT DXCore::Run()
 {
-	// Grab the start time now that
-	// the game loop is running
-	__int64 now;
-	QueryPerformanceCounter((LARGE_INTEGER*)&now);
-	startTime = now;
-	currentTime = now;
-	previousTime = now;
-
 	// Give subclass a chance to initialize
 	Init();
 
+	// Start the clock now that the game loop is running (after
+	// Init(), so loading doesn't count as game time).  Game time
+	// always starts from zero, so a benchmark's replay adds up
+	// its frame times exactly the same way on every run.
+	double now = clock->Now();
+	clockOffset = -now;
+	startTime = 0.0;
+	currentTime = 0.0;
+	previousTime = 0.0;
+	timestep.Reset(0.0);
+	pacer.Reset(now);
+	pacingStatsTime = 0.0;
+
+	if (replay)
+	{
+		timestep.Resume(0.0, replay->GetStartAccumulated(), replay->GetStartSimulated());
+		OnReplayStart(replay->GetStartState());
+	}
+	benchmarkFrameStart = now;
+
 	// Our overall game and message loop
 	MSG msg = {};
 	while (msg.message != WM_QUIT)
@@ -365,16 +458,52 @@ HRESULT DXCore::Run()
 			TranslateMessage(&msg);
 			DispatchMessage(&msg);
 		}
+		else if (replay && replayFrame >= replay->GetFrameCount())
+		{
+			// Ran out of recording - back to live input (or, at the
+			// end of a benchmark, out of the game entirely)
+			FinishReplay();
+		}
 		else
 		{
+			// Hold the frame back until the swap chain can take it
+			// (latency mode), and then until it's due.  Starting as
+			// late as possible means its input is as fresh as possible.
+			if (frameLatencyWaitable)
+				WaitForSingleObjectEx(frameLatencyWaitable, 1000, true);
+			pacer.WaitForNextFrame();
+
+			// Last frame's scratch memory is no longer in use
+			FrameArena::ResetAll();
+
 			// Update timer and title bar (if necessary)
 			UpdateTimer();
 			if(titleBarStats)
 				UpdateTitleBarStats();
-
-			// The game loop
-			Update(deltaTime, totalTime);
-			Draw(deltaTime, totalTime);
+			LogPacingStats();
+
+			// Everything that came in since last frame.  A replay swaps
+			// in what came in during the recording instead.
+			input.BeginFrame(currentTime);
+			if (replay)
+			{
+				InputSnapshot snapshot = replay->GetFrame(replayFrame).Input;
+				snapshot.Start = currentTime - deltaTime;
+				snapshot.End = currentTime;
+				input.SetSnapshot(snapshot);
+				replayFrame++;
+			}
+			else if (recording)
+			{
+				recording->AddFrame(deltaTime, input.GetSnapshot());
+			}
+
+			// The game loop - simulate however many whole ticks
+			// have passed, then draw between the last two
+			timestep.Advance(currentTime);
+			while (timestep.Tick())
+				Update(timestep.GetTickLength(), (float)timestep.GetSimulatedTime());
+			Draw(deltaTime, totalTime, timestep.GetInterpolation());
 		}
 	}
 
@@ -384,6 +513,159 @@ HRESULT DXCore::Run()
 }
 
 
+// --------------------------------------------------------
+// Starts recording from the next frame, with whatever the
+// game wants to save about where it's starting from, and
+// where the fixed timestep is between ticks
+// --------------------------------------------------------
+void DXCore::StartRecording()
+{
+	delete recording;
+	recording = new FrameRecording();
+	recording->SetStartTime(timestep.GetAccumulatedTime(), timestep.GetSimulatedTime());
+	OnRecordingStart(recording->GetStartState());
+}
+
+bool DXCore::StopRecording(const char* path)
+{
+	if (!recording)
+		return false;
+
+	bool saved = recording->Save(path);
+	delete recording;
+	recording = 0;
+	return saved;
+}
+
+// --------------------------------------------------------
+// The game (and the fixed timestep) go back to where the
+// recording started right away, and the first recorded
+// frame runs next
+// --------------------------------------------------------
+void DXCore::StartReplay(FrameRecording* newReplay)
+{
+	delete recording;
+	recording = 0;
+	delete replay;
+	replay = newReplay;
+	replayFrame = 0;
+
+	timestep.Resume(currentTime, replay->GetStartAccumulated(), replay->GetStartSimulated());
+	OnReplayStart(replay->GetStartState());
+}
+
+// --------------------------------------------------------
+// Game time carries on from where the replay left it, so
+// nothing sees time jump when the real clock takes over
+// --------------------------------------------------------
+void DXCore::FinishReplay()
+{
+	if (benchmarking)
+	{
+		RecordBenchmarkSample(clock->Now());
+		WriteBenchmarkResults();
+		Quit();
+	}
+
+	clockOffset = currentTime - clock->Now();
+	delete replay;
+	replay = 0;
+	replayFrame = 0;
+}
+
+// --------------------------------------------------------
+// Each frame is timed from its start to the next one's, so
+// this finishes off the last frame of the replay
+// --------------------------------------------------------
+void DXCore::RecordBenchmarkSample(double now)
+{
+	if (replayFrame > 0)
+	{
+		BenchmarkSample sample;
+		sample.SimulatedTime = replay->GetFrame(replayFrame - 1).DeltaTime;
+		sample.FrameTime = (float)(now - benchmarkFrameStart);
+		sample.GPUTime = GetGPUFrameTime();
+		benchmarkSamples.push_back(sample);
+	}
+	benchmarkFrameStart = now;
+}
+
+// --------------------------------------------------------
+// The frame rate limit is turned off for a benchmark, or
+// we'd only be timing how well it holds the limit
+// --------------------------------------------------------
+void DXCore::StartBenchmark(FrameRecording* script, const char* outputName)
+{
+	delete replay;
+	replay = script;
+	replayFrame = 0;
+
+	benchmarking = true;
+	benchmarkOutput = outputName;
+	benchmarkSamples.clear();
+	pacer.SetTargetFPS(0.0f);
+}
+
+// --------------------------------------------------------
+// Every frame goes to the CSV.  The JSON summary gives the
+// mean and percentiles, which are what to compare between
+// runs - the worst frames matter more than the average.
+// GPU times are the latest the game had, which trail the
+// frame they're listed with by a few frames.
+// --------------------------------------------------------
+void DXCore::WriteBenchmarkResults()
+{
+	std::ofstream csv((benchmarkOutput + ".csv").c_str(), std::ios::trunc);
+	csv << "frame,simulated_ms,frame_ms,gpu_ms\n";
+	csv.setf(std::ios::fixed);
+	csv.precision(4);
+	for (unsigned int i = 0; i < benchmarkSamples.size(); i++)
+	{
+		const BenchmarkSample& sample = benchmarkSamples[i];
+		csv << i << "," << sample.SimulatedTime * 1000.0f << "," << sample.FrameTime * 1000.0f << "," << sample.GPUTime * 1000.0f << "\n";
+	}
+
+	std::vector<float> frameTimes(benchmarkSamples.size());
+	std::vector<float> gpuTimes(benchmarkSamples.size());
+	double frameTotal = 0.0;
+	double gpuTotal = 0.0;
+	for (unsigned int i = 0; i < benchmarkSamples.size(); i++)
+	{
+		frameTimes[i] = benchmarkSamples[i].FrameTime * 1000.0f;
+		gpuTimes[i] = benchmarkSamples[i].GPUTime * 1000.0f;
+		frameTotal += frameTimes[i];
+		gpuTotal += gpuTimes[i];
+	}
+	std::sort(frameTimes.begin(), frameTimes.end());
+	std::sort(gpuTimes.begin(), gpuTimes.end());
+
+	unsigned int count = frameTimes.size();
+	std::ofstream json((benchmarkOutput + ".json").c_str(), std::ios::trunc);
+	json.setf(std::ios::fixed);
+	json.precision(4);
+	json << "{\n\t\"frames\": " << count << ",\n";
+	json << "\t\"seconds\": " << frameTotal / 1000.0 << ",\n";
+
+	const char* names[2] = { "frame_ms", "gpu_ms" };
+	std::vector<float>* times[2] = { &frameTimes, &gpuTimes };
+	double totals[2] = { frameTotal, gpuTotal };
+	for (unsigned int t = 0; t < 2; t++)
+	{
+		const std::vector<float>& sorted = *times[t];
+		json << "\t\"" << names[t] << "\": { ";
+		json << "\"mean\": " << (count > 0 ? totals[t] / count : 0.0) << ", ";
+		json << "\"p50\": " << (count > 0 ? sorted[count * 50 / 100] : 0.0f) << ", ";
+		json << "\"p95\": " << (count > 0 ? sorted[count * 95 / 100] : 0.0f) << ", ";
+		json << "\"p99\": " << (count > 0 ? sorted[count * 99 / 100] : 0.0f) << ", ";
+		json << "\"max\": " << (count > 0 ? sorted[count - 1] : 0.0f) << " }";
+		json << (t == 0 ? ",\n" : "\n");
+	}
+	json << "}\n";
+
+	printf("\nBenchmark: %u frames, mean %.3fms - written to %s.csv and %s.json",
+		count, count > 0 ? frameTotal / count : 0.0, benchmarkOutput.c_str(), benchmarkOutput.c_str());
+}
+
 // --------------------------------------------------------
 // Sends an OS-level Quit message to our process, which
 // will be handled by our message processing function
@@ -400,18 +682,24 @@ void DXCore::Quit()
 // --------------------------------------------------------
 void DXCore::UpdateTimer()
 {
-	// Grab the current time
-	__int64 now;
-	QueryPerformanceCounter((LARGE_INTEGER*)&now);
-	currentTime = now;
+	// Grab the current time.  Replays step through the recorded
+	// frame times instead, however long each frame really takes.
+	double now = clock->Now();
+	if (replay)
+		currentTime = previousTime + replay->GetFrame(replayFrame).DeltaTime;
+	else
+		currentTime = now + clockOffset;
+
+	if (benchmarking)
+		RecordBenchmarkSample(now);
 
 	// Calculate delta time and clamp to zero
 	//  - Could go negative if CPU goes into power save mode 
 	//    or the process itself gets moved to another core
-	deltaTime = max((float)((currentTime - previousTime) * perfCounterSeconds), 0.0f);
+	deltaTime = max((float)(currentTime - previousTime), 0.0f);
 
 	// Calculate the total time from start to now
-	totalTime = (float)((currentTime - startTime) * perfCounterSeconds);
+	totalTime = (float)(currentTime - startTime);
 
 	// Save current time for next frame
 	previousTime = currentTime;
@@ -444,7 +732,8 @@ void DXCore::UpdateTitleBarStats()
 		"    Width: "		<< width <<
 		"    Height: "		<< height <<
 		"    FPS: "			<< fpsFrameCount <<
-		"    Frame Time: "	<< mspf << "ms";
+		"    Frame Time: "	<< mspf << "ms" <<
+		"    Frame Arena: "	<< FrameArena::GetPeakHighWaterAll() / 1024 << "KB";
 
 	// Append the version of DirectX the app is using
 	switch (dxFeatureLevel)
@@ -465,6 +754,29 @@ void DXCore::UpdateTitleBarStats()
 	fpsTimeElapsed += 1.0f;
 }
 
+// --------------------------------------------------------
+// Prints how even frame times have been every few seconds.
+// The mean alone hides stutter - a steady 60fps and one
+// that alternates 8ms and 25ms frames look the same - so
+// the spread is what to watch.
+// --------------------------------------------------------
+void DXCore::LogPacingStats()
+{
+	if (currentTime - pacingStatsTime < PACING_STATS_INTERVAL)
+		return;
+	pacingStatsTime = currentTime;
+
+	FrameTimeStats stats = pacer.TakeStats();
+	printf("\nFrame times over %u frames (target %.0f fps, %s): mean %.2fms, std dev %.2fms, min %.2fms, max %.2fms",
+		stats.Frames,
+		pacer.GetTargetFPS(),
+		pacingMode == FRAME_PACING_LATENCY ? "latency" : "throughput",
+		stats.Mean * 1000.0,
+		stats.StdDev * 1000.0,
+		stats.Min * 1000.0,
+		stats.Max * 1000.0);
+}
+
 // --------------------------------------------------------
 // Allocates a console window we can print to for debugging
 // 
@@ -507,6 +819,23 @@ void DXCore::CreateConsoleWindow(int bufferLines, int bufferColumns, int windowL
 
 
 
+// --------------------------------------------------------
+// Events are timed on the game clock as they're dispatched.
+// Windows' own message times are on its tick count, which
+// only moves every 10-16ms - coarser than a frame - so
+// they'd say less than this does.
+// --------------------------------------------------------
+void DXCore::PushInput(InputEventType type, unsigned char key, int x, int y)
+{
+	InputEvent inputEvent;
+	inputEvent.Time = clock->Now() + clockOffset;
+	inputEvent.X = x;
+	inputEvent.Y = y;
+	inputEvent.Type = (unsigned char)type;
+	inputEvent.Key = key;
+	input.Push(inputEvent);
+}
+
 // --------------------------------------------------------
 // Handles messages that are sent to our window by the
 // operating system.  Ignoring these messages would cause
@@ -546,10 +875,31 @@ LRESULT DXCore::ProcessMessage(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lPara
 
 		return 0;
 
+	// A key going down or up.  Bit 30 is set on auto-repeats of a
+	// key that's already down, which the input queue doesn't need.
+	case WM_KEYDOWN:
+	case WM_SYSKEYDOWN:
+		if (!(lParam & (1 << 30)))
+			PushInput(INPUT_KEY_DOWN, (unsigned char)wParam, 0, 0);
+		break;
+
+	case WM_KEYUP:
+	case WM_SYSKEYUP:
+		PushInput(INPUT_KEY_UP, (unsigned char)wParam, 0, 0);
+		break;
+
+	// We won't hear about keys being released while another window
+	// has focus, so let go of them all now
+	case WM_KILLFOCUS:
+		PushInput(INPUT_FOCUS_LOST, 0, 0, 0);
+		break;
+
 	// Mouse button being pressed (while the cursor is currently over our window)
 	case WM_LBUTTONDOWN:
 	case WM_MBUTTONDOWN:
 	case WM_RBUTTONDOWN:
+		PushInput(INPUT_MOUSE_MOVE, 0, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
+		PushInput(INPUT_KEY_DOWN, uMsg == WM_LBUTTONDOWN ? VK_LBUTTON : uMsg == WM_RBUTTONDOWN ? VK_RBUTTON : VK_MBUTTON, 0, 0);
 		OnMouseDown(wParam, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
 		return 0;
 
@@ -557,16 +907,20 @@ LRESULT DXCore::ProcessMessage(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lPara
 	case WM_LBUTTONUP:
 	case WM_MBUTTONUP:
 	case WM_RBUTTONUP:
+		PushInput(INPUT_MOUSE_MOVE, 0, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
+		PushInput(INPUT_KEY_UP, uMsg == WM_LBUTTONUP ? VK_LBUTTON : uMsg == WM_RBUTTONUP ? VK_RBUTTON : VK_MBUTTON, 0, 0);
 		OnMouseUp(wParam, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
 		return 0;
 
 	// Cursor moves over the window (or outside, while we're currently capturing it)
 	case WM_MOUSEMOVE:
+		PushInput(INPUT_MOUSE_MOVE, 0, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
 		OnMouseMove(wParam, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
 		return 0;
 
 	// Mouse wheel is scrolled
 	case WM_MOUSEWHEEL:
+		PushInput(INPUT_MOUSE_WHEEL, 0, GET_WHEEL_DELTA_WPARAM(wParam), 0);
 		OnMouseWheel(GET_WHEEL_DELTA_WPARAM(wParam) / (float)WHEEL_DELTA, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
 		return 0;
 	}
@@ -3,6 +3,12 @@
 #include <Windows.h>
 #include <d3d11.h>
 #include <string>
+#include "FixedTimestep.h"
+#include "FramePacer.h"
+#include "Input.h"
+#include "FrameRecording.h"
+#include "DepthMode.h"
+#include <vector>
 
 // We can include the correct library files here
 // instead of in Visual Studio settings if we want
@@ -37,11 +43,21 @@ public:
 	HRESULT Run();				
 	void Quit();
 	virtual void OnResize();
+
+	// Replays the script (taking ownership) as fast as possible once
+	// Run() starts, writes each frame's timing to <outputName>.csv
+	// and a summary to <outputName>.json, then quits
+	void StartBenchmark(FrameRecording* script, const char* outputName);
+	bool IsBenchmarking() { return benchmarking; }
 	
 	// Pure virtual methods for setup and game functionality
-	virtual void Init()										= 0;
-	virtual void Update(float deltaTime, float totalTime)	= 0;
-	virtual void Draw(float deltaTime, float totalTime)		= 0;
+	//  - Update() runs once per fixed tick, so deltaTime is always
+	//    the tick length and totalTime the simulated time
+	//  - Draw() runs once per frame with the real frame time, and
+	//    how far (0 to 1) the frame is from the last tick to the next
+	virtual void Init()																= 0;
+	virtual void Update(float deltaTime, float totalTime)							= 0;
+	virtual void Draw(float deltaTime, float totalTime, float interpolation)		= 0;
 
 	// Convenience methods for handling mouse input, since we
 	// can easily grab mouse input from OS-level messages
@@ -49,6 +65,14 @@ public:
 	virtual void OnMouseUp	 (WPARAM buttonState, int x, int y) { }
 	virtual void OnMouseMove (WPARAM buttonState, int x, int y) { }
 	virtual void OnMouseWheel(float wheelDelta,   int x, int y) { }
+
+	// Hooks for recordings - saving and restoring whatever the game
+	// needs to start a replay from the same place as the recording
+	virtual void OnRecordingStart(std::vector<unsigned char>& startState) { }
+	virtual void OnReplayStart(const std::vector<unsigned char>& startState) { }
+
+	// The latest GPU frame time the game has measured, for benchmarks
+	virtual float GetGPUFrameTime() { return 0.0f; }
 	
 protected:
 	HINSTANCE	hInstance;		// The handle to the application
@@ -67,25 +91,93 @@ protected:
 	ID3D11DeviceContext*	context;
 
 	ID3D11RenderTargetView* backBufferRTV;
-	ID3D11DepthStencilView* depthStencilView;
 
 	// Helper function for allocating a console window
 	void CreateConsoleWindow(int bufferLines, int bufferColumns, int windowLines, int windowColumns);
 
+	// Splits real time into fixed simulation ticks (60 per second
+	// by default).  Set its rate before Run() or at any time after.
+	FixedTimestep timestep;
+
+	// Holds each frame back until it's due.  Unlimited by default;
+	// set a target frame rate before Run() or at any time after.
+	FramePacer pacer;
+
+	// Latency or throughput - picks the swap chain, so it has to be
+	// set before InitDirectX()
+	FramePacingMode pacingMode;
+
+	// Which way depth runs.  The game's depth buffer, depth tests
+	// and projection all follow it, so set it before Init().
+	DepthMode depthMode;
+
+	// Keyboard and mouse events, collected from window messages as
+	// they come in.  Each frame's snapshot is ready before Update().
+	Input input;
+
+	// Recording input and frame times, and replaying them (each from
+	// the next frame).  A replay takes ownership of the recording.
+	void StartRecording();
+	bool StopRecording(const char* path);
+	void StartReplay(FrameRecording* recording);
+	bool IsRecording() { return recording != 0; }
+	bool IsReplaying() { return replay != 0; }
+
+	// Replaces where the loop gets its time from (before Run()).
+	// We take ownership of the clock.
+	void SetClock(GameClock* newClock);
+
 private:
-	// Timing related data
-	double perfCounterSeconds;
+	// Timing related data.  Game time starts at zero when Run()
+	// does, and follows the clock except during replays.
+	GameClock* clock;
+	double clockOffset;			// Game time minus clock time
 	float totalTime;
 	float deltaTime;
-	__int64 startTime;
-	__int64 currentTime;
-	__int64 previousTime;
+	double startTime;
+	double currentTime;
+	double previousTime;
 
 	// FPS calculation
 	int fpsFrameCount;
 	float fpsTimeElapsed;
+
+	// Frame time variance, logged every few seconds
+	double pacingStatsTime;
+
+	// Swap chain setup, which resizing has to match
+	UINT swapChainBufferCount;
+	UINT swapChainFlags;
+
+	// Recording and replay
+	FrameRecording* recording;
+	FrameRecording* replay;
+	unsigned int replayFrame;
+
+	// Benchmark results, one per frame
+	struct BenchmarkSample
+	{
+		float SimulatedTime;	// The recorded frame time
+		float FrameTime;		// How long the frame really took
+		float GPUTime;
+	};
+	bool benchmarking;
+	std::string benchmarkOutput;
+	std::vector<BenchmarkSample> benchmarkSamples;
+	double benchmarkFrameStart;
+
+	// Signaled when the swap chain can take another frame (flip
+	// model in latency mode only, otherwise null)
+	HANDLE frameLatencyWaitable;
 	
 	void UpdateTimer();			// Updates the timer for this frame
 	void UpdateTitleBarStats();	// Puts debug info in the title bar
+	void LogPacingStats();		// Prints frame time stats to the console
+	void FinishReplay();
+	void RecordBenchmarkSample(double now);
+	void WriteBenchmarkResults();
+
+	// Queues an input event, stamped with when the current message was sent
+	void PushInput(InputEventType type, unsigned char key, int x, int y);
 };
 
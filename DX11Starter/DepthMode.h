@@ -0,0 +1,47 @@
+#pragma once
+
+#include <d3d11.h>
+
+// --------------------------------------------------------
+// How depth is stored and compared.
+//
+// Standard depth maps the near plane to 0 and the far plane
+// (100 units out) to 1, in a 24 bit depth buffer.  Nearly
+// all of its precision ends up right in front of the near
+// plane, so distant surfaces z-fight.
+//
+// Reverse Z maps the near plane to 1 and infinity to 0, in
+// a floating point buffer.  The float's exponent puts its
+// precision near 0, which cancels out the projection's
+// bunching, so precision stays roughly even all the way
+// out - and with no far plane, there's nothing to tune per
+// scene.  Nearer means greater, so the test flips.
+// --------------------------------------------------------
+enum DepthMode
+{
+	DEPTH_STANDARD,
+	DEPTH_REVERSE_Z
+};
+
+inline DXGI_FORMAT DepthBufferFormat(DepthMode mode)
+{
+	return mode == DEPTH_REVERSE_Z ? DXGI_FORMAT_D32_FLOAT : DXGI_FORMAT_D24_UNORM_S8_UINT;
+}
+
+// What the depth buffer is cleared to (the farthest possible depth)
+inline float DepthClearValue(DepthMode mode)
+{
+	return mode == DEPTH_REVERSE_Z ? 0.0f : 1.0f;
+}
+
+// D32_FLOAT has no stencil to clear
+inline UINT DepthClearFlags(DepthMode mode)
+{
+	return mode == DEPTH_REVERSE_Z ? D3D11_CLEAR_DEPTH : D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL;
+}
+
+// Passes when the new pixel is nearer than what's there
+inline D3D11_COMPARISON_FUNC DepthCompareFunc(DepthMode mode)
+{
+	return mode == DEPTH_REVERSE_Z ? D3D11_COMPARISON_GREATER : D3D11_COMPARISON_LESS;
+}
@@ -0,0 +1,195 @@
+#include "DepthPrepass.h"
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Constructor - Loads the prepass shader for the pool's
+// vertex format and creates the occlusion queries
+// --------------------------------------------------------
+DepthPrepass::DepthPrepass(ID3D11Device* device, ID3D11DeviceContext* context, PipelineStateCache* stateCache, VertexStreamFormat vertexFormat, DepthMode depthMode, const DepthPrepassSettings& settings)
+{
+	this->device = device;
+	this->context = context;
+	this->stateCache = stateCache;
+	this->depthMode = depthMode;
+	this->settings = settings;
+
+	frame = 0;
+	measuring = false;
+	measured = false;
+	overdraw = 0.0f;
+	enabled = settings.Mode == DEPTH_PREPASS_ON;
+
+	// Input layouts come from the position stream's format
+	if (vertexFormat == VERTEX_STREAM_QUANTIZED)
+	{
+		vertexShaders = new ShaderVariantCache<SimpleVertexShader>(device, context, L"QuantizedDepthPrepassVertexShader", stateCache);
+		vertexShaders->SetVertexFormat<QuantizedPositionVertex>();
+	}
+	else
+	{
+		vertexShaders = new ShaderVariantCache<SimpleVertexShader>(device, context, L"DepthPrepassVertexShader", stateCache);
+		vertexShaders->SetVertexFormat<PositionVertex>();
+	}
+
+	// Writes depth like any opaque pass, with no pixel shader at all
+	D3D11_DEPTH_STENCIL_DESC depthDesc = PipelineStateCache::DefaultDepthStencilDesc();
+	depthDesc.DepthFunc = DepthCompareFunc(depthMode);
+
+	// Without its shader there's no prepass at all, rather than
+	// a prepass drawn with a shader that expects other vertices
+	SimpleVertexShader* prepassVS = vertexShaders->Get(SHADER_FEATURES_DEFAULT);
+	if (!prepassVS)
+	{
+		this->settings.Mode = DEPTH_PREPASS_OFF;
+		enabled = false;
+	}
+
+	prepassState = stateCache->GetPipelineState(
+		prepassVS,
+		0,
+		stateCache->GetRasterizerState(PipelineStateCache::DefaultRasterizerDesc()),
+		stateCache->GetBlendState(PipelineStateCache::DefaultBlendDesc()),
+		stateCache->GetDepthStencilState(depthDesc));
+
+	// A frame whose query failed to create is never measured
+	D3D11_QUERY_DESC queryDesc = {};
+	queryDesc.Query = D3D11_QUERY_OCCLUSION;
+	for (unsigned int i = 0; i < QueryCount; i++)
+	{
+		queries[i].Query = 0;
+		queries[i].PixelCount = 0;
+		queries[i].Pending = false;
+		device->CreateQuery(&queryDesc, &queries[i].Query);
+	}
+}
+
+// --------------------------------------------------------
+// Destructor - The pipeline state belongs to the state cache
+// --------------------------------------------------------
+DepthPrepass::~DepthPrepass()
+{
+	for (unsigned int i = 0; i < QueryCount; i++)
+	{
+		if (queries[i].Query) { queries[i].Query->Release(); }
+	}
+
+	delete vertexShaders;
+}
+
+// --------------------------------------------------------
+// Depth is already final, so shading only has to find the
+// fragments that made it there (and leave depth alone)
+// --------------------------------------------------------
+D3D11_DEPTH_STENCIL_DESC DepthPrepass::GetShadingDepthDesc()
+{
+	D3D11_DEPTH_STENCIL_DESC depthDesc = PipelineStateCache::DefaultDepthStencilDesc();
+	depthDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+	depthDesc.DepthFunc = D3D11_COMPARISON_EQUAL;
+	return depthDesc;
+}
+
+void DepthPrepass::Begin()
+{
+	stateCache->Bind(prepassState);
+}
+
+void DepthPrepass::PrepareObject(const XMFLOAT4X4& worldViewProj, Mesh* mesh)
+{
+	SimpleVertexShader* vs = prepassState->VertexShader;
+	vs->SetMatrix4x4("worldViewProj", worldViewProj);
+
+	// Quantized meshes store positions relative to their bounds
+	if (mesh && mesh->IsQuantized())
+	{
+		vs->SetFloat3("positionCenter", mesh->GetQuantization().PositionCenter);
+		vs->SetFloat3("positionExtent", mesh->GetQuantization().PositionExtent);
+	}
+
+	vs->CopyAllBufferData();
+}
+
+// --------------------------------------------------------
+// Skips measuring this frame if the GPU hasn't finished
+// with the frame that used this query last time around
+// --------------------------------------------------------
+void DepthPrepass::BeginMeasuring()
+{
+	OverdrawQuery& query = queries[frame % QueryCount];
+	measuring = query.Query && !query.Pending;
+	if (measuring)
+		context->Begin(query.Query);
+}
+
+void DepthPrepass::EndMeasuring(unsigned int pixelCount)
+{
+	if (measuring)
+	{
+		OverdrawQuery& query = queries[frame % QueryCount];
+		context->End(query.Query);
+		query.PixelCount = pixelCount;
+		query.Pending = true;
+		measuring = false;
+	}
+	frame++;
+
+	ReadQueries();
+}
+
+// --------------------------------------------------------
+// Folds every finished measurement, oldest first, into the
+// overdraw estimate, then decides on the next frames.  The
+// gap between the two thresholds stops it flipping back and
+// forth when overdraw sits right around one of them.
+// --------------------------------------------------------
+void DepthPrepass::ReadQueries()
+{
+	for (unsigned int i = QueryCount; i > 0; i--)
+	{
+		OverdrawQuery& query = queries[(frame - i) % QueryCount];
+		if (!query.Pending)
+			continue;
+
+		UINT64 samples = 0;
+		if (context->GetData(query.Query, &samples, sizeof(samples), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+			break;
+		query.Pending = false;
+
+		if (query.PixelCount == 0)
+			continue;
+
+		float sample = (float)((double)samples / query.PixelCount);
+		overdraw = measured ? overdraw + (sample - overdraw) * settings.Smoothing : sample;
+		measured = true;
+	}
+
+	switch (settings.Mode)
+	{
+	case DEPTH_PREPASS_OFF:
+		enabled = false;
+		break;
+
+	case DEPTH_PREPASS_ON:
+		enabled = true;
+		break;
+
+	case DEPTH_PREPASS_AUTO:
+		if (!measured)
+			break;
+		if (!enabled && overdraw > settings.EnableOverdraw)
+			enabled = true;
+		else if (enabled && overdraw < settings.DisableOverdraw)
+			enabled = false;
+		break;
+	}
+}
+
+void DepthPrepass::WatchForChanges(AssetWatcher* assetWatcher)
+{
+	vertexShaders->WatchForChanges(assetWatcher);
+}
+
+bool DepthPrepass::ReloadShader(const std::wstring& path)
+{
+	return vertexShaders->Reload(path);
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <d3d11.h>
+#include <DirectXMath.h>
+#include <string>
+#include "ShaderVariants.h"
+#include "PipelineStateCache.h"
+#include "AssetWatcher.h"
+#include "SimpleShader.h"
+#include "GeometryPool.h"
+#include "DepthMode.h"
+#include "Mesh.h"
+
+// --------------------------------------------------------
+// Whether to lay depth down before shading
+// --------------------------------------------------------
+enum DepthPrepassMode
+{
+	DEPTH_PREPASS_OFF,
+	DEPTH_PREPASS_ON,
+	DEPTH_PREPASS_AUTO		// On while measured overdraw is high
+};
+
+struct DepthPrepassSettings
+{
+	DepthPrepassMode Mode;
+	float EnableOverdraw;		// Turn on above this many fragments per pixel...
+	float DisableOverdraw;		// ...and back off below this many
+	float Smoothing;			// 0 - 1, how much each frame moves the estimate
+};
+
+// --------------------------------------------------------
+// An optional depth only pass over the opaque entities,
+// drawn from the position stream with no pixel shader.
+// Shading then tests for EQUAL depth, so the (expensive)
+// pixel shader runs once per visible pixel rather than
+// once per fragment drawn.
+//
+// The prepass isn't free - every vertex is transformed
+// twice - so in AUTO mode it's only used while overdraw
+// is high enough to pay for it.  Overdraw is measured
+// with an occlusion query around whichever pass writes
+// depth: with early depth testing, fragments passing the
+// depth test while depth is laid down are exactly the
+// fragments a shading pass without a prepass would shade.
+// Results are read a few frames late, like the timers in
+// DynamicResolution.
+//
+// Each frame: IsEnabled() decides the passes.  Wrap the
+// pass writing depth in BeginMeasuring()/EndMeasuring().
+// For the prepass itself, Begin() and then PrepareObject()
+// before each draw.
+// --------------------------------------------------------
+class DepthPrepass
+{
+public:
+	DepthPrepass(ID3D11Device* device, ID3D11DeviceContext* context, PipelineStateCache* stateCache, VertexStreamFormat vertexFormat, DepthMode depthMode, const DepthPrepassSettings& settings);
+	~DepthPrepass();
+
+	// Should this frame draw the prepass?  Ask once at the start
+	// of the frame - EndMeasuring() decides for the next one.
+	bool IsEnabled() { return enabled; }
+
+	// The depth state shading should use over a prepass
+	D3D11_DEPTH_STENCIL_DESC GetShadingDepthDesc();
+
+	// Binds the prepass pipeline state
+	void Begin();
+
+	// Per object data, ahead of its draw (transposed, as for HLSL)
+	void PrepareObject(const DirectX::XMFLOAT4X4& worldViewProj, Mesh* mesh);
+
+	// Counts fragments passing the depth test in between.  pixelCount
+	// is the area drawn to, to turn that count into overdraw.
+	void BeginMeasuring();
+	void EndMeasuring(unsigned int pixelCount);
+
+	float GetOverdraw() { return overdraw; }
+	DepthPrepassSettings& GetSettings() { return settings; }
+
+	// Hot reloading of the prepass shader
+	void WatchForChanges(AssetWatcher* assetWatcher);
+	bool ReloadShader(const std::wstring& path);
+
+private:
+	// One frame's occlusion query, and the area it covered
+	struct OverdrawQuery
+	{
+		ID3D11Query* Query;
+		unsigned int PixelCount;
+		bool Pending;
+	};
+	static const unsigned int QueryCount = 4;
+
+	ID3D11Device* device;
+	ID3D11DeviceContext* context;
+	PipelineStateCache* stateCache;
+	DepthMode depthMode;
+	DepthPrepassSettings settings;
+
+	ShaderVariantCache<SimpleVertexShader>* vertexShaders;
+	const PipelineState* prepassState;
+
+	OverdrawQuery queries[QueryCount];
+	unsigned int frame;
+	bool measuring;				// Is this frame being measured?
+	bool measured;				// Has overdraw been measured at all yet?
+	float overdraw;				// Smoothed, fragments per pixel
+	bool enabled;
+
+	void ReadQueries();
+};
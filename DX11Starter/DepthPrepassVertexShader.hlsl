@@ -0,0 +1,19 @@
+// Depth prepass: just the position stream (PositionVertex,
+// see GeometryPool), and no pixel shader.  The position
+// math has to match VertexShader.hlsl exactly, so the
+// shading pass's EQUAL depth test passes (hence precise).
+cbuffer externalData : register(b0)
+{
+	matrix worldViewProj;
+};
+
+struct VertexShaderInput
+{
+	float3 position		: POSITION;
+};
+
+float4 main( VertexShaderInput input ) : SV_POSITION
+{
+	precise float4 position = mul(float4(input.position, 1.0f), worldViewProj);
+	return position;
+}
@@ -0,0 +1,239 @@
+#include "DynamicResolution.h"
+
+// --------------------------------------------------------
+// Constructor - Loads the upscale pass and creates the
+// timer queries.  The size comes with the first Resize().
+// --------------------------------------------------------
+DynamicResolution::DynamicResolution(ID3D11Device* device, ID3D11DeviceContext* context, PipelineStateCache* stateCache, const ResolutionGovernorSettings& settings, DepthMode depthMode)
+	: governor(settings)
+{
+	this->device = device;
+	this->context = context;
+	this->stateCache = stateCache;
+	this->depthMode = depthMode;
+
+	outputWidth = 0;
+	outputHeight = 0;
+	renderWidth = 0;
+	renderHeight = 0;
+	frame = 0;
+	timing = false;
+	lastGPUTime = 0.0f;
+
+	vertexShaders = new ShaderVariantCache<SimpleVertexShader>(device, context, L"FullscreenVertexShader", stateCache);
+	pixelShaders = new ShaderVariantCache<SimplePixelShader>(device, context, L"UpscalePixelShader", stateCache);
+
+	// Nothing to test against, so no depth
+	D3D11_DEPTH_STENCIL_DESC depthDesc = PipelineStateCache::DefaultDepthStencilDesc();
+	depthDesc.DepthEnable = false;
+	depthDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+
+	// Both shaders or nothing - EndScene() skips the upscale
+	// without them, rather than drawing with half a pipeline
+	upscaleState = 0;
+	SimpleVertexShader* upscaleVS = vertexShaders->Get(SHADER_FEATURES_DEFAULT);
+	SimplePixelShader* upscalePS = pixelShaders->Get(SHADER_FEATURES_DEFAULT);
+	if (upscaleVS && upscalePS)
+	{
+		upscaleState = stateCache->GetPipelineState(
+			upscaleVS,
+			upscalePS,
+			stateCache->GetRasterizerState(PipelineStateCache::DefaultRasterizerDesc()),
+			stateCache->GetBlendState(PipelineStateCache::DefaultBlendDesc()),
+			stateCache->GetDepthStencilState(depthDesc));
+	}
+
+	D3D11_SAMPLER_DESC sampDesc = {};
+	sampDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+	sampDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+	sampDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+	sampDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+	sampDesc.MaxLOD = D3D11_FLOAT32_MAX;
+	linearClamp = stateCache->GetSamplerState(sampDesc);
+
+	// A timer missing any of its queries is never used
+	D3D11_QUERY_DESC disjointDesc = {};
+	disjointDesc.Query = D3D11_QUERY_TIMESTAMP_DISJOINT;
+	D3D11_QUERY_DESC timestampDesc = {};
+	timestampDesc.Query = D3D11_QUERY_TIMESTAMP;
+	for (unsigned int i = 0; i < TimerCount; i++)
+	{
+		timers[i].Disjoint = 0;
+		timers[i].Start = 0;
+		timers[i].End = 0;
+		timers[i].Pending = false;
+
+		device->CreateQuery(&disjointDesc, &timers[i].Disjoint);
+		device->CreateQuery(&timestampDesc, &timers[i].Start);
+		device->CreateQuery(&timestampDesc, &timers[i].End);
+	}
+}
+
+// --------------------------------------------------------
+// Destructor - The sampler and pipeline state belong to
+// the state cache
+// --------------------------------------------------------
+DynamicResolution::~DynamicResolution()
+{
+	for (unsigned int i = 0; i < TimerCount; i++)
+	{
+		if (timers[i].Disjoint) { timers[i].Disjoint->Release(); }
+		if (timers[i].Start) { timers[i].Start->Release(); }
+		if (timers[i].End) { timers[i].End->Release(); }
+	}
+
+	delete vertexShaders;
+	delete pixelShaders;
+}
+
+void DynamicResolution::Resize(unsigned int width, unsigned int height)
+{
+	outputWidth = width > 0 ? width : 1;
+	outputHeight = height > 0 ? height : 1;
+}
+
+// --------------------------------------------------------
+// The color target matches the back buffer's format, and
+// the depth buffer DXCore's, so rendering into them works
+// exactly like rendering to the screen
+// --------------------------------------------------------
+RenderTextureDesc DynamicResolution::GetSceneColorDesc()
+{
+	RenderTextureDesc desc;
+	desc.Width = outputWidth;
+	desc.Height = outputHeight;
+	desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	desc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+	return desc;
+}
+
+RenderTextureDesc DynamicResolution::GetSceneDepthDesc()
+{
+	RenderTextureDesc desc;
+	desc.Width = outputWidth;
+	desc.Height = outputHeight;
+	desc.Format = DepthBufferFormat(depthMode);
+	desc.BindFlags = D3D11_BIND_DEPTH_STENCIL;
+	return desc;
+}
+
+// --------------------------------------------------------
+// Whoever draws first should clear the whole target, not
+// just the viewport, so a scale change never shows stale
+// pixels along the edges
+// --------------------------------------------------------
+void DynamicResolution::BeginScene()
+{
+	float scale = governor.GetScale();
+	renderWidth = (unsigned int)(outputWidth * scale + 0.5f);
+	renderHeight = (unsigned int)(outputHeight * scale + 0.5f);
+	if (renderWidth < 1) renderWidth = 1;
+	if (renderHeight < 1) renderHeight = 1;
+	if (renderWidth > outputWidth) renderWidth = outputWidth;
+	if (renderHeight > outputHeight) renderHeight = outputHeight;
+
+	D3D11_VIEWPORT viewport = {};
+	viewport.Width = (float)renderWidth;
+	viewport.Height = (float)renderHeight;
+	viewport.MinDepth = 0.0f;
+	viewport.MaxDepth = 1.0f;
+	context->RSSetViewports(1, &viewport);
+
+	// Skip timing this frame if the GPU hasn't even finished the
+	// frame that used this timer last time around
+	FrameTimer& timer = timers[frame % TimerCount];
+	timing = timer.Disjoint && timer.Start && timer.End && !timer.Pending;
+	if (timing)
+	{
+		context->Begin(timer.Disjoint);
+		context->End(timer.Start);
+	}
+}
+
+void DynamicResolution::EndScene(ID3D11ShaderResourceView* scene, ID3D11RenderTargetView* output)
+{
+	if (timing)
+	{
+		FrameTimer& timer = timers[frame % TimerCount];
+		context->End(timer.End);
+		context->End(timer.Disjoint);
+		timer.Pending = true;
+	}
+	frame++;
+
+	// Stretch the rendered corner over the whole output
+	context->OMSetRenderTargets(1, &output, 0);
+
+	D3D11_VIEWPORT viewport = {};
+	viewport.Width = (float)outputWidth;
+	viewport.Height = (float)outputHeight;
+	viewport.MinDepth = 0.0f;
+	viewport.MaxDepth = 1.0f;
+	context->RSSetViewports(1, &viewport);
+
+	if (!upscaleState)
+	{
+		ReadTimers();
+		return;
+	}
+
+	stateCache->Bind(upscaleState);
+
+	SimplePixelShader* ps = upscaleState->PixelShader;
+	ps->SetFloat2("uvScale", DirectX::XMFLOAT2((float)renderWidth / outputWidth, (float)renderHeight / outputHeight));
+	ps->SetFloat2("uvMax", DirectX::XMFLOAT2((renderWidth - 0.5f) / outputWidth, (renderHeight - 0.5f) / outputHeight));
+	ps->CopyAllBufferData();
+	ps->SetShaderResourceView("sceneTexture", scene);
+	ps->SetSamplerState("linearClamp", linearClamp);
+
+	context->Draw(3, 0);
+
+	// Next frame renders into it again
+	ps->SetShaderResourceView("sceneTexture", 0);
+
+	ReadTimers();
+}
+
+// --------------------------------------------------------
+// Collects every finished timing, oldest first, and feeds
+// it to the governor.  Stops at the first one that isn't
+// ready, since later frames won't be either.
+// --------------------------------------------------------
+void DynamicResolution::ReadTimers()
+{
+	for (unsigned int i = TimerCount; i > 0; i--)
+	{
+		FrameTimer& timer = timers[(frame - i) % TimerCount];
+		if (!timer.Pending)
+			continue;
+
+		D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint;
+		if (context->GetData(timer.Disjoint, &disjoint, sizeof(disjoint), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+			return;
+
+		UINT64 start = 0;
+		UINT64 end = 0;
+		if (context->GetData(timer.Start, &start, sizeof(start), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK ||
+			context->GetData(timer.End, &end, sizeof(end), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+			return;
+		timer.Pending = false;
+
+		// The GPU's clock changed speed part way through - no use
+		if (disjoint.Disjoint || disjoint.Frequency == 0 || end < start)
+			continue;
+
+		lastGPUTime = (float)((double)(end - start) / disjoint.Frequency);
+		governor.Update(lastGPUTime);
+	}
+}
+
+void DynamicResolution::WatchForChanges(AssetWatcher* assetWatcher)
+{
+	vertexShaders->WatchForChanges(assetWatcher);
+	pixelShaders->WatchForChanges(assetWatcher);
+}
+
+bool DynamicResolution::ReloadShader(const std::wstring& path)
+{
+	return vertexShaders->Reload(path) || pixelShaders->Reload(path);
+}
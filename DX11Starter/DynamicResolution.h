@@ -0,0 +1,95 @@
+#pragma once
+
+#include <d3d11.h>
+#include <string>
+#include "ResolutionGovernor.h"
+#include "ShaderVariants.h"
+#include "PipelineStateCache.h"
+#include "AssetWatcher.h"
+#include "SimpleShader.h"
+#include "DepthMode.h"
+#include "RenderGraphCompiler.h"
+
+// --------------------------------------------------------
+// Renders the scene at a varying fraction of the window's
+// resolution, then stretches it over the back buffer.
+//
+// The scene's targets (see GetSceneColorDesc()) stay at
+// full size, and only the viewport shrinks, so changing the
+// scale never reallocates anything.  How far to shrink comes from a
+// ResolutionGovernor fed with the GPU time of each frame's
+// scene, measured with timestamp queries.  Results are read
+// a few frames late (never stalling for them); without
+// timestamps the scale simply stays at its maximum.
+// --------------------------------------------------------
+class DynamicResolution
+{
+public:
+	DynamicResolution(ID3D11Device* device, ID3D11DeviceContext* context, PipelineStateCache* stateCache, const ResolutionGovernorSettings& settings, DepthMode depthMode);
+	~DynamicResolution();
+
+	// Matches the scene's targets to the back buffer
+	void Resize(unsigned int width, unsigned int height);
+
+	// What the scene should be drawn into - the color target has to
+	// be readable, for upscaling
+	RenderTextureDesc GetSceneColorDesc();
+	RenderTextureDesc GetSceneDepthDesc();
+
+	// Aims drawing at the part of the scene's targets this frame's
+	// scale uses, and starts timing.  Call before drawing the scene.
+	void BeginScene();
+
+	// Stops timing, upscales the scene into the output, and updates
+	// the scale from whichever earlier frames' timings have arrived
+	void EndScene(ID3D11ShaderResourceView* scene, ID3D11RenderTargetView* output);
+
+	float GetScale() { return governor.GetScale(); }
+	unsigned int GetRenderWidth() { return renderWidth; }
+	unsigned int GetRenderHeight() { return renderHeight; }
+	float GetLastGPUTime() { return lastGPUTime; }
+
+	ResolutionGovernor& GetGovernor() { return governor; }
+
+	// Hot reloading of the upscale shaders
+	void WatchForChanges(AssetWatcher* assetWatcher);
+	bool ReloadShader(const std::wstring& path);
+
+private:
+	// Timestamp queries for one frame.  Several are kept in
+	// flight so reading one never waits on the GPU.
+	struct FrameTimer
+	{
+		ID3D11Query* Disjoint;
+		ID3D11Query* Start;
+		ID3D11Query* End;
+		bool Pending;
+	};
+	static const unsigned int TimerCount = 4;
+
+	ID3D11Device* device;
+	ID3D11DeviceContext* context;
+	PipelineStateCache* stateCache;
+
+	ResolutionGovernor governor;
+
+	// Full output size, and the part of it being rendered
+	unsigned int outputWidth;
+	unsigned int outputHeight;
+	unsigned int renderWidth;
+	unsigned int renderHeight;
+
+	DepthMode depthMode;
+
+	ShaderVariantCache<SimpleVertexShader>* vertexShaders;
+	ShaderVariantCache<SimplePixelShader>* pixelShaders;
+	const PipelineState* upscaleState;
+	ID3D11SamplerState* linearClamp;
+
+	FrameTimer timers[TimerCount];
+	unsigned int frame;
+	bool timing;				// Is this frame being timed?
+	float lastGPUTime;
+
+	void ReadTimers();
+};
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "EntityStorage.h"
+#include "GameEntity.h"
+
+// --------------------------------------------------------
+// The game's entities, in chunked storage (see
+// EntityStorage).  Spawn takes a mesh and a material.
+// --------------------------------------------------------
+typedef EntityStorage<GameEntity> EntityPool;
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <vector>
+#include <new>
+#include <utility>
+
+// Entities per chunk.  Chunks never move, so entity
+// pointers stay valid until that entity is despawned.
+#define ENTITY_CHUNK_SIZE	256
+
+// Ids pack a slot index and that slot's generation into 32
+// bits (the same scheme as resource handles), so an id kept
+// after its entity is despawned goes stale instead of
+// finding whatever took the slot next
+#define ENTITY_INDEX_BITS		22
+#define ENTITY_INDEX_MASK		((1u << ENTITY_INDEX_BITS) - 1)
+#define ENTITY_GENERATION_MASK	((1u << (32 - ENTITY_INDEX_BITS)) - 1)
+
+// --------------------------------------------------------
+// Chunked storage for entities of one type (see EntityPool
+// for the game's).
+//
+// Entities live side by side in fixed size chunks instead
+// of each being its own heap allocation, so walking them
+// touches memory in order.  Despawned slots go on a free
+// list and are reused by the next spawn, so spawning and
+// despawning are O(1) and only allocate when every chunk
+// is full.
+//
+// Zero is never a valid id.
+// --------------------------------------------------------
+template <typename EntityType>
+class EntityStorage
+{
+public:
+	EntityStorage() { count = 0; }
+
+	// Destroys any entities still alive and frees every chunk
+	~EntityStorage()
+	{
+		for (unsigned int c = 0; c < chunks.size(); c++)
+		{
+			for (unsigned int i = 0; i < ENTITY_CHUNK_SIZE; i++)
+			{
+				if (chunks[c]->Alive[i])
+					chunks[c]->Entities[i].~EntityType();
+			}
+
+			::operator delete(chunks[c]->Entities);
+			delete chunks[c];
+		}
+	}
+
+	// Creates an entity in the first free slot, passing args to
+	// its constructor.  Returns the new entity's id.
+	template <typename... Args> unsigned int Spawn(Args&&... args)
+	{
+		if (freeSlots.empty())
+			AddChunk();
+
+		unsigned int index = freeSlots.back();
+		freeSlots.pop_back();
+
+		Chunk* chunk = chunks[index / ENTITY_CHUNK_SIZE];
+		unsigned int slot = index % ENTITY_CHUNK_SIZE;
+
+		new (&chunk->Entities[slot]) EntityType(std::forward<Args>(args)...);
+		chunk->Alive[slot] = true;
+		chunk->LiveCount++;
+		count++;
+
+		return MakeId(index, chunk->Generation[slot]);
+	}
+
+	// Destroys an entity and frees its slot for reuse.  Stale
+	// ids are ignored.
+	void Despawn(unsigned int id)
+	{
+		EntityType* entity = Get(id);
+		if (!entity)
+			return;
+
+		unsigned int index = id & ENTITY_INDEX_MASK;
+		Chunk* chunk = chunks[index / ENTITY_CHUNK_SIZE];
+		unsigned int slot = index % ENTITY_CHUNK_SIZE;
+
+		entity->~EntityType();
+		chunk->Alive[slot] = false;
+		chunk->LiveCount--;
+		count--;
+
+		// Generation zero is skipped, so no id is ever zero
+		unsigned int generation = (chunk->Generation[slot] + 1) & ENTITY_GENERATION_MASK;
+		chunk->Generation[slot] = generation ? generation : 1;
+
+		freeSlots.push_back(index);
+	}
+
+	// Gets a live entity, or 0 if the id is stale or was never used
+	EntityType* Get(unsigned int id)
+	{
+		unsigned int index = id & ENTITY_INDEX_MASK;
+		unsigned int c = index / ENTITY_CHUNK_SIZE;
+		unsigned int slot = index % ENTITY_CHUNK_SIZE;
+		if (c >= chunks.size() || !chunks[c]->Alive[slot] || chunks[c]->Generation[slot] != (id >> ENTITY_INDEX_BITS))
+			return 0;
+
+		return &chunks[c]->Entities[slot];
+	}
+
+	unsigned int GetCount() { return count; }
+
+	// Calls func(EntityType*) for every live entity, in memory order
+	template <typename Func> void ForEach(Func func)
+	{
+		for (unsigned int c = 0; c < chunks.size(); c++)
+		{
+			Chunk* chunk = chunks[c];
+			if (chunk->LiveCount == 0)
+				continue;
+
+			for (unsigned int i = 0; i < ENTITY_CHUNK_SIZE; i++)
+			{
+				if (chunk->Alive[i])
+					func(&chunk->Entities[i]);
+			}
+		}
+	}
+
+	// Same, but calls func(id, EntityType*)
+	template <typename Func> void ForEachWithId(Func func)
+	{
+		for (unsigned int c = 0; c < chunks.size(); c++)
+		{
+			Chunk* chunk = chunks[c];
+			if (chunk->LiveCount == 0)
+				continue;
+
+			for (unsigned int i = 0; i < ENTITY_CHUNK_SIZE; i++)
+			{
+				if (chunk->Alive[i])
+					func(MakeId(c * ENTITY_CHUNK_SIZE + i, chunk->Generation[i]), &chunk->Entities[i]);
+			}
+		}
+	}
+
+private:
+	struct Chunk
+	{
+		EntityType* Entities;	// Raw storage, constructed as entities spawn
+		bool Alive[ENTITY_CHUNK_SIZE];
+		unsigned int Generation[ENTITY_CHUNK_SIZE];
+		unsigned int LiveCount;
+	};
+
+	std::vector<Chunk*> chunks;
+	std::vector<unsigned int> freeSlots;
+	unsigned int count;
+
+	static unsigned int MakeId(unsigned int index, unsigned int generation)
+	{
+		return (generation << ENTITY_INDEX_BITS) | index;
+	}
+
+	// Allocates another chunk and puts all of its slots on the
+	// free list, lowest first, so spawns fill chunks in order
+	void AddChunk()
+	{
+		Chunk* chunk = new Chunk();
+		chunk->Entities = (EntityType*)::operator new(sizeof(EntityType) * ENTITY_CHUNK_SIZE);
+		chunk->LiveCount = 0;
+		for (unsigned int i = 0; i < ENTITY_CHUNK_SIZE; i++)
+		{
+			chunk->Alive[i] = false;
+			chunk->Generation[i] = 1;
+		}
+
+		unsigned int firstIndex = (unsigned int)chunks.size() * ENTITY_CHUNK_SIZE;
+		chunks.push_back(chunk);
+
+		freeSlots.reserve(freeSlots.size() + ENTITY_CHUNK_SIZE);
+		for (unsigned int i = ENTITY_CHUNK_SIZE; i > 0; i--)
+			freeSlots.push_back(firstIndex + i - 1);
+	}
+};
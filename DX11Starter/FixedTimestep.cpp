@@ -0,0 +1,63 @@
+#include "FixedTimestep.h"
+
+FixedTimestep::FixedTimestep(float ticksPerSecond, unsigned int maxTicksPerFrame)
+{
+	SetTicksPerSecond(ticksPerSecond);
+	SetMaxTicksPerFrame(maxTicksPerFrame);
+	Reset(0.0);
+}
+
+void FixedTimestep::Reset(double now)
+{
+	lastTime = now;
+	accumulator = 0.0;
+	simulatedTime = 0.0;
+	droppedTime = 0.0;
+	tickCount = 0;
+}
+
+void FixedTimestep::Resume(double now, double accumulated, double simulated)
+{
+	Reset(now);
+	accumulator = accumulated;
+	simulatedTime = simulated;
+}
+
+// --------------------------------------------------------
+// Time running backwards (which some counters do across
+// cores) counts as no time passing
+// --------------------------------------------------------
+void FixedTimestep::Advance(double now)
+{
+	double elapsed = now - lastTime;
+	lastTime = now;
+	if (elapsed > 0.0)
+		accumulator += elapsed;
+
+	double maxAccumulated = tickLength * maxTicksPerFrame;
+	if (accumulator > maxAccumulated)
+	{
+		droppedTime += accumulator - maxAccumulated;
+		accumulator = maxAccumulated;
+	}
+}
+
+bool FixedTimestep::Tick()
+{
+	if (accumulator < tickLength)
+		return false;
+
+	accumulator -= tickLength;
+	simulatedTime += tickLength;
+	tickCount++;
+	return true;
+}
+
+// --------------------------------------------------------
+// Anything left in the accumulator carries over at the new
+// rate, so changing rates mid-game doesn't lose time
+// --------------------------------------------------------
+void FixedTimestep::SetTicksPerSecond(float ticksPerSecond)
+{
+	tickLength = ticksPerSecond > 0.0f ? 1.0 / ticksPerSecond : 1.0 / 60.0;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+// --------------------------------------------------------
+// Where the game loop gets the time from, in seconds.
+// DXCore uses the performance counter; anything else (a
+// fake clock that only moves when told to, say) can be
+// swapped in to drive the loop deterministically.
+//
+// SleepFor() gives up the CPU for roughly that long.  It
+// may wake late (never early), so anything that needs to
+// be on time sleeps short and checks Now() for the rest.
+// --------------------------------------------------------
+class GameClock
+{
+public:
+	virtual ~GameClock() {}
+	virtual double Now() = 0;
+	virtual void SleepFor(double seconds) = 0;
+};
+
+// --------------------------------------------------------
+// Fixed timestep accumulator.
+//
+// Real time goes in each frame with Advance(), and comes
+// out as whole ticks of a fixed length with Tick(), so the
+// simulation steps the same way at any frame rate.  What's
+// left over (less than one tick) becomes the interpolation
+// factor for drawing between the last two ticks.
+//
+// If a frame falls too far behind, the time beyond
+// maxTicksPerFrame ticks is dropped rather than caught up
+// on, so a slow update can't snowball into ever longer
+// frames (the "spiral of death").  The game slows down
+// instead.
+//
+// Knows nothing about Windows, so it can be used (and
+// tested) on its own.
+// --------------------------------------------------------
+class FixedTimestep
+{
+public:
+	FixedTimestep(float ticksPerSecond, unsigned int maxTicksPerFrame);
+
+	// Starts counting from "now" with nothing accumulated
+	void Reset(double now);
+
+	// Starts counting from "now" with time already accumulated and
+	// simulated, as an earlier run had them
+	void Resume(double now, double accumulated, double simulated);
+
+	// Adds the time since the last call
+	void Advance(double now);
+
+	// Consumes one tick if enough time has built up.  Call in a
+	// loop, updating once each time it returns true.
+	bool Tick();
+
+	// How far between the last tick and the next the current
+	// time is, from 0 to 1
+	float GetInterpolation() { return (float)(accumulator / tickLength); }
+
+	float GetTickLength() { return (float)tickLength; }
+	double GetAccumulatedTime() { return accumulator; }
+	double GetSimulatedTime() { return simulatedTime; }
+	unsigned long long GetTickCount() { return tickCount; }
+	double GetDroppedTime() { return droppedTime; }
+
+	void SetTicksPerSecond(float ticksPerSecond);
+	void SetMaxTicksPerFrame(unsigned int maxTicks) { maxTicksPerFrame = maxTicks > 0 ? maxTicks : 1; }
+
+private:
+	double tickLength;
+	unsigned int maxTicksPerFrame;
+
+	double lastTime;
+	double accumulator;			// Real time not yet simulated
+	double simulatedTime;		// Total of every tick run
+	double droppedTime;			// Total thrown away by the clamp
+	unsigned long long tickCount;
+};
@@ -0,0 +1,132 @@
+#include "FrameArena.h"
+#include <cstdint>
+
+std::mutex FrameArena::arenasMutex;
+std::vector<FrameArena*> FrameArena::arenas;
+
+// --------------------------------------------------------
+// Constructor - Allocates the arena and registers it so
+// ResetAll() can find it
+// --------------------------------------------------------
+FrameArena::FrameArena(size_t capacity)
+{
+	this->capacity = capacity;
+	buffer = new unsigned char[capacity];
+	offset = 0;
+	overflowBytes = 0;
+	lastFrameHighWater = 0;
+	peakHighWater = 0;
+
+	std::lock_guard<std::mutex> lock(arenasMutex);
+	arenas.push_back(this);
+}
+
+// --------------------------------------------------------
+// Destructor
+// --------------------------------------------------------
+FrameArena::~FrameArena()
+{
+	{
+		std::lock_guard<std::mutex> lock(arenasMutex);
+		for (unsigned int i = 0; i < arenas.size(); i++)
+		{
+			if (arenas[i] == this)
+			{
+				arenas.erase(arenas.begin() + i);
+				break;
+			}
+		}
+	}
+
+	for (unsigned int i = 0; i < overflowBlocks.size(); i++)
+		delete[] overflowBlocks[i];
+	delete[] buffer;
+}
+
+// --------------------------------------------------------
+// Bumps the offset forward.  Alignment must be a power of
+// two.  It's the address that gets aligned, not the offset,
+// since new[] only promises the buffer itself is aligned
+// for the largest fundamental type.
+// --------------------------------------------------------
+void* FrameArena::Allocate(size_t size, size_t alignment)
+{
+	uintptr_t address = (uintptr_t)(buffer + offset);
+	size_t start = offset + (((address + alignment - 1) & ~(uintptr_t)(alignment - 1)) - address);
+	if (start <= capacity && size <= capacity - start)
+	{
+		offset = start + size;
+		return buffer + start;
+	}
+
+	// Out of room - borrow from the heap until the next reset
+	unsigned char* block = new unsigned char[size + alignment];
+	overflowBlocks.push_back(block);
+	overflowBytes += size + alignment;
+
+	address = (uintptr_t)block;
+	return block + (((address + alignment - 1) & ~(uintptr_t)(alignment - 1)) - address);
+}
+
+// --------------------------------------------------------
+// Records this frame's usage and starts over.  If the frame
+// overflowed, the arena is regrown to fit it.
+// --------------------------------------------------------
+void FrameArena::Reset()
+{
+	lastFrameHighWater = GetUsed();
+	if (lastFrameHighWater > peakHighWater)
+		peakHighWater = lastFrameHighWater;
+
+	if (!overflowBlocks.empty())
+	{
+		for (unsigned int i = 0; i < overflowBlocks.size(); i++)
+			delete[] overflowBlocks[i];
+		overflowBlocks.clear();
+
+		// Double until the busiest frame fits
+		while (capacity < peakHighWater)
+			capacity *= 2;
+
+		delete[] buffer;
+		buffer = new unsigned char[capacity];
+	}
+
+	offset = 0;
+	overflowBytes = 0;
+}
+
+// --------------------------------------------------------
+// Each thread lazily creates its own arena the first time
+// it asks for one, and it's destroyed when the thread ends
+// --------------------------------------------------------
+FrameArena* FrameArena::GetThreadArena()
+{
+	thread_local FrameArena arena(FRAME_ARENA_DEFAULT_SIZE);
+	return &arena;
+}
+
+// --------------------------------------------------------
+// Resets every thread's arena
+// --------------------------------------------------------
+void FrameArena::ResetAll()
+{
+	std::lock_guard<std::mutex> lock(arenasMutex);
+	for (unsigned int i = 0; i < arenas.size(); i++)
+		arenas[i]->Reset();
+}
+
+// --------------------------------------------------------
+// Largest single frame across all threads, for budgeting
+// --------------------------------------------------------
+size_t FrameArena::GetPeakHighWaterAll()
+{
+	std::lock_guard<std::mutex> lock(arenasMutex);
+	size_t peak = 0;
+	for (unsigned int i = 0; i < arenas.size(); i++)
+	{
+		if (arenas[i]->peakHighWater > peak)
+			peak = arenas[i]->peakHighWater;
+	}
+	return peak;
+}
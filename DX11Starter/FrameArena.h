@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <mutex>
+
+// Starting size of each thread's arena.  Arenas grow to fit
+// their busiest frame, so this only needs to be a good guess.
+#define FRAME_ARENA_DEFAULT_SIZE	(256 * 1024)
+
+// --------------------------------------------------------
+// Linear (bump) allocator for data that only lives for one
+// frame: draw lists, visible entity lists, and the like.
+//
+// Allocating just moves an offset forward, and nothing is
+// freed individually; the whole arena is reset at the start
+// of each frame.  If a frame needs more than the arena has,
+// the extra comes from the heap and the arena grows to fit
+// at the next reset, so it settles after a frame or two.
+//
+// Each thread has its own arena (see GetThreadArena), so no
+// locking is needed to allocate.
+// --------------------------------------------------------
+class FrameArena
+{
+public:
+	FrameArena(size_t capacity);
+	~FrameArena();
+
+	void* Allocate(size_t size, size_t alignment = 16);
+
+	template <typename T> T* AllocateArray(size_t count)
+	{
+		return (T*)Allocate(sizeof(T) * count, alignof(T));
+	}
+
+	// Throws away everything allocated since the last reset
+	void Reset();
+
+	// Budget stats
+	size_t GetCapacity() { return capacity; }
+	size_t GetUsed() { return offset + overflowBytes; }
+	size_t GetLastFrameHighWater() { return lastFrameHighWater; }
+	size_t GetPeakHighWater() { return peakHighWater; }
+
+	// The calling thread's arena
+	static FrameArena* GetThreadArena();
+
+	// Resets every thread's arena.  Call at a frame boundary,
+	// when no thread is still using last frame's allocations.
+	static void ResetAll();
+
+	// Largest single frame seen on any thread
+	static size_t GetPeakHighWaterAll();
+
+private:
+	unsigned char* buffer;
+	size_t capacity;
+	size_t offset;
+
+	// Heap blocks for anything that didn't fit this frame
+	std::vector<unsigned char*> overflowBlocks;
+	size_t overflowBytes;
+
+	size_t lastFrameHighWater;
+	size_t peakHighWater;
+
+	// Every live arena, so they can all be reset together
+	static std::mutex arenasMutex;
+	static std::vector<FrameArena*> arenas;
+};
+
+// --------------------------------------------------------
+// STL allocator that takes memory from a frame arena, so
+// containers built during a frame never touch the heap:
+//
+//   FrameVector<GameEntity*> visible;
+//
+// Deallocation does nothing; memory comes back on reset.
+// Don't keep these containers past the end of the frame.
+// --------------------------------------------------------
+template <typename T>
+class FrameAllocator
+{
+public:
+	typedef T value_type;
+
+	FrameAllocator() : arena(FrameArena::GetThreadArena()) {}
+	FrameAllocator(FrameArena* arena) : arena(arena) {}
+	template <typename U> FrameAllocator(const FrameAllocator<U>& other) : arena(other.GetArena()) {}
+
+	T* allocate(size_t count) { return arena->AllocateArray<T>(count); }
+	void deallocate(T*, size_t) {}
+
+	FrameArena* GetArena() const { return arena; }
+
+	template <typename U> bool operator==(const FrameAllocator<U>& other) const { return arena == other.GetArena(); }
+	template <typename U> bool operator!=(const FrameAllocator<U>& other) const { return arena != other.GetArena(); }
+
+private:
+	FrameArena* arena;
+};
+
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
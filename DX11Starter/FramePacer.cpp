@@ -0,0 +1,110 @@
+#include "FramePacer.h"
+#include <cmath>
+
+// Bounds on how early we stop sleeping before a deadline
+#define MIN_SPIN_TIME	0.0005
+#define MAX_SPIN_TIME	0.004
+
+FramePacer::FramePacer(GameClock* clock)
+{
+	this->clock = clock;
+	frameLength = 0.0;
+
+	// Assume a 1ms scheduler until we've seen otherwise
+	sleepLateness = 0.001;
+	spinTime = 0.0015;
+
+	ClearStats();
+	Reset(0.0);
+}
+
+void FramePacer::SetTargetFPS(float fps)
+{
+	frameLength = fps > 0.0f ? 1.0 / fps : 0.0;
+}
+
+void FramePacer::Reset(double now)
+{
+	nextFrame = now;
+	lastFrame = now;
+	ClearStats();
+}
+
+// --------------------------------------------------------
+// Sleeps most of the way to the next slot on the grid and
+// spins the last bit.  Each sleep's lateness feeds back
+// into how early the next one stops: a late wake pushes
+// the spin time up at once, while on-time wakes only ease
+// it back down slowly.
+// --------------------------------------------------------
+double FramePacer::WaitForNextFrame()
+{
+	double now = clock->Now();
+
+	if (frameLength > 0.0)
+	{
+		// Too far behind to catch up - start a new grid from here
+		if (now - nextFrame > frameLength)
+			nextFrame = now;
+
+		double sleepTime = nextFrame - now - spinTime;
+		if (sleepTime > 0.0)
+		{
+			clock->SleepFor(sleepTime);
+			double woke = clock->Now();
+			double lateness = (woke - now) - sleepTime;
+			now = woke;
+
+			if (lateness > sleepLateness)
+				sleepLateness = lateness;
+			else
+				sleepLateness += (lateness - sleepLateness) * 0.05;
+
+			spinTime = sleepLateness * 1.25 + 0.00025;
+			if (spinTime < MIN_SPIN_TIME) spinTime = MIN_SPIN_TIME;
+			if (spinTime > MAX_SPIN_TIME) spinTime = MAX_SPIN_TIME;
+		}
+
+		while (now < nextFrame)
+			now = clock->Now();
+
+		nextFrame += frameLength;
+	}
+
+	RecordFrame(now - lastFrame);
+	lastFrame = now;
+	return now;
+}
+
+void FramePacer::RecordFrame(double frameTime)
+{
+	statFrames++;
+	double delta = frameTime - statMean;
+	statMean += delta / statFrames;
+	statSquares += delta * (frameTime - statMean);
+
+	if (frameTime < statMin) statMin = frameTime;
+	if (frameTime > statMax) statMax = frameTime;
+}
+
+FrameTimeStats FramePacer::TakeStats()
+{
+	FrameTimeStats stats;
+	stats.Frames = statFrames;
+	stats.Mean = statMean;
+	stats.StdDev = statFrames > 1 ? sqrt(statSquares / (statFrames - 1)) : 0.0;
+	stats.Min = statFrames > 0 ? statMin : 0.0;
+	stats.Max = statFrames > 0 ? statMax : 0.0;
+
+	ClearStats();
+	return stats;
+}
+
+void FramePacer::ClearStats()
+{
+	statFrames = 0;
+	statMean = 0.0;
+	statSquares = 0.0;
+	statMin = 1e30;
+	statMax = 0.0;
+}
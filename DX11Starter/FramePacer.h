@@ -0,0 +1,89 @@
+#pragma once
+
+#include "FixedTimestep.h"
+
+// --------------------------------------------------------
+// How frames are queued up for the GPU
+// --------------------------------------------------------
+enum FramePacingMode
+{
+	FRAME_PACING_LATENCY,		// At most one frame in flight - input is as fresh as possible
+	FRAME_PACING_THROUGHPUT		// Let the CPU run a few frames ahead to keep the GPU busy
+};
+
+// --------------------------------------------------------
+// Frame times over a stretch of frames, in seconds
+// --------------------------------------------------------
+struct FrameTimeStats
+{
+	unsigned int Frames;
+	double Mean;
+	double StdDev;
+	double Min;
+	double Max;
+};
+
+// --------------------------------------------------------
+// Frame rate limiter.
+//
+// Frames are scheduled on a fixed grid (one every 1/fps
+// seconds) rather than "1/fps after the last one ended",
+// so an early wake or a slightly long frame doesn't drift
+// the rate.  A frame that falls more than a whole frame
+// behind restarts the grid instead of rushing to catch up.
+//
+// Waiting is a hybrid: sleep until just before the frame
+// is due, then spin on the clock for the rest.  Sleeping
+// alone is only accurate to the scheduler's tick (~1ms at
+// best), spinning alone burns a core.  How early to stop
+// sleeping adapts to how late the clock's sleeps wake.
+//
+// Only talks to the time through a GameClock, so it can
+// be driven by a fake one.
+// --------------------------------------------------------
+class FramePacer
+{
+public:
+	// The clock isn't owned
+	FramePacer(GameClock* clock);
+
+	void SetClock(GameClock* clock) { this->clock = clock; }
+
+	// 0 (the default) doesn't limit the frame rate at all
+	void SetTargetFPS(float fps);
+	float GetTargetFPS() { return frameLength > 0.0 ? (float)(1.0 / frameLength) : 0.0f; }
+
+	// Starts the schedule (and frame timing) from "now"
+	void Reset(double now);
+
+	// Blocks until the next frame is due, then returns the time
+	// it started.  Also times the frame that just ended.
+	double WaitForNextFrame();
+
+	// Frame times since the last call, then starts over
+	FrameTimeStats TakeStats();
+
+	// How long before a deadline sleeping stops and spinning starts
+	double GetSpinTime() { return spinTime; }
+
+private:
+	GameClock* clock;
+
+	double frameLength;			// 0 for unlimited
+	double nextFrame;			// When the next frame is due
+	double lastFrame;			// When the last one started
+
+	double sleepLateness;		// How late sleeps tend to wake
+	double spinTime;
+
+	// Running stats (Welford's method, so the variance
+	// doesn't lose precision over many frames)
+	unsigned int statFrames;
+	double statMean;
+	double statSquares;
+	double statMin;
+	double statMax;
+
+	void RecordFrame(double frameTime);
+	void ClearStats();
+};
@@ -0,0 +1,200 @@
+#include "FrameRecording.h"
+#include <cstring>
+#include <fstream>
+
+// Recording files start with this, then a version
+static const char recordingMagic[4] = { 'F', 'R', 'E', 'C' };
+static const unsigned int recordingVersion = 2;
+
+static_assert(ACTION_COUNT <= 16, "Recorded action masks are 16 bits");
+
+// A frame with no held times: delta time, four action masks,
+// four cursor values and the wheel
+static const unsigned int recordingMinFrameBytes = sizeof(float) + 4 * sizeof(unsigned short) + 4 * sizeof(short) + sizeof(float);
+
+template <typename T> static void Write(std::ofstream& file, const T& value)
+{
+	file.write((const char*)&value, sizeof(T));
+}
+
+template <typename T> static void Read(std::ifstream& file, T* value)
+{
+	file.read((char*)value, sizeof(T));
+}
+
+// Cursor positions and movement are stored as 16 bits
+static short ClampShort(int value)
+{
+	if (value < -32768) return -32768;
+	if (value > 32767) return 32767;
+	return (short)value;
+}
+
+FrameRecording::FrameRecording()
+{
+	startAccumulated = 0.0;
+	startSimulated = 0.0;
+}
+
+void FrameRecording::Clear()
+{
+	frames.clear();
+	startState.clear();
+	startAccumulated = 0.0;
+	startSimulated = 0.0;
+}
+
+// --------------------------------------------------------
+// The snapshot's Start and End are left to the replay to
+// fill in, from its own running time
+// --------------------------------------------------------
+void FrameRecording::AddFrame(float deltaTime, const InputSnapshot& input)
+{
+	RecordedFrame frame;
+	frame.DeltaTime = deltaTime;
+	frame.Input = input;
+	frame.Input.Start = 0.0;
+	frame.Input.End = 0.0;
+	frames.push_back(frame);
+}
+
+float FrameRecording::GetDuration()
+{
+	double total = 0.0;
+	for (unsigned int i = 0; i < frames.size(); i++)
+		total += frames[i].DeltaTime;
+	return (float)total;
+}
+
+bool FrameRecording::Save(const char* path)
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+		return false;
+
+	file.write(recordingMagic, sizeof(recordingMagic));
+	Write(file, recordingVersion);
+	Write(file, startAccumulated);
+	Write(file, startSimulated);
+	Write(file, (unsigned int)startState.size());
+	if (!startState.empty())
+		file.write((const char*)&startState[0], startState.size());
+	Write(file, (unsigned int)frames.size());
+
+	for (unsigned int i = 0; i < frames.size(); i++)
+	{
+		const InputSnapshot& input = frames[i].Input;
+
+		unsigned short held = 0, pressed = 0, released = 0, timed = 0;
+		for (unsigned int a = 0; a < ACTION_COUNT; a++)
+		{
+			if (input.Held[a]) held |= 1 << a;
+			if (input.Pressed[a]) pressed |= 1 << a;
+			if (input.Released[a]) released |= 1 << a;
+			if (input.HeldTime[a] > 0.0f) timed |= 1 << a;
+		}
+
+		Write(file, frames[i].DeltaTime);
+		Write(file, held);
+		Write(file, pressed);
+		Write(file, released);
+		Write(file, timed);
+		for (unsigned int a = 0; a < ACTION_COUNT; a++)
+		{
+			if (timed & (1 << a))
+				Write(file, input.HeldTime[a]);
+		}
+		Write(file, ClampShort(input.MouseX));
+		Write(file, ClampShort(input.MouseY));
+		Write(file, ClampShort(input.LookX));
+		Write(file, ClampShort(input.LookY));
+		Write(file, input.Wheel);
+	}
+
+	return file.good();
+}
+
+// --------------------------------------------------------
+// Leaves the recording as it was if the file is missing,
+// from another version, or cut short.  Sizes in the file
+// are checked against what's left of it before anything
+// is allocated for them, so a corrupt one can't ask for
+// gigabytes.
+// --------------------------------------------------------
+bool FrameRecording::Load(const char* path)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+		return false;
+
+	std::streamoff fileSize = file.tellg();
+	file.seekg(0, std::ios::beg);
+	auto remaining = [&]() { return (unsigned long long)(fileSize - file.tellg()); };
+
+	char magic[4];
+	unsigned int version = 0;
+	double accumulated = 0.0, simulated = 0.0;
+	unsigned int stateSize = 0;
+	file.read(magic, sizeof(magic));
+	Read(file, &version);
+	Read(file, &accumulated);
+	Read(file, &simulated);
+	Read(file, &stateSize);
+	if (!file.good() || memcmp(magic, recordingMagic, sizeof(magic)) != 0 || version != recordingVersion)
+		return false;
+
+	if (stateSize > remaining())
+		return false;
+
+	std::vector<unsigned char> newState(stateSize);
+	if (stateSize > 0)
+		file.read((char*)&newState[0], stateSize);
+
+	unsigned int count = 0;
+	Read(file, &count);
+	if (!file.good() || (unsigned long long)count * recordingMinFrameBytes > remaining())
+		return false;
+
+	std::vector<RecordedFrame> newFrames(count);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		InputSnapshot& input = newFrames[i].Input;
+		unsigned short held = 0, pressed = 0, released = 0, timed = 0;
+		short mouseX = 0, mouseY = 0, lookX = 0, lookY = 0;
+
+		Read(file, &newFrames[i].DeltaTime);
+		Read(file, &held);
+		Read(file, &pressed);
+		Read(file, &released);
+		Read(file, &timed);
+		for (unsigned int a = 0; a < ACTION_COUNT; a++)
+		{
+			input.Held[a] = (held & (1 << a)) != 0;
+			input.Pressed[a] = (pressed & (1 << a)) != 0;
+			input.Released[a] = (released & (1 << a)) != 0;
+			input.HeldTime[a] = 0.0f;
+			if (timed & (1 << a))
+				Read(file, &input.HeldTime[a]);
+		}
+		Read(file, &mouseX);
+		Read(file, &mouseY);
+		Read(file, &lookX);
+		Read(file, &lookY);
+		Read(file, &input.Wheel);
+
+		input.Start = 0.0;
+		input.End = 0.0;
+		input.MouseX = mouseX;
+		input.MouseY = mouseY;
+		input.LookX = lookX;
+		input.LookY = lookY;
+	}
+	if (!file.good())
+		return false;
+
+	frames.swap(newFrames);
+	startState.swap(newState);
+	startAccumulated = accumulated;
+	startSimulated = simulated;
+	return true;
+}
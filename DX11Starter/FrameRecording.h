@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+#include "Input.h"
+
+// --------------------------------------------------------
+// One frame of a recording: how long it lasted and what the
+// input snapshot said
+// --------------------------------------------------------
+struct RecordedFrame
+{
+	float DeltaTime;
+	InputSnapshot Input;
+};
+
+// --------------------------------------------------------
+// A frame by frame recording of input and frame times.
+//
+// Replaying one feeds the game exactly the same snapshots
+// with exactly the same frame times, so the fixed timestep
+// runs the same ticks and the camera flies the same path
+// on any machine, at any real frame rate.  That's what
+// makes it usable for benchmarks.
+//
+// StartState is whatever the game needs to put back before
+// the first frame (where the camera was, say) - opaque
+// bytes as far as the recording is concerned.  The fixed
+// timestep's leftover and simulated time are kept as well,
+// so the replay's ticks fall on the very same frames.
+//
+// On disk each frame is packed into bit masks, plus the
+// held time of only those actions that were held - around
+// 26 bytes a frame.
+// --------------------------------------------------------
+class FrameRecording
+{
+public:
+	FrameRecording();
+
+	void Clear();
+	void AddFrame(float deltaTime, const InputSnapshot& input);
+
+	unsigned int GetFrameCount() { return frames.size(); }
+	const RecordedFrame& GetFrame(unsigned int index) { return frames[index]; }
+	float GetDuration();
+
+	std::vector<unsigned char>& GetStartState() { return startState; }
+
+	void SetStartTime(double accumulated, double simulated) { startAccumulated = accumulated; startSimulated = simulated; }
+	double GetStartAccumulated() { return startAccumulated; }
+	double GetStartSimulated() { return startSimulated; }
+
+	bool Save(const char* path);
+	bool Load(const char* path);
+
+private:
+	std::vector<RecordedFrame> frames;
+	std::vector<unsigned char> startState;
+	double startAccumulated;	// FixedTimestep time not yet ticked
+	double startSimulated;		// and already ticked
+};
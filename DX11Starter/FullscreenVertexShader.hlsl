@@ -0,0 +1,20 @@
+
+// Full screen pass without any vertex buffer: three verticies
+// from SV_VertexID make one triangle that covers the screen
+// (and then some, which is clipped away)
+struct VertexToPixel
+{
+	float4 position		: SV_POSITION;
+	float2 uv			: TEXCOORD;		// 0 to 1 across the screen
+};
+
+VertexToPixel main(uint id : SV_VertexID)
+{
+	VertexToPixel output;
+
+	// (0,0), (2,0), (0,2) - clockwise on screen once y is flipped
+	output.uv = float2((id << 1) & 2, id & 2);
+	output.position = float4(output.uv.x * 2.0f - 1.0f, 1.0f - output.uv.y * 2.0f, 0.0f, 1.0f);
+
+	return output;
+}
@@ -1,10 +1,35 @@
 #include "Game.h"
 #include "Vertex.h"
-#include "WICTextureLoader.h"
+#include "ConstantBuffers.h"
+#include "DDSTextureLoader.h"
+#include "FrameArena.h"
+#include <algorithm>
 
 // For the DirectX Math library
 using namespace DirectX;
 
+// What color textures are compressed to on import
+#define COLOR_TEXTURE_FORMAT	BLOCK_BC7
+
+// Rays traced per vertex when baking ambient occlusion
+#define OCCLUSION_RAYS_PER_VERTEX	256
+
+// Frames per second to cap drawing at (0 for no cap)
+#define FRAME_RATE_LIMIT	144
+
+// Where F9 records input to, and F10 plays it back from
+#define INPUT_RECORDING_FILE	"input.rec"
+
+// Where the camera starts (and benchmark flythroughs with it)
+#define CAMERA_START_POSITION	XMFLOAT3(0, 0, -5)
+
+// Benchmark results go to <name>.csv and <name>.json
+#define BENCHMARK_OUTPUT		"benchmark"
+
+// GPU time per frame dynamic resolution aims for (a little
+// under the frame rate limit, to leave room for the upscale)
+#define GPU_FRAME_BUDGET	0.006f
+
 // --------------------------------------------------------
 // Constructor
 //
@@ -21,19 +46,55 @@ Game::Game(HINSTANCE hInstance)
 		720,			   // Height of the window's client area
 		true)			   // Show extra stats (fps) in title bar?
 {
-	// Initialize fields
-	meshOne = 0;
-	meshTwo = 0;
-	meshObject = 0;
-	myMaterial = 0;
-	metalMat = 0;
+	// Initialize fields (resource handles start out invalid on their own)
+	resources = 0;
+	geometry = 0;
+	threads = 0;
+	textureImporter = 0;
+	clusterCuller = 0;
+	clusterCulling = true;
+	entities = 0;
+	raycaster = 0;
+	entityPicked = false;
+	pickedEntity = 0;
+	probes = 0;
 	myCamera = 0;
-	pixelShader = 0;
-	vertexShader = 0;
-	radSRV = 0;
-	mtlSRV = 0;
+	dynamicResolution = 0;
+	depthPrepass = 0;
+	renderGraph = 0;
+	pixelShaders = 0;
+	vertexShaders = 0;
+	stateCache = 0;
+	assetWatcher = 0;
 	sampler = 0;
 
+	// Full precision vertices unless asked for the quantized ones
+	// (half the size) with SetVertexFormat()
+	vertexFormat = VERTEX_STREAM_FULL;
+
+	// Don't draw faster than anyone can see, and keep at most one
+	// frame queued so the camera responds as quickly as it can
+	pacer.SetTargetFPS(FRAME_RATE_LIMIT);
+	pacingMode = FRAME_PACING_LATENCY;
+
+	// Reverse Z with no far plane, so the view distance never needs
+	// tuning.  DEPTH_STANDARD goes back to a 0.1 - 100 range.
+	depthMode = DEPTH_REVERSE_Z;
+
+	// Fly with WASD, X and space, and turn by dragging with any button
+	input.Bind('W', ACTION_MOVE_FORWARD);
+	input.Bind('S', ACTION_MOVE_BACK);
+	input.Bind('A', ACTION_MOVE_LEFT);
+	input.Bind('D', ACTION_MOVE_RIGHT);
+	input.Bind('X', ACTION_MOVE_UP);
+	input.Bind(VK_SPACE, ACTION_MOVE_DOWN);
+	input.Bind(VK_LBUTTON, ACTION_LOOK);
+	input.Bind(VK_RBUTTON, ACTION_LOOK);
+	input.Bind(VK_MBUTTON, ACTION_LOOK);
+	input.Bind(VK_ESCAPE, ACTION_QUIT);
+	input.Bind(VK_F9, ACTION_RECORD);
+	input.Bind(VK_F10, ACTION_REPLAY);
+
 #if defined(DEBUG) || defined(_DEBUG)
 	// Do we want a console window?  Probably only in debug mode
 	CreateConsoleWindow(500, 120, 32, 120);
@@ -48,34 +109,56 @@ Game::Game(HINSTANCE hInstance)
 // --------------------------------------------------------
 Game::~Game()
 {
-	// Delete all our meshes for the game. We delete these here instead of in entities so that we do not
-	// have to keep track of the number of references per Entity. Different entites will share meshes
-	delete meshOne;
-	delete meshTwo;
-	delete meshObject;
-	delete meshCube;
+	// Stop watching for asset changes before anything it loads into goes away
+	delete assetWatcher;
 
-	// Delete all out gameEntities
-	for (int i = 0; i < numberGameEntities; i++)
-		delete gameEntities[i];
+	// Points into the meshes, so goes before them
+	delete raycaster;
+	delete probes;
+
+	// Drop the references our entities hold, then free them all at once
+	ResourceRegistry* registry = resources;
+	entities->ForEach([registry](GameEntity* entity)
+	{
+		registry->Release(entity->GetMesh());
+		registry->Release(entity->GetMaterial());
+	});
+	delete entities;
 
 	// Delete the camera
 	delete myCamera;
 
-	//Release texture resources
-	radSRV->Release();
-	mtlSRV->Release();
-	sampler->Release();
+	// Drop our own references to the shared meshes, materials and textures
+	resources->Release(meshOne);
+	resources->Release(meshTwo);
+	resources->Release(meshObject);
+	resources->Release(meshCube);
+	resources->Release(myMaterial);
+	resources->Release(metalMat);
+	resources->Release(radTexture);
+	resources->Release(mtlTexture);
+
+	// Destroys everything the registry owns, including anything
+	// still waiting out its retirement frames
+	delete resources;
+
+	// Meshes give their space back to the pool, so it goes last
+	delete geometry;
+	delete clusterCuller;
+	delete textureImporter;
+	delete threads;
+
+	delete dynamicResolution;
+	delete depthPrepass;
+	delete renderGraph;
 
-	// Delete my material. We delete these here instead of in entities so that we do not
-	// have to keep track of the number of references per Entity. Different entites will share materials.
-	delete myMaterial;
-	delete metalMat;
+	// Delete our shader caches, which will delete every
+	// loaded permutation (and their internal DirectX stuff)
+	delete vertexShaders;
+	delete pixelShaders;
 
-	// Delete our simple shader objects, which
-	// will clean up their own internal DirectX stuff
-	delete vertexShader;
-	delete pixelShader;
+	// Releases every state object (including our sampler)
+	delete stateCache;
 }
 
 // --------------------------------------------------------
@@ -100,6 +183,36 @@ void Game::Init()
 	CreateMatrices();
 	CreateBasicGeometry();
 
+	// Scale the scene between half and full resolution.  The gains
+	// are on the relative error, so they hold for any budget.
+	ResolutionGovernorSettings resolutionSettings;
+	resolutionSettings.MinScale = 0.5f;
+	resolutionSettings.MaxScale = 1.0f;
+	resolutionSettings.TargetFrameTime = GPU_FRAME_BUDGET;
+	resolutionSettings.Proportional = 0.5f;
+	resolutionSettings.Integral = 0.1f;
+	resolutionSettings.Derivative = 0.05f;
+	resolutionSettings.Smoothing = 0.3f;
+
+	// Benchmarks compare runs at the same resolution
+	if (IsBenchmarking())
+		resolutionSettings.MinScale = resolutionSettings.MaxScale;
+	dynamicResolution = new DynamicResolution(device, context, stateCache, resolutionSettings, depthMode);
+	dynamicResolution->Resize(width, height);
+	dynamicResolution->WatchForChanges(assetWatcher);
+
+	// Every render target the frame draws into comes from here
+	renderGraph = new RenderGraph(device);
+
+	// Start reloading assets as they change.  Compiled shaders end up
+	// in the working directory or Debug/, depending on how we're run.
+	vector<wstring> assetDirectories;
+	assetDirectories.push_back(L"Assets/Models");
+	assetDirectories.push_back(L"Assets/Textures");
+	assetDirectories.push_back(L".");
+	assetDirectories.push_back(L"Debug");
+	assetWatcher->Start(assetDirectories);
+
 	// Tell the input assembler stage of the pipeline what kind of
 	// geometric primitives (points, lines or triangles) we want to draw.  
 	// Essentially: "What kind of shape should the GPU draw with our data?"
@@ -114,16 +227,51 @@ void Game::Init()
 // --------------------------------------------------------
 void Game::LoadShaders()
 {
-	vertexShader = new SimpleVertexShader(device, context);
-	if (!vertexShader->LoadShaderFile(L"Debug/VertexShader.cso"))
-		vertexShader->LoadShaderFile(L"VertexShader.cso");		
+	// Shader permutations are loaded lazily the first time a
+	// material asks for a particular feature mask.  They share
+	// input layouts (and all other state) through the cache.
+	stateCache = new PipelineStateCache(device, context);
+	// Input layouts come straight from our C++ vertex structs
+	if (vertexFormat == VERTEX_STREAM_QUANTIZED)
+	{
+		vertexShaders = new ShaderVariantCache<SimpleVertexShader>(device, context, L"QuantizedVertexShader", stateCache);
+		vertexShaders->SetVertexFormat<QuantizedVertex, OcclusionVertex>();
+	}
+	else
+	{
+		vertexShaders = new ShaderVariantCache<SimpleVertexShader>(device, context, L"VertexShader", stateCache);
+		vertexShaders->SetVertexFormat<Vertex, OcclusionVertex>();
+	}
+	pixelShaders = new ShaderVariantCache<SimplePixelShader>(device, context, L"PixelShader", stateCache);
 
-	pixelShader = new SimplePixelShader(device, context);
-	if (!pixelShader->LoadShaderFile(L"Debug/PixelShader.cso"))
-		pixelShader->LoadShaderFile(L"PixelShader.cso");
+	// Only lay depth down first once there's enough overdraw to
+	// repay drawing everything twice
+	DepthPrepassSettings prepassSettings;
+	prepassSettings.Mode = DEPTH_PREPASS_AUTO;
+	prepassSettings.EnableOverdraw = 1.5f;
+	prepassSettings.DisableOverdraw = 1.25f;
+	prepassSettings.Smoothing = 0.05f;
+	depthPrepass = new DepthPrepass(device, context, stateCache, vertexFormat, depthMode, prepassSettings);
 
-	CreateWICTextureFromFile(device, context, L"Assets/Textures/rad.png", 0, &radSRV);
-	CreateWICTextureFromFile(device, context, L"Assets/Textures/mtl.png", 0, &mtlSRV);
+	// Every shader, texture and mesh we load is registered for hot reloading
+	assetWatcher = new AssetWatcher();
+	resources = new ResourceRegistry();
+	vertexShaders->WatchForChanges(assetWatcher);
+	pixelShaders->WatchForChanges(assetWatcher);
+	depthPrepass->WatchForChanges(assetWatcher);
+
+	// Textures are compressed (across every core) the first time
+	// they're seen, or after they change, and loaded compressed
+	threads = new ThreadPool();
+	textureImporter = new TextureImporter(device, context, threads);
+	textureImporter->ImportIfStale(L"Assets/Textures/rad.png", COLOR_TEXTURE_FORMAT);
+	textureImporter->ImportIfStale(L"Assets/Textures/mtl.png", COLOR_TEXTURE_FORMAT);
+	radTexture = AddTexture(L"Assets/Textures/rad.png");
+	mtlTexture = AddTexture(L"Assets/Textures/mtl.png");
+	textureFiles[L"Assets/Textures/rad.png"] = radTexture;
+	textureFiles[L"Assets/Textures/mtl.png"] = mtlTexture;
+	assetWatcher->WatchFile(L"Assets/Textures/rad.png", ASSET_TEXTURE);
+	assetWatcher->WatchFile(L"Assets/Textures/mtl.png", ASSET_TEXTURE);
 
 	// Create a sampler state that defines the sampling
 	// options for any and all textures we use
@@ -138,21 +286,52 @@ void Game::LoadShaders()
 	sampDesc.MaxAnisotropy = 16;
 
 
-	// Now, create the sampler from the description
-	device->CreateSamplerState(&sampDesc, &sampler);
+	// Now, get the sampler for that description (owned by the cache)
+	sampler = stateCache->GetSamplerState(sampDesc);
+
+	// Both materials are textured and lit by our two directional lights,
+	// with default render states (apart from which way the depth test
+	// goes), so they share a single pipeline state
+	D3D11_DEPTH_STENCIL_DESC depthDesc = PipelineStateCache::DefaultDepthStencilDesc();
+	depthDesc.DepthFunc = DepthCompareFunc(depthMode);
 
-	myMaterial = new Materials(vertexShader, pixelShader, radSRV, sampler);
-	metalMat = new Materials(vertexShader, pixelShader, mtlSRV, sampler);
-	// You'll notice that the code above attempts to load each
-	// compiled shader file (.cso) from two different relative paths.
+	// A permutation that wasn't compiled comes back null, in which
+	// case the plain default shaders are the best we can do
+	const unsigned int litTextured = ShaderFeatures(true, 2, false, false);
+	SimpleVertexShader* litTexturedVS = vertexShaders->Get(litTextured);
+	SimplePixelShader* litTexturedPS = pixelShaders->Get(litTextured);
+	if (!litTexturedVS) litTexturedVS = vertexShaders->Get(SHADER_FEATURES_DEFAULT);
+	if (!litTexturedPS) litTexturedPS = pixelShaders->Get(SHADER_FEATURES_DEFAULT);
 
-	// This is because the "working directory" (where relative paths begin)
-	// will be different during the following two scenarios:
-	//  - Debugging in VS: The "Project Directory" (where your .cpp files are) 
-	//  - Run .exe directly: The "Output Directory" (where the .exe & .cso files are)
+	const PipelineState* litTexturedState = stateCache->GetPipelineState(
+		litTexturedVS,
+		litTexturedPS,
+		stateCache->GetRasterizerState(PipelineStateCache::DefaultRasterizerDesc()),
+		stateCache->GetBlendState(PipelineStateCache::DefaultBlendDesc()),
+		stateCache->GetDepthStencilState(depthDesc));
+	const PipelineState* litTexturedPrepassedState = stateCache->GetPipelineState(
+		litTexturedVS,
+		litTexturedPS,
+		stateCache->GetRasterizerState(PipelineStateCache::DefaultRasterizerDesc()),
+		stateCache->GetBlendState(PipelineStateCache::DefaultBlendDesc()),
+		stateCache->GetDepthStencilState(depthPrepass->GetShadingDepthDesc()));
 
-	// Checking both paths is the easiest way to ensure both 
-	// scenarios work correctly, although others exist
+	// Each material holds a reference to its texture
+	resources->AddRef(radTexture);
+	resources->AddRef(mtlTexture);
+	myMaterial = resources->Add(new Materials(stateCache, litTexturedState, radTexture, sampler));
+	metalMat = resources->Add(new Materials(stateCache, litTexturedState, mtlTexture, sampler));
+	resources->Get(myMaterial)->SetPrepassedState(litTexturedPrepassedState);
+	resources->Get(metalMat)->SetPrepassedState(litTexturedPrepassedState);
+
+	// Our C++ cbuffer structs are copied over whole, so make sure
+	// they still match what the compiled shaders expect
+	if (litTexturedVS && !litTexturedVS->ValidateBufferLayout<VertexShaderExternalData>())
+		printf("VertexShaderExternalData does not match the vertex shader's cbuffer\n");
+	if (litTexturedPS && !litTexturedPS->ValidateBufferLayout<PixelShaderExternalData>())
+		printf("PixelShaderExternalData does not match the pixel shader's cbuffer\n");
+	if (litTexturedPS && !litTexturedPS->ValidateBufferLayout<SHCoefficients>())
+		printf("SHCoefficients does not match the pixel shader's probes cbuffer\n");
 }
 
 
@@ -164,7 +343,7 @@ void Game::LoadShaders()
 void Game::CreateMatrices()
 {
 	// Create the camera which has a view matrix
-	myCamera = new Camera(XMFLOAT3(0, 0, -5), 2, width, height);
+	myCamera = new Camera(CAMERA_START_POSITION, 2, width, height, depthMode);
 }
 
 
@@ -212,20 +391,82 @@ void Game::CreateBasicGeometry()
 	int indicesOne[] = { 0, 1, 2 };
 	int indicesTwo[] = { 2, 0, 1, 2, 1, 3 };
 
-	// Create our meshes for the game
-	meshOne = new Mesh(verticesOne, 3, indicesOne, 3, device);
-	meshTwo = new Mesh(verticesTwo, 4, indicesTwo, 6, device);
-	meshObject = new Mesh("cone.obj", device);
-	meshCube = new Mesh("cube.obj", device);
+	// Create our meshes for the game, all sharing one set of buffers
+	geometry = new GeometryPool(device, context, vertexFormat, 64 * 1024, 64 * 1024);
+	clusterCuller = new ClusterCuller(device, context);
+	meshOne = resources->Add(new Mesh(verticesOne, 3, indicesOne, 3, geometry));
+	meshTwo = resources->Add(new Mesh(verticesTwo, 4, indicesTwo, 6, geometry));
+	meshObject = resources->Add(new Mesh("cone.obj", geometry));
+	meshCube = resources->Add(new Mesh("cube.obj", geometry));
+
+	// Bake ambient occlusion across every core.  Models keep their
+	// bakes next to them, so only the first run (or the first after
+	// they change) pays for it.
+	resources->Get(meshOne)->BakeOcclusion(threads, OCCLUSION_RAYS_PER_VERTEX);
+	resources->Get(meshTwo)->BakeOcclusion(threads, OCCLUSION_RAYS_PER_VERTEX);
+	resources->Get(meshObject)->BakeOcclusion(threads, OCCLUSION_RAYS_PER_VERTEX, "Assets/Models/cone.obj" OCCLUSION_CACHE_EXTENSION);
+	resources->Get(meshCube)->BakeOcclusion(threads, OCCLUSION_RAYS_PER_VERTEX, "Assets/Models/cube.obj" OCCLUSION_CACHE_EXTENSION);
+	meshFiles[L"Assets/Models/cone.obj"] = meshObject;
+	meshFiles[L"Assets/Models/cube.obj"] = meshCube;
+	assetWatcher->SetMeshSettings(vertexFormat, OCCLUSION_RAYS_PER_VERTEX);
+	assetWatcher->WatchFile(L"Assets/Models/cone.obj", ASSET_MESH);
+	assetWatcher->WatchFile(L"Assets/Models/cube.obj", ASSET_MESH);
 
 	// Create game entities with the new meshes and individual world matricies.
 	//gameEntities.push_back(new GameEntity(meshOne, myMaterial));
 	//gameEntities.push_back(new GameEntity(meshOne, myMaterial));
 	//gameEntities.push_back(new GameEntity(meshTwo, myMaterial));
-	gameEntities.push_back(new GameEntity(meshObject, myMaterial));
-	GameEntity* temp = new GameEntity(meshCube, metalMat);
+	// Every entity holds a reference to its mesh and material
+	entities = new EntityPool();
+	raycaster = new SceneRaycaster();
+
+	resources->AddRef(meshObject);
+	resources->AddRef(myMaterial);
+	entities->Spawn(meshObject, myMaterial);
+
+	resources->AddRef(meshCube);
+	resources->AddRef(metalMat);
+	GameEntity* temp = entities->Get(entities->Spawn(meshCube, metalMat));
 	temp->SetPosition(XMFLOAT3(4, 0 , 0));
-	gameEntities.push_back(temp);
+
+	// Bake ambient light probes around everything we just placed.
+	// The sky is the first light's ambient color, darker below.
+	entities->ForEach([](GameEntity* entity)
+	{
+		// Placed, not moved - nothing to interpolate from
+		entity->StorePreviousTransform();
+		entity->CalculateWorldMatrix();
+	});
+	BakeProbes();
+}
+
+// --------------------------------------------------------
+// Bakes the ambient light probes against wherever the
+// entities and their meshes are now.  The grid is placed
+// around the scene the first time, and kept after that.
+// --------------------------------------------------------
+void Game::BakeProbes()
+{
+	raycaster->Build(entities, resources);
+
+	if (!probes)
+	{
+		XMFLOAT3 sceneMin, sceneMax;
+		if (!raycaster->GetBounds(&sceneMin, &sceneMax))
+			return;
+
+		XMFLOAT3 margin(2.0f, 2.0f, 2.0f);
+		XMStoreFloat3(&sceneMin, XMVectorSubtract(XMLoadFloat3(&sceneMin), XMLoadFloat3(&margin)));
+		XMStoreFloat3(&sceneMax, XMVectorAdd(XMLoadFloat3(&sceneMax), XMLoadFloat3(&margin)));
+		probes = new SHProbeGrid(sceneMin, sceneMax, 16, 8, 16);
+	}
+
+	SHBakeSettings probeSettings;
+	probeSettings.SkyColor = XMFLOAT3(dirLightOne.AmbientColor.x, dirLightOne.AmbientColor.y, dirLightOne.AmbientColor.z);
+	XMStoreFloat3(&probeSettings.GroundColor, XMVectorScale(XMLoadFloat3(&probeSettings.SkyColor), 0.5f));
+	probeSettings.RaysPerProbe = 256;
+	probeSettings.MaxDistance = 10.0f;
+	probes->Bake(*raycaster, probeSettings, threads);
 }
 
 
@@ -241,6 +482,259 @@ void Game::OnResize()
 	// Resize the projection matrix in our Camera
 	myCamera->Resize(width, height);
 
+	// The offscreen scene always matches the back buffer (the render
+	// graph lets go of the old size's targets on its own)
+	dynamicResolution->Resize(width, height);
+
+}
+
+// --------------------------------------------------------
+// The mips come from the .dds too, so there's nothing to
+// generate - null if it's missing or unreadable
+// --------------------------------------------------------
+ID3D11ShaderResourceView* Game::LoadCompressedTexture(const wstring& sourcePath)
+{
+	ID3D11ShaderResourceView* srv = 0;
+	if (FAILED(CreateDDSTextureFromFile(device, TextureImporter::GetCompressedPath(sourcePath).c_str(), 0, &srv)))
+		return 0;
+	return srv;
+}
+
+// --------------------------------------------------------
+// A single magenta texel, so a missing texture stands out
+// --------------------------------------------------------
+ID3D11ShaderResourceView* Game::CreatePlaceholderTexture()
+{
+	const unsigned int magenta = 0xFFFF00FF;
+
+	D3D11_TEXTURE2D_DESC textureDesc = {};
+	textureDesc.Width = 1;
+	textureDesc.Height = 1;
+	textureDesc.MipLevels = 1;
+	textureDesc.ArraySize = 1;
+	textureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	textureDesc.Usage = D3D11_USAGE_IMMUTABLE;
+	textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	textureDesc.SampleDesc.Count = 1;
+
+	D3D11_SUBRESOURCE_DATA initialData = {};
+	initialData.pSysMem = &magenta;
+	initialData.SysMemPitch = sizeof(magenta);
+
+	ID3D11Texture2D* texture = 0;
+	if (FAILED(device->CreateTexture2D(&textureDesc, &initialData, &texture)))
+		return 0;
+
+	ID3D11ShaderResourceView* srv = 0;
+	device->CreateShaderResourceView(texture, 0, &srv);
+	texture->Release();
+	return srv;
+}
+
+// --------------------------------------------------------
+// Registers a compressed texture.  One that won't load is
+// reported and stands in as the placeholder instead, so its
+// handle is still live and fixing the file on disk swaps
+// the real one in (the registry won't take a null SRV).
+// --------------------------------------------------------
+TextureHandle Game::AddTexture(const wstring& sourcePath)
+{
+	ID3D11ShaderResourceView* srv = LoadCompressedTexture(sourcePath);
+	if (!srv)
+	{
+		printf("Couldn't load %ls, using a placeholder\n", sourcePath.c_str());
+		srv = CreatePlaceholderTexture();
+	}
+	return resources->Add(srv);
+}
+
+// --------------------------------------------------------
+// Swaps in any assets the watcher has finished reloading.
+// Called once a frame, at the top of Draw(), so a frame is
+// always drawn entirely with either the old or the new
+// version (however many ticks it ran).
+// --------------------------------------------------------
+void Game::ApplyAssetReloads()
+{
+	vector<AssetReload> reloads;
+	assetWatcher->TakeReloads(reloads);
+	bool probesStale = false;
+
+	for (unsigned int i = 0; i < reloads.size(); i++)
+	{
+		AssetReload& reload = reloads[i];
+		switch (reload.Type)
+		{
+		case ASSET_MESH:
+		{
+			// Built and baked on the watcher thread, so this is just the
+			// upload.  Every handle to the mesh now refers to the new
+			// one, and the old one is destroyed once the GPU is done.
+			Mesh* newMesh = new Mesh(reload.Geometry, geometry);
+			if (!resources->Replace(meshFiles[reload.Path], newMesh))
+				delete newMesh;
+			else
+				probesStale = true;
+			break;
+		}
+
+		case ASSET_TEXTURE:
+		{
+			// Recompress, then load the result like any other time
+			if (!textureImporter->Import(reload.Path, &reload.FileData[0], reload.FileData.size(), COLOR_TEXTURE_FORMAT))
+				break;
+			ID3D11ShaderResourceView* newSRV = LoadCompressedTexture(reload.Path);
+			if (!newSRV)
+				break;
+
+			if (!resources->Replace(textureFiles[reload.Path], newSRV))
+				newSRV->Release();
+			break;
+		}
+
+		case ASSET_SHADER:
+			if (!vertexShaders->Reload(reload.Path) && !pixelShaders->Reload(reload.Path) &&
+				!depthPrepass->ReloadShader(reload.Path))
+				dynamicResolution->ReloadShader(reload.Path);
+			break;
+		}
+
+		printf("Reloaded %ls\n", reload.Path.c_str());
+	}
+
+	// The probes saw the old shapes (once, however many changed)
+	if (probesStale)
+		BakeProbes();
+}
+
+// --------------------------------------------------------
+// F9 starts recording input (and saves it when pressed
+// again), F10 plays the last recording back.  Both are
+// ignored during a replay, which recorded them too.
+// --------------------------------------------------------
+void Game::UpdateRecording()
+{
+	const InputSnapshot& snapshot = input.GetSnapshot();
+	if (IsReplaying())
+		return;
+
+	if (snapshot.Pressed[ACTION_RECORD])
+	{
+		if (!IsRecording())
+		{
+			StartRecording();
+			printf("Recording input\n");
+		}
+		else if (StopRecording(INPUT_RECORDING_FILE))
+		{
+			printf("Saved input to %s\n", INPUT_RECORDING_FILE);
+		}
+	}
+	else if (snapshot.Pressed[ACTION_REPLAY])
+	{
+		FrameRecording* recording = new FrameRecording();
+		if (recording->Load(INPUT_RECORDING_FILE))
+		{
+			printf("Replaying input from %s\n", INPUT_RECORDING_FILE);
+			StartReplay(recording);
+		}
+		else
+			delete recording;
+	}
+}
+
+// --------------------------------------------------------
+// The camera's pose, as 5 floats
+// --------------------------------------------------------
+void Game::OnRecordingStart(std::vector<unsigned char>& startState)
+{
+	float pose[5];
+	XMFLOAT3 position;
+	myCamera->GetPose(&position, &pose[3], &pose[4]);
+	pose[0] = position.x;
+	pose[1] = position.y;
+	pose[2] = position.z;
+
+	startState.assign((unsigned char*)pose, (unsigned char*)pose + sizeof(pose));
+}
+
+// --------------------------------------------------------
+// A recording without a pose (like the built in flythrough)
+// starts from where the camera starts out
+// --------------------------------------------------------
+void Game::OnReplayStart(const std::vector<unsigned char>& startState)
+{
+	float pose[5] = { CAMERA_START_POSITION.x, CAMERA_START_POSITION.y, CAMERA_START_POSITION.z, 0.0f, 0.0f };
+	if (startState.size() == sizeof(pose))
+		memcpy(pose, &startState[0], sizeof(pose));
+
+	myCamera->SetPose(XMFLOAT3(pose[0], pose[1], pose[2]), pose[3], pose[4]);
+}
+
+float Game::GetGPUFrameTime()
+{
+	return dynamicResolution ? dynamicResolution->GetLastGPUTime() : 0.0f;
+}
+
+// --------------------------------------------------------
+// Benchmarks are ready to go before Init(), so loading can
+// set itself up for one (dynamic resolution is pinned)
+// --------------------------------------------------------
+void Game::SetUpBenchmark(const char* recordingPath)
+{
+	FrameRecording* script = new FrameRecording();
+	if (!recordingPath || !script->Load(recordingPath))
+		CreateBenchmarkFlythrough(script);
+
+	printf("Benchmarking %u frames (%.1f seconds)\n", script->GetFrameCount(), script->GetDuration());
+	StartBenchmark(script, BENCHMARK_OUTPUT);
+}
+
+// --------------------------------------------------------
+// Meshes pick their vertex layout when they load in Init(),
+// so this has to come before that to take effect
+// --------------------------------------------------------
+void Game::SetVertexFormat(VertexStreamFormat format)
+{
+	vertexFormat = format;
+}
+
+// --------------------------------------------------------
+// A scripted 20 second flight at 60 fps: back and forth
+// through the scene while turning slowly, then a climb and
+// a drop, so the view sweeps over every entity
+// --------------------------------------------------------
+void Game::CreateBenchmarkFlythrough(FrameRecording* script)
+{
+	const float frameTime = 1.0f / 60.0f;
+	const unsigned int frameCount = 20 * 60;
+
+	InputSnapshot snapshot;
+	for (unsigned int f = 0; f < frameCount; f++)
+	{
+		float t = f * frameTime;
+		for (unsigned int a = 0; a < ACTION_COUNT; a++)
+		{
+			snapshot.Held[a] = false;
+			snapshot.Pressed[a] = false;
+			snapshot.Released[a] = false;
+			snapshot.HeldTime[a] = 0.0f;
+		}
+
+		InputAction move = t < 6.0f ? ACTION_MOVE_FORWARD : t < 12.0f ? ACTION_MOVE_BACK : t < 16.0f ? ACTION_MOVE_UP : ACTION_MOVE_DOWN;
+		snapshot.Held[move] = true;
+		snapshot.HeldTime[move] = frameTime;
+
+		snapshot.Start = 0.0;
+		snapshot.End = 0.0;
+		snapshot.MouseX = 0;
+		snapshot.MouseY = 0;
+		snapshot.LookX = f % 2 == 0 ? 1 : 0;
+		snapshot.LookY = 0;
+		snapshot.Wheel = 0.0f;
+
+		script->AddFrame(frameTime, snapshot);
+	}
 }
 
 // --------------------------------------------------------
@@ -248,8 +742,11 @@ void Game::OnResize()
 // --------------------------------------------------------
 void Game::Update(float deltaTime, float totalTime)
 {
+	// Whatever moves this tick is drawn blending in from here
+	entities->ForEach([](GameEntity* entity) { entity->StorePreviousTransform(); });
+
 	// Quit if the escape key is pressed
-	if (GetAsyncKeyState(VK_ESCAPE))
+	if (input.GetSnapshot().Held[ACTION_QUIT])
 		Quit();
 
 	float sinTime = (sin(totalTime * 3) + 2.0f) / 10.0f;
@@ -265,46 +762,194 @@ void Game::Update(float deltaTime, float totalTime)
 	gameEntities[1]->SetScale(sinTime);
 	gameEntities[1]->SetRotationZ(-totalTime);
 	gameEntities[1]->SetTranslation(2* cos(gameEntities[1]->GetAngleFromOrigin() + DirectX::XM_PI), 2 * sin (gameEntities[1]->GetAngleFromOrigin() + DirectX::XM_PI));*/
-
-	// Update the view matrix every frame.
-	myCamera->Update(deltaTime);
 }
 
 // --------------------------------------------------------
 // Clear the screen, redraw everything, present to the user
 // --------------------------------------------------------
-void Game::Draw(float deltaTime, float totalTime)
+void Game::Draw(float deltaTime, float totalTime, float interpolation)
 {
+	// Pick up changed assets before anything draws with them
+	ApplyAssetReloads();
+
+	// Update the view matrix every frame.  The camera follows input
+	// directly, so it moves per frame rather than per tick.
+	UpdateRecording();
+	myCamera->Update(input.GetSnapshot());
+
 	// Background color (Cornflower Blue in this case) for clearing
 	const float color[4] = {0.4f, 0.6f, 0.75f, 0.0f};
 
-	// Clear the render target and depth buffer (erases what's on the screen)
+	// Aim drawing at however much of the scene's targets this frame's
+	// resolution uses, and start timing the GPU
 	//  - Do this ONCE PER FRAME
 	//  - At the beginning of Draw (before drawing *anything*)
-	context->ClearRenderTargetView(backBufferRTV, color);
-	context->ClearDepthStencilView(
-		depthStencilView, 
-		D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL,
-		1.0f,
-		0);
+	dynamicResolution->BeginScene();
 
 	
-	for (int i = 0; i < numberGameEntities; i++)
+	// Gather this frame's draw list (in frame memory, not the heap) and
+	// sort it by material, so entities sharing shaders and states draw
+	// back to back and the pipeline state cache can skip rebinding them
+	FrameVector<GameEntity*> drawList;
+	drawList.reserve(entities->GetCount());
+	entities->ForEach([&](GameEntity* entity) { drawList.push_back(entity); });
+
+	std::sort(drawList.begin(), drawList.end(), [](GameEntity* a, GameEntity* b)
+	{
+		return a->GetMaterial().Value < b->GetMaterial().Value;
+	});
+
+	// Calculate the new worldMatrix for each entity, and the one matrix
+	// its vertices need (which both passes below share).  Ambient light
+	// is sampled here too, so it only lives as long as the frame.
+	const XMFLOAT4X4& viewProjection = myCamera->GetViewProjectionMatrix();
+	FrameVector<XMFLOAT4X4> worldViewProjs;
+	FrameVector<SHCoefficients> ambients;
+	worldViewProjs.reserve(drawList.size());
+	ambients.resize(drawList.size());
+	for (unsigned int i = 0; i < drawList.size(); i++)
+	{
+		drawList[i]->CalculateWorldMatrix(interpolation);
+		worldViewProjs.push_back(drawList[i]->GetWorldViewProj(viewProjection));
+
+		// Unlit if there are no probes
+		XMFLOAT3 position = drawList[i]->GetPosition();
+		if (probes)
+			probes->Sample(XMLoadFloat3(&position), &ambients[i]);
+		else
+			ambients[i] = {};
+	}
+
+	// Cull every entity's clusters up front, so all of the surviving
+	// indices go to the GPU in a single upload
+	// (Anything going wrong just draws whole meshes this frame.)
+	FrameVector<ClusterDraw> clusterDraws;
+	bool drawClusters = clusterCulling;
+	if (drawClusters)
+	{
+		clusterDraws.reserve(drawList.size());
+		clusterCuller->Begin(viewProjection, myCamera->GetPosition());
+		for (unsigned int i = 0; i < drawList.size(); i++)
+		{
+			ClusterDraw draw = {};
+			Mesh* mesh = resources->Get(drawList[i]->GetMesh());
+			if (mesh)
+				draw = clusterCuller->Cull(mesh, drawList[i]->GetMatrix());
+			clusterDraws.push_back(draw);
+		}
+
+		if (!clusterCuller->Upload())
+			drawClusters = false;
+	}
+
+	// Overdraw is counted in whichever pass lays depth down
+	bool prepass = depthPrepass->IsEnabled();
+	unsigned int renderPixels = dynamicResolution->GetRenderWidth() * dynamicResolution->GetRenderHeight();
+
+	// Describe the frame as passes over the scene's targets.  The graph
+	// puts them in order and finds (or reuses) textures for the targets.
+	renderGraph->Reset();
+	unsigned int backBuffer = renderGraph->ImportTexture("BackBuffer", backBufferRTV, 0, 0);
+	unsigned int sceneColor = renderGraph->AddTexture("SceneColor", dynamicResolution->GetSceneColorDesc());
+	unsigned int sceneDepth = renderGraph->AddTexture("SceneDepth", dynamicResolution->GetSceneDepthDesc());
+
+	// Depth first, from just the positions, drawing exactly what the
+	// shading pass will (same list, same culled clusters)
+	if (prepass)
 	{
-		// Calculate the new worldMatrix for entity
-		gameEntities[i]->CalculateWorldMatrix();
+		unsigned int prepassPass = renderGraph->AddPass("DepthPrepass", [&]()
+		{
+			ID3D11DepthStencilView* depth = renderGraph->GetDSV(sceneDepth);
+			context->OMSetRenderTargets(0, 0, depth);
+			context->ClearDepthStencilView(depth, DepthClearFlags(depthMode), DepthClearValue(depthMode), 0);
+
+			geometry->BindPositions();
+			if (drawClusters)
+				clusterCuller->Bind();
 
-		// Set all material data for each game entity
-		gameEntities[i]->PrepareMaterials(myCamera->GetViewMatrix(), myCamera->GetProjectionMatrix(), dirLightOne, dirLightTwo);
+			depthPrepass->Begin();
+			depthPrepass->BeginMeasuring();
+			for (unsigned int i = 0; i < drawList.size(); i++)
+			{
+				if (drawClusters && clusterDraws[i].IndexCount == 0)
+					continue;
 
-		// Custom draw method that will set the mesh verticies for us
-		gameEntities[i]->Draw(context);
+				depthPrepass->PrepareObject(worldViewProjs[i], resources->Get(drawList[i]->GetMesh()));
+				if (drawClusters)
+					drawList[i]->Draw(context, resources, clusterDraws[i]);
+				else
+					drawList[i]->Draw(context, resources);
+			}
+			depthPrepass->EndMeasuring(renderPixels);
+		});
+		renderGraph->Write(prepassPass, sceneDepth);
 	}
 
+	unsigned int shadingPass = renderGraph->AddPass("Shading", [&]()
+	{
+		// Clear the whole of each target, not just the viewport, so a
+		// scale change never shows stale pixels along the edges
+		ID3D11RenderTargetView* target = renderGraph->GetRTV(sceneColor);
+		ID3D11DepthStencilView* depth = renderGraph->GetDSV(sceneDepth);
+		context->OMSetRenderTargets(1, &target, depth);
+		context->ClearRenderTargetView(target, color);
+		if (!prepass)
+			context->ClearDepthStencilView(depth, DepthClearFlags(depthMode), DepthClearValue(depthMode), 0);
+
+		// Every mesh shares the same vertex buffer (and index buffer,
+		// unless we're drawing culled clusters)
+		geometry->Bind();
+		if (drawClusters)
+			clusterCuller->Bind();
+
+		if (!prepass)
+			depthPrepass->BeginMeasuring();
+
+		for (unsigned int i = 0; i < drawList.size(); i++)
+		{
+			GameEntity* entity = drawList[i];
+
+			// Nothing left of it to draw?
+			if (drawClusters && clusterDraws[i].IndexCount == 0)
+				continue;
+
+			// Set all material data for each game entity
+			entity->PrepareMaterials(worldViewProjs[i], ambients[i], dirLightOne, dirLightTwo, resources, prepass);
+
+			// Custom draw method that will set the mesh verticies for us
+			if (drawClusters)
+				entity->Draw(context, resources, clusterDraws[i]);
+			else
+				entity->Draw(context, resources);
+		}
+
+		if (!prepass)
+			depthPrepass->EndMeasuring(renderPixels);
+	});
+	if (prepass)
+		renderGraph->Read(shadingPass, sceneDepth);
+	renderGraph->Write(shadingPass, sceneDepth);
+	renderGraph->Write(shadingPass, sceneColor);
+
+	// Stretch the scene over the back buffer.  This rebinds the back
+	// buffer every frame, which flip model swap chains need anyway
+	// (they unbind it on every Present()).
+	unsigned int upscalePass = renderGraph->AddPass("Upscale", [&]()
+	{
+		dynamicResolution->EndScene(renderGraph->GetSRV(sceneColor), renderGraph->GetRTV(backBuffer));
+	});
+	renderGraph->Read(upscalePass, sceneColor);
+	renderGraph->Write(upscalePass, backBuffer);
+
+	renderGraph->Execute();
+
 	// Present the back buffer to the user
 	//  - Puts the final frame we're drawing into the window so the user can see it
 	//  - Do this exactly ONCE PER FRAME (always at the very end of the frame)
 	swapChain->Present(0, 0);
+
+	// Anything released a few frames ago is no longer in use by the GPU
+	resources->EndFrame();
 }
 
 
@@ -317,7 +962,18 @@ void Game::Draw(float deltaTime, float totalTime)
 // --------------------------------------------------------
 void Game::OnMouseDown(WPARAM buttonState, int x, int y)
 {
-	// Add any custom code here...
+	// Left click picks whatever entity is under the cursor, or
+	// nothing on empty space.  The scene is rebuilt first so it
+	// sees where entities are now.
+	if (buttonState & MK_LBUTTON)
+	{
+		raycaster->Build(entities, resources);
+
+		SceneHit hit;
+		entityPicked = raycaster->Raycast(myCamera->GetPickRay(x, y, width, height), &hit);
+		if (entityPicked)
+			pickedEntity = hit.Entity;
+	}
 
 	// Save the previous mouse position, so we have it for the future
 	prevMousePos.x = x;
@@ -349,11 +1005,8 @@ void Game::OnMouseUp(WPARAM buttonState, int x, int y)
 void Game::OnMouseMove(WPARAM buttonState, int x, int y)
 {
 	// Add any custom code here...
-	if (buttonState && 0x0002)
-	{
-		myCamera->RotateX(y - prevMousePos.y);
-		myCamera->RotateY(x - prevMousePos.x);
-	}
+	//  - Dragging turns the camera through the input snapshot (ACTION_LOOK)
+
 	// Save the previous mouse position, so we have it for the future
 	prevMousePos.x = x;
 	prevMousePos.y = y;
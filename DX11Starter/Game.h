@@ -3,12 +3,25 @@
 #include "DXCore.h"
 #include "Mesh.h"
 #include "GameEntity.h"
+#include "EntityPool.h"
+#include "SceneRaycaster.h"
+#include "LightProbes.h"
 #include "Camera.h"
 #include "Lights.h"
 #include "SimpleShader.h"
+#include "ShaderVariants.h"
+#include "PipelineStateCache.h"
+#include "AssetWatcher.h"
+#include "ResourceRegistry.h"
 #include "Materials.h"
+#include "ThreadPool.h"
+#include "TextureImporter.h"
+#include "DynamicResolution.h"
+#include "DepthPrepass.h"
+#include "RenderGraph.h"
 #include <DirectXMath.h>
 #include <vector>
+#include <unordered_map>
 
 using namespace std;
 
@@ -25,49 +38,110 @@ public:
 	void Init();
 	void OnResize();
 	void Update(float deltaTime, float totalTime);
-	void Draw(float deltaTime, float totalTime);
+	void Draw(float deltaTime, float totalTime, float interpolation);
 
 	// Overridden mouse input helper methods
 	void OnMouseDown (WPARAM buttonState, int x, int y);
 	void OnMouseUp	 (WPARAM buttonState, int x, int y);
 	void OnMouseMove (WPARAM buttonState, int x, int y);
 	void OnMouseWheel(float wheelDelta,   int x, int y);
+
+	// Benchmarks the recording at this path (or a built in flythrough
+	// if it's null or can't be loaded).  Call before Run().
+	void SetUpBenchmark(const char* recordingPath);
+
+	// Meshes are loaded at full precision unless this asks for
+	// quantized vertices instead.  Call before Run().
+	void SetVertexFormat(VertexStreamFormat format);
+
+	// Recordings start and replay from the camera's pose
+	void OnRecordingStart(std::vector<unsigned char>& startState);
+	void OnReplayStart(const std::vector<unsigned char>& startState);
+	float GetGPUFrameTime();
 private:
 
 	// Initialization helper methods - feel free to customize, combine, etc.
 	void LoadShaders(); 
 	void CreateMatrices();
 	void CreateBasicGeometry();
+	void ApplyAssetReloads();
+	void BakeProbes();
+	ID3D11ShaderResourceView* LoadCompressedTexture(const wstring& sourcePath);
+	ID3D11ShaderResourceView* CreatePlaceholderTexture();
+	TextureHandle AddTexture(const wstring& sourcePath);
+	void UpdateRecording();
+	void CreateBenchmarkFlythrough(FrameRecording* script);
+
+	// Owns all meshes, materials and textures
+	ResourceRegistry* resources;
+
+	// Shared vertex and index buffers for every mesh
+	GeometryPool* geometry;
+	VertexStreamFormat vertexFormat;
+
+	// Every core, for baking and texture compression
+	ThreadPool* threads;
+
+	// Compresses textures into .dds files as they're loaded
+	TextureImporter* textureImporter;
+
+	// Culls each mesh's clusters before drawing
+	ClusterCuller* clusterCuller;
+	bool clusterCulling;
 
 	// Mesh containers for buffer values
-	Mesh* meshOne;
-	Mesh* meshTwo;
-	Mesh* meshObject;
-	Mesh* meshCube;
+	MeshHandle meshOne;
+	MeshHandle meshTwo;
+	MeshHandle meshObject;
+	MeshHandle meshCube;
 
 	// Make a few GameEntities
-	int numberGameEntities = 2;
-	vector<GameEntity*> gameEntities;
+	EntityPool* entities;
+
+	// Ray queries against the entities (mouse picking)
+	SceneRaycaster* raycaster;
+	bool entityPicked;
+	unsigned int pickedEntity;	// Last one clicked on, if entityPicked
+
+	// Baked ambient light, sampled for each entity as it's drawn
+	SHProbeGrid* probes;
 
 	// Make a new Camera
 	Camera* myCamera;
 
-	// Shaders for game
-	SimpleVertexShader* vertexShader;
-	SimplePixelShader* pixelShader;
+	// Renders the scene smaller when the GPU falls behind
+	DynamicResolution* dynamicResolution;
+
+	// Lays depth down before shading, while overdraw is high
+	DepthPrepass* depthPrepass;
+
+	// Orders each frame's passes and owns their render targets
+	RenderGraph* renderGraph;
+
+	// Every shared state object (input layouts, samplers, etc.)
+	PipelineStateCache* stateCache;
+
+	// Shader permutations for game, looked up by feature mask
+	ShaderVariantCache<SimpleVertexShader>* vertexShaders;
+	ShaderVariantCache<SimplePixelShader>* pixelShaders;
 
 	// Lights for game
 	DirectionalLight dirLightOne;
 	DirectionalLight dirLightTwo;
 
 	// Textures for the game
-	ID3D11ShaderResourceView* radSRV;
-	ID3D11ShaderResourceView* mtlSRV;
+	TextureHandle radTexture;
+	TextureHandle mtlTexture;
 	ID3D11SamplerState* sampler;
 
 	//Material for all current stuff
-	Materials* myMaterial;
-	Materials* metalMat;
+	MaterialHandle myMaterial;
+	MaterialHandle metalMat;
+
+	// Reloads assets as they change on disk, and what each file feeds
+	AssetWatcher* assetWatcher;
+	unordered_map<wstring, MeshHandle> meshFiles;
+	unordered_map<wstring, TextureHandle> textureFiles;
 
 	// Keeps track of the old mouse position.  Useful for 
 	// determining how far the mouse moved in a single frame.
@@ -1,11 +1,12 @@
 #include "GameEntity.h"
 #include "Mesh.h"
 #include "Lights.h"
+#include "ConstantBuffers.h"
 #include <DirectXMath.h>
 
 using namespace DirectX;
 
-GameEntity::GameEntity(Mesh* entityMesh, Materials* newMaterial)
+GameEntity::GameEntity(MeshHandle entityMesh, MaterialHandle newMaterial)
 {
 	myMesh = entityMesh;
 	myMaterial = newMaterial;
@@ -16,6 +17,7 @@ GameEntity::GameEntity(Mesh* entityMesh, Materials* newMaterial)
 	position = DirectX::XMFLOAT3(+0.0f, +0.0f, +0.0f);
 	scalar = DirectX::XMFLOAT3(+1.0f, +1.0f, +1.0f);
 	rotation = DirectX::XMFLOAT3(+0.0f, +0.0f, +0.0f);
+	StorePreviousTransform();
 	angleFromOrigin = 0.0f;
 }
 
@@ -69,24 +71,36 @@ void GameEntity::SetTranslation(float x, float y)
 	SetPosition(DirectX::XMFLOAT3(x, y, position.z));
 }
 
-void GameEntity::CalculateWorldMatrix()
+void GameEntity::StorePreviousTransform()
 {
-	DirectX::XMMATRIX scale = DirectX::XMMatrixScaling(scalar.x, scalar.y, scalar.z);
-	DirectX::XMMATRIX localRotation = DirectX::XMMatrixRotationZ(rotation.z);
-	DirectX::XMMATRIX localPosition = DirectX::XMMatrixTranslation(position.x, position.y, position.z);
+	previousPosition = position;
+	previousScalar = scalar;
+	previousRotation = rotation;
+}
+
+void GameEntity::CalculateWorldMatrix(float interpolation)
+{
+	// Blend from where the last tick left us to where this one did,
+	// so motion stays smooth when frames and ticks don't line up
+	XMFLOAT3 drawPosition, drawScalar, drawRotation;
+	XMStoreFloat3(&drawPosition, XMVectorLerp(XMLoadFloat3(&previousPosition), XMLoadFloat3(&position), interpolation));
+	XMStoreFloat3(&drawScalar, XMVectorLerp(XMLoadFloat3(&previousScalar), XMLoadFloat3(&scalar), interpolation));
+	XMStoreFloat3(&drawRotation, XMVectorLerp(XMLoadFloat3(&previousRotation), XMLoadFloat3(&rotation), interpolation));
+
+	DirectX::XMMATRIX scale = DirectX::XMMatrixScaling(drawScalar.x, drawScalar.y, drawScalar.z);
+	DirectX::XMMATRIX localRotation = DirectX::XMMatrixRotationZ(drawRotation.z);
+	DirectX::XMMATRIX localPosition = DirectX::XMMatrixTranslation(drawPosition.x, drawPosition.y, drawPosition.z);
 
 	SetMatrix(DirectX::XMMatrixTranspose(scale * localRotation * localPosition));
 }
-void GameEntity::Draw(ID3D11DeviceContext*	context)
+void GameEntity::Draw(ID3D11DeviceContext*	context, ResourceRegistry* resources)
 {
-	// Set buffers in the input assembler
-	//  - Do this ONCE PER OBJECT you're drawing, since each object might
-	//    have different geometry.
-	UINT stride = sizeof(Vertex);
-	UINT offset = 0;
-	ID3D11Buffer* temp = myMesh->GetVertexBuffer();
-	context->IASetVertexBuffers(0, 1, &temp, &stride, &offset);
-	context->IASetIndexBuffer(myMesh->GetIndexBuffer(), DXGI_FORMAT_R32_UINT, 0);
+	Mesh* mesh = resources->Get(myMesh);
+	if (!mesh)
+		return;
+
+	// Every mesh lives in the shared GeometryPool buffers, which are
+	// bound once per frame, so there's nothing to set up per object
 
 	// Finally do the actual drawing
 	//  - Do this ONCE PER OBJECT you intend to draw
@@ -94,51 +108,85 @@ void GameEntity::Draw(ID3D11DeviceContext*	context)
 	//  - DrawIndexed() uses the currently set INDEX BUFFER to look up corresponding
 	//     vertices in the currently set VERTEX BUFFER
 	context->DrawIndexed(
-		myMesh->GetIndexCount(),     // The number of indices to use (we could draw a subset if we wanted)
-		0,     // Offset to the first index we want to use
-		0);    // Offset to add to each index when looking up vertices
+		mesh->GetIndexCount(),       // The number of indices to use (we could draw a subset if we wanted)
+		mesh->GetFirstIndex(),       // Offset to the first index we want to use
+		mesh->GetBaseVertex());      // Offset to add to each index when looking up vertices
 }
 
-void GameEntity::PrepareMaterials(XMFLOAT4X4 viewMatrix, XMFLOAT4X4 projectionMarix, DirectionalLight& dirLightOne, DirectionalLight& dirLightTwo)
+void GameEntity::Draw(ID3D11DeviceContext*	context, ResourceRegistry* resources, const ClusterDraw& clusters)
 {
+	Mesh* mesh = resources->Get(myMesh);
+	if (!mesh || clusters.IndexCount == 0)
+		return;
+
+	// The culled indices are still relative to the mesh, so the
+	// mesh's base vertex in the pool applies as usual
+	context->DrawIndexed(
+		clusters.IndexCount,
+		clusters.FirstIndex,
+		mesh->GetBaseVertex());
+}
+
+// --------------------------------------------------------
+// Both matrices are stored transposed, so world * viewProj
+// comes out as viewProj * world
+// --------------------------------------------------------
+XMFLOAT4X4 GameEntity::GetWorldViewProj(const XMFLOAT4X4& viewProjection)
+{
+	XMFLOAT4X4 worldViewProj;
+	XMStoreFloat4x4(&worldViewProj, XMMatrixMultiply(XMLoadFloat4x4(&viewProjection), XMLoadFloat4x4(&worldMatrix)));
+	return worldViewProj;
+}
+
+void GameEntity::PrepareMaterials(const XMFLOAT4X4& worldViewProj, const SHCoefficients& ambient, DirectionalLight& dirLightOne, DirectionalLight& dirLightTwo, ResourceRegistry* resources, bool depthPrepassed)
+{
+	Materials* material = resources->Get(myMaterial);
+	if (!material)
+		return;
+
 	// Send data to shader variables
 	//  - Do this ONCE PER OBJECT you're drawing
 	//  - This is actually a complex process of copying data to a local buffer
 	//    and then copying that entire buffer to the GPU.  
 	//  - The "SimpleShader" class handles all of that for you.
-	myMaterial->GetVertexShader()->SetMatrix4x4("world", worldMatrix);
-	myMaterial->GetVertexShader()->SetMatrix4x4("view", viewMatrix);
-	myMaterial->GetVertexShader()->SetMatrix4x4("projection", projectionMarix);
+	VertexShaderExternalData vsData;
+	vsData.world = worldMatrix;
+	vsData.worldViewProj = worldViewProj;
+	material->GetVertexShader()->SetBufferData(vsData);
+
+	// Quantized meshes store positions relative to their bounds
+	Mesh* mesh = resources->Get(myMesh);
+	if (mesh && mesh->IsQuantized())
+	{
+		material->GetVertexShader()->SetFloat3("positionCenter", mesh->GetQuantization().PositionCenter);
+		material->GetVertexShader()->SetFloat3("positionExtent", mesh->GetQuantization().PositionExtent);
+	}
 
 	// Once you've set all of the data you care to change for
 	// the next draw call, you need to actually send it to the GPU
 	//  - If you skip this, the "SetMatrix" calls above won't make it to the GPU!
-	myMaterial->GetVertexShader()->CopyAllBufferData();
-	myMaterial->GetVertexShader()->SetShader();
-
-	// Set the vertex and pixel shaders to use for the next Draw() command
-	//  - These don't technically need to be set every frame...YET
-	//  - Once you start applying different shaders to different objects,
-	//    you'll need to swap the current shaders before each draw
-	myMaterial->GetPixelShader()->SetData(
-		"lightOne",
-		&dirLightOne,
-		sizeof(DirectionalLight));
-
-	myMaterial->GetPixelShader()->SetData(
-		"lightTwo",
-		&dirLightTwo,
-		sizeof(DirectionalLight));
-
-	myMaterial->GetPixelShader()->SetShaderResourceView(
+	material->GetVertexShader()->CopyAllBufferData();
+
+	// Both lights go over in a single copy, laid out to match the cbuffer
+	PixelShaderExternalData psData;
+	psData.lightOne = dirLightOne;
+	psData.lightTwo = dirLightTwo;
+	material->GetPixelShader()->SetBufferData(psData);
+	material->GetPixelShader()->SetBufferData(ambient);
+
+	material->GetPixelShader()->SetShaderResourceView(
 		"diffuseTexture",
-		myMaterial->GetShaderResourceView());
+		resources->Get(material->GetTexture()));
 
-	myMaterial->GetPixelShader()->SetSamplerState(
+	material->GetPixelShader()->SetSamplerState(
 		"samp",
-		myMaterial->GetSamplerState());
+		material->GetSamplerState());
+
+	material->GetPixelShader()->CopyAllBufferData();
 
-	myMaterial->GetPixelShader()->CopyAllBufferData();
-	myMaterial->GetPixelShader()->SetShader();
+	// Set the vertex and pixel shaders (and render states) to use for
+	// the next Draw() command.  The pipeline state cache skips anything
+	// that's still bound from the previous entity.
+	material->BindPipelineState(depthPrepassed);
 
 }
@@ -4,15 +4,21 @@
 #include "Mesh.h"
 #include "Materials.h"
 #include "Lights.h"
+#include "ResourceRegistry.h"
+#include "ClusterCuller.h"
+#include "LightProbes.h"
 
 using namespace DirectX;
 
 class GameEntity
 {
 public:
-	GameEntity(Mesh* entityMesh, Materials* newMaterial);
+	GameEntity(MeshHandle entityMesh, MaterialHandle newMaterial);
 	~GameEntity();
 
+	MeshHandle GetMesh() { return myMesh; }
+	MaterialHandle GetMaterial() { return myMaterial; }
+
 	XMFLOAT4X4 GetMatrix();
 	void SetMatrix(XMMATRIX& newWorldMatrix);
 
@@ -25,7 +31,9 @@ public:
 	XMFLOAT3 GetRotation();
 	void SetRotation(XMFLOAT3 newRotation);
 
-	void Draw(ID3D11DeviceContext*	context);
+	void Draw(ID3D11DeviceContext*	context, ResourceRegistry* resources);
+	// Draws only the clusters that survived culling (culler's index buffer bound)
+	void Draw(ID3D11DeviceContext*	context, ResourceRegistry* resources, const ClusterDraw& clusters);
 
 	void SetScale(float scale);
 	
@@ -36,17 +44,33 @@ public:
 	void SetAngleFromOrigin(float angle);
 	float GetAngleFromOrigin();
 
-	void CalculateWorldMatrix();
+	// Builds the world matrix "interpolation" of the way from the
+	// previous tick's transform to the current one
+	void CalculateWorldMatrix(float interpolation = 1.0f);
+
+	// Call at the start of each tick, before anything moves
+	void StorePreviousTransform();
+
+	// world * viewProj, transposed like every matrix sent to HLSL
+	XMFLOAT4X4 GetWorldViewProj(const XMFLOAT4X4& viewProjection);
 
-	void PrepareMaterials(XMFLOAT4X4 viewMatrix, XMFLOAT4X4 projectionMatrix, DirectionalLight& dirLight, DirectionalLight& dirLightTwo);
+	// ambient - the probes sampled where the entity is this frame
+	// depthPrepassed - depth was already laid down by a prepass
+	void PrepareMaterials(const XMFLOAT4X4& worldViewProj, const SHCoefficients& ambient, DirectionalLight& dirLight, DirectionalLight& dirLightTwo, ResourceRegistry* resources, bool depthPrepassed);
 
 private:
 	XMFLOAT3 position;
 	XMFLOAT3 scalar;
 	XMFLOAT3 rotation;
+	// The transform as of the last tick, for interpolating
+	XMFLOAT3 previousPosition;
+	XMFLOAT3 previousScalar;
+	XMFLOAT3 previousRotation;
 	XMFLOAT4X4 worldMatrix;
-	Mesh* myMesh;
-	Materials* myMaterial;
+	// Handles rather than pointers - whoever creates the entity holds
+	// a reference to each on its behalf
+	MeshHandle myMesh;
+	MaterialHandle myMaterial;
 	float angleFromOrigin;
 };
 
@@ -0,0 +1,210 @@
+#include "GeometryPool.h"
+#include <cstring>
+
+// --------------------------------------------------------
+// Constructor - Creates the shared buffers up front
+// --------------------------------------------------------
+GeometryPool::GeometryPool(ID3D11Device* device, ID3D11DeviceContext* context, VertexStreamFormat format, unsigned int vertexCapacity, unsigned int indexCapacity)
+	: vertexAllocator(vertexCapacity), indexAllocator(indexCapacity)
+{
+	this->device = device;
+	this->context = context;
+	this->format = format;
+	vertexStride = format == VERTEX_STREAM_QUANTIZED
+		? VertexFormat<QuantizedVertex>::Stride
+		: VertexFormat<Vertex>::Stride;
+	positionStride = format == VERTEX_STREAM_QUANTIZED
+		? VertexFormat<QuantizedPositionVertex>::Stride
+		: VertexFormat<PositionVertex>::Stride;
+
+	vertexBuffer = CreateBuffer(vertexStride * vertexCapacity, D3D11_BIND_VERTEX_BUFFER);
+	occlusionBuffer = CreateBuffer(VertexFormat<OcclusionVertex>::Stride * vertexCapacity, D3D11_BIND_VERTEX_BUFFER);
+	positionBuffer = CreateBuffer(positionStride * vertexCapacity, D3D11_BIND_VERTEX_BUFFER);
+	indexBuffer = CreateBuffer(sizeof(int) * indexCapacity, D3D11_BIND_INDEX_BUFFER);
+}
+
+// --------------------------------------------------------
+// Destructor
+// --------------------------------------------------------
+GeometryPool::~GeometryPool()
+{
+	if (vertexBuffer) { vertexBuffer->Release(); }
+	if (occlusionBuffer) { occlusionBuffer->Release(); }
+	if (positionBuffer) { positionBuffer->Release(); }
+	if (indexBuffer) { indexBuffer->Release(); }
+}
+
+// --------------------------------------------------------
+// Finds room for a mesh (growing the buffers if needed) and
+// copies its vertices and indices in
+//
+// Returns true if the geometry was added to the pool
+// --------------------------------------------------------
+bool GeometryPool::Allocate(const void* vertices, unsigned int vertexCount, const int* indices, unsigned int indexCount, GeometryRange* range)
+{
+	unsigned int baseVertex, firstIndex;
+
+	if (!vertexAllocator.Allocate(vertexCount, &baseVertex))
+	{
+		// Every vertex stream shares the one allocator
+		ID3D11Buffer** vertexBuffers[] = { &vertexBuffer, &occlusionBuffer, &positionBuffer };
+		unsigned int vertexSizes[] = { vertexStride, VertexFormat<OcclusionVertex>::Stride, positionStride };
+		if (!GrowBuffers(vertexBuffers, vertexSizes, 3, &vertexAllocator, D3D11_BIND_VERTEX_BUFFER, vertexCount) ||
+			!vertexAllocator.Allocate(vertexCount, &baseVertex))
+			return false;
+	}
+
+	if (!indexAllocator.Allocate(indexCount, &firstIndex))
+	{
+		ID3D11Buffer** indexBuffers[] = { &indexBuffer };
+		unsigned int indexSizes[] = { sizeof(int) };
+		if (!GrowBuffers(indexBuffers, indexSizes, 1, &indexAllocator, D3D11_BIND_INDEX_BUFFER, indexCount) ||
+			!indexAllocator.Allocate(indexCount, &firstIndex))
+		{
+			vertexAllocator.Free(baseVertex, vertexCount);
+			return false;
+		}
+	}
+
+	// Copy into our slice of each buffer.  Indices stay relative
+	// to the mesh; the base vertex is added at draw time.
+	D3D11_BOX box = {};
+	box.bottom = 1;
+	box.back = 1;
+
+	box.left = baseVertex * vertexStride;
+	box.right = box.left + vertexCount * vertexStride;
+	context->UpdateSubresource(vertexBuffer, 0, &box, vertices, 0, 0);
+
+	std::vector<unsigned char> positions(vertexCount * positionStride);
+	const unsigned char* source = (const unsigned char*)vertices;
+	for (unsigned int i = 0; i < vertexCount; i++)
+		memcpy(&positions[i * positionStride], source + i * vertexStride, positionStride);
+
+	box.left = baseVertex * positionStride;
+	box.right = box.left + vertexCount * positionStride;
+	context->UpdateSubresource(positionBuffer, 0, &box, &positions[0], 0, 0);
+
+	box.left = firstIndex * sizeof(int);
+	box.right = box.left + indexCount * sizeof(int);
+	context->UpdateSubresource(indexBuffer, 0, &box, indices, 0, 0);
+
+	range->BaseVertex = baseVertex;
+	range->VertexCount = vertexCount;
+	range->FirstIndex = firstIndex;
+	range->IndexCount = indexCount;
+
+	// Nothing is occluded until the mesh is baked
+	OcclusionVertex open = { 255 };
+	std::vector<OcclusionVertex> occlusion(vertexCount, open);
+	SetOcclusion(*range, &occlusion[0]);
+	return true;
+}
+
+void GeometryPool::SetOcclusion(const GeometryRange& range, const OcclusionVertex* occlusion)
+{
+	if (range.VertexCount == 0)
+		return;
+
+	D3D11_BOX box = {};
+	box.left = range.BaseVertex * VertexFormat<OcclusionVertex>::Stride;
+	box.right = box.left + range.VertexCount * VertexFormat<OcclusionVertex>::Stride;
+	box.bottom = 1;
+	box.back = 1;
+	context->UpdateSubresource(occlusionBuffer, 0, &box, occlusion, 0, 0);
+}
+
+// --------------------------------------------------------
+// Returns a mesh's slices to the pool
+// --------------------------------------------------------
+void GeometryPool::Free(const GeometryRange& range)
+{
+	vertexAllocator.Free(range.BaseVertex, range.VertexCount);
+	indexAllocator.Free(range.FirstIndex, range.IndexCount);
+}
+
+// --------------------------------------------------------
+// Sets the shared buffers once for any number of draws
+// --------------------------------------------------------
+void GeometryPool::Bind()
+{
+	ID3D11Buffer* vertexBuffers[] = { vertexBuffer, occlusionBuffer };
+	UINT strides[] = { vertexStride, VertexFormat<OcclusionVertex>::Stride };
+	UINT offsets[] = { 0, 0 };
+	context->IASetVertexBuffers(0, 2, vertexBuffers, strides, offsets);
+	context->IASetIndexBuffer(indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+}
+
+void GeometryPool::BindPositions()
+{
+	UINT offset = 0;
+	context->IASetVertexBuffers(0, 1, &positionBuffer, &positionStride, &offset);
+	context->IASetIndexBuffer(indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+}
+
+// --------------------------------------------------------
+// Doubles a set of buffers sharing one allocator until
+// "needed" more elements fit at the end, copying the
+// existing contents over on the GPU.  Either every buffer
+// grows or none do.
+// --------------------------------------------------------
+bool GeometryPool::GrowBuffers(ID3D11Buffer** buffers[], const unsigned int elementSizes[], unsigned int bufferCount, RangeAllocator* allocator, UINT bindFlags, unsigned int needed)
+{
+	unsigned int oldSize = allocator->GetSize();
+	unsigned int newSize = oldSize > 0 ? oldSize : 1024;
+	while (newSize - oldSize < needed)
+		newSize *= 2;
+
+	// At most the three vertex streams share an allocator
+	ID3D11Buffer* newBuffers[3] = {};
+	for (unsigned int i = 0; i < bufferCount; i++)
+	{
+		newBuffers[i] = CreateBuffer(newSize * elementSizes[i], bindFlags);
+		if (!newBuffers[i])
+		{
+			for (unsigned int j = 0; j < i; j++)
+				newBuffers[j]->Release();
+			return false;
+		}
+	}
+
+	for (unsigned int i = 0; i < bufferCount; i++)
+	{
+		ID3D11Buffer** buffer = buffers[i];
+		if (*buffer)
+		{
+			D3D11_BOX box = {};
+			box.right = oldSize * elementSizes[i];
+			box.bottom = 1;
+			box.back = 1;
+			context->CopySubresourceRegion(newBuffers[i], 0, 0, 0, 0, *buffer, 0, &box);
+			(*buffer)->Release();
+		}
+		*buffer = newBuffers[i];
+	}
+
+	allocator->Grow(newSize);
+
+	// The old buffers may still be bound
+	Bind();
+	return true;
+}
+
+// --------------------------------------------------------
+// Pool buffers are DEFAULT usage rather than IMMUTABLE,
+// since meshes are copied in after creation
+// --------------------------------------------------------
+ID3D11Buffer* GeometryPool::CreateBuffer(unsigned int byteWidth, UINT bindFlags)
+{
+	if (byteWidth == 0)
+		return 0;
+
+	D3D11_BUFFER_DESC desc = {};
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.ByteWidth = byteWidth;
+	desc.BindFlags = bindFlags;
+
+	ID3D11Buffer* buffer = 0;
+	device->CreateBuffer(&desc, 0, &buffer);
+	return buffer;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <d3d11.h>
+#include <vector>
+#include "Vertex.h"
+#include "VertexQuantization.h"
+#include "RangeAllocator.h"
+
+// --------------------------------------------------------
+// A mesh's slice of the shared geometry buffers
+// --------------------------------------------------------
+struct GeometryRange
+{
+	unsigned int BaseVertex;
+	unsigned int VertexCount;
+	unsigned int FirstIndex;
+	unsigned int IndexCount;
+};
+
+// --------------------------------------------------------
+// What each vertex in a pool looks like
+// --------------------------------------------------------
+enum VertexStreamFormat
+{
+	VERTEX_STREAM_FULL,			// Vertex (32 bytes)
+	VERTEX_STREAM_QUANTIZED		// QuantizedVertex (16 bytes)
+};
+
+// --------------------------------------------------------
+// One big vertex buffer and one big index buffer shared by
+// every mesh.  Meshes are suballocated out of them, so all
+// draws can use the same IA bindings and only differ in
+// their first index and base vertex.
+//
+// The buffers double in size (copying on the GPU) when they
+// run out of room, so meshes never need to know the actual
+// buffer objects.
+//
+// Every vertex in a pool has the same format, so meshes
+// convert their vertices to match before allocating.
+//
+// Baked occlusion lives in a second vertex buffer (slot 1)
+// that parallels the first, so it can be written whenever
+// a bake finishes.  It starts out fully open.
+//
+// A third parallel buffer holds just the positions, for
+// depth only passes, so they fetch a half or a third of
+// the bytes per vertex.  Position always comes first in a
+// pool's vertex format, so it's copied straight out.
+// --------------------------------------------------------
+class GeometryPool
+{
+public:
+	GeometryPool(ID3D11Device* device, ID3D11DeviceContext* context, VertexStreamFormat format, unsigned int vertexCapacity, unsigned int indexCapacity);
+	~GeometryPool();
+
+	// Copies geometry into the pool.  Must be called on the
+	// main thread, since it uses the immediate context.
+	// Vertices must already be in the pool's format.
+	bool Allocate(const void* vertices, unsigned int vertexCount, const int* indices, unsigned int indexCount, GeometryRange* range);
+	void Free(const GeometryRange& range);
+
+	// Overwrites a range's occlusion stream (one OcclusionVertex
+	// per vertex).  Main thread only, like Allocate().
+	void SetOcclusion(const GeometryRange& range, const OcclusionVertex* occlusion);
+
+	// Binds the shared buffers to the input assembler
+	void Bind();
+
+	// Binds just the position stream (in slot 0), and the indices
+	void BindPositions();
+
+	VertexStreamFormat GetVertexFormat() { return format; }
+	unsigned int GetVertexStride() { return vertexStride; }
+
+private:
+	ID3D11Device* device;
+	ID3D11DeviceContext* context;
+
+	VertexStreamFormat format;
+	unsigned int vertexStride;
+	unsigned int positionStride;	// PositionVertex or QuantizedPositionVertex
+
+	ID3D11Buffer* vertexBuffer;
+	ID3D11Buffer* occlusionBuffer;
+	ID3D11Buffer* positionBuffer;
+	ID3D11Buffer* indexBuffer;
+	RangeAllocator vertexAllocator;
+	RangeAllocator indexAllocator;
+
+	bool GrowBuffers(ID3D11Buffer** buffers[], const unsigned int elementSizes[], unsigned int bufferCount, RangeAllocator* allocator, UINT bindFlags, unsigned int needed);
+	ID3D11Buffer* CreateBuffer(unsigned int byteWidth, UINT bindFlags);
+};
@@ -0,0 +1,166 @@
+#include "Input.h"
+
+Input::Input()
+{
+	head.store(0);
+	tail.store(0);
+	dropped.store(0);
+
+	for (unsigned int i = 0; i < 256; i++)
+	{
+		bindings[i] = NoAction;
+		keysDown[i] = false;
+	}
+
+	for (unsigned int a = 0; a < ACTION_COUNT; a++)
+	{
+		actionKeys[a] = 0;
+		actionDownTime[a] = 0.0;
+		snapshot.Held[a] = false;
+		snapshot.Pressed[a] = false;
+		snapshot.Released[a] = false;
+		snapshot.HeldTime[a] = 0.0f;
+	}
+	mouseX = 0;
+	mouseY = 0;
+	snapshot.Start = 0.0;
+	snapshot.End = 0.0;
+	snapshot.MouseX = 0;
+	snapshot.MouseY = 0;
+	snapshot.LookX = 0;
+	snapshot.LookY = 0;
+	snapshot.Wheel = 0.0f;
+}
+
+void Input::Bind(unsigned char key, InputAction action)
+{
+	bindings[key] = (unsigned char)action;
+}
+
+// --------------------------------------------------------
+// Only ever called by the producer.  The event is written
+// before the new tail is published, so the consumer never
+// sees a slot that's half filled in.
+// --------------------------------------------------------
+bool Input::Push(const InputEvent& inputEvent)
+{
+	unsigned int t = tail.load(std::memory_order_relaxed);
+	if (t - head.load(std::memory_order_acquire) >= QueueSize)
+	{
+		dropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	queue[t & (QueueSize - 1)] = inputEvent;
+	tail.store(t + 1, std::memory_order_release);
+	return true;
+}
+
+// --------------------------------------------------------
+// Drains the queue and works out the frame's snapshot.
+// Events are clamped into the frame, so one stamped a
+// little early still counts from its start.
+// --------------------------------------------------------
+const InputSnapshot& Input::BeginFrame(double now)
+{
+	snapshot.Start = snapshot.End;
+	snapshot.End = now > snapshot.Start ? now : snapshot.Start;
+	snapshot.LookX = 0;
+	snapshot.LookY = 0;
+	snapshot.Wheel = 0.0f;
+
+	// Anything still held was held from the very start of this frame
+	for (unsigned int a = 0; a < ACTION_COUNT; a++)
+	{
+		snapshot.Pressed[a] = false;
+		snapshot.Released[a] = false;
+		snapshot.HeldTime[a] = 0.0f;
+		actionDownTime[a] = snapshot.Start;
+	}
+
+	unsigned int h = head.load(std::memory_order_relaxed);
+	unsigned int t = tail.load(std::memory_order_acquire);
+	for (; h != t; h++)
+		Apply(queue[h & (QueueSize - 1)]);
+	head.store(h, std::memory_order_release);
+
+	snapshot.MouseX = mouseX;
+	snapshot.MouseY = mouseY;
+	for (unsigned int a = 0; a < ACTION_COUNT; a++)
+	{
+		snapshot.Held[a] = actionKeys[a] > 0;
+		if (snapshot.Held[a])
+			snapshot.HeldTime[a] += (float)(snapshot.End - actionDownTime[a]);
+	}
+
+	return snapshot;
+}
+
+void Input::Apply(const InputEvent& inputEvent)
+{
+	double time = inputEvent.Time;
+	if (time < snapshot.Start) time = snapshot.Start;
+	if (time > snapshot.End) time = snapshot.End;
+
+	switch (inputEvent.Type)
+	{
+	case INPUT_KEY_DOWN:
+		SetKey(inputEvent.Key, true, time);
+		break;
+
+	case INPUT_KEY_UP:
+		SetKey(inputEvent.Key, false, time);
+		break;
+
+	case INPUT_MOUSE_MOVE:
+		if (actionKeys[ACTION_LOOK] > 0)
+		{
+			snapshot.LookX += inputEvent.X - mouseX;
+			snapshot.LookY += inputEvent.Y - mouseY;
+		}
+		mouseX = inputEvent.X;
+		mouseY = inputEvent.Y;
+		break;
+
+	case INPUT_MOUSE_WHEEL:
+		snapshot.Wheel += inputEvent.X / 120.0f;
+		break;
+
+	case INPUT_FOCUS_LOST:
+		for (unsigned int k = 0; k < 256; k++)
+			SetKey((unsigned char)k, false, time);
+		break;
+	}
+}
+
+// --------------------------------------------------------
+// Key repeats (a down while already down) change nothing.
+// An action is held while any of its keys are.
+// --------------------------------------------------------
+void Input::SetKey(unsigned char key, bool down, double time)
+{
+	if (keysDown[key] == down)
+		return;
+	keysDown[key] = down;
+
+	unsigned char action = bindings[key];
+	if (action == NoAction)
+		return;
+
+	if (down)
+	{
+		if (actionKeys[action]++ == 0)
+		{
+			actionDownTime[action] = time;
+			snapshot.Pressed[action] = true;
+		}
+	}
+	else
+	{
+		if (--actionKeys[action] == 0)
+		{
+			snapshot.HeldTime[action] += (float)(time - actionDownTime[action]);
+			snapshot.Released[action] = true;
+		}
+	}
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <atomic>
+
+// --------------------------------------------------------
+// One raw input event, as it came from the OS
+// --------------------------------------------------------
+enum InputEventType
+{
+	INPUT_KEY_DOWN,			// Key is a virtual key code (mouse buttons included)
+	INPUT_KEY_UP,
+	INPUT_MOUSE_MOVE,		// X, Y is the new cursor position
+	INPUT_MOUSE_WHEEL,		// X is the number of notches (x120)
+	INPUT_FOCUS_LOST		// Every key counts as released
+};
+
+struct InputEvent
+{
+	double Time;			// Seconds, on the game loop's clock
+	int X;
+	int Y;
+	unsigned char Type;		// An InputEventType
+	unsigned char Key;
+};
+
+// --------------------------------------------------------
+// What the game responds to, independent of the keys (or
+// buttons) bound to it
+// --------------------------------------------------------
+enum InputAction
+{
+	ACTION_MOVE_FORWARD,
+	ACTION_MOVE_BACK,
+	ACTION_MOVE_LEFT,
+	ACTION_MOVE_RIGHT,
+	ACTION_MOVE_UP,
+	ACTION_MOVE_DOWN,
+	ACTION_LOOK,			// Mouse movement turns the camera while held
+	ACTION_QUIT,
+	ACTION_RECORD,			// Starts/stops recording input
+	ACTION_REPLAY,			// Plays the last recording back
+
+	ACTION_COUNT
+};
+
+// --------------------------------------------------------
+// Everything that happened over one frame, from the end of
+// the last frame to the start of this one.
+//
+// HeldTime is how many seconds of that span each action
+// was held for, so movement can follow exactly when a key
+// went down or up rather than rounding to whole frames.
+// --------------------------------------------------------
+struct InputSnapshot
+{
+	double Start;
+	double End;
+
+	bool Held[ACTION_COUNT];		// At the end of the frame
+	bool Pressed[ACTION_COUNT];		// Went down at some point
+	bool Released[ACTION_COUNT];	// Went up at some point
+	float HeldTime[ACTION_COUNT];
+
+	int MouseX;						// Cursor position at the end
+	int MouseY;
+	int LookX;						// Cursor movement while ACTION_LOOK was held
+	int LookY;
+	float Wheel;					// Notches scrolled
+};
+
+// --------------------------------------------------------
+// Input collected from window messages as it arrives, then
+// handed to the game a frame at a time.
+//
+// Events go into a fixed size single producer / single
+// consumer ring buffer, so the message handler never locks
+// or allocates (and could run on its own thread).  Once a
+// frame, BeginFrame() drains it into an InputSnapshot.
+//
+// A replay can swap in a recorded snapshot after each
+// BeginFrame() (see FrameRecording).
+// --------------------------------------------------------
+class Input
+{
+public:
+	Input();
+
+	// Any number of keys can share an action (one key has one action)
+	void Bind(unsigned char key, InputAction action);
+
+	// Producer side - false if the buffer is full and it was dropped
+	bool Push(const InputEvent& inputEvent);
+
+	// Consumer side - builds the snapshot from the last frame up to now
+	const InputSnapshot& BeginFrame(double now);
+	const InputSnapshot& GetSnapshot() { return snapshot; }
+
+	// Replaces this frame's snapshot.  Live keys keep being tracked
+	// underneath, and take over again on the next BeginFrame().
+	void SetSnapshot(const InputSnapshot& replacement) { snapshot = replacement; }
+
+	unsigned int GetDroppedCount() { return dropped.load(); }
+
+private:
+	static const unsigned int QueueSize = 1024;		// Must be a power of 2
+	static const unsigned char NoAction = 0xFF;
+
+	// The ring buffer.  head and tail only ever count up; each
+	// side writes its own and reads the other's.
+	InputEvent queue[QueueSize];
+	std::atomic<unsigned int> head;		// Next to read (consumer)
+	std::atomic<unsigned int> tail;		// Next to write (producer)
+	std::atomic<unsigned int> dropped;
+
+	unsigned char bindings[256];
+	bool keysDown[256];
+	unsigned int actionKeys[ACTION_COUNT];	// How many bound keys are down
+	double actionDownTime[ACTION_COUNT];
+	int mouseX;
+	int mouseY;
+
+	InputSnapshot snapshot;
+
+	void Apply(const InputEvent& inputEvent);
+	void SetKey(unsigned char key, bool down, double time);
+};
@@ -0,0 +1,175 @@
+#include "LightProbes.h"
+#include "SceneRaycaster.h"
+#include <cmath>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// The 9 real SH basis functions for a unit direction, in
+// the same order as EvaluateSH() in PixelShader.hlsl
+// --------------------------------------------------------
+static void EvaluateSHBasis(float x, float y, float z, float basis[9])
+{
+	basis[0] = 0.282095f;
+	basis[1] = 0.488603f * y;
+	basis[2] = 0.488603f * z;
+	basis[3] = 0.488603f * x;
+	basis[4] = 1.092548f * x * y;
+	basis[5] = 1.092548f * y * z;
+	basis[6] = 0.315392f * (3.0f * z * z - 1.0f);
+	basis[7] = 1.092548f * x * z;
+	basis[8] = 0.546274f * (x * x - y * y);
+}
+
+// Convolving with the cosine lobe scales each band by A(l)
+// (pi, 2pi/3, pi/4), and Lambert divides by pi again
+static const float bandScale[9] =
+{
+	1.0f,
+	2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f,
+	0.25f, 0.25f, 0.25f, 0.25f, 0.25f
+};
+
+// --------------------------------------------------------
+// Constructor - Probes start out black until baked
+// --------------------------------------------------------
+SHProbeGrid::SHProbeGrid(XMFLOAT3 min, XMFLOAT3 max, unsigned int countX, unsigned int countY, unsigned int countZ)
+{
+	this->min = min;
+	counts[0] = countX > 2 ? countX : 2;
+	counts[1] = countY > 2 ? countY : 2;
+	counts[2] = countZ > 2 ? countZ : 2;
+
+	// A flat axis gets a zero inverse, so everything samples its first layer
+	cellSize = XMFLOAT3(
+		(max.x - min.x) / (counts[0] - 1),
+		(max.y - min.y) / (counts[1] - 1),
+		(max.z - min.z) / (counts[2] - 1));
+	invCellSize = XMFLOAT3(
+		cellSize.x > 0.0f ? 1.0f / cellSize.x : 0.0f,
+		cellSize.y > 0.0f ? 1.0f / cellSize.y : 0.0f,
+		cellSize.z > 0.0f ? 1.0f / cellSize.z : 0.0f);
+
+	SHProbe black;
+	for (unsigned int k = 0; k < 9; k++)
+		black.C[k] = XMFLOAT3(0, 0, 0);
+	probes.assign(counts[0] * counts[1] * counts[2], black);
+}
+
+// --------------------------------------------------------
+// Every probe traces the same set of directions, so the
+// basis and sky for each one are worked out once up front.
+//
+// A ray that hits the back of a surface started inside a
+// mesh.  It's treated as seeing the sky, which keeps probes
+// inside an object (usually at its own center) from going
+// black and shading the object by its own insides.
+// --------------------------------------------------------
+void SHProbeGrid::Bake(const SceneRaycaster& scene, const SHBakeSettings& settings, ThreadPool* threads)
+{
+	unsigned int rayCount = settings.RaysPerProbe > 0 ? settings.RaysPerProbe : 1;
+
+	// Fibonacci spiral - evenly spread over the sphere for any count
+	std::vector<XMFLOAT3> directions(rayCount);
+	std::vector<XMFLOAT3> skyRadiance(rayCount);
+	std::vector<float> basis(rayCount * 9);
+	float goldenAngle = XM_PI * (3.0f - sqrtf(5.0f));
+	for (unsigned int r = 0; r < rayCount; r++)
+	{
+		float y = 1.0f - (2.0f * r + 1.0f) / rayCount;
+		float radius = sqrtf(1.0f - y * y);
+		float phi = goldenAngle * r;
+		directions[r] = XMFLOAT3(radius * cosf(phi), y, radius * sinf(phi));
+		EvaluateSHBasis(directions[r].x, directions[r].y, directions[r].z, &basis[r * 9]);
+
+		XMVECTOR sky = XMVectorLerp(XMLoadFloat3(&settings.GroundColor), XMLoadFloat3(&settings.SkyColor), y * 0.5f + 0.5f);
+		XMStoreFloat3(&skyRadiance[r], sky);
+	}
+
+	// Each ray stands for 4pi / N of the sphere
+	XMVECTOR bandWeight[9];
+	for (unsigned int k = 0; k < 9; k++)
+		bandWeight[k] = XMVectorReplicate(bandScale[k] * 4.0f * XM_PI / rayCount);
+
+	threads->ParallelFor(probes.size(), 1, [&](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int p = begin; p < end; p++)
+		{
+			unsigned int x = p % counts[0];
+			unsigned int y = (p / counts[0]) % counts[1];
+			unsigned int z = p / (counts[0] * counts[1]);
+
+			Ray ray;
+			ray.Origin = XMFLOAT3(
+				min.x + cellSize.x * x,
+				min.y + cellSize.y * y,
+				min.z + cellSize.z * z);
+			ray.MaxDistance = settings.MaxDistance;
+
+			XMVECTOR sum[9];
+			for (unsigned int k = 0; k < 9; k++)
+				sum[k] = XMVectorZero();
+
+			for (unsigned int r = 0; r < rayCount; r++)
+			{
+				ray.Direction = directions[r];
+
+				SceneHit hit;
+				if (scene.Raycast(ray, &hit) && hit.FrontFace)
+					continue;
+
+				// Project what this ray sees onto each basis function,
+				// all three channels at once
+				XMVECTOR radiance = XMLoadFloat3(&skyRadiance[r]);
+				const float* rayBasis = &basis[r * 9];
+				for (unsigned int k = 0; k < 9; k++)
+					sum[k] = XMVectorMultiplyAdd(radiance, XMVectorReplicate(rayBasis[k]), sum[k]);
+			}
+
+			for (unsigned int k = 0; k < 9; k++)
+				XMStoreFloat3(&probes[p].C[k], XMVectorMultiply(sum[k], bandWeight[k]));
+		}
+	});
+}
+
+// --------------------------------------------------------
+// Blends the 8 probes of the cell the point is in
+// --------------------------------------------------------
+void XM_CALLCONV SHProbeGrid::Sample(FXMVECTOR position, SHCoefficients* result) const
+{
+	XMVECTOR lastProbe = XMVectorSet((float)(counts[0] - 1), (float)(counts[1] - 1), (float)(counts[2] - 1), 0.0f);
+	XMVECTOR local = XMVectorMultiply(XMVectorSubtract(position, XMLoadFloat3(&min)), XMLoadFloat3(&invCellSize));
+	local = XMVectorClamp(local, XMVectorZero(), lastProbe);
+
+	// The cell's first corner, kept one short of the end so the
+	// far corner exists too
+	XMVECTOR corner = XMVectorMin(XMVectorFloor(local), XMVectorSubtract(lastProbe, XMVectorSplatOne()));
+	XMFLOAT3 first, t;
+	XMStoreFloat3(&first, corner);
+	XMStoreFloat3(&t, XMVectorSubtract(local, corner));
+	unsigned int x = (unsigned int)first.x;
+	unsigned int y = (unsigned int)first.y;
+	unsigned int z = (unsigned int)first.z;
+
+	XMVECTOR sum[9];
+	for (unsigned int k = 0; k < 9; k++)
+		sum[k] = XMVectorZero();
+
+	for (unsigned int c = 0; c < 8; c++)
+	{
+		float weight =
+			((c & 1) ? t.x : 1.0f - t.x) *
+			((c & 2) ? t.y : 1.0f - t.y) *
+			((c & 4) ? t.z : 1.0f - t.z);
+		if (weight <= 0.0f)
+			continue;
+
+		const SHProbe& probe = probes[ProbeIndex(x + (c & 1), y + ((c >> 1) & 1), z + ((c >> 2) & 1))];
+		XMVECTOR w = XMVectorReplicate(weight);
+		for (unsigned int k = 0; k < 9; k++)
+			sum[k] = XMVectorMultiplyAdd(XMLoadFloat3(&probe.C[k]), w, sum[k]);
+	}
+
+	for (unsigned int k = 0; k < 9; k++)
+		XMStoreFloat4(&result->C[k], sum[k]);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+#include "ThreadPool.h"
+
+class SceneRaycaster;
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Irradiance as 9 (L2) spherical harmonic coefficients, in
+// RGB.  Matches "cbuffer probes" in PixelShader.hlsl, which
+// is why each coefficient is padded out to a float4.
+//
+// The coefficients are pre-convolved with the cosine lobe
+// and divided by pi, so evaluating them at a normal gives
+// the diffuse ambient light for a white surface directly.
+// --------------------------------------------------------
+struct SHCoefficients
+{
+	XMFLOAT4 C[9];
+};
+
+// --------------------------------------------------------
+// How the sky is sampled when baking probes
+// --------------------------------------------------------
+struct SHBakeSettings
+{
+	XMFLOAT3 SkyColor;		// Radiance straight up
+	XMFLOAT3 GroundColor;	// Radiance straight down (blended in between)
+	unsigned int RaysPerProbe;
+	float MaxDistance;		// Geometry farther than this doesn't block the sky
+};
+
+// --------------------------------------------------------
+// A regular 3D grid of irradiance probes.
+//
+// Each probe is baked by tracing rays against the scene -
+// rays that escape see the sky, rays that hit something
+// don't - and projecting what they see onto L2 SH.  Probes
+// are independent, so the bake runs across a thread pool.
+//
+// At runtime each entity trilinearly blends the 8 probes
+// around it, giving it ambient light that's darker under
+// and between other objects.  Probes are stored as packed
+// RGB (108 bytes each) since the grid is mostly read.
+// --------------------------------------------------------
+class SHProbeGrid
+{
+public:
+	// At least 2 probes on each axis, spread evenly from min to max
+	SHProbeGrid(XMFLOAT3 min, XMFLOAT3 max, unsigned int countX, unsigned int countY, unsigned int countZ);
+
+	void Bake(const SceneRaycaster& scene, const SHBakeSettings& settings, ThreadPool* threads);
+
+	// Irradiance at a point (clamped to the grid)
+	void XM_CALLCONV Sample(FXMVECTOR position, SHCoefficients* result) const;
+
+	unsigned int GetProbeCount() { return probes.size(); }
+
+private:
+	struct SHProbe
+	{
+		XMFLOAT3 C[9];
+	};
+
+	XMFLOAT3 min;
+	XMFLOAT3 cellSize;
+	XMFLOAT3 invCellSize;
+	unsigned int counts[3];
+	std::vector<SHProbe> probes;	// x fastest, then y, then z
+
+	unsigned int ProbeIndex(unsigned int x, unsigned int y, unsigned int z) const
+	{
+		return (z * counts[1] + y) * counts[0] + x;
+	}
+};
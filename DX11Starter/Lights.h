@@ -1,6 +1,7 @@
 #include <d3d11.h>
 #include <d3dcompiler.h>
 #include <DirectXMath.h>
+#include "ConstantBufferLayout.h"
 #pragma once
 
 using namespace DirectX;
@@ -10,4 +11,11 @@ struct DirectionalLight
 	XMFLOAT4 AmbientColor;
 	XMFLOAT4 DiffuseColor;
 	XMFLOAT3 Direction;
-};
\ No newline at end of file
+	float Padding;		// Keeps consecutive lights on 16-byte boundaries, like HLSL
+};
+
+// Must line up with the DirectionalLight struct in PixelShader.hlsl
+HLSL_CHECK_FIRST(DirectionalLight, AmbientColor);
+HLSL_CHECK_NEXT(DirectionalLight, AmbientColor, DiffuseColor);
+HLSL_CHECK_NEXT(DirectionalLight, DiffuseColor, Direction);
+HLSL_STRUCT_TYPE(DirectionalLight, Direction);
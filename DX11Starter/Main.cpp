@@ -1,6 +1,8 @@
 
 #include <Windows.h>
 #include "Game.h"
+#include <cstring>
+#include <string>
 
 // --------------------------------------------------------
 // Entry point for a graphical (non-console) Windows application
@@ -35,6 +37,26 @@ int WINAPI WinMain(
 	hr = dxGame.InitDirectX();
 	if(FAILED(hr)) return hr;
 
+	// "-quantize" stores meshes with quantized vertices, at half
+	// the size of full precision ones
+	if (strstr(lpCmdLine, "-quantize"))
+		dxGame.SetVertexFormat(VERTEX_STREAM_QUANTIZED);
+
+	// "-benchmark" replays a built in flythrough, timing every frame,
+	// and "-benchmark file.rec" replays that recording instead (the
+	// path runs up to the next flag)
+	const char* benchmark = strstr(lpCmdLine, "-benchmark");
+	if (benchmark)
+	{
+		std::string path = benchmark + strlen("-benchmark");
+		size_t nextFlag = path.find(" -");
+		if (nextFlag != std::string::npos)
+			path.erase(nextFlag);
+		path.erase(0, path.find_first_not_of(' '));
+		path.erase(path.find_last_not_of(' ') + 1);
+		dxGame.SetUpBenchmark(path.empty() ? 0 : path.c_str());
+	}
+
 	// Begin the message and game loop, and then return
 	// whatever we get back once the game loop is over
 	return dxGame.Run();
@@ -2,12 +2,26 @@
 
 
 
-Materials::Materials(SimpleVertexShader* newVertShader, SimplePixelShader* newPixShader, ID3D11ShaderResourceView* srvPtr, ID3D11SamplerState* smplPtr)
+Materials::Materials(SimpleVertexShader* newVertShader, SimplePixelShader* newPixShader, TextureHandle newTexture, ID3D11SamplerState* smplPtr)
 {
 	vertexShader = newVertShader;
 	pixelShader = newPixShader;
-	srv = srvPtr;
+	texture = newTexture;
 	sampler = smplPtr;
+	stateCache = 0;
+	pipelineState = 0;
+	prepassedState = 0;
+}
+
+Materials::Materials(PipelineStateCache* stateCache, const PipelineState* state, TextureHandle newTexture, ID3D11SamplerState* smplPtr)
+{
+	vertexShader = state->VertexShader;
+	pixelShader = state->PixelShader;
+	texture = newTexture;
+	sampler = smplPtr;
+	this->stateCache = stateCache;
+	pipelineState = state;
+	prepassedState = 0;
 }
 
 
@@ -15,3 +29,19 @@ Materials::~Materials()
 {
 	
 }
+
+// --------------------------------------------------------
+// Materials without a pipeline state just set their
+// shaders directly, every time
+// --------------------------------------------------------
+void Materials::BindPipelineState(bool depthPrepassed)
+{
+	if (stateCache && pipelineState)
+	{
+		stateCache->Bind(depthPrepassed && prepassedState ? prepassedState : pipelineState);
+		return;
+	}
+
+	vertexShader->SetShader();
+	pixelShader->SetShader();
+}
@@ -1,21 +1,38 @@
 #include "SimpleShader.h"
+#include "PipelineStateCache.h"
+#include "ResourceRegistry.h"
 
 #pragma once
 class Materials
 {
 public:
-	Materials(SimpleVertexShader* newVertShader, SimplePixelShader* newPixShader, ID3D11ShaderResourceView* srvPtr, ID3D11SamplerState* smplPtr);
+	Materials(SimpleVertexShader* newVertShader, SimplePixelShader* newPixShader, TextureHandle newTexture, ID3D11SamplerState* smplPtr);
+	Materials(PipelineStateCache* stateCache, const PipelineState* state, TextureHandle newTexture, ID3D11SamplerState* smplPtr);
 	~Materials();
 	inline SimpleVertexShader* GetVertexShader() { return vertexShader; };
 	inline SimplePixelShader* GetPixelShader() { return pixelShader; };
-	inline ID3D11ShaderResourceView* GetShaderResourceView() { return srv; };
+	inline TextureHandle GetTexture() { return texture; };
 	inline ID3D11SamplerState* GetSamplerState() { return sampler; };
+	inline const PipelineState* GetPipelineState() { return pipelineState; };
+
+	// Same shaders, but testing for equal depth against a prepass
+	// (see DepthPrepass).  Anything drawn over a prepass needs one,
+	// since its usual "nearer" test fails on equal depth.
+	void SetPrepassedState(const PipelineState* state) { prepassedState = state; };
+
+	// Binds shaders and states, skipping whatever is already bound
+	void BindPipelineState(bool depthPrepassed = false);
 private:
 	// Wrappers for DirectX shaders to provide simplified functionality
 	SimpleVertexShader* vertexShader;
 	SimplePixelShader* pixelShader;
-	ID3D11ShaderResourceView* srv;
+	TextureHandle texture;	// Referenced (see ResourceRegistry)
 	ID3D11SamplerState* sampler;
 
+	// Shared bundle of shaders and states (owned by the cache)
+	PipelineStateCache* stateCache;
+	const PipelineState* pipelineState;
+	const PipelineState* prepassedState;
+
 };
 
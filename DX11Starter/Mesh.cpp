@@ -1,16 +1,51 @@
 #include "Mesh.h"
+#include "GeometryPool.h"
+#include "Meshlets.h"
+#include <cstdio>
 #include <iostream>
 #include <fstream>
 #include <vector>
 #include <string>
+#include <unordered_map>
+#include <utility>
 
-Mesh::Mesh(Vertex* verticies, int vertexNumber, int* indicies, int indexNumber, ID3D11Device* device)
+Mesh::Mesh(Vertex* verticies, int vertexNumber, int* indicies, int indexNumber, GeometryPool* geometryPool)
 {
-	CreateVertexBuffer(vertexNumber, verticies, device);
-	CreateIndexBuffer(indexNumber, indicies, device);
+	pool = geometryPool;
+	Prepare(verticies, vertexNumber, indicies, indexNumber, pool->GetVertexFormat(), &data);
+	Upload();
 }
 
-Mesh::Mesh(char* fileinfo, ID3D11Device* device)
+Mesh::Mesh(char* fileinfo, GeometryPool* geometryPool)
+{
+	pool = geometryPool;
+
+	std::vector<Vertex> verts;
+	std::vector<int> indices;
+	if (LoadOBJ(fileinfo, verts, indices))
+		Prepare(&verts[0], verts.size(), &indices[0], indices.size(), pool->GetVertexFormat(), &data);
+	else
+		Prepare(0, 0, 0, 0, pool->GetVertexFormat(), &data);
+	Upload();
+}
+
+Mesh::Mesh(MeshData& prepared, GeometryPool* geometryPool)
+{
+	pool = geometryPool;
+	std::swap(data, prepared);
+	Upload();
+}
+
+// --------------------------------------------------------
+// Reads an OBJ file from Assets/Models into plain vertex and
+// index lists.  Touches no GPU state, so it's safe to call
+// from any thread.
+//
+// Returns true if the file had any triangles in it, and false
+// if it had none or had a face that can't be read (a corner
+// that isn't position/uv/normal, or an index out of range)
+// --------------------------------------------------------
+bool Mesh::LoadOBJ(char* fileinfo, std::vector<Vertex>& verts, std::vector<int>& indices)
 {
 	// File input object
 	std::string filePath = "./Assets/Models/";
@@ -19,17 +54,54 @@ Mesh::Mesh(char* fileinfo, ID3D11Device* device)
 
 	// Check for successful open
 	if (!fileHandle.is_open())
-		return;
+		return false;
 
 	// Variables used while reading the file
 	std::vector<XMFLOAT3> positions;     // Positions from the file
 	std::vector<XMFLOAT3> normals;       // Normals from the file
 	std::vector<XMFLOAT2> uvs;           // UVs from the file
-	std::vector<Vertex> verts;           // Verts we're assembling
-	std::vector<int> indices;           // Indices of these verts
-	unsigned int vertCounter = 0;        // Count of vertices/indices
 	char chars[100];                     // String for line reading
 
+	// Vertex for each unique position/uv/normal combination.
+	// Returns -1 if any index is outside what's been read so far.
+	std::unordered_map<unsigned long long, int> corners;
+	auto corner = [&](unsigned int p, unsigned int t, unsigned int n)
+	{
+		if (p == 0 || p > positions.size() ||
+			t == 0 || t > uvs.size() ||
+			n == 0 || n > normals.size())
+			return -1;
+
+		unsigned long long key = ((unsigned long long)p << 42) | ((unsigned long long)t << 21) | n;
+		auto found = corners.find(key);
+		if (found != corners.end())
+			return found->second;
+
+		Vertex v;
+		v.Position = positions[p - 1];
+		v.UV = uvs[t - 1];
+		v.Normal = normals[n - 1];
+
+		// The model is most likely in a right-handed space,
+		// especially if it came from Maya.  We want to convert
+		// to a left-handed space for DirectX.  This means we 
+		// need to:
+		//  - Invert the Z position
+		//  - Invert the normal's Z
+		//  - Flip the winding order (done when adding indices)
+		// We also need to flip the UV coordinate since DirectX
+		// defines (0,0) as the top left of the texture, and many
+		// 3D modeling packages use the bottom left as (0,0)
+		v.UV.y = 1.0f - v.UV.y;
+		v.Position.z *= -1.0f;
+		v.Normal.z *= -1.0f;
+
+		int index = (int)verts.size();
+		verts.push_back(v);
+		corners[key] = index;
+		return index;
+	};
+
 										 // Still have data left?
 	while (fileHandle.good())
 	{
@@ -85,157 +157,200 @@ Mesh::Mesh(char* fileinfo, ID3D11Device* device)
 				&i[6], &i[7], &i[8],
 				&i[9], &i[10], &i[11]);
 
-			// - Create the verts by looking up
-			//    corresponding data from vectors
-			// - OBJ File indices are 1-based, so
-			//    they need to be adusted
-			Vertex v1;
-			v1.Position = positions[i[0] - 1];
-			v1.UV = uvs[i[1] - 1];
-			v1.Normal = normals[i[2] - 1];
-
-			Vertex v2;
-			v2.Position = positions[i[3] - 1];
-			v2.UV = uvs[i[4] - 1];
-			v2.Normal = normals[i[5] - 1];
-
-			Vertex v3;
-			v3.Position = positions[i[6] - 1];
-			v3.UV = uvs[i[7] - 1];
-			v3.Normal = normals[i[8] - 1];
-
-			// The model is most likely in a right-handed space,
-			// especially if it came from Maya.  We want to convert
-			// to a left-handed space for DirectX.  This means we 
-			// need to:
-			//  - Invert the Z position
-			//  - Invert the normal's Z
-			//  - Flip the winding order
-			// We also need to flip the UV coordinate since DirectX
-			// defines (0,0) as the top left of the texture, and many
-			// 3D modeling packages use the bottom left as (0,0)
-
-			// Flip the UV's since they're probably "upside down"
-			v1.UV.y = 1.0f - v1.UV.y;
-			v2.UV.y = 1.0f - v2.UV.y;
-			v3.UV.y = 1.0f - v3.UV.y;
-
-			// Flip Z (LH vs. RH)
-			v1.Position.z *= -1.0f;
-			v2.Position.z *= -1.0f;
-			v3.Position.z *= -1.0f;
-
-			// Flip normal Z
-			v1.Normal.z *= -1.0f;
-			v2.Normal.z *= -1.0f;
-			v3.Normal.z *= -1.0f;
-
-			// Add the verts to the vector (flipping the winding order)
-			verts.push_back(v1);
-			verts.push_back(v3);
-			verts.push_back(v2);
-
-			// Add three more indices
-			indices.push_back(vertCounter); vertCounter += 1;
-			indices.push_back(vertCounter); vertCounter += 1;
-			indices.push_back(vertCounter); vertCounter += 1;
+			// Only full position/uv/normal triangles and quads are
+			// supported - anything else means a file we can't read
+			if (facesRead != 9 && facesRead != 12)
+				return false;
+
+			// - Each corner is looked up by its position/uv/normal
+			//    indices, so corners shared between faces share one
+			//    vertex (which meshlets and the vertex cache rely on)
+			// - OBJ File indices are 1-based, which corner() adjusts for
+			int c1 = corner(i[0], i[1], i[2]);
+			int c2 = corner(i[3], i[4], i[5]);
+			int c3 = corner(i[6], i[7], i[8]);
+			if (c1 < 0 || c2 < 0 || c3 < 0)
+				return false;
+
+			// Add the triangle (flipping the winding order)
+			indices.push_back(c1);
+			indices.push_back(c3);
+			indices.push_back(c2);
 
 			// Was there a 4th face?
 			if (facesRead == 12)
 			{
-				// Make the last vertex
-				Vertex v4;
-				v4.Position = positions[i[9] - 1];
-				v4.UV = uvs[i[10] - 1];
-				v4.Normal = normals[i[11] - 1];
-
-				// Flip the UV, Z pos and normal
-				v4.UV.y = 1.0f - v4.UV.y;
-				v4.Position.z *= -1.0f;
-				v4.Normal.z *= -1.0f;
-
 				// Add a whole triangle (flipping the winding order)
-				verts.push_back(v1);
-				verts.push_back(v4);
-				verts.push_back(v3);
-
-				// Add three more indices
-				indices.push_back(vertCounter); vertCounter += 1;
-				indices.push_back(vertCounter); vertCounter += 1;
-				indices.push_back(vertCounter); vertCounter += 1;
+				int c4 = corner(i[9], i[10], i[11]);
+				if (c4 < 0)
+					return false;
+				indices.push_back(c1);
+				indices.push_back(c4);
+				indices.push_back(c3);
 			}
 		}
 	}
 
-	// Close the file and create the actual buffers
+	// Close the file
 	fileHandle.close();
 
+	// Nothing usable in the file means it may still be being written
+	return !verts.empty();
+}
+
+// --------------------------------------------------------
+// Splits the mesh into clusters for culling and builds its
+// BVH.  The pool gets the indices in meshlet order too, so
+// drawing the whole mesh is unchanged.
+//
+// Quantized pools get compressed copies of the verticies,
+// and how much precision that cost is reported.
+//
+// Returns false (leaving an empty mesh) if there's nothing
+// to draw
+// --------------------------------------------------------
+bool Mesh::Prepare(const Vertex* verticies, int vertexNumber, const int* indicies, int indexNumber, VertexStreamFormat format, MeshData* data)
+{
+	data->Verticies.clear();
+	data->Quantized.clear();
+	data->Quantization = {};
+	data->Quantization.PositionExtent = XMFLOAT3(1, 1, 1);
+	data->Indicies.clear();
+	data->Meshlets.clear();
+	data->BVH = TriangleBVH();
+	data->Occlusion.clear();
+
+	if (vertexNumber <= 0 || indexNumber <= 0)
+		return false;
+
+	if (!BuildMeshlets(verticies, vertexNumber, indicies, indexNumber, data->Meshlets, data->Indicies) || data->Indicies.empty())
+	{
+		data->Meshlets.clear();
+		data->Indicies.assign(indicies, indicies + indexNumber);
+	}
+
+	data->BVH.Build(verticies, vertexNumber, &data->Indicies[0], data->Indicies.size());
+	data->Verticies.assign(verticies, verticies + vertexNumber);
+
+	if (format != VERTEX_STREAM_QUANTIZED)
+		return true;
+
+	data->Quantized.resize(vertexNumber);
+	QuantizeVertices(verticies, vertexNumber, &data->Quantized[0], &data->Quantization);
+
+	// Bounds were built from the exact positions, so grow them
+	// to cover wherever quantization moved the verticies to
+	for (unsigned int i = 0; i < data->Meshlets.size(); i++)
+		data->Meshlets[i].Radius += data->Quantization.MaxPositionError;
 
-	// - At this point, "verts" is a vector of Vertex structs, and can be used
-	//    directly to create a vertex buffer:  &verts[0] is the address of the first vert
-	//
-	CreateVertexBuffer(verts.size(), &(verts[0]), device);
-	// - The vector "indices" is similar. It's a vector of unsigned ints and
-	//    can be used directly for the index buffer: &indices[0] is the address of the first int
-	//
-	CreateIndexBuffer(indices.size(), &(indices[0]), device);
-	// - "vertCounter" is BOTH the number of vertices and the number of indices
-	// - Yes, the indices are a bit redundant here (one per vertex)
+	printf("Quantized %d verticies: position error %f, normal error %f degrees, uv error %f\n",
+		vertexNumber,
+		data->Quantization.MaxPositionError,
+		data->Quantization.MaxNormalError,
+		data->Quantization.MaxUVError);
+	return true;
 }
 
-void Mesh::CreateVertexBuffer(int vertexNumber, Vertex* verticies, ID3D11Device* device)
+// --------------------------------------------------------
+// Copies the prepared geometry (and occlusion, if it's
+// been baked) into the shared pool.  The mesh only
+// remembers where in the pool's buffers it ended up.
+// --------------------------------------------------------
+void Mesh::Upload()
 {
-	// Create the VERTEX BUFFER description -----------------------------------
-	// - The description is created on the stack because we only need
-	//    it to create the buffer.  The description is then useless.
-	D3D11_BUFFER_DESC vbd;
-	vbd.Usage = D3D11_USAGE_IMMUTABLE;
-	vbd.ByteWidth = sizeof(Vertex) * vertexNumber;       // 3 = number of vertices in the buffer
-	vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER; // Tells DirectX this is a vertex buffer
-	vbd.CPUAccessFlags = 0;
-	vbd.MiscFlags = 0;
-	vbd.StructureByteStride = 0;
-
-	// Create the proper struct to hold the initial vertex data
-	// - This is how we put the initial data into the buffer
-	D3D11_SUBRESOURCE_DATA initialVertexData;
-	initialVertexData.pSysMem = verticies;
-
-	// Actually create the buffer with the initial data
-	// - Once we do this, we'll NEVER CHANGE THE BUFFER AGAIN
-	device->CreateBuffer(&vbd, &initialVertexData, &vertexBuffer);
+	range.BaseVertex = 0;
+	range.VertexCount = 0;
+	range.FirstIndex = 0;
+	range.IndexCount = 0;
+
+	if (data.Verticies.empty() || data.Indicies.empty())
+		return;
+
+	const void* verticies = &data.Verticies[0];
+	if (IsQuantized())
+	{
+		// Prepared for a different pool
+		if (data.Quantized.size() != data.Verticies.size())
+			return;
+		verticies = &data.Quantized[0];
+	}
+
+	if (!pool->Allocate(verticies, data.Verticies.size(), &data.Indicies[0], data.Indicies.size(), &range))
+		return;
+
+	if (!data.Occlusion.empty())
+		pool->SetOcclusion(range, &data.Occlusion[0]);
+
+	// The pool has its own copies of these now
+	std::vector<QuantizedVertex>().swap(data.Quantized);
+	std::vector<OcclusionVertex>().swap(data.Occlusion);
 }
 
-void Mesh::CreateIndexBuffer(int indexNumber, int* indicies, ID3D11Device* device)
+// --------------------------------------------------------
+// Rays reach half the mesh's size, so a mesh darkens its
+// own creases without the far side shading everything.
+// The BVH was built from the meshlet ordered indices, so
+// those are what a cached bake is matched against.
+// --------------------------------------------------------
+bool Mesh::Bake(MeshData* data, ThreadPool* threads, unsigned int raysPerVertex, const char* cachePath)
 {
-	// Create the INDEX BUFFER description ------------------------------------
-	// - The description is created on the stack because we only need
-	//    it to create the buffer.  The description is then useless.
-	D3D11_BUFFER_DESC ibd;
-	ibd.Usage = D3D11_USAGE_IMMUTABLE;
-	ibd.ByteWidth = sizeof(int) * indexNumber;         // 3 = number of indices in the buffer
-	ibd.BindFlags = D3D11_BIND_INDEX_BUFFER; // Tells DirectX this is an index buffer
-	ibd.CPUAccessFlags = 0;
-	ibd.MiscFlags = 0;
-	ibd.StructureByteStride = 0;
-
-	// Create the proper struct to hold the initial index data
-	// - This is how we put the initial data into the buffer
-	D3D11_SUBRESOURCE_DATA initialIndexData;
-	initialIndexData.pSysMem = indicies;
-
-	// Actually create the buffer with the initial data
-	// - Once we do this, we'll NEVER CHANGE THE BUFFER AGAIN
-	device->CreateBuffer(&ibd, &initialIndexData, &indexBuffer);
-
-	// Assign the number of indicies to Mesh after successfully creating buffer.
-	numIndicies = indexNumber;
+	if (data->Verticies.empty() || data->BVH.IsEmpty())
+		return false;
+
+	XMFLOAT3 boundsMin, boundsMax;
+	data->BVH.GetBounds(&boundsMin, &boundsMax);
+	float size = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&boundsMax), XMLoadFloat3(&boundsMin))));
+
+	OcclusionBakeSettings settings;
+	settings.RaysPerVertex = raysPerVertex;
+	settings.MaxDistance = size * 0.5f;
+	settings.Bias = size * 0.001f;
+
+	data->Occlusion.resize(data->Verticies.size());
+	if (cachePath && LoadVertexOcclusion(cachePath,
+		&data->Verticies[0], data->Verticies.size(), &data->Indicies[0], data->Indicies.size(),
+		settings, &data->Occlusion[0]))
+	{
+		printf("Loaded occlusion for %d verticies from %s\n", (int)data->Verticies.size(), cachePath);
+		return true;
+	}
+
+	OcclusionBakeStats stats;
+	if (!BakeVertexOcclusion(data->BVH, &data->Verticies[0], data->Verticies.size(), settings, threads, &data->Occlusion[0], &stats))
+	{
+		data->Occlusion.clear();
+		return false;
+	}
+
+	printf("Baked occlusion for %d verticies: %llu rays in %f ms on %u threads (%f Mrays/s)\n",
+		(int)data->Verticies.size(),
+		stats.Rays,
+		stats.Seconds * 1000.0,
+		stats.Threads,
+		stats.Seconds > 0.0 ? stats.Rays / stats.Seconds / 1000000.0 : 0.0);
+
+	if (cachePath && !SaveVertexOcclusion(cachePath,
+		&data->Verticies[0], data->Verticies.size(), &data->Indicies[0], data->Indicies.size(),
+		settings, &data->Occlusion[0]))
+		printf("Couldn't save occlusion to %s\n", cachePath);
+	return true;
+}
+
+// --------------------------------------------------------
+// Bakes in place, straight into the pool
+// --------------------------------------------------------
+bool Mesh::BakeOcclusion(ThreadPool* threads, unsigned int raysPerVertex, const char* cachePath)
+{
+	if (range.IndexCount == 0 || !Bake(&data, threads, raysPerVertex, cachePath))
+		return false;
+
+	pool->SetOcclusion(range, &data.Occlusion[0]);
+	std::vector<OcclusionVertex>().swap(data.Occlusion);
+	return true;
 }
 
 Mesh::~Mesh()
 {
-	// Release any (and all!) DirectX objects
-	// we've made in the Game class
-	if (vertexBuffer) { vertexBuffer->Release(); }
-	if (indexBuffer) { indexBuffer->Release(); }
+	// Give our space in the pool back
+	pool->Free(range);
 }
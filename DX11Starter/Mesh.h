@@ -1,26 +1,86 @@
 #include "Vertex.h"
+#include "GeometryPool.h"
+#include "VertexQuantization.h"
+#include "Meshlets.h"
+#include "BVH.h"
+#include "OcclusionBaker.h"
 #include <d3d11.h>
+#include <vector>
 
 #pragma once
+
+// --------------------------------------------------------
+// Everything about a mesh that's worked out on the CPU:
+// its clusters, triangles for ray queries, verticies in the
+// pool's format and their baked occlusion.  Building one
+// touches no GPU state, so it can happen on any thread.
+// --------------------------------------------------------
+struct MeshData
+{
+	std::vector<Vertex> Verticies;				// Full precision, kept for baking
+	std::vector<QuantizedVertex> Quantized;		// Only for quantized pools
+	QuantizationInfo Quantization;
+	std::vector<int> Indicies;					// In meshlet order when there are meshlets
+	std::vector<Meshlet> Meshlets;
+	TriangleBVH BVH;
+	std::vector<OcclusionVertex> Occlusion;		// Empty until baked
+};
+
 // Class that contains the definition for rendering a shape
 class Mesh
 {
 public:
-	Mesh(Vertex* verticies, int numVerticies, int* indicies, int numIndicies, ID3D11Device* device);
-	Mesh(char* fileinfo, ID3D11Device* device);
+	Mesh(Vertex* verticies, int numVerticies, int* indicies, int numIndicies, GeometryPool* geometryPool);
+	Mesh(char* fileinfo, GeometryPool* geometryPool);
+	// Takes over data built by Prepare() (and maybe Bake()) for
+	// this pool's format, so only the upload is left to do.
+	// Main thread only.
+	Mesh(MeshData& prepared, GeometryPool* geometryPool);
 	~Mesh();
-	ID3D11Buffer* GetVertexBuffer() { return vertexBuffer; };
-	ID3D11Buffer* GetIndexBuffer() { return indexBuffer; };
-	int GetIndexCount() { return numIndicies; };
+
+	// Where this mesh lives in the pool's shared buffers
+	int GetIndexCount() { return range.IndexCount; };
+	unsigned int GetFirstIndex() { return range.FirstIndex; };
+	int GetBaseVertex() { return range.BaseVertex; };
+
+	// Quantized meshes need their bounds to decode positions
+	bool IsQuantized() { return pool->GetVertexFormat() == VERTEX_STREAM_QUANTIZED; };
+	const QuantizationInfo& GetQuantization() { return data.Quantization; };
+
+	// Clusters for culling, and our indices in the order they use
+	const std::vector<Meshlet>& GetMeshlets() { return data.Meshlets; };
+	const std::vector<int>& GetMeshletIndices() { return data.Indicies; };
+
+	// Triangles for ray queries, in model space.  Hits index the
+	// meshlet ordered indices above.
+	const TriangleBVH& GetBVH() { return data.BVH; };
+
+	// Ray traces ambient occlusion for every vertex and writes it
+	// to the pool's occlusion stream.  Blocks until done, using
+	// every thread in the pool; call on the main thread.  With a
+	// cache path, a bake saved there for this same mesh is used
+	// instead, and a fresh bake is saved there.
+	bool BakeOcclusion(ThreadPool* threads, unsigned int raysPerVertex, const char* cachePath = 0);
+
+	// Parses an OBJ file without touching the GPU (safe on any thread)
+	static bool LoadOBJ(char* fileinfo, std::vector<Vertex>& verts, std::vector<int>& indices);
+
+	// Builds the clusters and BVH, and quantizes the verticies if
+	// the pool will want them that way (safe on any thread)
+	static bool Prepare(const Vertex* verticies, int vertexNumber, const int* indicies, int indexNumber, VertexStreamFormat format, MeshData* data);
+
+	// Ray traces the prepared mesh's occlusion into data->Occlusion,
+	// or loads it from the cache as above (safe on any thread, but
+	// the thread pool can only run one loop at a time)
+	static bool Bake(MeshData* data, ThreadPool* threads, unsigned int raysPerVertex, const char* cachePath = 0);
 
 private:
-	void CreateVertexBuffer(int vertexNumber, Vertex* verticies, ID3D11Device* device);
-	void CreateIndexBuffer(int indexNumber, int* indicies, ID3D11Device* device);
-	// Holds the verticies for a shape. Defines position adn color
-	ID3D11Buffer* vertexBuffer;
-	// Holds the order the verticies should be rendered in.
-	ID3D11Buffer* indexBuffer;
-	// Number indicies to render
-	int numIndicies;
+	void Upload();
+	// The pool holding our verticies and indicies
+	GeometryPool* pool;
+	// Our slice of the pool's vertex and index buffers
+	GeometryRange range;
+	// Our clusters, BVH and verticies, kept on the CPU for the
+	// cluster culler, ray queries and baking
+	MeshData data;
 };
-
@@ -0,0 +1,217 @@
+#include "Meshlets.h"
+#include <climits>
+#include <cmath>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Fills in a finished meshlet's bounding sphere and normal
+// cone, then adds it to the list
+// --------------------------------------------------------
+static void FinishMeshlet(Meshlet& meshlet, const Vertex* vertices, const std::vector<int>& meshletIndices, std::vector<Meshlet>& meshlets)
+{
+	const int* indices = &meshletIndices[meshlet.FirstIndex];
+
+	// Sphere around the cluster's bounding box.  Not the tightest
+	// possible, but close for the compact clusters we build.
+	XMVECTOR minPosition = XMLoadFloat3(&vertices[indices[0]].Position);
+	XMVECTOR maxPosition = minPosition;
+	for (unsigned int i = 1; i < meshlet.IndexCount; i++)
+	{
+		XMVECTOR position = XMLoadFloat3(&vertices[indices[i]].Position);
+		minPosition = XMVectorMin(minPosition, position);
+		maxPosition = XMVectorMax(maxPosition, position);
+	}
+
+	XMVECTOR center = XMVectorScale(XMVectorAdd(minPosition, maxPosition), 0.5f);
+	XMVECTOR maxDistanceSq = XMVectorZero();
+	for (unsigned int i = 0; i < meshlet.IndexCount; i++)
+	{
+		XMVECTOR offset = XMVectorSubtract(XMLoadFloat3(&vertices[indices[i]].Position), center);
+		maxDistanceSq = XMVectorMax(maxDistanceSq, XMVector3LengthSq(offset));
+	}
+
+	XMStoreFloat3(&meshlet.Center, center);
+	meshlet.Radius = sqrtf(XMVectorGetX(maxDistanceSq));
+
+	// Cone axis is the area weighted average face normal.  Front
+	// faces are clockwise, so cross(p1 - p0, p2 - p0) points out.
+	XMVECTOR axis = XMVectorZero();
+	for (unsigned int i = 0; i < meshlet.IndexCount; i += 3)
+	{
+		XMVECTOR p0 = XMLoadFloat3(&vertices[indices[i]].Position);
+		XMVECTOR p1 = XMLoadFloat3(&vertices[indices[i + 1]].Position);
+		XMVECTOR p2 = XMLoadFloat3(&vertices[indices[i + 2]].Position);
+		axis = XMVectorAdd(axis, XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0)));
+	}
+
+	meshlet.ConeAxis = XMFLOAT3(0, 0, 1);
+	meshlet.ConeCutoff = 1.0f;
+	if (XMVectorGetX(XMVector3LengthSq(axis)) > 0.0f)
+	{
+		axis = XMVector3Normalize(axis);
+
+		// Widest angle between the axis and any face normal
+		float minDot = 1.0f;
+		for (unsigned int i = 0; i < meshlet.IndexCount; i += 3)
+		{
+			XMVECTOR p0 = XMLoadFloat3(&vertices[indices[i]].Position);
+			XMVECTOR p1 = XMLoadFloat3(&vertices[indices[i + 1]].Position);
+			XMVECTOR p2 = XMLoadFloat3(&vertices[indices[i + 2]].Position);
+			XMVECTOR normal = XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0));
+			if (XMVectorGetX(XMVector3LengthSq(normal)) == 0.0f)
+				continue;
+
+			float dot = XMVectorGetX(XMVector3Dot(XMVector3Normalize(normal), axis));
+			if (dot < minDot)
+				minDot = dot;
+		}
+
+		// A cone wider than ~84 degrees would almost never cull.
+		// Otherwise the cutoff is sin(cone angle): the view
+		// direction has to be within 90 - angle of the axis.
+		XMStoreFloat3(&meshlet.ConeAxis, axis);
+		if (minDot > 0.1f)
+			meshlet.ConeCutoff = sqrtf(1.0f - minDot * minDot);
+	}
+
+	meshlets.push_back(meshlet);
+}
+
+// --------------------------------------------------------
+// Greedy: triangles are added in index order until the next
+// one would go over either limit.  Meshes from modelling
+// tools are mostly in strips or patches already, so this
+// keeps clusters compact without any sorting.
+// --------------------------------------------------------
+bool BuildMeshlets(const Vertex* vertices, unsigned int vertexCount, const int* indices, unsigned int indexCount, std::vector<Meshlet>& meshlets, std::vector<int>& meshletIndices)
+{
+	meshlets.clear();
+	meshletIndices.clear();
+	meshletIndices.reserve(indexCount);
+
+	// The meshlet each vertex was last added to, so checking
+	// whether the current one already has it is one lookup
+	std::vector<unsigned int> lastMeshlet(vertexCount, UINT_MAX);
+
+	Meshlet current = {};
+	for (unsigned int i = 0; i + 2 < indexCount; i += 3)
+	{
+		const int* triangle = &indices[i];
+		for (unsigned int k = 0; k < 3; k++)
+		{
+			if (triangle[k] < 0 || (unsigned int)triangle[k] >= vertexCount)
+				return false;
+		}
+
+		// Degenerate triangles may count a vertex twice, which
+		// only ever ends a meshlet a little early
+		unsigned int id = meshlets.size();
+		unsigned int newVertices = 0;
+		for (unsigned int k = 0; k < 3; k++)
+		{
+			if (lastMeshlet[triangle[k]] != id)
+				newVertices++;
+		}
+
+		if (current.VertexCount + newVertices > MESHLET_MAX_VERTICES ||
+			current.IndexCount / 3 == MESHLET_MAX_TRIANGLES)
+		{
+			FinishMeshlet(current, vertices, meshletIndices, meshlets);
+			current = {};
+			current.FirstIndex = meshletIndices.size();
+			id = meshlets.size();
+		}
+
+		for (unsigned int k = 0; k < 3; k++)
+		{
+			if (lastMeshlet[triangle[k]] != id)
+			{
+				lastMeshlet[triangle[k]] = id;
+				current.VertexCount++;
+			}
+			meshletIndices.push_back(triangle[k]);
+		}
+		current.IndexCount += 3;
+	}
+
+	if (current.IndexCount > 0)
+		FinishMeshlet(current, vertices, meshletIndices, meshlets);
+
+	return true;
+}
+
+// --------------------------------------------------------
+// Planes come straight from the columns of world * viewProj
+// (Gribb/Hartmann), which puts them in model space.  Culling
+// there is exact for any world matrix, since which side of
+// a plane a point is on doesn't change under the transform.
+//
+// With a reverse Z, infinite projection one of the depth
+// planes has no normal (it's at infinity), and is left as
+// a plane nothing is ever outside of.
+// --------------------------------------------------------
+MeshletFrustum MakeMeshletFrustum(FXMMATRIX world, CXMMATRIX viewProjection, FXMVECTOR cameraPosition)
+{
+	// Rows of the transpose are the columns of world * viewProj
+	XMMATRIX columns = XMMatrixTranspose(XMMatrixMultiply(world, viewProjection));
+
+	XMVECTOR planes[6] =
+	{
+		XMVectorAdd(columns.r[3], columns.r[0]),		// Left
+		XMVectorSubtract(columns.r[3], columns.r[0]),	// Right
+		XMVectorAdd(columns.r[3], columns.r[1]),		// Bottom
+		XMVectorSubtract(columns.r[3], columns.r[1]),	// Top
+		columns.r[2],									// z >= 0 (near, or far with reverse Z)
+		XMVectorSubtract(columns.r[3], columns.r[2]),	// z <= w (far, or near with reverse Z)
+	};
+
+	MeshletFrustum frustum;
+	for (unsigned int i = 0; i < 6; i++)
+	{
+		if (XMVectorGetX(XMVector3LengthSq(planes[i])) > 0.0f)
+			XMStoreFloat4(&frustum.Planes[i], XMPlaneNormalize(planes[i]));
+		else
+			frustum.Planes[i] = XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+	}
+
+	XMMATRIX invWorld = XMMatrixInverse(0, world);
+	XMStoreFloat3(&frustum.CameraPosition, XMVector3TransformCoord(cameraPosition, invWorld));
+	return frustum;
+}
+
+// --------------------------------------------------------
+// Sphere vs. frustum first (cheap, and culls the most), then
+// the normal cone for clusters facing entirely away
+// --------------------------------------------------------
+unsigned int CullMeshlets(const Meshlet* meshlets, unsigned int meshletCount, const int* meshletIndices, const MeshletFrustum& frustum, std::vector<int>& visibleIndices)
+{
+	XMVECTOR planes[6];
+	for (unsigned int i = 0; i < 6; i++)
+		planes[i] = XMLoadFloat4(&frustum.Planes[i]);
+	XMVECTOR camera = XMLoadFloat3(&frustum.CameraPosition);
+
+	unsigned int visible = 0;
+	for (unsigned int m = 0; m < meshletCount; m++)
+	{
+		const Meshlet& meshlet = meshlets[m];
+		XMVECTOR center = XMLoadFloat3(&meshlet.Center);
+
+		bool outside = false;
+		for (unsigned int i = 0; i < 6 && !outside; i++)
+			outside = XMVectorGetX(XMPlaneDotCoord(planes[i], center)) < -meshlet.Radius;
+		if (outside)
+			continue;
+
+		XMVECTOR toCluster = XMVectorSubtract(center, camera);
+		float alongAxis = XMVectorGetX(XMVector3Dot(toCluster, XMLoadFloat3(&meshlet.ConeAxis)));
+		if (alongAxis >= meshlet.ConeCutoff * XMVectorGetX(XMVector3Length(toCluster)) + meshlet.Radius)
+			continue;
+
+		const int* first = meshletIndices + meshlet.FirstIndex;
+		visibleIndices.insert(visibleIndices.end(), first, first + meshlet.IndexCount);
+		visible++;
+	}
+
+	return visible;
+}
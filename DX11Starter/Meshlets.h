@@ -0,0 +1,63 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+#include "Vertex.h"
+
+// Cluster size limits (the usual mesh shader limits, so the
+// same clusters would work if we ever move culling to the GPU)
+#define MESHLET_MAX_VERTICES	64
+#define MESHLET_MAX_TRIANGLES	124
+
+// --------------------------------------------------------
+// A small cluster of neighbouring triangles, with bounds
+// for culling the whole cluster at once
+// --------------------------------------------------------
+struct Meshlet
+{
+	unsigned int FirstIndex;	// Into the mesh's meshlet-ordered indices
+	unsigned int IndexCount;
+	unsigned int VertexCount;	// Unique verticies referenced
+
+	// Bounding sphere (model space)
+	XMFLOAT3 Center;
+	float Radius;
+
+	// Normal cone.  Every triangle faces away from a camera at c when
+	//   dot(Center - c, ConeAxis) >= ConeCutoff * |Center - c| + Radius
+	// A cutoff of 1 means the normals are too spread out to ever cull.
+	XMFLOAT3 ConeAxis;
+	float ConeCutoff;
+};
+
+// --------------------------------------------------------
+// What a cluster has to be inside of (or facing) to be
+// drawn, in a mesh's model space
+// --------------------------------------------------------
+struct MeshletFrustum
+{
+	XMFLOAT4 Planes[6];			// Normalized, pointing inwards
+	XMFLOAT3 CameraPosition;
+};
+
+// Splits triangles into meshlets, in index order.  meshletIndices
+// gets the same triangles, reordered so each meshlet's are together.
+// Returns false if an index is out of range.
+bool BuildMeshlets(
+	const Vertex* vertices, unsigned int vertexCount,
+	const int* indices, unsigned int indexCount,
+	std::vector<Meshlet>& meshlets,
+	std::vector<int>& meshletIndices);
+
+// Brings the camera's frustum and position into a mesh's model
+// space.  Matrices are the usual (not transposed) DirectXMath ones.
+MeshletFrustum MakeMeshletFrustum(DirectX::FXMMATRIX world, DirectX::CXMMATRIX viewProjection, DirectX::FXMVECTOR cameraPosition);
+
+// Appends the indices of every meshlet that's inside the frustum and
+// has at least one triangle facing the camera.  Returns how many
+// meshlets survived.
+unsigned int CullMeshlets(
+	const Meshlet* meshlets, unsigned int meshletCount,
+	const int* meshletIndices,
+	const MeshletFrustum& frustum,
+	std::vector<int>& visibleIndices);
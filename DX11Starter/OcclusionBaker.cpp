@@ -0,0 +1,203 @@
+#include "OcclusionBaker.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Bit reversal of i, as a fraction in [0, 1).  Paired with
+// i / n this gives the Hammersley point set, which covers
+// the hemisphere far more evenly than random rays.
+// --------------------------------------------------------
+static float RadicalInverse(unsigned int i)
+{
+	i = (i << 16) | (i >> 16);
+	i = ((i & 0x55555555) << 1) | ((i & 0xAAAAAAAA) >> 1);
+	i = ((i & 0x33333333) << 2) | ((i & 0xCCCCCCCC) >> 2);
+	i = ((i & 0x0F0F0F0F) << 4) | ((i & 0xF0F0F0F0) >> 4);
+	i = ((i & 0x00FF00FF) << 8) | ((i & 0xFF00FF00) >> 8);
+	return i * 2.3283064365386963e-10f;
+}
+
+// Scrambles a vertex index, to offset each vertex's pattern
+static unsigned int Hash(unsigned int x)
+{
+	x ^= x >> 16;
+	x *= 0x7feb352d;
+	x ^= x >> 15;
+	x *= 0x846ca68b;
+	x ^= x >> 16;
+	return x;
+}
+
+// Saved bakes start with this, then a version
+static const char occlusionMagic[4] = { 'O', 'C', 'C', 'L' };
+static const unsigned int occlusionVersion = 1;
+
+// Part of every saved bake's key.  Bump it whenever the bake
+// itself changes, so older files stop matching.
+static const unsigned int occlusionBakeRevision = 1;
+
+// FNV-1a, continued from hash
+static unsigned long long HashBytes(unsigned long long hash, const void* data, size_t size)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+static unsigned long long OcclusionKey(const Vertex* vertices, unsigned int vertexCount, const int* indices, unsigned int indexCount, const OcclusionBakeSettings& settings)
+{
+	unsigned long long hash = 0xcbf29ce484222325ull;
+	hash = HashBytes(hash, &occlusionBakeRevision, sizeof(occlusionBakeRevision));
+	hash = HashBytes(hash, &settings.RaysPerVertex, sizeof(settings.RaysPerVertex));
+	hash = HashBytes(hash, &settings.MaxDistance, sizeof(settings.MaxDistance));
+	hash = HashBytes(hash, &settings.Bias, sizeof(settings.Bias));
+	hash = HashBytes(hash, &vertexCount, sizeof(vertexCount));
+	hash = HashBytes(hash, vertices, vertexCount * sizeof(Vertex));
+	hash = HashBytes(hash, &indexCount, sizeof(indexCount));
+	hash = HashBytes(hash, indices, indexCount * sizeof(int));
+	return hash;
+}
+
+// --------------------------------------------------------
+// Vertices are independent, so they're simply split across
+// the pool.  Rays only need any hit, not the closest, so
+// most stop at the first leaf they reach.
+// --------------------------------------------------------
+bool BakeVertexOcclusion(const TriangleBVH& bvh, const Vertex* vertices, unsigned int vertexCount, const OcclusionBakeSettings& settings, ThreadPool* threads, OcclusionVertex* occlusion, OcclusionBakeStats* stats)
+{
+	if (bvh.IsEmpty())
+		return false;
+
+	unsigned int rayCount = settings.RaysPerVertex > 0 ? settings.RaysPerVertex : 1;
+	std::atomic<unsigned int> skipped(0);
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	threads->ParallelFor(vertexCount, 32, [&](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int v = begin; v < end; v++)
+		{
+			XMVECTOR normal = XMLoadFloat3(&vertices[v].Normal);
+			if (XMVectorGetX(XMVector3LengthSq(normal)) == 0.0f)
+			{
+				occlusion[v].Occlusion = 255;
+				skipped++;
+				continue;
+			}
+			normal = XMVector3Normalize(normal);
+
+			// Basis around the normal, without a special case for
+			// any direction (Duff et al. 2017)
+			XMFLOAT3 n;
+			XMStoreFloat3(&n, normal);
+			float sign = copysignf(1.0f, n.z);
+			float a = -1.0f / (sign + n.z);
+			float b = n.x * n.y * a;
+			XMVECTOR tangent = XMVectorSet(1.0f + sign * n.x * n.x * a, sign * b, -sign * n.x, 0.0f);
+			XMVECTOR bitangent = XMVectorSet(b, sign + n.y * n.y * a, -n.y, 0.0f);
+
+			Ray ray;
+			XMStoreFloat3(&ray.Origin, XMVectorMultiplyAdd(normal, XMVectorReplicate(settings.Bias), XMLoadFloat3(&vertices[v].Position)));
+			ray.MaxDistance = settings.MaxDistance;
+
+			// Shifting the points (wrapping around) gives each vertex
+			// a different pattern, which hides banding between them
+			unsigned int hash = Hash(v);
+			float shiftU = (hash & 0xFFFF) / 65536.0f;
+			float shiftV = (hash >> 16) / 65536.0f;
+
+			unsigned int open = 0;
+			for (unsigned int r = 0; r < rayCount; r++)
+			{
+				float u = (r + 0.5f) / rayCount + shiftU;
+				float w = RadicalInverse(r) + shiftV;
+				if (u >= 1.0f) u -= 1.0f;
+				if (w >= 1.0f) w -= 1.0f;
+
+				// Cosine weighted: even over the unit disk, then
+				// projected up onto the hemisphere
+				float radius = sqrtf(u);
+				float phi = XM_2PI * w;
+				float z = sqrtf(1.0f - u > 0.0f ? 1.0f - u : 0.0f);
+				XMVECTOR direction = XMVectorScale(tangent, radius * cosf(phi));
+				direction = XMVectorAdd(direction, XMVectorScale(bitangent, radius * sinf(phi)));
+				direction = XMVectorAdd(direction, XMVectorScale(normal, z));
+				XMStoreFloat3(&ray.Direction, direction);
+
+				if (!bvh.IntersectAny(ray))
+					open++;
+			}
+
+			occlusion[v].Occlusion = (unsigned char)((open * 255 + rayCount / 2) / rayCount);
+		}
+	});
+
+	if (stats)
+	{
+		std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+		stats->Rays = (unsigned long long)(vertexCount - skipped.load()) * rayCount;
+		stats->Seconds = elapsed.count();
+		stats->Threads = threads->GetThreadCount();
+	}
+
+	return true;
+}
+
+bool SaveVertexOcclusion(const char* path, const Vertex* vertices, unsigned int vertexCount, const int* indices, unsigned int indexCount, const OcclusionBakeSettings& settings, const OcclusionVertex* occlusion)
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+		return false;
+
+	unsigned long long key = OcclusionKey(vertices, vertexCount, indices, indexCount, settings);
+	file.write(occlusionMagic, sizeof(occlusionMagic));
+	file.write((const char*)&occlusionVersion, sizeof(occlusionVersion));
+	file.write((const char*)&key, sizeof(key));
+	file.write((const char*)&vertexCount, sizeof(vertexCount));
+	if (vertexCount > 0)
+		file.write((const char*)occlusion, vertexCount * sizeof(OcclusionVertex));
+	return file.good();
+}
+
+// --------------------------------------------------------
+// Read whole before anything is copied out, so a file cut
+// short changes nothing
+// --------------------------------------------------------
+bool LoadVertexOcclusion(const char* path, const Vertex* vertices, unsigned int vertexCount, const int* indices, unsigned int indexCount, const OcclusionBakeSettings& settings, OcclusionVertex* occlusion)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	char magic[4];
+	unsigned int version = 0;
+	unsigned long long key = 0;
+	unsigned int count = 0;
+	file.read(magic, sizeof(magic));
+	file.read((char*)&version, sizeof(version));
+	file.read((char*)&key, sizeof(key));
+	file.read((char*)&count, sizeof(count));
+	if (!file.good() || memcmp(magic, occlusionMagic, sizeof(magic)) != 0 || version != occlusionVersion)
+		return false;
+	if (count != vertexCount || key != OcclusionKey(vertices, vertexCount, indices, indexCount, settings))
+		return false;
+
+	std::vector<OcclusionVertex> loaded(count);
+	if (count > 0)
+		file.read((char*)&loaded[0], count * sizeof(OcclusionVertex));
+	if (!file.good())
+		return false;
+
+	if (count > 0)
+		memcpy(occlusion, &loaded[0], count * sizeof(OcclusionVertex));
+	return true;
+}
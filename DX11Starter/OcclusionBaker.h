@@ -0,0 +1,63 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include "BVH.h"
+#include "ThreadPool.h"
+#include "Vertex.h"
+
+// Saved bakes sit next to their model, named after it with
+// this on the end
+#define OCCLUSION_CACHE_EXTENSION	".occlusion"
+
+// --------------------------------------------------------
+// How an occlusion bake is sampled
+// --------------------------------------------------------
+struct OcclusionBakeSettings
+{
+	unsigned int RaysPerVertex;
+	float MaxDistance;		// Anything farther doesn't occlude (model units)
+	float Bias;				// Rays start this far off the surface
+};
+
+// --------------------------------------------------------
+// What a bake cost
+// --------------------------------------------------------
+struct OcclusionBakeStats
+{
+	unsigned long long Rays;
+	double Seconds;
+	unsigned int Threads;
+};
+
+// Ray traces ambient occlusion at each vertex of a mesh against
+// its own triangles: the fraction of cosine weighted rays over
+// the normal's hemisphere that escape within MaxDistance.
+//
+// Every vertex uses the same (rotated) ray pattern no matter
+// which thread runs it, so results don't depend on the thread
+// count.  Returns false if the BVH is empty.
+bool BakeVertexOcclusion(
+	const TriangleBVH& bvh,
+	const Vertex* vertices, unsigned int vertexCount,
+	const OcclusionBakeSettings& settings,
+	ThreadPool* threads,
+	OcclusionVertex* occlusion,
+	OcclusionBakeStats* stats);
+
+// Saves a bake to disk, along with a hash of everything it was
+// made from: the mesh (indices in the order its BVH was built
+// from) and the settings.  Loading only succeeds for a file
+// made from exactly the same, so an edited model just misses.
+// Loading leaves occlusion untouched if it fails.
+bool SaveVertexOcclusion(
+	const char* path,
+	const Vertex* vertices, unsigned int vertexCount,
+	const int* indices, unsigned int indexCount,
+	const OcclusionBakeSettings& settings,
+	const OcclusionVertex* occlusion);
+bool LoadVertexOcclusion(
+	const char* path,
+	const Vertex* vertices, unsigned int vertexCount,
+	const int* indices, unsigned int indexCount,
+	const OcclusionBakeSettings& settings,
+	OcclusionVertex* occlusion);
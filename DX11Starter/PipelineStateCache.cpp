@@ -0,0 +1,362 @@
+#include "PipelineStateCache.h"
+#include "SimpleShader.h"
+
+// --------------------------------------------------------
+// Helpers for building cache keys.  Descriptions are copied
+// in field by field (rather than hashing the raw struct) so
+// compiler padding never makes two equal descriptions look
+// different.
+// --------------------------------------------------------
+static void AppendKey(std::string& key, unsigned int value)
+{
+	key.append((const char*)&value, sizeof(unsigned int));
+}
+
+static void AppendKey(std::string& key, float value)
+{
+	key.append((const char*)&value, sizeof(float));
+}
+
+static void AppendKey(std::string& key, const void* pointer)
+{
+	key.append((const char*)&pointer, sizeof(void*));
+}
+
+static void AppendKey(std::string& key, const D3D11_DEPTH_STENCILOP_DESC& op)
+{
+	AppendKey(key, (unsigned int)op.StencilFailOp);
+	AppendKey(key, (unsigned int)op.StencilDepthFailOp);
+	AppendKey(key, (unsigned int)op.StencilPassOp);
+	AppendKey(key, (unsigned int)op.StencilFunc);
+}
+
+// --------------------------------------------------------
+// Constructor
+// --------------------------------------------------------
+PipelineStateCache::PipelineStateCache(ID3D11Device* device, ID3D11DeviceContext* context)
+{
+	this->device = device;
+	this->context = context;
+
+	InvalidateBoundState();
+}
+
+// --------------------------------------------------------
+// Destructor - Releases every state object we created
+// --------------------------------------------------------
+PipelineStateCache::~PipelineStateCache()
+{
+	for (auto& pair : inputLayouts) pair.second->Release();
+	for (auto& pair : rasterizerStates) pair.second->Release();
+	for (auto& pair : blendStates) pair.second->Release();
+	for (auto& pair : depthStencilStates) pair.second->Release();
+	for (auto& pair : samplerStates) pair.second->Release();
+	for (auto& pair : pipelineStates) delete pair.second;
+}
+
+// --------------------------------------------------------
+// Gets an input layout matching this semantic signature.
+// Every vertex shader with the same inputs shares one
+// layout, so switching between them never touches the IA.
+//
+// Returns 0 if the layout could not be created
+// --------------------------------------------------------
+ID3D11InputLayout* PipelineStateCache::GetInputLayout(const D3D11_INPUT_ELEMENT_DESC* elements, unsigned int elementCount, const void* shaderCode, size_t shaderCodeSize)
+{
+	std::string key;
+	for (unsigned int i = 0; i < elementCount; i++)
+	{
+		key.append(elements[i].SemanticName);
+		key.push_back('\0');
+		AppendKey(key, elements[i].SemanticIndex);
+		AppendKey(key, (unsigned int)elements[i].Format);
+		AppendKey(key, elements[i].InputSlot);
+		AppendKey(key, elements[i].AlignedByteOffset);
+		AppendKey(key, (unsigned int)elements[i].InputSlotClass);
+		AppendKey(key, elements[i].InstanceDataStepRate);
+	}
+
+	auto found = inputLayouts.find(key);
+	if (found != inputLayouts.end())
+		return found->second;
+
+	// First shader with this signature - its code is used to validate the layout
+	ID3D11InputLayout* layout = 0;
+	if (FAILED(device->CreateInputLayout(elements, elementCount, shaderCode, shaderCodeSize, &layout)))
+		return 0;
+
+	inputLayouts[key] = layout;
+	return layout;
+}
+
+// --------------------------------------------------------
+// Gets a rasterizer state matching the description
+// --------------------------------------------------------
+ID3D11RasterizerState* PipelineStateCache::GetRasterizerState(const D3D11_RASTERIZER_DESC& desc)
+{
+	std::string key;
+	AppendKey(key, (unsigned int)desc.FillMode);
+	AppendKey(key, (unsigned int)desc.CullMode);
+	AppendKey(key, (unsigned int)desc.FrontCounterClockwise);
+	AppendKey(key, (unsigned int)desc.DepthBias);
+	AppendKey(key, desc.DepthBiasClamp);
+	AppendKey(key, desc.SlopeScaledDepthBias);
+	AppendKey(key, (unsigned int)desc.DepthClipEnable);
+	AppendKey(key, (unsigned int)desc.ScissorEnable);
+	AppendKey(key, (unsigned int)desc.MultisampleEnable);
+	AppendKey(key, (unsigned int)desc.AntialiasedLineEnable);
+
+	auto found = rasterizerStates.find(key);
+	if (found != rasterizerStates.end())
+		return found->second;
+
+	ID3D11RasterizerState* state = 0;
+	if (FAILED(device->CreateRasterizerState(&desc, &state)))
+		return 0;
+
+	rasterizerStates[key] = state;
+	return state;
+}
+
+// --------------------------------------------------------
+// Gets a blend state matching the description
+// --------------------------------------------------------
+ID3D11BlendState* PipelineStateCache::GetBlendState(const D3D11_BLEND_DESC& desc)
+{
+	// Without independent blending only the first target matters
+	unsigned int targetCount = desc.IndependentBlendEnable ? 8 : 1;
+
+	std::string key;
+	AppendKey(key, (unsigned int)desc.AlphaToCoverageEnable);
+	AppendKey(key, (unsigned int)desc.IndependentBlendEnable);
+	for (unsigned int i = 0; i < targetCount; i++)
+	{
+		const D3D11_RENDER_TARGET_BLEND_DESC& rt = desc.RenderTarget[i];
+		AppendKey(key, (unsigned int)rt.BlendEnable);
+		AppendKey(key, (unsigned int)rt.SrcBlend);
+		AppendKey(key, (unsigned int)rt.DestBlend);
+		AppendKey(key, (unsigned int)rt.BlendOp);
+		AppendKey(key, (unsigned int)rt.SrcBlendAlpha);
+		AppendKey(key, (unsigned int)rt.DestBlendAlpha);
+		AppendKey(key, (unsigned int)rt.BlendOpAlpha);
+		AppendKey(key, (unsigned int)rt.RenderTargetWriteMask);
+	}
+
+	auto found = blendStates.find(key);
+	if (found != blendStates.end())
+		return found->second;
+
+	ID3D11BlendState* state = 0;
+	if (FAILED(device->CreateBlendState(&desc, &state)))
+		return 0;
+
+	blendStates[key] = state;
+	return state;
+}
+
+// --------------------------------------------------------
+// Gets a depth stencil state matching the description
+// --------------------------------------------------------
+ID3D11DepthStencilState* PipelineStateCache::GetDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& desc)
+{
+	std::string key;
+	AppendKey(key, (unsigned int)desc.DepthEnable);
+	AppendKey(key, (unsigned int)desc.DepthWriteMask);
+	AppendKey(key, (unsigned int)desc.DepthFunc);
+	AppendKey(key, (unsigned int)desc.StencilEnable);
+	AppendKey(key, (unsigned int)desc.StencilReadMask);
+	AppendKey(key, (unsigned int)desc.StencilWriteMask);
+	AppendKey(key, desc.FrontFace);
+	AppendKey(key, desc.BackFace);
+
+	auto found = depthStencilStates.find(key);
+	if (found != depthStencilStates.end())
+		return found->second;
+
+	ID3D11DepthStencilState* state = 0;
+	if (FAILED(device->CreateDepthStencilState(&desc, &state)))
+		return 0;
+
+	depthStencilStates[key] = state;
+	return state;
+}
+
+// --------------------------------------------------------
+// Gets a sampler state matching the description
+// --------------------------------------------------------
+ID3D11SamplerState* PipelineStateCache::GetSamplerState(const D3D11_SAMPLER_DESC& desc)
+{
+	std::string key;
+	AppendKey(key, (unsigned int)desc.Filter);
+	AppendKey(key, (unsigned int)desc.AddressU);
+	AppendKey(key, (unsigned int)desc.AddressV);
+	AppendKey(key, (unsigned int)desc.AddressW);
+	AppendKey(key, desc.MipLODBias);
+	AppendKey(key, desc.MaxAnisotropy);
+	AppendKey(key, (unsigned int)desc.ComparisonFunc);
+	for (int i = 0; i < 4; i++)
+		AppendKey(key, desc.BorderColor[i]);
+	AppendKey(key, desc.MinLOD);
+	AppendKey(key, desc.MaxLOD);
+
+	auto found = samplerStates.find(key);
+	if (found != samplerStates.end())
+		return found->second;
+
+	ID3D11SamplerState* state = 0;
+	if (FAILED(device->CreateSamplerState(&desc, &state)))
+		return 0;
+
+	samplerStates[key] = state;
+	return state;
+}
+
+// --------------------------------------------------------
+// Gets the bundle for a set of shaders and states.  Since
+// the states themselves are already unique, the bundle is
+// keyed by their addresses.
+// --------------------------------------------------------
+const PipelineState* PipelineStateCache::GetPipelineState(
+	SimpleVertexShader* vertexShader,
+	SimplePixelShader* pixelShader,
+	ID3D11RasterizerState* rasterizerState,
+	ID3D11BlendState* blendState,
+	ID3D11DepthStencilState* depthStencilState)
+{
+	std::string key;
+	AppendKey(key, vertexShader);
+	AppendKey(key, pixelShader);
+	AppendKey(key, rasterizerState);
+	AppendKey(key, blendState);
+	AppendKey(key, depthStencilState);
+
+	auto found = pipelineStates.find(key);
+	if (found != pipelineStates.end())
+		return found->second;
+
+	PipelineState* state = new PipelineState();
+	state->VertexShader = vertexShader;
+	state->PixelShader = pixelShader;
+	state->RasterizerState = rasterizerState;
+	state->BlendState = blendState;
+	state->DepthStencilState = depthStencilState;
+
+	pipelineStates[key] = state;
+	return state;
+}
+
+// --------------------------------------------------------
+// The same values DirectX uses when no state is bound
+// --------------------------------------------------------
+D3D11_RASTERIZER_DESC PipelineStateCache::DefaultRasterizerDesc()
+{
+	D3D11_RASTERIZER_DESC desc = {};
+	desc.FillMode = D3D11_FILL_SOLID;
+	desc.CullMode = D3D11_CULL_BACK;
+	desc.DepthClipEnable = true;
+	return desc;
+}
+
+D3D11_BLEND_DESC PipelineStateCache::DefaultBlendDesc()
+{
+	D3D11_BLEND_DESC desc = {};
+	for (int i = 0; i < 8; i++)
+	{
+		desc.RenderTarget[i].SrcBlend = D3D11_BLEND_ONE;
+		desc.RenderTarget[i].DestBlend = D3D11_BLEND_ZERO;
+		desc.RenderTarget[i].BlendOp = D3D11_BLEND_OP_ADD;
+		desc.RenderTarget[i].SrcBlendAlpha = D3D11_BLEND_ONE;
+		desc.RenderTarget[i].DestBlendAlpha = D3D11_BLEND_ZERO;
+		desc.RenderTarget[i].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+		desc.RenderTarget[i].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+	}
+	return desc;
+}
+
+D3D11_DEPTH_STENCIL_DESC PipelineStateCache::DefaultDepthStencilDesc()
+{
+	D3D11_DEPTH_STENCILOP_DESC op = {};
+	op.StencilFailOp = D3D11_STENCIL_OP_KEEP;
+	op.StencilDepthFailOp = D3D11_STENCIL_OP_KEEP;
+	op.StencilPassOp = D3D11_STENCIL_OP_KEEP;
+	op.StencilFunc = D3D11_COMPARISON_ALWAYS;
+
+	D3D11_DEPTH_STENCIL_DESC desc = {};
+	desc.DepthEnable = true;
+	desc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
+	desc.DepthFunc = D3D11_COMPARISON_LESS;
+	desc.StencilReadMask = D3D11_DEFAULT_STENCIL_READ_MASK;
+	desc.StencilWriteMask = D3D11_DEFAULT_STENCIL_WRITE_MASK;
+	desc.FrontFace = op;
+	desc.BackFace = op;
+	return desc;
+}
+
+// --------------------------------------------------------
+// Binds a pipeline state in one call.  Each piece is only
+// sent to the context if it differs from what's bound, so
+// drawing many objects with one material costs nothing
+// after the first.
+//
+// A shader's constant buffers are bound along with it, and
+// CopyAllBufferData() updates them in place, so they don't
+// need rebinding while the same shader stays bound.
+// --------------------------------------------------------
+void PipelineStateCache::Bind(const PipelineState* state)
+{
+	if (state == boundState)
+		return;
+	boundState = state;
+
+	if (state->VertexShader != boundVertexShader)
+	{
+		// Sets the shader, input layout and constant buffers
+		state->VertexShader->SetShader();
+		boundVertexShader = state->VertexShader;
+	}
+
+	if (state->PixelShader != boundPixelShader || !pixelShaderKnown)
+	{
+		// No pixel shader at all for depth only passes
+		if (state->PixelShader)
+			state->PixelShader->SetShader();
+		else
+			context->PSSetShader(0, 0, 0);
+		boundPixelShader = state->PixelShader;
+		pixelShaderKnown = true;
+	}
+
+	if (state->RasterizerState != boundRasterizerState)
+	{
+		context->RSSetState(state->RasterizerState);
+		boundRasterizerState = state->RasterizerState;
+	}
+
+	if (state->BlendState != boundBlendState)
+	{
+		context->OMSetBlendState(state->BlendState, 0, 0xFFFFFFFF);
+		boundBlendState = state->BlendState;
+	}
+
+	if (state->DepthStencilState != boundDepthStencilState)
+	{
+		context->OMSetDepthStencilState(state->DepthStencilState, 0);
+		boundDepthStencilState = state->DepthStencilState;
+	}
+}
+
+// --------------------------------------------------------
+// Forgets what's bound, forcing the next Bind() to set
+// everything.  Use after anything else touches the context
+// (a SetShader() call outside the cache, a device reset...)
+// --------------------------------------------------------
+void PipelineStateCache::InvalidateBoundState()
+{
+	boundState = 0;
+	boundVertexShader = 0;
+	boundPixelShader = 0;
+	pixelShaderKnown = false;
+	boundRasterizerState = 0;
+	boundBlendState = 0;
+	boundDepthStencilState = 0;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <d3d11.h>
+#include <string>
+#include <unordered_map>
+
+class SimpleVertexShader;
+class SimplePixelShader;
+
+// --------------------------------------------------------
+// A bundle of everything a material needs bound before it
+// draws.  Bundles are immutable and shared: two materials
+// asking for the same shaders and states get the same one.
+// --------------------------------------------------------
+struct PipelineState
+{
+	SimpleVertexShader* VertexShader;
+	SimplePixelShader* PixelShader;			// Null for depth only passes
+	ID3D11RasterizerState* RasterizerState;
+	ID3D11BlendState* BlendState;
+	ID3D11DepthStencilState* DepthStencilState;
+};
+
+// --------------------------------------------------------
+// Owns every immutable state object in the game, hashed by
+// its description, so identical descriptions always map to
+// a single DirectX object:
+//  - Input layouts are keyed by their semantic signature
+//  - Rasterizer, blend, depth and sampler states are keyed
+//    by their full description
+//
+// It also tracks what is currently bound so that binding a
+// PipelineState skips anything already set on the context.
+//
+// Returned objects are owned by the cache - AddRef them if
+// you need to hold on to them past the cache's lifetime.
+// --------------------------------------------------------
+class PipelineStateCache
+{
+public:
+	PipelineStateCache(ID3D11Device* device, ID3D11DeviceContext* context);
+	~PipelineStateCache();
+
+	ID3D11InputLayout* GetInputLayout(const D3D11_INPUT_ELEMENT_DESC* elements, unsigned int elementCount, const void* shaderCode, size_t shaderCodeSize);
+	ID3D11RasterizerState* GetRasterizerState(const D3D11_RASTERIZER_DESC& desc);
+	ID3D11BlendState* GetBlendState(const D3D11_BLEND_DESC& desc);
+	ID3D11DepthStencilState* GetDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& desc);
+	ID3D11SamplerState* GetSamplerState(const D3D11_SAMPLER_DESC& desc);
+
+	// Gets the shared bundle for this combination of shaders and states
+	const PipelineState* GetPipelineState(
+		SimpleVertexShader* vertexShader,
+		SimplePixelShader* pixelShader,
+		ID3D11RasterizerState* rasterizerState,
+		ID3D11BlendState* blendState,
+		ID3D11DepthStencilState* depthStencilState);
+
+	// Default descriptions, matching DirectX's own defaults
+	static D3D11_RASTERIZER_DESC DefaultRasterizerDesc();
+	static D3D11_BLEND_DESC DefaultBlendDesc();
+	static D3D11_DEPTH_STENCIL_DESC DefaultDepthStencilDesc();
+
+	// Binds a bundle, skipping anything that's already bound
+	void Bind(const PipelineState* state);
+
+	// Call if something outside the cache changes pipeline state
+	void InvalidateBoundState();
+
+private:
+	ID3D11Device* device;
+	ID3D11DeviceContext* context;
+
+	// State objects, keyed by a byte string built from their descriptions
+	std::unordered_map<std::string, ID3D11InputLayout*> inputLayouts;
+	std::unordered_map<std::string, ID3D11RasterizerState*> rasterizerStates;
+	std::unordered_map<std::string, ID3D11BlendState*> blendStates;
+	std::unordered_map<std::string, ID3D11DepthStencilState*> depthStencilStates;
+	std::unordered_map<std::string, ID3D11SamplerState*> samplerStates;
+	std::unordered_map<std::string, PipelineState*> pipelineStates;
+
+	// What's currently bound on the context (for redundant state elision)
+	const PipelineState* boundState;
+	SimpleVertexShader* boundVertexShader;
+	SimplePixelShader* boundPixelShader;
+	bool pixelShaderKnown;				// Null is a real choice, not just "unknown"
+	ID3D11RasterizerState* boundRasterizerState;
+	ID3D11BlendState* boundBlendState;
+	ID3D11DepthStencilState* boundDepthStencilState;
+};
@@ -1,4 +1,16 @@
 
+// Permutation switches.  These defaults build the standard
+// textured, two light shader (PixelShader.cso); the
+// PixelShader_XX.hlsl files override them to build the
+// other variants (see ShaderVariants.h for the bit layout)
+#ifndef USE_TEXTURE
+#define USE_TEXTURE 1
+#endif
+
+#ifndef LIGHT_COUNT
+#define LIGHT_COUNT 2
+#endif
+
 // Struct representing the data we expect to receive from earlier pipeline stages
 // - Should match the output of our corresponding vertex shader
 // - The name of the struct itself is unimportant
@@ -14,6 +26,7 @@ struct VertexToPixel
 	float4 position		: SV_POSITION;
 	float3 normal       : NORMAL;
 	float2 uv           : TEXCOORD;
+	float occlusion     : OCCLUSION;	// Baked ambient occlusion (1 is open)
 	//float4 color		: COLOR;
 };
 
@@ -28,12 +41,46 @@ struct DirectionalLight
 // cbuffer for a directional light
 cbuffer externalData : register(b0)
 {
+#if LIGHT_COUNT > 0
 	DirectionalLight lightOne;
+#endif
+#if LIGHT_COUNT > 1
 	DirectionalLight lightTwo;
+#endif
+};
+
+#if LIGHT_COUNT > 0
+// Ambient light where the entity is, from the probe grid
+// (SHCoefficients in LightProbes.h)
+cbuffer probes : register(b1)
+{
+	float4 shCoefficients[9];
 };
 
+// --------------------------------------------------------
+// Diffuse ambient light for a normal.  The coefficients are
+// already convolved, so this is just the basis weighted sum
+// (same order as EvaluateSHBasis() in LightProbes.cpp).
+// --------------------------------------------------------
+float3 EvaluateSH(float3 n)
+{
+	float3 result = shCoefficients[0].rgb * 0.282095f;
+	result += shCoefficients[1].rgb * 0.488603f * n.y;
+	result += shCoefficients[2].rgb * 0.488603f * n.z;
+	result += shCoefficients[3].rgb * 0.488603f * n.x;
+	result += shCoefficients[4].rgb * 1.092548f * n.x * n.y;
+	result += shCoefficients[5].rgb * 1.092548f * n.y * n.z;
+	result += shCoefficients[6].rgb * 0.315392f * (3.0f * n.z * n.z - 1.0f);
+	result += shCoefficients[7].rgb * 1.092548f * n.x * n.z;
+	result += shCoefficients[8].rgb * 0.546274f * (n.x * n.x - n.y * n.y);
+	return max(result, 0.0f);
+}
+#endif
+
+#if USE_TEXTURE
 Texture2D diffuseTexture : register(t0);
 SamplerState samp : register (s0);
+#endif
 
 // --------------------------------------------------------
 // The entry point (main method) for our pixel shader
@@ -48,23 +95,39 @@ float4 main(VertexToPixel input) : SV_TARGET
 {
 
 	// Sample a texture for the colors on that texture
+#if USE_TEXTURE
 	float4 surfaceColor = diffuseTexture.Sample(samp, input.uv);
+#else
+	float4 surfaceColor = float4(1, 1, 1, 1);
+#endif
 
-
+#if LIGHT_COUNT == 0
+	// Unlit variant
+	return surfaceColor;
+#else
 	// Calculate the lights effects in the scene
 
 	// Normnalize all incoming pixel data, just in case.
 	input.normal = normalize(input.normal);
 
-	// Reverse the direction of light direction
-	float3 lightOneReverseNormal = normalize(mul(lightOne.Direction , -1.0f));
-	float3 lightTwoReverseNormal = normalize(mul(lightTwo.Direction, -1.0f));
-
-	// Calculate the amount of light on a single pixel by taking the between direction to the light and the normal of a pixel.
+	// Reverse the direction of light direction, then calculate the amount of light on a single pixel
+	// by taking the between direction to the light and the normal of a pixel.
 	// This yields the angle between the two.
+	float3 lightOneReverseNormal = normalize(mul(lightOne.Direction , -1.0f));
 	float amountLightOne = saturate(dot(input.normal, lightOneReverseNormal));
+	float4 totalColor = surfaceColor * amountLightOne;
+
+	// Ambient light from the probes, minus however much the
+	// mesh blocks itself
+	totalColor.rgb += surfaceColor.rgb * EvaluateSH(input.normal) * input.occlusion;
+
+#if LIGHT_COUNT > 1
+	float3 lightTwoReverseNormal = normalize(mul(lightTwo.Direction, -1.0f));
 	float amountLightTwo = saturate(dot(input.normal, lightTwoReverseNormal));
+	totalColor += surfaceColor * amountLightTwo;
+#endif
 
 	// Add all lights together and return the color.
-	return (surfaceColor * amountLightOne) + (surfaceColor * amountLightTwo);
-}
\ No newline at end of file
+	return totalColor;
+#endif
+}
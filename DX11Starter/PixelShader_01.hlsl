@@ -0,0 +1,4 @@
+// Permutation 0x01 - textured, unlit
+#define USE_TEXTURE 1
+#define LIGHT_COUNT 0
+#include "PixelShader.hlsl"
@@ -0,0 +1,4 @@
+// Permutation 0x09 - textured, one directional light
+#define USE_TEXTURE 1
+#define LIGHT_COUNT 1
+#include "PixelShader.hlsl"
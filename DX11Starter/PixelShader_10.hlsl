@@ -0,0 +1,4 @@
+// Permutation 0x10 - untextured, two directional lights
+#define USE_TEXTURE 0
+#define LIGHT_COUNT 2
+#include "PixelShader.hlsl"
@@ -0,0 +1,26 @@
+// Same as DepthPrepassVertexShader.hlsl, but for the
+// QuantizedPositionVertex stream.  Must match the position
+// math in QuantizedVertexShader.hlsl exactly.
+cbuffer externalData : register(b0)
+{
+	matrix worldViewProj;
+};
+
+// The mesh's bounds (from QuantizationInfo)
+cbuffer quantization : register(b1)
+{
+	float3 positionCenter;
+	float3 positionExtent;
+};
+
+struct VertexShaderInput
+{
+	float4 position		: POSITION;     // R16G16B16A16_SNORM, relative to bounds
+};
+
+float4 main( VertexShaderInput input ) : SV_POSITION
+{
+	precise float3 modelPosition = input.position.xyz * positionExtent + positionCenter;
+	precise float4 position = mul(float4(modelPosition, 1.0f), worldViewProj);
+	return position;
+}
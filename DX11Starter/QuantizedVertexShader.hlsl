@@ -0,0 +1,62 @@
+// Same as VertexShader.hlsl, but for QuantizedVertex data
+// (see VertexQuantization.h).  The packed formats are all
+// unpacked to floats by the input assembler, so only the
+// position bounds and the normal's octahedral mapping need
+// undoing here.
+cbuffer externalData : register(b0)
+{
+	matrix world;
+	matrix worldViewProj;		// world * view * projection, from the CPU
+};
+
+// The mesh's bounds (from QuantizationInfo)
+cbuffer quantization : register(b1)
+{
+	float3 positionCenter;
+	float3 positionExtent;
+};
+
+struct VertexShaderInput
+{
+	float4 position		: POSITION;     // R16G16B16A16_SNORM, relative to bounds
+	float2 normal       : NORMAL;       // R16G16_SNORM, octahedral
+	float2 uv           : TEXCOORD;     // R16G16_FLOAT
+	float occlusion     : OCCLUSION;    // R8_UNORM, slot 1
+};
+
+// Matches VertexShader.hlsl, so the same pixel shaders work
+struct VertexToPixel
+{
+	float4 position		: SV_POSITION;
+	float3 normal       : NORMAL;
+	float2 uv           : TEXCOORD;
+	float occlusion     : OCCLUSION;
+};
+
+// --------------------------------------------------------
+// Inverse of EncodeOctahedral() in VertexQuantization.cpp
+// --------------------------------------------------------
+float3 DecodeOctahedral(float2 e)
+{
+	float3 n = float3(e, 1.0f - abs(e.x) - abs(e.y));
+	float t = saturate(-n.z);
+	n.xy += n.xy >= 0.0f ? -t : t;
+	return normalize(n);
+}
+
+VertexToPixel main( VertexShaderInput input )
+{
+	VertexToPixel output;
+
+	// Precise, so it matches QuantizedDepthPrepassVertexShader.hlsl bit
+	// for bit when drawing over a depth prepass
+	precise float3 position = input.position.xyz * positionExtent + positionCenter;
+	precise float4 clipPosition = mul(float4(position, 1.0f), worldViewProj);
+	output.position = clipPosition;
+
+	output.normal = mul(DecodeOctahedral(input.normal), (float3x3)world);
+	output.uv = input.uv;
+	output.occlusion = input.occlusion;
+
+	return output;
+}
@@ -0,0 +1,120 @@
+#include "RangeAllocator.h"
+
+// --------------------------------------------------------
+// Constructor - Everything starts out free
+// --------------------------------------------------------
+RangeAllocator::RangeAllocator(unsigned int size)
+{
+	this->size = size;
+	if (size > 0)
+	{
+		FreeRange all = { 0, size };
+		freeRanges.push_back(all);
+	}
+}
+
+// --------------------------------------------------------
+// Best fit: takes the smallest free range that's big enough
+// (an exact fit ends the search early), splitting off the
+// front of it
+// --------------------------------------------------------
+bool RangeAllocator::Allocate(unsigned int count, unsigned int* offset)
+{
+	if (count == 0)
+		return false;
+
+	int best = -1;
+	for (unsigned int i = 0; i < freeRanges.size(); i++)
+	{
+		if (freeRanges[i].Count < count)
+			continue;
+
+		if (best < 0 || freeRanges[i].Count < freeRanges[best].Count)
+		{
+			best = i;
+			if (freeRanges[i].Count == count)
+				break;
+		}
+	}
+
+	if (best < 0)
+		return false;
+
+	*offset = freeRanges[best].Offset;
+	freeRanges[best].Offset += count;
+	freeRanges[best].Count -= count;
+	if (freeRanges[best].Count == 0)
+		freeRanges.erase(freeRanges.begin() + best);
+
+	return true;
+}
+
+// --------------------------------------------------------
+// Returns a range, merging it with the free ranges on
+// either side where they touch
+// --------------------------------------------------------
+void RangeAllocator::Free(unsigned int offset, unsigned int count)
+{
+	if (count == 0)
+		return;
+
+	// Find the first free range after this one
+	unsigned int next = 0;
+	while (next < freeRanges.size() && freeRanges[next].Offset < offset)
+		next++;
+
+	bool joinsPrevious = next > 0 && freeRanges[next - 1].Offset + freeRanges[next - 1].Count == offset;
+	bool joinsNext = next < freeRanges.size() && offset + count == freeRanges[next].Offset;
+
+	if (joinsPrevious && joinsNext)
+	{
+		freeRanges[next - 1].Count += count + freeRanges[next].Count;
+		freeRanges.erase(freeRanges.begin() + next);
+	}
+	else if (joinsPrevious)
+	{
+		freeRanges[next - 1].Count += count;
+	}
+	else if (joinsNext)
+	{
+		freeRanges[next].Offset = offset;
+		freeRanges[next].Count += count;
+	}
+	else
+	{
+		FreeRange range = { offset, count };
+		freeRanges.insert(freeRanges.begin() + next, range);
+	}
+}
+
+// --------------------------------------------------------
+// The new space at the end is just one more free range
+// --------------------------------------------------------
+void RangeAllocator::Grow(unsigned int newSize)
+{
+	if (newSize <= size)
+		return;
+
+	unsigned int oldSize = size;
+	size = newSize;
+	Free(oldSize, newSize - oldSize);
+}
+
+unsigned int RangeAllocator::GetFreeTotal()
+{
+	unsigned int total = 0;
+	for (unsigned int i = 0; i < freeRanges.size(); i++)
+		total += freeRanges[i].Count;
+	return total;
+}
+
+unsigned int RangeAllocator::GetLargestFree()
+{
+	unsigned int largest = 0;
+	for (unsigned int i = 0; i < freeRanges.size(); i++)
+	{
+		if (freeRanges[i].Count > largest)
+			largest = freeRanges[i].Count;
+	}
+	return largest;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+
+// --------------------------------------------------------
+// Free-list suballocator for a linear range of elements.
+//
+// Free space is kept as a list of ranges sorted by offset.
+// Allocation takes the best (smallest) fitting range, and
+// freeing merges a range with its neighbours, so the free
+// list stays short and fragmentation stays low.
+//
+// Knows nothing about DirectX, so it can be used (and
+// tested) on its own.
+// --------------------------------------------------------
+class RangeAllocator
+{
+public:
+	RangeAllocator(unsigned int size);
+
+	// Returns false if no free range is big enough
+	bool Allocate(unsigned int count, unsigned int* offset);
+	void Free(unsigned int offset, unsigned int count);
+
+	// Extends the managed range to newSize elements
+	void Grow(unsigned int newSize);
+
+	unsigned int GetSize() { return size; }
+	unsigned int GetFreeTotal();
+	unsigned int GetLargestFree();
+	unsigned int GetFreeRangeCount() { return (unsigned int)freeRanges.size(); }
+
+private:
+	struct FreeRange
+	{
+		unsigned int Offset;
+		unsigned int Count;
+	};
+
+	std::vector<FreeRange> freeRanges;	// Sorted by offset
+	unsigned int size;
+};
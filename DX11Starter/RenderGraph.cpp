@@ -0,0 +1,177 @@
+#include "RenderGraph.h"
+#include <cstdio>
+
+RenderGraph::RenderGraph(ID3D11Device* device)
+{
+	this->device = device;
+}
+
+RenderGraph::~RenderGraph()
+{
+	for (unsigned int i = 0; i < pool.size(); i++)
+		ReleaseTexture(pool[i]);
+}
+
+void RenderGraph::Reset()
+{
+	compiler.Reset();
+	executes.clear();
+	views.clear();
+}
+
+unsigned int RenderGraph::AddTexture(const char* name, const RenderTextureDesc& desc)
+{
+	TextureViews none = {};
+	views.push_back(none);
+	return compiler.AddTexture(name, desc);
+}
+
+// --------------------------------------------------------
+// The graph doesn't hold a reference to imported views -
+// they only need to outlive this frame's Execute()
+// --------------------------------------------------------
+unsigned int RenderGraph::ImportTexture(const char* name, ID3D11RenderTargetView* rtv, ID3D11ShaderResourceView* srv, ID3D11DepthStencilView* dsv)
+{
+	TextureViews imported = { rtv, srv, dsv };
+	views.push_back(imported);
+	return compiler.ImportTexture(name);
+}
+
+// --------------------------------------------------------
+// A graph that fails to compile will fail the same way every
+// frame, so each new error is only reported once
+// --------------------------------------------------------
+bool RenderGraph::Execute()
+{
+	if (!compiler.Compile())
+	{
+		if (compiler.GetError() != lastError)
+		{
+			lastError = compiler.GetError();
+			printf("Render graph: %s\n", lastError.c_str());
+		}
+		return false;
+	}
+	lastError.clear();
+
+	if (!AllocateTextures())
+		return false;
+
+	const std::vector<unsigned int>& schedule = compiler.GetSchedule();
+	for (unsigned int s = 0; s < schedule.size(); s++)
+		executes[schedule[s]].Run(executes[schedule[s]].Closure);
+
+	return true;
+}
+
+// --------------------------------------------------------
+// Gives each physical texture a pooled one with the same
+// description (creating it if there are none spare), then
+// retires whatever has sat unused for too long
+// --------------------------------------------------------
+bool RenderGraph::AllocateTextures()
+{
+	for (unsigned int i = 0; i < pool.size(); i++)
+		pool[i].InUse = false;
+
+	physicalToPool.resize(compiler.GetPhysicalTextureCount());
+	for (unsigned int p = 0; p < physicalToPool.size(); p++)
+	{
+		const RenderTextureDesc& desc = compiler.GetPhysicalDesc(p);
+
+		unsigned int found = pool.size();
+		for (unsigned int i = 0; i < pool.size(); i++)
+		{
+			if (!pool[i].InUse && pool[i].Desc == desc)
+			{
+				found = i;
+				break;
+			}
+		}
+
+		if (found == pool.size())
+		{
+			PooledTexture pooled;
+			if (!CreateTexture(desc, &pooled))
+			{
+				printf("Render graph: couldn't create a %ux%u texture\n", desc.Width, desc.Height);
+				return false;
+			}
+			pool.push_back(pooled);
+		}
+
+		pool[found].InUse = true;
+		physicalToPool[p] = found;
+	}
+
+	for (unsigned int t = 0; t < views.size(); t++)
+	{
+		unsigned int physical = compiler.GetPhysicalTexture(t);
+		if (!compiler.IsImported(t) && physical != RenderGraphCompiler::Unused)
+			views[t] = pool[physicalToPool[physical]].Views;
+	}
+
+	for (unsigned int i = 0; i < pool.size();)
+	{
+		pool[i].IdleFrames = pool[i].InUse ? 0 : pool[i].IdleFrames + 1;
+		if (pool[i].IdleFrames > RetireFrames)
+		{
+			ReleaseTexture(pool[i]);
+			pool[i] = pool.back();
+			pool.pop_back();
+		}
+		else
+		{
+			i++;
+		}
+	}
+
+	return true;
+}
+
+// --------------------------------------------------------
+// One view of each kind the bind flags ask for
+// --------------------------------------------------------
+bool RenderGraph::CreateTexture(const RenderTextureDesc& desc, PooledTexture* pooled)
+{
+	pooled->Desc = desc;
+	pooled->Texture = 0;
+	pooled->Views.RTV = 0;
+	pooled->Views.SRV = 0;
+	pooled->Views.DSV = 0;
+	pooled->IdleFrames = 0;
+	pooled->InUse = false;
+
+	D3D11_TEXTURE2D_DESC textureDesc = {};
+	textureDesc.Width = desc.Width;
+	textureDesc.Height = desc.Height;
+	textureDesc.MipLevels = 1;
+	textureDesc.ArraySize = 1;
+	textureDesc.Format = (DXGI_FORMAT)desc.Format;
+	textureDesc.Usage = D3D11_USAGE_DEFAULT;
+	textureDesc.BindFlags = desc.BindFlags;
+	textureDesc.SampleDesc.Count = 1;
+
+	if (FAILED(device->CreateTexture2D(&textureDesc, 0, &pooled->Texture)))
+		return false;
+
+	bool created = true;
+	if (desc.BindFlags & D3D11_BIND_RENDER_TARGET)
+		created &= SUCCEEDED(device->CreateRenderTargetView(pooled->Texture, 0, &pooled->Views.RTV));
+	if (desc.BindFlags & D3D11_BIND_SHADER_RESOURCE)
+		created &= SUCCEEDED(device->CreateShaderResourceView(pooled->Texture, 0, &pooled->Views.SRV));
+	if (desc.BindFlags & D3D11_BIND_DEPTH_STENCIL)
+		created &= SUCCEEDED(device->CreateDepthStencilView(pooled->Texture, 0, &pooled->Views.DSV));
+
+	if (!created)
+		ReleaseTexture(*pooled);
+	return created;
+}
+
+void RenderGraph::ReleaseTexture(PooledTexture& pooled)
+{
+	if (pooled.Views.RTV) { pooled.Views.RTV->Release(); pooled.Views.RTV = 0; }
+	if (pooled.Views.SRV) { pooled.Views.SRV->Release(); pooled.Views.SRV = 0; }
+	if (pooled.Views.DSV) { pooled.Views.DSV->Release(); pooled.Views.DSV = 0; }
+	if (pooled.Texture) { pooled.Texture->Release(); pooled.Texture = 0; }
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <d3d11.h>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "FrameArena.h"
+#include "RenderGraphCompiler.h"
+
+// --------------------------------------------------------
+// A frame described as passes, each declaring the textures
+// it reads and writes, instead of hand managed targets.
+//
+// Each frame: Reset(), add textures and passes, Execute().
+// Execute() compiles the graph (see RenderGraphCompiler),
+// finds a real texture for each physical one, then runs
+// the scheduled passes in order.  While a pass runs it
+// gets its views from GetRTV() / GetSRV() / GetDSV().
+//
+// Real textures are pooled across frames by description,
+// and released once they've gone unused for a few frames
+// (after a resize, say), so a steady frame allocates
+// nothing.  Depth textures are depth only - they can't
+// also be read as shader resources.
+//
+// The graph itself doesn't allocate in a steady frame
+// either: names are literals, its containers keep their
+// memory across Reset(), and pass lambdas are copied into
+// the thread's FrameArena rather than a std::function.
+// --------------------------------------------------------
+class RenderGraph
+{
+public:
+	RenderGraph(ID3D11Device* device);
+	~RenderGraph();
+
+	// Starts describing a new frame
+	void Reset();
+
+	unsigned int AddTexture(const char* name, const RenderTextureDesc& desc);
+	unsigned int ImportTexture(const char* name, ID3D11RenderTargetView* rtv, ID3D11ShaderResourceView* srv, ID3D11DepthStencilView* dsv);
+
+	// The lambda is copied into this frame's arena, which never
+	// runs destructors, so it can only capture references and
+	// plain values
+	template <typename Execute> unsigned int AddPass(const char* name, const Execute& execute)
+	{
+		static_assert(std::is_trivially_destructible<Execute>::value, "Render graph passes can't capture anything that needs destroying");
+
+		void* memory = FrameArena::GetThreadArena()->Allocate(sizeof(Execute), alignof(Execute));
+		PassExecute pass = { &RunPass<Execute>, new (memory) Execute(execute) };
+		executes.push_back(pass);
+		return compiler.AddPass(name);
+	}
+
+	void Read(unsigned int pass, unsigned int texture) { compiler.Read(pass, texture); }
+	void Write(unsigned int pass, unsigned int texture) { compiler.Write(pass, texture); }
+
+	// Returns false (running nothing) if the graph doesn't compile
+	// or a texture couldn't be created
+	bool Execute();
+
+	// Views of a texture, for the pass that's running
+	ID3D11RenderTargetView* GetRTV(unsigned int texture) { return views[texture].RTV; }
+	ID3D11ShaderResourceView* GetSRV(unsigned int texture) { return views[texture].SRV; }
+	ID3D11DepthStencilView* GetDSV(unsigned int texture) { return views[texture].DSV; }
+
+	RenderGraphCompiler& GetCompiler() { return compiler; }
+
+	// Real textures currently held, in use or not
+	unsigned int GetAllocatedTextureCount() { return pool.size(); }
+
+private:
+	// A pass's lambda, and how to call it without knowing its type
+	struct PassExecute
+	{
+		void (*Run)(void* closure);
+		void* Closure;
+	};
+
+	template <typename Execute> static void RunPass(void* closure)
+	{
+		(*(Execute*)closure)();
+	}
+
+	struct TextureViews
+	{
+		ID3D11RenderTargetView* RTV;
+		ID3D11ShaderResourceView* SRV;
+		ID3D11DepthStencilView* DSV;
+	};
+
+	struct PooledTexture
+	{
+		RenderTextureDesc Desc;
+		ID3D11Texture2D* Texture;
+		TextureViews Views;
+		unsigned int IdleFrames;
+		bool InUse;
+	};
+
+	// How long an unused texture is kept around for
+	static const unsigned int RetireFrames = 3;
+
+	ID3D11Device* device;
+	RenderGraphCompiler compiler;
+
+	std::vector<PassExecute> executes;		// One per pass
+	std::vector<TextureViews> views;		// One per texture
+	std::vector<PooledTexture> pool;
+	std::vector<unsigned int> physicalToPool;
+	std::string lastError;
+
+	bool AllocateTextures();
+	bool CreateTexture(const RenderTextureDesc& desc, PooledTexture* pooled);
+	void ReleaseTexture(PooledTexture& pooled);
+};
@@ -0,0 +1,356 @@
+#include "RenderGraphCompiler.h"
+#include <algorithm>
+#include <functional>
+
+RenderGraphCompiler::RenderGraphCompiler()
+{
+	passCount = 0;
+	textureCount = 0;
+}
+
+void RenderGraphCompiler::Reset()
+{
+	passCount = 0;
+	textureCount = 0;
+	schedule.clear();
+	physicalDescs.clear();
+	error.clear();
+}
+
+unsigned int RenderGraphCompiler::AddTexture(const char* name, const RenderTextureDesc& desc)
+{
+	if (textureCount == textures.size())
+		textures.push_back(Texture());
+
+	Texture& texture = textures[textureCount];
+	texture.Name = name;
+	texture.Desc = desc;
+	texture.Imported = false;
+	texture.Writers.clear();
+	texture.FirstUse = Unused;
+	texture.LastUse = Unused;
+	texture.Physical = Unused;
+	return textureCount++;
+}
+
+unsigned int RenderGraphCompiler::ImportTexture(const char* name)
+{
+	RenderTextureDesc none = {};
+	unsigned int texture = AddTexture(name, none);
+	textures[texture].Imported = true;
+	return texture;
+}
+
+unsigned int RenderGraphCompiler::AddPass(const char* name)
+{
+	if (passCount == passes.size())
+		passes.push_back(Pass());
+
+	Pass& pass = passes[passCount];
+	pass.Name = name;
+	pass.Reads.clear();
+	pass.Writes.clear();
+	pass.Position = Unused;
+	return passCount++;
+}
+
+void RenderGraphCompiler::Read(unsigned int pass, unsigned int texture)
+{
+	passes[pass].Reads.push_back(texture);
+}
+
+void RenderGraphCompiler::Write(unsigned int pass, unsigned int texture)
+{
+	passes[pass].Writes.push_back(texture);
+	textures[texture].Writers.push_back(pass);
+}
+
+bool RenderGraphCompiler::Writes(unsigned int pass, unsigned int texture)
+{
+	const std::vector<unsigned int>& writes = passes[pass].Writes;
+	return std::find(writes.begin(), writes.end(), texture) != writes.end();
+}
+
+// --------------------------------------------------------
+// Throws out the results of any earlier compile, checks
+// every read has something to read, then works out the
+// rest in stages
+// --------------------------------------------------------
+bool RenderGraphCompiler::Compile()
+{
+	schedule.clear();
+	physicalDescs.clear();
+	error.clear();
+	for (unsigned int p = 0; p < passCount; p++)
+		passes[p].Position = Unused;
+	for (unsigned int t = 0; t < textureCount; t++)
+	{
+		textures[t].FirstUse = Unused;
+		textures[t].LastUse = Unused;
+		textures[t].Physical = Unused;
+	}
+
+	for (unsigned int p = 0; p < passCount; p++)
+	{
+		for (unsigned int r = 0; r < passes[p].Reads.size(); r++)
+		{
+			const Texture& texture = textures[passes[p].Reads[r]];
+			if (!texture.Imported && texture.Writers.empty())
+			{
+				error = std::string(passes[p].Name) + " reads " + texture.Name + ", which nothing writes";
+				return false;
+			}
+		}
+	}
+
+	CullPasses();
+	if (!SortPasses())
+		return false;
+
+	FindLifetimes();
+	AssignPhysicalTextures();
+	return true;
+}
+
+// --------------------------------------------------------
+// Works backwards from the imported textures.  A live pass
+// needs whatever wrote the textures it reads, and whatever
+// wrote its own outputs before it (which it builds on).
+// --------------------------------------------------------
+void RenderGraphCompiler::CullPasses()
+{
+	live.assign(passCount, false);
+	pending.clear();
+
+	for (unsigned int t = 0; t < textureCount; t++)
+	{
+		if (!textures[t].Imported)
+			continue;
+		for (unsigned int w = 0; w < textures[t].Writers.size(); w++)
+			pending.push_back(textures[t].Writers[w]);
+	}
+
+	while (!pending.empty())
+	{
+		unsigned int p = pending.back();
+		pending.pop_back();
+		if (live[p])
+			continue;
+		live[p] = true;
+
+		for (unsigned int r = 0; r < passes[p].Reads.size(); r++)
+		{
+			const std::vector<unsigned int>& writers = textures[passes[p].Reads[r]].Writers;
+			pending.insert(pending.end(), writers.begin(), writers.end());
+		}
+
+		for (unsigned int w = 0; w < passes[p].Writes.size(); w++)
+		{
+			const std::vector<unsigned int>& writers = textures[passes[p].Writes[w]].Writers;
+			for (unsigned int i = 0; i < writers.size() && writers[i] != p; i++)
+				pending.push_back(writers[i]);
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Topological sort (Kahn's algorithm) of the live passes,
+// always taking the earliest added pass that's ready, so a
+// graph built in a sensible order runs in that order.
+//
+// Each texture's writers form a chain, and every pass that
+// only reads it waits for the end of the chain.
+// --------------------------------------------------------
+bool RenderGraphCompiler::SortPasses()
+{
+	if (next.size() < passCount)
+		next.resize(passCount);
+	for (unsigned int p = 0; p < passCount; p++)
+		next[p].clear();
+	waitingOn.assign(passCount, 0);
+	unsigned int liveCount = 0;
+
+	for (unsigned int p = 0; p < passCount; p++)
+	{
+		if (live[p])
+			liveCount++;
+	}
+
+	for (unsigned int t = 0; t < textureCount; t++)
+	{
+		// Only live writers matter - culled ones never run
+		liveWriters.clear();
+		for (unsigned int w = 0; w < textures[t].Writers.size(); w++)
+		{
+			if (live[textures[t].Writers[w]])
+				liveWriters.push_back(textures[t].Writers[w]);
+		}
+		if (liveWriters.empty())
+			continue;
+
+		for (unsigned int w = 1; w < liveWriters.size(); w++)
+		{
+			next[liveWriters[w - 1]].push_back(liveWriters[w]);
+			waitingOn[liveWriters[w]]++;
+		}
+
+		for (unsigned int p = 0; p < passCount; p++)
+		{
+			if (!live[p] || Writes(p, t))
+				continue;
+
+			const std::vector<unsigned int>& reads = passes[p].Reads;
+			if (std::find(reads.begin(), reads.end(), t) != reads.end())
+			{
+				next[liveWriters.back()].push_back(p);
+				waitingOn[p]++;
+			}
+		}
+	}
+
+	// Passes are added to the heap in index order, which is
+	// already a valid min-heap
+	ready.clear();
+	for (unsigned int p = 0; p < passCount; p++)
+	{
+		if (live[p] && waitingOn[p] == 0)
+			ready.push_back(p);
+	}
+
+	while (!ready.empty())
+	{
+		std::pop_heap(ready.begin(), ready.end(), std::greater<unsigned int>());
+		unsigned int p = ready.back();
+		ready.pop_back();
+		passes[p].Position = schedule.size();
+		schedule.push_back(p);
+
+		for (unsigned int n = 0; n < next[p].size(); n++)
+		{
+			if (--waitingOn[next[p][n]] == 0)
+			{
+				ready.push_back(next[p][n]);
+				std::push_heap(ready.begin(), ready.end(), std::greater<unsigned int>());
+			}
+		}
+	}
+
+	if (schedule.size() == liveCount)
+		return true;
+
+	// Whatever never became ready is in a cycle, or waiting on
+	// one.  Peeling off the stuck passes nothing stuck waits on
+	// (working back from the end) leaves just the cycle.
+	for (unsigned int p = 0; p < passCount; p++)
+	{
+		waitingOn[p] = 0;
+		live[p] = live[p] && passes[p].Position == Unused;
+	}
+	for (unsigned int p = 0; p < passCount; p++)
+	{
+		for (unsigned int n = 0; live[p] && n < next[p].size(); n++)
+		{
+			if (live[next[p][n]])
+				waitingOn[p]++;
+		}
+	}
+
+	pending.clear();
+	for (unsigned int p = 0; p < passCount; p++)
+	{
+		if (live[p] && waitingOn[p] == 0)
+			pending.push_back(p);
+	}
+	while (!pending.empty())
+	{
+		unsigned int p = pending.back();
+		pending.pop_back();
+		live[p] = false;
+		for (unsigned int q = 0; q < passCount; q++)
+		{
+			for (unsigned int n = 0; live[q] && n < next[q].size(); n++)
+			{
+				if (next[q][n] == p && --waitingOn[q] == 0)
+					pending.push_back(q);
+			}
+		}
+	}
+
+	error = "Passes depend on each other in a cycle:";
+	for (unsigned int p = 0; p < passCount; p++)
+	{
+		if (live[p])
+			error += std::string(" ") + passes[p].Name;
+	}
+	return false;
+}
+
+void RenderGraphCompiler::FindLifetimes()
+{
+	for (unsigned int s = 0; s < schedule.size(); s++)
+	{
+		const Pass& pass = passes[schedule[s]];
+		const std::vector<unsigned int>* uses[] = { &pass.Reads, &pass.Writes };
+		for (unsigned int u = 0; u < 2; u++)
+		{
+			for (unsigned int i = 0; i < uses[u]->size(); i++)
+			{
+				Texture& texture = textures[(*uses[u])[i]];
+				if (texture.FirstUse == Unused)
+					texture.FirstUse = s;
+				texture.LastUse = s;
+			}
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Interval packing: in order of first use, each transient
+// texture takes over a matching physical texture whose last
+// user has already run, or gets a new one.  Taking the one
+// freed longest ago leaves the recently freed ones for
+// textures that start later.
+// --------------------------------------------------------
+void RenderGraphCompiler::AssignPhysicalTextures()
+{
+	order.clear();
+	for (unsigned int t = 0; t < textureCount; t++)
+	{
+		if (!textures[t].Imported && textures[t].FirstUse != Unused)
+			order.push_back(t);
+	}
+
+	// Ties go by index, which keeps the result stable without
+	// stable_sort's temporary buffer
+	std::sort(order.begin(), order.end(), [this](unsigned int a, unsigned int b)
+	{
+		if (textures[a].FirstUse != textures[b].FirstUse)
+			return textures[a].FirstUse < textures[b].FirstUse;
+		return a < b;
+	});
+
+	physicalLastUse.clear();
+	for (unsigned int i = 0; i < order.size(); i++)
+	{
+		Texture& texture = textures[order[i]];
+
+		unsigned int best = Unused;
+		for (unsigned int p = 0; p < physicalDescs.size(); p++)
+		{
+			if (!(physicalDescs[p] == texture.Desc) || physicalLastUse[p] >= texture.FirstUse)
+				continue;
+			if (best == Unused || physicalLastUse[p] < physicalLastUse[best])
+				best = p;
+		}
+
+		if (best == Unused)
+		{
+			best = physicalDescs.size();
+			physicalDescs.push_back(texture.Desc);
+			physicalLastUse.push_back(0);
+		}
+
+		texture.Physical = best;
+		physicalLastUse[best] = texture.LastUse;
+	}
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// --------------------------------------------------------
+// What a transient texture needs to be.  Format and bind
+// flags are DXGI_FORMAT and D3D11_BIND_FLAG values, kept as
+// plain integers so the compiler doesn't need DirectX.
+// Two textures can only share memory if these all match.
+// --------------------------------------------------------
+struct RenderTextureDesc
+{
+	unsigned int Width;
+	unsigned int Height;
+	unsigned int Format;
+	unsigned int BindFlags;
+};
+
+inline bool operator==(const RenderTextureDesc& a, const RenderTextureDesc& b)
+{
+	return a.Width == b.Width && a.Height == b.Height && a.Format == b.Format && a.BindFlags == b.BindFlags;
+}
+
+// --------------------------------------------------------
+// Turns a frame's passes, and the textures each one reads
+// and writes, into something that can run:
+//  - An order: every pass writing a texture runs before
+//    every pass that only reads it, and passes writing the
+//    same texture run in the order they were added.  Ties
+//    also go by the order added.
+//  - Culling: only passes that contribute to an imported
+//    texture (the back buffer, say) are kept.
+//  - Lifetimes: the first and last scheduled pass to touch
+//    each transient texture.
+//  - Aliasing: transient textures whose lifetimes don't
+//    overlap share one physical texture, if their
+//    descriptions match.
+//
+// Knows nothing about DirectX (see RenderGraph for that),
+// so it can be used (and tested) on its own.
+//
+// The graph is rebuilt every frame, so nothing in here
+// allocates once it's seen a frame's worth of passes:
+// Reset() keeps every container's memory, names are
+// pointers to strings that outlive the frame (literals),
+// and compiling works in member scratch space.
+//
+// Anything aliased starts out holding whatever was in the
+// physical texture before, so the first pass to write a
+// transient texture has to clear or overwrite all of it.
+// --------------------------------------------------------
+class RenderGraphCompiler
+{
+public:
+	static const unsigned int Unused = 0xFFFFFFFF;
+
+	RenderGraphCompiler();
+
+	// Forgets every pass and texture (keeping their memory)
+	void Reset();
+
+	// Textures the graph allocates, and ones that live outside of
+	// it.  Imported textures are never aliased, and are what the
+	// graph is ultimately for: passes writing them are never culled.
+	unsigned int AddTexture(const char* name, const RenderTextureDesc& desc);
+	unsigned int ImportTexture(const char* name);
+
+	unsigned int AddPass(const char* name);
+	void Read(unsigned int pass, unsigned int texture);
+	void Write(unsigned int pass, unsigned int texture);
+
+	// False (with a reason in GetError()) if the passes depend on
+	// each other in a cycle, or a pass reads a transient texture
+	// that nothing writes
+	bool Compile();
+	const std::string& GetError() { return error; }
+
+	// Results - scheduled passes in order, and culled passes
+	// (and textures only they used) report Unused
+	const std::vector<unsigned int>& GetSchedule() { return schedule; }
+	bool IsCulled(unsigned int pass) { return passes[pass].Position == Unused; }
+	unsigned int GetFirstUse(unsigned int texture) { return textures[texture].FirstUse; }
+	unsigned int GetLastUse(unsigned int texture) { return textures[texture].LastUse; }
+
+	// Which physical texture a transient one is stored in
+	unsigned int GetPhysicalTexture(unsigned int texture) { return textures[texture].Physical; }
+	unsigned int GetPhysicalTextureCount() { return physicalDescs.size(); }
+	const RenderTextureDesc& GetPhysicalDesc(unsigned int physical) { return physicalDescs[physical]; }
+
+	unsigned int GetPassCount() { return passCount; }
+	unsigned int GetTextureCount() { return textureCount; }
+	const char* GetPassName(unsigned int pass) { return passes[pass].Name; }
+	const char* GetTextureName(unsigned int texture) { return textures[texture].Name; }
+	bool IsImported(unsigned int texture) { return textures[texture].Imported; }
+
+private:
+	struct Pass
+	{
+		const char* Name;
+		std::vector<unsigned int> Reads;
+		std::vector<unsigned int> Writes;
+		unsigned int Position;			// In the schedule
+	};
+
+	struct Texture
+	{
+		const char* Name;
+		RenderTextureDesc Desc;
+		bool Imported;
+		std::vector<unsigned int> Writers;	// In the order added
+		unsigned int FirstUse;				// Schedule positions
+		unsigned int LastUse;
+		unsigned int Physical;
+	};
+
+	// Only the first passCount / textureCount are this frame's;
+	// the rest are kept for their vectors' memory
+	std::vector<Pass> passes;
+	std::vector<Texture> textures;
+	unsigned int passCount;
+	unsigned int textureCount;
+
+	std::vector<unsigned int> schedule;
+	std::vector<RenderTextureDesc> physicalDescs;
+	std::string error;
+
+	// Compile() scratch space, kept between frames
+	std::vector<bool> live;							// Per pass
+	std::vector<unsigned int> pending;
+	std::vector<std::vector<unsigned int> > next;	// Per pass: who waits on it
+	std::vector<unsigned int> waitingOn;			// Per pass
+	std::vector<unsigned int> liveWriters;
+	std::vector<unsigned int> ready;				// Min-heap
+	std::vector<unsigned int> order;
+	std::vector<unsigned int> physicalLastUse;
+
+	bool Writes(unsigned int pass, unsigned int texture);
+	void CullPasses();
+	bool SortPasses();
+	void FindLifetimes();
+	void AssignPhysicalTextures();
+};
@@ -0,0 +1,54 @@
+#include "ResolutionGovernor.h"
+#include <cmath>
+
+ResolutionGovernor::ResolutionGovernor(const ResolutionGovernorSettings& settings)
+{
+	this->settings = settings;
+	if (this->settings.MinScale <= 0.0f) this->settings.MinScale = 0.1f;
+	if (this->settings.MaxScale < this->settings.MinScale) this->settings.MaxScale = this->settings.MinScale;
+	Reset();
+}
+
+void ResolutionGovernor::Reset()
+{
+	scale = settings.MaxScale;
+	area = scale * scale;
+	filteredTime = 0.0f;
+	lastError = 0.0f;
+	secondLastError = 0.0f;
+}
+
+// --------------------------------------------------------
+// The error is relative (0.5 means half the budget is
+// spare, -0.5 means 50% over), so the gains don't depend on
+// the target.  Its first frame has no history to take
+// differences against, so it starts from zero error.
+// --------------------------------------------------------
+float ResolutionGovernor::Update(float frameTime)
+{
+	if (frameTime <= 0.0f || settings.TargetFrameTime <= 0.0f)
+		return scale;
+
+	if (filteredTime == 0.0f)
+		filteredTime = frameTime;
+	else
+		filteredTime += (frameTime - filteredTime) * settings.Smoothing;
+
+	float error = (settings.TargetFrameTime - filteredTime) / settings.TargetFrameTime;
+
+	float change =
+		settings.Proportional * (error - lastError) +
+		settings.Integral * error +
+		settings.Derivative * (error - 2.0f * lastError + secondLastError);
+	secondLastError = lastError;
+	lastError = error;
+
+	float minArea = settings.MinScale * settings.MinScale;
+	float maxArea = settings.MaxScale * settings.MaxScale;
+	area += change;
+	if (area < minArea) area = minArea;
+	if (area > maxArea) area = maxArea;
+
+	scale = sqrtf(area);
+	return scale;
+}
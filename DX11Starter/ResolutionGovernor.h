@@ -0,0 +1,59 @@
+#pragma once
+
+// --------------------------------------------------------
+// How a ResolutionGovernor reacts to frame times
+// --------------------------------------------------------
+struct ResolutionGovernorSettings
+{
+	float MinScale;			// Smallest fraction of the output's width and height
+	float MaxScale;			// Largest (1 for native resolution)
+	float TargetFrameTime;	// Seconds of rendering per frame to aim for
+
+	// Controller gains, on the relative error in frame time
+	float Proportional;
+	float Integral;
+	float Derivative;
+
+	// How much of each new frame time goes into the filtered
+	// one (0 to 1) - lower is steadier but slower to react
+	float Smoothing;
+};
+
+// --------------------------------------------------------
+// Picks a resolution scale from measured frame times.
+//
+// A PID controller in velocity form: each frame nudges the
+// scaled pixel count (scale squared, since that's what
+// rendering cost follows) by an amount based on how far
+// the filtered frame time is from the target.  Working on
+// the change rather than the value means hitting a scale
+// limit can't wind the integral term up.
+//
+// Pure arithmetic - the same timings in always give the
+// same scales out, so traces can be replayed through it.
+// --------------------------------------------------------
+class ResolutionGovernor
+{
+public:
+	ResolutionGovernor(const ResolutionGovernorSettings& settings);
+
+	// Back to the largest scale, forgetting all history
+	void Reset();
+
+	// Feeds in one frame's time and returns the new scale
+	float Update(float frameTime);
+
+	float GetScale() { return scale; }
+	float GetFilteredFrameTime() { return filteredTime; }
+
+	ResolutionGovernorSettings& GetSettings() { return settings; }
+
+private:
+	ResolutionGovernorSettings settings;
+
+	float scale;
+	float area;				// scale * scale
+	float filteredTime;		// 0 until the first frame
+	float lastError;
+	float secondLastError;
+};
@@ -0,0 +1,72 @@
+#include "ResourceRegistry.h"
+#include "Mesh.h"
+#include "Materials.h"
+
+// --------------------------------------------------------
+// Constructor
+// --------------------------------------------------------
+ResourceRegistry::ResourceRegistry()
+{
+	frame = 0;
+}
+
+// --------------------------------------------------------
+// Destructor - Destroys everything, whether or not it's
+// still referenced.  Must happen before the device goes.
+// --------------------------------------------------------
+ResourceRegistry::~ResourceRegistry()
+{
+	std::vector<Mesh*> deadMeshes;
+	std::vector<Materials*> deadMaterials;
+	std::vector<ID3D11ShaderResourceView*> deadTextures;
+
+	meshes.CollectAll(deadMeshes);
+	materials.CollectAll(deadMaterials);
+	textures.CollectAll(deadTextures);
+
+	// Materials would release their textures, but those are all going anyway
+	for (unsigned int i = 0; i < deadMaterials.size(); i++)
+		delete deadMaterials[i];
+	deadMaterials.clear();
+
+	Destroy(deadMeshes, deadMaterials, deadTextures);
+}
+
+// --------------------------------------------------------
+// Advances the frame counter and destroys anything that
+// was retired RESOURCE_RETIRE_FRAMES frames ago
+// --------------------------------------------------------
+void ResourceRegistry::EndFrame()
+{
+	frame++;
+
+	std::vector<Mesh*> deadMeshes;
+	std::vector<Materials*> deadMaterials;
+	std::vector<ID3D11ShaderResourceView*> deadTextures;
+
+	// Materials first, as destroying one can retire its texture
+	materials.Collect(frame, deadMaterials);
+	meshes.Collect(frame, deadMeshes);
+	textures.Collect(frame, deadTextures);
+
+	Destroy(deadMeshes, deadMaterials, deadTextures);
+}
+
+// --------------------------------------------------------
+// Actually destroys resources, each in its own way
+// --------------------------------------------------------
+void ResourceRegistry::Destroy(std::vector<Mesh*>& deadMeshes, std::vector<Materials*>& deadMaterials, std::vector<ID3D11ShaderResourceView*>& deadTextures)
+{
+	for (unsigned int i = 0; i < deadMaterials.size(); i++)
+	{
+		// A material holds a reference to its texture
+		textures.Release(deadMaterials[i]->GetTexture(), frame);
+		delete deadMaterials[i];
+	}
+
+	for (unsigned int i = 0; i < deadMeshes.size(); i++)
+		delete deadMeshes[i];
+
+	for (unsigned int i = 0; i < deadTextures.size(); i++)
+		deadTextures[i]->Release();
+}
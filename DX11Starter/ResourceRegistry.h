@@ -0,0 +1,248 @@
+#pragma once
+
+#include <d3d11.h>
+#include <vector>
+
+class Mesh;
+class Materials;
+
+// Resources released during a frame are kept alive this many
+// frames longer, so the GPU is done with them before they go
+#define RESOURCE_RETIRE_FRAMES		3
+
+// Handles pack a slot index and that slot's generation into 32 bits
+#define RESOURCE_INDEX_BITS			20
+#define RESOURCE_INDEX_MASK			((1u << RESOURCE_INDEX_BITS) - 1)
+#define RESOURCE_GENERATION_MASK	((1u << (32 - RESOURCE_INDEX_BITS)) - 1)
+
+// --------------------------------------------------------
+// A stable, typed 32-bit reference to a resource.  Zero is
+// never a valid handle, and a handle to a destroyed resource
+// goes stale (its generation no longer matches) instead of
+// dangling.
+// --------------------------------------------------------
+template <typename T>
+struct ResourceHandle
+{
+	unsigned int Value;
+
+	ResourceHandle() : Value(0) {}
+	explicit ResourceHandle(unsigned int value) : Value(value) {}
+
+	unsigned int Index() const { return Value & RESOURCE_INDEX_MASK; }
+	unsigned int Generation() const { return Value >> RESOURCE_INDEX_BITS; }
+	bool IsValid() const { return Value != 0; }
+
+	bool operator==(const ResourceHandle& other) const { return Value == other.Value; }
+	bool operator!=(const ResourceHandle& other) const { return Value != other.Value; }
+};
+
+typedef ResourceHandle<Mesh> MeshHandle;
+typedef ResourceHandle<Materials> MaterialHandle;
+typedef ResourceHandle<ID3D11ShaderResourceView> TextureHandle;
+
+// --------------------------------------------------------
+// Reference counted slots for one type of resource.
+//
+// Adding and releasing are O(1): freed slots go on a free
+// list and are reused with a new generation.  Resources
+// aren't destroyed when their count hits zero; they're
+// retired, and handed back by Collect() once the GPU can
+// no longer be using them.
+// --------------------------------------------------------
+template <typename T>
+class ResourcePool
+{
+public:
+	ResourcePool() {}
+
+	// Takes ownership of a resource, with a single reference.
+	// Null isn't a resource, so gets the invalid handle.
+	ResourceHandle<T> Add(T* resource)
+	{
+		if (!resource)
+			return ResourceHandle<T>();
+
+		unsigned int index;
+		if (!freeSlots.empty())
+		{
+			index = freeSlots.back();
+			freeSlots.pop_back();
+		}
+		else
+		{
+			index = (unsigned int)slots.size();
+			Slot slot = { 0, 1, 0 };
+			slots.push_back(slot);
+		}
+
+		slots[index].Resource = resource;
+		slots[index].RefCount = 1;
+		return ResourceHandle<T>((slots[index].Generation << RESOURCE_INDEX_BITS) | index);
+	}
+
+	// Gets the resource, or 0 if the handle is stale
+	T* Get(ResourceHandle<T> handle) const
+	{
+		const Slot* slot = Find(handle);
+		return slot ? slot->Resource : 0;
+	}
+
+	void AddRef(ResourceHandle<T> handle)
+	{
+		Slot* slot = Find(handle);
+		if (slot)
+			slot->RefCount++;
+	}
+
+	// Drops a reference.  The last one invalidates every handle
+	// to the slot right away and retires the resource.
+	void Release(ResourceHandle<T> handle, unsigned int frame)
+	{
+		Slot* slot = Find(handle);
+		if (!slot || --slot->RefCount > 0)
+			return;
+
+		Retire(slot->Resource, frame);
+		slot->Resource = 0;
+
+		// Never hand out generation zero, so handle zero stays invalid
+		slot->Generation = (slot->Generation + 1) & RESOURCE_GENERATION_MASK;
+		if (slot->Generation == 0)
+			slot->Generation = 1;
+
+		freeSlots.push_back(handle.Index());
+	}
+
+	// Points a handle at a new resource (hot reloading), retiring the old one
+	bool Replace(ResourceHandle<T> handle, T* resource, unsigned int frame)
+	{
+		Slot* slot = Find(handle);
+		if (!slot)
+			return false;
+
+		Retire(slot->Resource, frame);
+		slot->Resource = resource;
+		return true;
+	}
+
+	// Hands back retired resources that are now safe to destroy
+	void Collect(unsigned int frame, std::vector<T*>& destroyed)
+	{
+		unsigned int kept = 0;
+		for (unsigned int i = 0; i < retired.size(); i++)
+		{
+			if (frame - retired[i].Frame >= RESOURCE_RETIRE_FRAMES)
+				destroyed.push_back(retired[i].Resource);
+			else
+				retired[kept++] = retired[i];
+		}
+		retired.resize(kept);
+	}
+
+	// Hands back everything, live or retired (for shutting down)
+	void CollectAll(std::vector<T*>& destroyed)
+	{
+		for (unsigned int i = 0; i < retired.size(); i++)
+			destroyed.push_back(retired[i].Resource);
+		for (unsigned int i = 0; i < slots.size(); i++)
+		{
+			if (slots[i].Resource)
+				destroyed.push_back(slots[i].Resource);
+		}
+
+		retired.clear();
+		slots.clear();
+		freeSlots.clear();
+	}
+
+private:
+	struct Slot
+	{
+		T* Resource;
+		unsigned int Generation;
+		unsigned int RefCount;
+	};
+
+	struct RetiredResource
+	{
+		T* Resource;
+		unsigned int Frame;
+	};
+
+	std::vector<Slot> slots;
+	std::vector<unsigned int> freeSlots;
+	std::vector<RetiredResource> retired;
+
+	Slot* Find(ResourceHandle<T> handle)
+	{
+		unsigned int index = handle.Index();
+		if (index >= slots.size() || slots[index].Generation != handle.Generation() || !slots[index].Resource)
+			return 0;
+		return &slots[index];
+	}
+
+	const Slot* Find(ResourceHandle<T> handle) const
+	{
+		return const_cast<ResourcePool*>(this)->Find(handle);
+	}
+
+	void Retire(T* resource, unsigned int frame)
+	{
+		if (!resource)
+			return;
+
+		RetiredResource entry = { resource, frame };
+		retired.push_back(entry);
+	}
+};
+
+// --------------------------------------------------------
+// Owns every mesh, material and texture in the game.
+//
+// Everything that uses a resource holds a handle and a
+// reference to it, rather than a raw pointer, so shared
+// resources are destroyed exactly once, when the last user
+// lets go (and the GPU is finished with them).
+//
+// Shaders aren't in here: ShaderVariantCache already owns
+// and shares them.
+// --------------------------------------------------------
+class ResourceRegistry
+{
+public:
+	ResourceRegistry();
+	~ResourceRegistry();
+
+	MeshHandle Add(Mesh* mesh) { return meshes.Add(mesh); }
+	MaterialHandle Add(Materials* material) { return materials.Add(material); }
+	TextureHandle Add(ID3D11ShaderResourceView* texture) { return textures.Add(texture); }
+
+	Mesh* Get(MeshHandle handle) const { return meshes.Get(handle); }
+	Materials* Get(MaterialHandle handle) const { return materials.Get(handle); }
+	ID3D11ShaderResourceView* Get(TextureHandle handle) const { return textures.Get(handle); }
+
+	void AddRef(MeshHandle handle) { meshes.AddRef(handle); }
+	void AddRef(MaterialHandle handle) { materials.AddRef(handle); }
+	void AddRef(TextureHandle handle) { textures.AddRef(handle); }
+
+	void Release(MeshHandle handle) { meshes.Release(handle, frame); }
+	void Release(MaterialHandle handle) { materials.Release(handle, frame); }
+	void Release(TextureHandle handle) { textures.Release(handle, frame); }
+
+	// Swaps in a reloaded resource - every handle now refers to it
+	bool Replace(MeshHandle handle, Mesh* mesh) { return meshes.Replace(handle, mesh, frame); }
+	bool Replace(TextureHandle handle, ID3D11ShaderResourceView* texture) { return textures.Replace(handle, texture, frame); }
+
+	// Destroys whatever was retired long enough ago - call once per frame
+	void EndFrame();
+
+private:
+	unsigned int frame;
+
+	ResourcePool<Mesh> meshes;
+	ResourcePool<Materials> materials;
+	ResourcePool<ID3D11ShaderResourceView> textures;
+
+	void Destroy(std::vector<Mesh*>& deadMeshes, std::vector<Materials*>& deadMaterials, std::vector<ID3D11ShaderResourceView*>& deadTextures);
+};
@@ -0,0 +1,190 @@
+#include "SceneRaycaster.h"
+#include "EntityPool.h"
+#include "ResourceRegistry.h"
+#include <algorithm>
+#include <cfloat>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Gathers every live entity with a mesh and builds the top
+// level tree over their world space boxes
+// --------------------------------------------------------
+void SceneRaycaster::Build(EntityPool* entities, ResourceRegistry* resources)
+{
+	nodes.clear();
+
+	std::vector<Instance> unordered;
+	std::vector<XMFLOAT3> boxMin;
+	std::vector<XMFLOAT3> boxMax;
+	unordered.reserve(entities->GetCount());
+	boxMin.reserve(entities->GetCount());
+	boxMax.reserve(entities->GetCount());
+
+	entities->ForEachWithId([&](unsigned int id, GameEntity* entity)
+	{
+		Mesh* mesh = resources->Get(entity->GetMesh());
+		if (!mesh || mesh->GetBVH().IsEmpty())
+			return;
+
+		// Stored transposed for HLSL
+		XMFLOAT4X4 storedWorld = entity->GetMatrix();
+		XMMATRIX world = XMMatrixTranspose(XMLoadFloat4x4(&storedWorld));
+
+		// World space box around the transformed model space box
+		XMFLOAT3 localMin, localMax;
+		mesh->GetBVH().GetBounds(&localMin, &localMax);
+		XMVECTOR worldMin = XMVectorReplicate(FLT_MAX);
+		XMVECTOR worldMax = XMVectorReplicate(-FLT_MAX);
+		for (unsigned int corner = 0; corner < 8; corner++)
+		{
+			XMVECTOR point = XMVectorSet(
+				(corner & 1) ? localMax.x : localMin.x,
+				(corner & 2) ? localMax.y : localMin.y,
+				(corner & 4) ? localMax.z : localMin.z,
+				1.0f);
+			point = XMVector3TransformCoord(point, world);
+			worldMin = XMVectorMin(worldMin, point);
+			worldMax = XMVectorMax(worldMax, point);
+		}
+
+		Instance instance;
+		instance.Entity = id;
+		instance.Triangles = &mesh->GetBVH();
+		XMStoreFloat4x4(&instance.InverseWorld, XMMatrixInverse(0, world));
+		unordered.push_back(instance);
+
+		boxMin.push_back(XMFLOAT3());
+		boxMax.push_back(XMFLOAT3());
+		XMStoreFloat3(&boxMin.back(), worldMin);
+		XMStoreFloat3(&boxMax.back(), worldMax);
+	});
+
+	instances.clear();
+	if (unordered.empty())
+		return;
+
+	std::vector<unsigned int> order;
+	BuildBVH(&boxMin[0], &boxMax[0], unordered.size(), nodes, order);
+
+	// Store the instances in leaf order so leaves index them directly
+	instances.reserve(unordered.size());
+	for (unsigned int i = 0; i < order.size(); i++)
+		instances.push_back(unordered[order[i]]);
+}
+
+bool SceneRaycaster::GetBounds(XMFLOAT3* min, XMFLOAT3* max) const
+{
+	if (nodes.empty())
+		return false;
+
+	*min = nodes[0].Min;
+	*max = nodes[0].Max;
+	return true;
+}
+
+bool SceneRaycaster::Raycast(const Ray& ray, SceneHit* hit) const
+{
+	return Traverse<false>(ray, hit);
+}
+
+bool SceneRaycaster::AnyHit(const Ray& ray) const
+{
+	return Traverse<true>(ray, 0);
+}
+
+// --------------------------------------------------------
+// Same walk as the triangle BVH, with meshes for leaves.
+// The ray's direction isn't renormalized in model space, so
+// distances along it stay in world units even with scale.
+// --------------------------------------------------------
+template <bool AnyHit>
+bool SceneRaycaster::Traverse(const Ray& ray, SceneHit* hit) const
+{
+	if (nodes.empty())
+		return false;
+
+	XMVECTOR origin = XMLoadFloat3(&ray.Origin);
+	XMVECTOR direction = XMLoadFloat3(&ray.Direction);
+	XMVECTOR invDirection = XMVectorReciprocal(direction);
+
+	float closest = ray.MaxDistance;
+	bool found = false;
+
+	unsigned int stack[BVH_MAX_DEPTH];
+	float stackDistance[BVH_MAX_DEPTH];
+	unsigned int stackSize = 0;
+
+	float rootDistance = IntersectBVHNode(nodes[0], origin, invDirection, closest);
+	if (rootDistance < 0.0f)
+		return false;
+	stack[0] = 0;
+	stackDistance[0] = rootDistance;
+	stackSize = 1;
+
+	while (stackSize > 0)
+	{
+		stackSize--;
+		if (stackDistance[stackSize] > closest)
+			continue;
+		const BVHNode& node = nodes[stack[stackSize]];
+
+		if (node.Count == 0)
+		{
+			float leftDistance = IntersectBVHNode(nodes[node.First], origin, invDirection, closest);
+			float rightDistance = IntersectBVHNode(nodes[node.First + 1], origin, invDirection, closest);
+
+			unsigned int nearChild = node.First, farChild = node.First + 1;
+			float nearDistance = leftDistance, farDistance = rightDistance;
+			if (nearDistance < 0.0f || (farDistance >= 0.0f && farDistance < nearDistance))
+			{
+				std::swap(nearChild, farChild);
+				std::swap(nearDistance, farDistance);
+			}
+
+			if (farDistance >= 0.0f)
+			{
+				stack[stackSize] = farChild;
+				stackDistance[stackSize++] = farDistance;
+			}
+			if (nearDistance >= 0.0f)
+			{
+				stack[stackSize] = nearChild;
+				stackDistance[stackSize++] = nearDistance;
+			}
+			continue;
+		}
+
+		for (unsigned int i = node.First; i < node.First + node.Count; i++)
+		{
+			const Instance& instance = instances[i];
+			XMMATRIX invWorld = XMLoadFloat4x4(&instance.InverseWorld);
+
+			Ray local;
+			XMStoreFloat3(&local.Origin, XMVector3TransformCoord(origin, invWorld));
+			XMStoreFloat3(&local.Direction, XMVector3TransformNormal(direction, invWorld));
+			local.MaxDistance = closest;
+
+			if (AnyHit)
+			{
+				if (instance.Triangles->IntersectAny(local))
+					return true;
+				continue;
+			}
+
+			RayHit triangleHit;
+			if (!instance.Triangles->IntersectClosest(local, &triangleHit))
+				continue;
+
+			found = true;
+			closest = triangleHit.Distance;
+			hit->Entity = instance.Entity;
+			hit->Distance = triangleHit.Distance;
+			hit->Triangle = triangleHit.Triangle;
+			hit->FrontFace = triangleHit.FrontFace;
+			XMStoreFloat3(&hit->Position, XMVectorMultiplyAdd(direction, XMVectorReplicate(triangleHit.Distance), origin));
+		}
+	}
+
+	return found;
+}
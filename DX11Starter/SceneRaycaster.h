@@ -0,0 +1,65 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+#include "BVH.h"
+
+// Only Build() needs these, so the query side (and what bakes
+// against it) doesn't pull in the game's D3D types
+class GameEntity;
+class ResourceRegistry;
+template <typename EntityType> class EntityStorage;
+typedef EntityStorage<GameEntity> EntityPool;
+
+// --------------------------------------------------------
+// What a scene ray query hit
+// --------------------------------------------------------
+struct SceneHit
+{
+	unsigned int Entity;		// Id in the entity pool
+	float Distance;
+	unsigned int Triangle;		// First index of the triangle, in the mesh's meshlet order
+	XMFLOAT3 Position;			// World space
+	bool FrontFace;				// Hit the outside of the mesh
+};
+
+// --------------------------------------------------------
+// Ray queries against every entity in the scene.
+//
+// A top level BVH over the entities' world space bounds
+// finds the instances a ray might hit; the ray is then moved
+// into each one's model space and tested against its mesh's
+// own triangle BVH, so meshes are never transformed or
+// copied per instance.
+//
+// Entities move, so Build() again whenever the query needs
+// to see where they are now.  It only touches one box per
+// entity, so it's cheap enough to do every frame.
+// --------------------------------------------------------
+class SceneRaycaster
+{
+public:
+	void Build(EntityPool* entities, ResourceRegistry* resources);
+
+	// Nearest hit along the ray, if any
+	bool Raycast(const Ray& ray, SceneHit* hit) const;
+
+	// Whether the ray hits anything (line of sight, etc.)
+	bool AnyHit(const Ray& ray) const;
+
+	// World space box around every entity.  False if there are none.
+	bool GetBounds(XMFLOAT3* min, XMFLOAT3* max) const;
+
+private:
+	struct Instance
+	{
+		unsigned int Entity;
+		const TriangleBVH* Triangles;
+		XMFLOAT4X4 InverseWorld;
+	};
+
+	std::vector<BVHNode> nodes;
+	std::vector<Instance> instances;	// In leaf order
+
+	template <bool AnyHit> bool Traverse(const Ray& ray, SceneHit* hit) const;
+};
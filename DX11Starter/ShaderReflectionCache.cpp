@@ -0,0 +1,158 @@
+#include "ShaderReflectionCache.h"
+#include <fstream>
+
+// --------------------------------------------------------
+// 64-bit FNV-1a hash of the compiled shader blob.  Any
+// recompile of the .cso changes the hash and invalidates
+// the sidecar.
+// --------------------------------------------------------
+unsigned long long ShaderReflectionCache::HashBlob(const void* data, size_t size)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	unsigned long long hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+// --------------------------------------------------------
+// The sidecar lives right next to the shader file
+// --------------------------------------------------------
+std::wstring ShaderReflectionCache::GetSidecarPath(LPCWSTR shaderFile)
+{
+	std::wstring path(shaderFile);
+	path.append(L".refl");
+	return path;
+}
+
+// --------------------------------------------------------
+// Walks the shader with D3DReflect and copies out everything
+// SimpleShader uses: constant buffers and their variables,
+// bound resources, the input signature and thread group size.
+//
+// Returns true if reflection succeeded, false otherwise
+// --------------------------------------------------------
+bool ShaderReflectionCache::Reflect(ID3DBlob* shaderBlob, ShaderReflectionData* data)
+{
+	ID3D11ShaderReflection* refl;
+	HRESULT hr = D3DReflect(
+		shaderBlob->GetBufferPointer(),
+		shaderBlob->GetBufferSize(),
+		IID_ID3D11ShaderReflection,
+		(void**)&refl);
+	if (FAILED(hr))
+		return false;
+
+	// Get the description of the shader
+	D3D11_SHADER_DESC shaderDesc;
+	refl->GetDesc(&shaderDesc);
+
+	// Bound resources (textures, samplers, UAVs, cbuffers)
+	data->Resources.resize(shaderDesc.BoundResources);
+	for (unsigned int r = 0; r < shaderDesc.BoundResources; r++)
+	{
+		D3D11_SHADER_INPUT_BIND_DESC resourceDesc;
+		refl->GetResourceBindingDesc(r, &resourceDesc);
+
+		data->Resources[r].Name = resourceDesc.Name;
+		data->Resources[r].Type = resourceDesc.Type;
+		data->Resources[r].BindIndex = resourceDesc.BindPoint;
+	}
+
+	// Constant buffers and their variables
+	data->ConstantBuffers.resize(shaderDesc.ConstantBuffers);
+	for (unsigned int b = 0; b < shaderDesc.ConstantBuffers; b++)
+	{
+		ID3D11ShaderReflectionConstantBuffer* cb = refl->GetConstantBufferByIndex(b);
+
+		D3D11_SHADER_BUFFER_DESC bufferDesc;
+		cb->GetDesc(&bufferDesc);
+
+		D3D11_SHADER_INPUT_BIND_DESC bindDesc;
+		refl->GetResourceBindingDescByName(bufferDesc.Name, &bindDesc);
+
+		CachedConstantBuffer& cached = data->ConstantBuffers[b];
+		cached.Name = bufferDesc.Name;
+		cached.Size = bufferDesc.Size;
+		cached.BindIndex = bindDesc.BindPoint;
+		cached.Variables.resize(bufferDesc.Variables);
+
+		for (unsigned int v = 0; v < bufferDesc.Variables; v++)
+		{
+			D3D11_SHADER_VARIABLE_DESC varDesc;
+			cb->GetVariableByIndex(v)->GetDesc(&varDesc);
+
+			cached.Variables[v].Name = varDesc.Name;
+			cached.Variables[v].ByteOffset = varDesc.StartOffset;
+			cached.Variables[v].Size = varDesc.Size;
+		}
+	}
+
+	// Input signature, used by vertex shaders to build an input layout
+	data->InputParameters.resize(shaderDesc.InputParameters);
+	for (unsigned int i = 0; i < shaderDesc.InputParameters; i++)
+	{
+		D3D11_SIGNATURE_PARAMETER_DESC paramDesc;
+		refl->GetInputParameterDesc(i, &paramDesc);
+
+		data->InputParameters[i].SemanticName = paramDesc.SemanticName;
+		data->InputParameters[i].SemanticIndex = paramDesc.SemanticIndex;
+		data->InputParameters[i].Mask = paramDesc.Mask;
+		data->InputParameters[i].ComponentType = paramDesc.ComponentType;
+	}
+
+	// Thread group size (zero for anything but compute shaders)
+	refl->GetThreadGroupSize(
+		&data->ThreadGroupSize[0],
+		&data->ThreadGroupSize[1],
+		&data->ThreadGroupSize[2]);
+
+	refl->Release();
+	return true;
+}
+
+// --------------------------------------------------------
+// Reads a sidecar file, validating that it was written for
+// exactly this shader blob.
+//
+// Returns true if the cache was valid and data was filled in
+// --------------------------------------------------------
+bool ShaderReflectionCache::Load(LPCWSTR sidecarFile, unsigned long long blobHash, unsigned int blobSize, ShaderReflectionData* data)
+{
+	// Read the whole file in one go
+	std::ifstream file(sidecarFile, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+		return false;
+
+	std::streamsize fileSize = file.tellg();
+	if (fileSize <= 0)
+		return false;
+
+	std::vector<unsigned char> bytes((size_t)fileSize);
+	file.seekg(0, std::ios::beg);
+	if (!file.read((char*)&bytes[0], fileSize))
+		return false;
+
+	return ParseReflectionSidecar(&bytes[0], bytes.size(), blobHash, blobSize, data);
+}
+
+// --------------------------------------------------------
+// Writes reflection data to a sidecar file.  Failing to
+// write (read-only install directory, etc.) is harmless;
+// we'll just reflect again next time.
+// --------------------------------------------------------
+bool ShaderReflectionCache::Save(LPCWSTR sidecarFile, unsigned long long blobHash, unsigned int blobSize, const ShaderReflectionData& data)
+{
+	std::vector<unsigned char> out;
+	WriteReflectionSidecar(blobHash, blobSize, data, &out);
+
+	std::ofstream file(sidecarFile, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+		return false;
+
+	file.write((const char*)&out[0], out.size());
+	return file.good();
+}
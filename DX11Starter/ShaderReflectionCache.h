@@ -0,0 +1,24 @@
+#pragma once
+
+#include <d3d11.h>
+#include <d3dcompiler.h>
+#include <string>
+#include <vector>
+#include "ShaderReflectionData.h"
+
+// --------------------------------------------------------
+// Reads and writes shader reflection results to a compact
+// binary file next to each .cso ("Shader.cso.refl"), keyed
+// by a hash of the compiled blob.  A stale or missing
+// sidecar simply falls back to D3DReflect.
+// --------------------------------------------------------
+class ShaderReflectionCache
+{
+public:
+	static unsigned long long HashBlob(const void* data, size_t size);
+	static std::wstring GetSidecarPath(LPCWSTR shaderFile);
+
+	static bool Reflect(ID3DBlob* shaderBlob, ShaderReflectionData* data);
+	static bool Load(LPCWSTR sidecarFile, unsigned long long blobHash, unsigned int blobSize, ShaderReflectionData* data);
+	static bool Save(LPCWSTR sidecarFile, unsigned long long blobHash, unsigned int blobSize, const ShaderReflectionData& data);
+};
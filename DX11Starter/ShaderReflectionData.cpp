@@ -0,0 +1,204 @@
+#include "ShaderReflectionData.h"
+#include <cstring>
+
+// Bump this whenever the layout of the sidecar file changes
+#define REFLECTION_CACHE_MAGIC		0x4C465253 // "SRFL"
+#define REFLECTION_CACHE_VERSION	1
+
+// Smallest each entry can be on disk (an empty name's
+// length plus the entry's fixed fields), used to bound
+// counts before anything is resized
+#define MIN_CBUFFER_BYTES		16
+#define MIN_VARIABLE_BYTES		12
+#define MIN_RESOURCE_BYTES		12
+#define MIN_INPUT_BYTES			16
+
+// --------------------------------------------------------
+// Small helpers for reading and writing the sidecar.  The
+// reader tracks the end of the buffer so a truncated or
+// corrupt file fails cleanly instead of reading garbage.
+// --------------------------------------------------------
+struct CacheReader
+{
+	const unsigned char* cursor;
+	const unsigned char* end;
+
+	size_t Remaining() { return (size_t)(end - cursor); }
+
+	bool ReadUInt(unsigned int* value)
+	{
+		if (Remaining() < sizeof(unsigned int)) return false;
+		memcpy(value, cursor, sizeof(unsigned int));
+		cursor += sizeof(unsigned int);
+		return true;
+	}
+
+	bool ReadUInt64(unsigned long long* value)
+	{
+		if (Remaining() < sizeof(unsigned long long)) return false;
+		memcpy(value, cursor, sizeof(unsigned long long));
+		cursor += sizeof(unsigned long long);
+		return true;
+	}
+
+	bool ReadString(std::string* value)
+	{
+		unsigned int length;
+		if (!ReadUInt(&length)) return false;
+		if (Remaining() < length) return false;
+		value->assign((const char*)cursor, length);
+		cursor += length;
+		return true;
+	}
+
+	// Reads an entry count, failing if that many entries of at
+	// least minEntryBytes each couldn't fit in what's left
+	bool ReadCount(unsigned int* count, size_t minEntryBytes)
+	{
+		if (!ReadUInt(count)) return false;
+		return *count <= Remaining() / minEntryBytes;
+	}
+};
+
+static void WriteUInt(std::vector<unsigned char>& out, unsigned int value)
+{
+	const unsigned char* bytes = (const unsigned char*)&value;
+	out.insert(out.end(), bytes, bytes + sizeof(unsigned int));
+}
+
+static void WriteUInt64(std::vector<unsigned char>& out, unsigned long long value)
+{
+	const unsigned char* bytes = (const unsigned char*)&value;
+	out.insert(out.end(), bytes, bytes + sizeof(unsigned long long));
+}
+
+static void WriteString(std::vector<unsigned char>& out, const std::string& value)
+{
+	WriteUInt(out, (unsigned int)value.size());
+	out.insert(out.end(), value.begin(), value.end());
+}
+
+// --------------------------------------------------------
+// Serializes reflection data, replacing the contents of out
+// --------------------------------------------------------
+void WriteReflectionSidecar(unsigned long long blobHash, unsigned int blobSize, const ShaderReflectionData& data, std::vector<unsigned char>* out)
+{
+	out->clear();
+
+	// Header
+	WriteUInt(*out, REFLECTION_CACHE_MAGIC);
+	WriteUInt(*out, REFLECTION_CACHE_VERSION);
+	WriteUInt64(*out, blobHash);
+	WriteUInt(*out, blobSize);
+	WriteUInt(*out, (unsigned int)data.ConstantBuffers.size());
+	WriteUInt(*out, (unsigned int)data.Resources.size());
+	WriteUInt(*out, (unsigned int)data.InputParameters.size());
+	for (int i = 0; i < 3; i++)
+		WriteUInt(*out, data.ThreadGroupSize[i]);
+
+	// Constant buffers
+	for (unsigned int b = 0; b < data.ConstantBuffers.size(); b++)
+	{
+		const CachedConstantBuffer& cb = data.ConstantBuffers[b];
+		WriteString(*out, cb.Name);
+		WriteUInt(*out, cb.Size);
+		WriteUInt(*out, cb.BindIndex);
+		WriteUInt(*out, (unsigned int)cb.Variables.size());
+		for (unsigned int v = 0; v < cb.Variables.size(); v++)
+		{
+			WriteString(*out, cb.Variables[v].Name);
+			WriteUInt(*out, cb.Variables[v].ByteOffset);
+			WriteUInt(*out, cb.Variables[v].Size);
+		}
+	}
+
+	// Bound resources
+	for (unsigned int r = 0; r < data.Resources.size(); r++)
+	{
+		WriteString(*out, data.Resources[r].Name);
+		WriteUInt(*out, data.Resources[r].Type);
+		WriteUInt(*out, data.Resources[r].BindIndex);
+	}
+
+	// Input signature
+	for (unsigned int i = 0; i < data.InputParameters.size(); i++)
+	{
+		WriteString(*out, data.InputParameters[i].SemanticName);
+		WriteUInt(*out, data.InputParameters[i].SemanticIndex);
+		WriteUInt(*out, data.InputParameters[i].Mask);
+		WriteUInt(*out, data.InputParameters[i].ComponentType);
+	}
+}
+
+// --------------------------------------------------------
+// Parses a sidecar, validating that it was written for
+// exactly this shader blob.
+//
+// Returns true if the bytes were valid and data was filled in
+// --------------------------------------------------------
+bool ParseReflectionSidecar(const unsigned char* bytes, size_t size, unsigned long long blobHash, unsigned int blobSize, ShaderReflectionData* data)
+{
+	CacheReader reader = { bytes, bytes + size };
+
+	// Header - must match the current format and shader blob
+	unsigned int magic, version, storedSize;
+	unsigned long long hash;
+	if (!reader.ReadUInt(&magic) || magic != REFLECTION_CACHE_MAGIC) return false;
+	if (!reader.ReadUInt(&version) || version != REFLECTION_CACHE_VERSION) return false;
+	if (!reader.ReadUInt64(&hash) || hash != blobHash) return false;
+	if (!reader.ReadUInt(&storedSize) || storedSize != blobSize) return false;
+
+	// Each count is checked again at its section, against
+	// what's left once the earlier sections are read
+	unsigned int cbCount, resourceCount, inputCount;
+	if (!reader.ReadCount(&cbCount, MIN_CBUFFER_BYTES)) return false;
+	if (!reader.ReadCount(&resourceCount, MIN_RESOURCE_BYTES)) return false;
+	if (!reader.ReadCount(&inputCount, MIN_INPUT_BYTES)) return false;
+	for (int i = 0; i < 3; i++)
+		if (!reader.ReadUInt(&data->ThreadGroupSize[i])) return false;
+
+	// Constant buffers
+	if (cbCount > reader.Remaining() / MIN_CBUFFER_BYTES) return false;
+	data->ConstantBuffers.resize(cbCount);
+	for (unsigned int b = 0; b < cbCount; b++)
+	{
+		CachedConstantBuffer& cb = data->ConstantBuffers[b];
+		unsigned int varCount;
+		if (!reader.ReadString(&cb.Name)) return false;
+		if (!reader.ReadUInt(&cb.Size)) return false;
+		if (!reader.ReadUInt(&cb.BindIndex)) return false;
+		if (!reader.ReadCount(&varCount, MIN_VARIABLE_BYTES)) return false;
+
+		cb.Variables.resize(varCount);
+		for (unsigned int v = 0; v < varCount; v++)
+		{
+			if (!reader.ReadString(&cb.Variables[v].Name)) return false;
+			if (!reader.ReadUInt(&cb.Variables[v].ByteOffset)) return false;
+			if (!reader.ReadUInt(&cb.Variables[v].Size)) return false;
+		}
+	}
+
+	// Bound resources
+	if (resourceCount > reader.Remaining() / MIN_RESOURCE_BYTES) return false;
+	data->Resources.resize(resourceCount);
+	for (unsigned int r = 0; r < resourceCount; r++)
+	{
+		if (!reader.ReadString(&data->Resources[r].Name)) return false;
+		if (!reader.ReadUInt(&data->Resources[r].Type)) return false;
+		if (!reader.ReadUInt(&data->Resources[r].BindIndex)) return false;
+	}
+
+	// Input signature
+	if (inputCount > reader.Remaining() / MIN_INPUT_BYTES) return false;
+	data->InputParameters.resize(inputCount);
+	for (unsigned int i = 0; i < inputCount; i++)
+	{
+		if (!reader.ReadString(&data->InputParameters[i].SemanticName)) return false;
+		if (!reader.ReadUInt(&data->InputParameters[i].SemanticIndex)) return false;
+		if (!reader.ReadUInt(&data->InputParameters[i].Mask)) return false;
+		if (!reader.ReadUInt(&data->InputParameters[i].ComponentType)) return false;
+	}
+
+	// Anything left over means this isn't a sidecar we wrote
+	return reader.Remaining() == 0;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// --------------------------------------------------------
+// Plain copies of the reflection data SimpleShader needs.
+// These can be filled either by D3DReflect or by reading
+// a cached sidecar file written on a previous run.
+// --------------------------------------------------------
+struct CachedShaderVariable
+{
+	std::string Name;
+	unsigned int ByteOffset;
+	unsigned int Size;
+};
+
+struct CachedConstantBuffer
+{
+	std::string Name;
+	unsigned int Size;
+	unsigned int BindIndex;
+	std::vector<CachedShaderVariable> Variables;
+};
+
+struct CachedShaderResource
+{
+	std::string Name;
+	unsigned int Type;		// A D3D_SHADER_INPUT_TYPE value
+	unsigned int BindIndex;
+};
+
+struct CachedInputParameter
+{
+	std::string SemanticName;
+	unsigned int SemanticIndex;
+	unsigned int Mask;
+	unsigned int ComponentType; // A D3D_REGISTER_COMPONENT_TYPE value
+};
+
+struct ShaderReflectionData
+{
+	std::vector<CachedConstantBuffer> ConstantBuffers;
+	std::vector<CachedShaderResource> Resources;
+	std::vector<CachedInputParameter> InputParameters;
+	unsigned int ThreadGroupSize[3];	// Only meaningful for compute shaders
+};
+
+// --------------------------------------------------------
+// The sidecar's binary format, kept apart from the file
+// and D3D code so it can be tested on its own.
+//
+// Parsing checks every count against the bytes left, so a
+// truncated or corrupt sidecar fails instead of allocating
+// whatever a garbage count asks for.
+// --------------------------------------------------------
+void WriteReflectionSidecar(unsigned long long blobHash, unsigned int blobSize, const ShaderReflectionData& data, std::vector<unsigned char>* out);
+bool ParseReflectionSidecar(const unsigned char* bytes, size_t size, unsigned long long blobHash, unsigned int blobSize, ShaderReflectionData* data);
@@ -0,0 +1,197 @@
+#pragma once
+
+#include "SimpleShader.h"
+#include "PipelineStateCache.h"
+#include "AssetWatcher.h"
+#include "VertexFormat.h"
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <cstdio>
+
+// --------------------------------------------------------
+// Feature bits used to pick a shader permutation.  Every
+// permutation is precompiled to "<BaseName>_XX.cso", where
+// XX is the feature mask in hex (see PixelShader_09.hlsl).
+// --------------------------------------------------------
+#define SHADER_FEATURE_TEXTURE		0x01	// Sample the diffuse texture
+#define SHADER_FEATURE_INSTANCING	0x02	// Per-instance world matrices
+#define SHADER_FEATURE_SHADOWS		0x04	// Sample a shadow map
+#define SHADER_FEATURE_LIGHT_SHIFT	3		// Light count (0-3) lives in bits 3-4
+#define SHADER_FEATURE_LIGHT_MASK	0x18
+#define SHADER_VARIANT_COUNT		32		// One slot per possible mask
+
+// Builds a feature mask at compile time
+inline constexpr unsigned int ShaderFeatures(bool textured, unsigned int lightCount, bool instanced, bool shadowed)
+{
+	return
+		(textured ? SHADER_FEATURE_TEXTURE : 0) |
+		(instanced ? SHADER_FEATURE_INSTANCING : 0) |
+		(shadowed ? SHADER_FEATURE_SHADOWS : 0) |
+		((lightCount << SHADER_FEATURE_LIGHT_SHIFT) & SHADER_FEATURE_LIGHT_MASK);
+}
+
+// The permutation the plain VertexShader.cso/PixelShader.cso files
+// are built as
+#define SHADER_FEATURES_DEFAULT ShaderFeatures(true, 2, false, false)
+
+// --------------------------------------------------------
+// Flat table of lazily loaded shader permutations, indexed
+// directly by feature mask.
+//
+// Variants are only loaded the first time they're asked
+// for.  A variant with no compiled .cso comes back null,
+// and it's up to the caller whether to use another one.
+// --------------------------------------------------------
+template <class ShaderType>
+class ShaderVariantCache
+{
+public:
+	ShaderVariantCache(ID3D11Device* device, ID3D11DeviceContext* context, const std::wstring& baseName, PipelineStateCache* stateCache = 0)
+	{
+		this->device = device;
+		this->context = context;
+		this->baseName = baseName;
+		this->stateCache = stateCache;
+		this->watcher = 0;
+		this->inputElements = 0;
+		this->inputElementCount = 0;
+
+		for (unsigned int i = 0; i < SHADER_VARIANT_COUNT; i++)
+		{
+			variants[i] = 0;
+			attempted[i] = false;
+		}
+	}
+
+	~ShaderVariantCache()
+	{
+		for (unsigned int i = 0; i < SHADER_VARIANT_COUNT; i++)
+			delete variants[i];
+	}
+
+	// Gets the shader for a feature mask, loading it on first use.
+	// Returns null if that permutation was never compiled.
+	ShaderType* Get(unsigned int features)
+	{
+		features &= (SHADER_VARIANT_COUNT - 1);
+
+		// Already loaded (or already found missing)?
+		if (attempted[features])
+			return variants[features];
+		attempted[features] = true;
+
+		// The default variant is the plain, un-suffixed shader file
+		std::wstring fileName = baseName;
+		if (features != SHADER_FEATURES_DEFAULT)
+		{
+			std::wostringstream suffix;
+			suffix << L"_" << std::uppercase << std::hex << std::setw(2) << std::setfill(L'0') << features;
+			fileName += suffix.str();
+		}
+		fileName += L".cso";
+
+		// The "working directory" differs between debugging in VS
+		// (the project directory) and running the .exe directly
+		// (the output directory), so check both paths
+		ShaderType* shader = new ShaderType(device, context);
+		shader->SetStateCache(stateCache);
+		ApplyInputElements(shader);
+		std::wstring paths[] = { L"Debug/" + fileName, fileName };
+		for (unsigned int p = 0; p < 2; p++)
+		{
+			if (!shader->LoadShaderFile(paths[p].c_str()))
+				continue;
+
+			variants[features] = shader;
+			files[features] = paths[p];
+			if (watcher)
+				watcher->WatchFile(paths[p], ASSET_SHADER);
+			return shader;
+		}
+
+		// No such permutation.  Substituting another one here would
+		// hide a missing build step, so say so and let the caller pick.
+		delete shader;
+		printf("Missing shader permutation %ls\n", fileName.c_str());
+		return 0;
+	}
+
+	// Vertex shaders only: every variant uses this input layout
+	// instead of one from reflection (see SimpleVertexShader)
+	void SetInputElements(const D3D11_INPUT_ELEMENT_DESC* elements, unsigned int count)
+	{
+		inputElements = elements;
+		inputElementCount = count;
+	}
+
+	// Same, with the layout of a DECLARE_VERTEX_FORMAT struct
+	template <typename VertexType> void SetVertexFormat()
+	{
+		SetInputElements(VertexFormat<VertexType>::Elements(), VertexFormat<VertexType>::ElementCount);
+	}
+
+	// Same, with a second stream in slot 1 (see VertexStreams)
+	template <typename VertexType, typename StreamType> void SetVertexFormat()
+	{
+		SetInputElements(VertexStreams<VertexType, StreamType>::Elements(), VertexStreams<VertexType, StreamType>::ElementCount);
+	}
+
+	// Reloads variants from this file as they're loaded
+	void WatchForChanges(AssetWatcher* assetWatcher)
+	{
+		watcher = assetWatcher;
+		for (unsigned int i = 0; i < SHADER_VARIANT_COUNT; i++)
+		{
+			if (variants[i])
+				watcher->WatchFile(files[i], ASSET_SHADER);
+		}
+	}
+
+	// Reloads the variant loaded from this file, in place, so every
+	// material using it picks up the change.  A scratch shader is
+	// loaded first, so a broken .cso leaves the old one running.
+	bool Reload(const std::wstring& path)
+	{
+		for (unsigned int i = 0; i < SHADER_VARIANT_COUNT; i++)
+		{
+			if (!variants[i] || files[i] != path)
+				continue;
+
+			ShaderType scratch(device, context);
+			ApplyInputElements(&scratch);
+			if (!scratch.LoadShaderFile(path.c_str()))
+				return false;
+
+			variants[i]->LoadShaderFile(path.c_str());
+
+			// Same shader object, different DirectX shader underneath
+			if (stateCache)
+				stateCache->InvalidateBoundState();
+			return true;
+		}
+		return false;
+	}
+
+private:
+	ID3D11Device* device;
+	ID3D11DeviceContext* context;
+	std::wstring baseName;
+	PipelineStateCache* stateCache;
+	AssetWatcher* watcher;
+
+	ShaderType* variants[SHADER_VARIANT_COUNT];
+	bool attempted[SHADER_VARIANT_COUNT];
+	std::wstring files[SHADER_VARIANT_COUNT];	// Where each loaded variant came from
+
+	const D3D11_INPUT_ELEMENT_DESC* inputElements;
+	unsigned int inputElementCount;
+
+	// Only vertex shaders take an input layout
+	void ApplyInputElements(SimpleVertexShader* shader)
+	{
+		if (inputElements)
+			shader->SetInputElements(inputElements, inputElementCount);
+	}
+	void ApplyInputElements(ISimpleShader*) {}
+};
@@ -1,4 +1,5 @@
 #include "SimpleShader.h"
+#include "PipelineStateCache.h"
 
 ///////////////////////////////////////////////////////////////////////////////
 // ------ BASE SIMPLE SHADER --------------------------------------------------
@@ -12,11 +13,15 @@ ISimpleShader::ISimpleShader(ID3D11Device* device, ID3D11DeviceContext* context)
 	// Save the device
 	this->device = device;
 	this->deviceContext = context;
+	this->stateCache = 0;
 
 	// Set up fields
 	constantBufferCount = 0;
 	constantBuffers = 0;
 	shaderBlob = 0;
+	shaderValid = false;
+	reflectionBlock = 0;
+	reflection = 0;
 }
 
 // --------------------------------------------------------
@@ -35,24 +40,28 @@ ISimpleShader::~ISimpleShader()
 // --------------------------------------------------------
 void ISimpleShader::CleanUp()
 {
-	// Handle constant buffers and local data buffers
+	// Handle constant buffers (their local data lives in the reflection block)
 	for (unsigned int i = 0; i < constantBufferCount; i++)
 	{
-		constantBuffers[i].ConstantBuffer->Release();
-		delete[] constantBuffers[i].LocalDataBuffer;
+		if (constantBuffers[i].ConstantBuffer)
+			constantBuffers[i].ConstantBuffer->Release();
 	}
 
 	if (constantBuffers)
 	{
 		delete[] constantBuffers;
+		constantBuffers = 0;
 		constantBufferCount = 0;
 	}
 
-	for (unsigned int i = 0; i < shaderResourceViews.size(); i++)
-		delete shaderResourceViews[i];
-	
-	for (unsigned int i = 0; i < samplerStates.size(); i++)
-		delete samplerStates[i];
+	// SRV and sampler info structs also live in the reflection block
+	if (reflectionBlock)
+	{
+		delete[] reflectionBlock;
+		reflectionBlock = 0;
+	}
+	shaderResourceViews.clear();
+	samplerStates.clear();
 
 	// Clean up tables
 	varTable.clear();
@@ -66,12 +75,23 @@ void ISimpleShader::CleanUp()
 // reflection.  This must be a separate step from the constructor since
 // we can't invoke derived class overrides in the base class constructor.
 //
+// Reflection results are cached in a sidecar file next to the shader
+// (see ShaderReflectionCache), so D3DReflect only runs the first time
+// a particular compiled blob is seen.
+//
 // shaderFile - A "wide string" specifying the compiled shader to load
 // 
 // Returns true if shader is loaded properly, false otherwise
 // --------------------------------------------------------
 bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 {
+	// Drop any previously loaded blob, in case we're reloading
+	if (shaderBlob)
+	{
+		shaderBlob->Release();
+		shaderBlob = 0;
+	}
+
 	// Load the shader to a blob and ensure it worked
 	HRESULT hr = D3DReadFileToBlob(shaderFile, &shaderBlob);
 	if (hr != S_OK)
@@ -79,86 +99,115 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 		return false;
 	}
 
+	// Try the cached reflection data first, and only fall back
+	// to actually reflecting the shader if it's missing or stale
+	unsigned int blobSize = (unsigned int)shaderBlob->GetBufferSize();
+	unsigned long long blobHash = ShaderReflectionCache::HashBlob(shaderBlob->GetBufferPointer(), blobSize);
+	std::wstring sidecar = ShaderReflectionCache::GetSidecarPath(shaderFile);
+
+	ShaderReflectionData data;
+	if (!ShaderReflectionCache::Load(sidecar.c_str(), blobHash, blobSize, &data))
+	{
+		if (!ShaderReflectionCache::Reflect(shaderBlob, &data))
+			return false;
+
+		ShaderReflectionCache::Save(sidecar.c_str(), blobHash, blobSize, data);
+	}
+
 	// Create the shader - Calls an overloaded version of this abstract
 	// method in the appropriate child class
+	reflection = &data;
 	shaderValid = CreateShader(shaderBlob);
+	reflection = 0;
 	if (!shaderValid)
 	{
 		return false;
 	}
 
-	// Set up shader reflection to get information about
-	// this shader and its variables,  buffers, etc.
-	ID3D11ShaderReflection* refl;
-	D3DReflect(
-		shaderBlob->GetBufferPointer(),
-		shaderBlob->GetBufferSize(),
-		IID_ID3D11ShaderReflection,
-		(void**)&refl);
-	
-	// Get the description of the shader
-	D3D11_SHADER_DESC shaderDesc;
-	refl->GetDesc(&shaderDesc);
+	// Set up our tables of variables, buffers and resources
+	BuildTables(data);
+	return true;
+}
+
+// --------------------------------------------------------
+// Builds the constant buffers and all of the lookup tables
+// from reflection data (fresh or cached).
+//
+// SRV info, sampler info and the local data for every
+// constant buffer are carved out of one allocation rather
+// than being allocated one by one.
+// --------------------------------------------------------
+void ISimpleShader::BuildTables(const ShaderReflectionData& data)
+{
+	// Count the resources we track
+	unsigned int srvCount = 0;
+	unsigned int samplerCount = 0;
+	for (unsigned int r = 0; r < data.Resources.size(); r++)
+	{
+		if (data.Resources[r].Type == D3D_SIT_TEXTURE) srvCount++;
+		else if (data.Resources[r].Type == D3D_SIT_SAMPLER) samplerCount++;
+	}
+
+	// Lay out the block: SRVs, samplers, then each constant
+	// buffer's local data on a 16-byte boundary
+	size_t srvBytes = sizeof(SimpleSRV) * srvCount;
+	size_t samplerBytes = sizeof(SimpleSampler) * samplerCount;
+	size_t blockSize = (srvBytes + samplerBytes + 15) & ~15;
+	for (unsigned int b = 0; b < data.ConstantBuffers.size(); b++)
+		blockSize += (data.ConstantBuffers[b].Size + 15) & ~15;
+
+	reflectionBlock = new unsigned char[blockSize];
+	ZeroMemory(reflectionBlock, blockSize);
+
+	SimpleSRV* srvs = (SimpleSRV*)reflectionBlock;
+	SimpleSampler* samplers = (SimpleSampler*)(reflectionBlock + srvBytes);
+	unsigned char* localData = reflectionBlock + ((srvBytes + samplerBytes + 15) & ~15);
 
-	// Create resource arrays
-	constantBufferCount = shaderDesc.ConstantBuffers;
-	constantBuffers = new SimpleConstantBuffer[constantBufferCount];
-	
 	// Handle bound resources (like shaders and samplers)
-	unsigned int resourceCount = shaderDesc.BoundResources;
-	for (unsigned int r = 0; r < resourceCount; r++)
+	shaderResourceViews.reserve(srvCount);
+	samplerStates.reserve(samplerCount);
+	for (unsigned int r = 0; r < data.Resources.size(); r++)
 	{
-		// Get this resource's description
-		D3D11_SHADER_INPUT_BIND_DESC resourceDesc;
-		refl->GetResourceBindingDesc(r, &resourceDesc);
+		const CachedShaderResource& resource = data.Resources[r];
 
 		// Check the type
-		switch (resourceDesc.Type)
+		switch (resource.Type)
 		{
 		case D3D_SIT_TEXTURE: // A texture resource
 		{
-			// Create the SRV wrapper
-			SimpleSRV* srv = new SimpleSRV();
-			srv->BindIndex = resourceDesc.BindPoint;	// Shader bind point
+			SimpleSRV* srv = &srvs[shaderResourceViews.size()];
+			srv->BindIndex = resource.BindIndex;		// Shader bind point
 			srv->Index = shaderResourceViews.size();	// Raw index
 
-			textureTable.insert(std::pair<std::string, SimpleSRV*>(resourceDesc.Name, srv));
+			textureTable.insert(std::pair<std::string, SimpleSRV*>(resource.Name, srv));
 			shaderResourceViews.push_back(srv);
 		}
 			break;
 
 		case D3D_SIT_SAMPLER: // A sampler resource
 		{
-			// Create the sampler wrapper
-			SimpleSampler* samp = new SimpleSampler();
-			samp->BindIndex = resourceDesc.BindPoint;	// Shader bind point
+			SimpleSampler* samp = &samplers[samplerStates.size()];
+			samp->BindIndex = resource.BindIndex;		// Shader bind point
 			samp->Index = samplerStates.size();			// Raw index
 
-			samplerTable.insert(std::pair<std::string, SimpleSampler*>(resourceDesc.Name, samp));
+			samplerTable.insert(std::pair<std::string, SimpleSampler*>(resource.Name, samp));
 			samplerStates.push_back(samp);
 		}
 			break;
 		}
 	}
 
+	// Create resource arrays
+	constantBufferCount = data.ConstantBuffers.size();
+	constantBuffers = new SimpleConstantBuffer[constantBufferCount];
+
 	// Loop through all constant buffers
 	for (unsigned int b = 0; b < constantBufferCount; b++)
 	{
-		// Get this buffer
-		ID3D11ShaderReflectionConstantBuffer* cb =
-			refl->GetConstantBufferByIndex(b);
-		
-		// Get the description of this buffer
-		D3D11_SHADER_BUFFER_DESC bufferDesc;
-		cb->GetDesc(&bufferDesc);
-		
-		// Get the description of the resource binding, so
-		// we know exactly how it's bound in the shader
-		D3D11_SHADER_INPUT_BIND_DESC bindDesc;
-		refl->GetResourceBindingDescByName(bufferDesc.Name, &bindDesc);
-		
+		const CachedConstantBuffer& bufferDesc = data.ConstantBuffers[b];
+
 		// Set up the buffer and put its pointer in the table
-		constantBuffers[b].BindIndex = bindDesc.BindPoint;
+		constantBuffers[b].BindIndex = bufferDesc.BindIndex;
 		constantBuffers[b].Name = bufferDesc.Name;
 		cbTable.insert(std::pair<std::string, SimpleConstantBuffer*>(bufferDesc.Name, &constantBuffers[b]));
 
@@ -170,42 +219,29 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 		newBuffDesc.CPUAccessFlags = 0;
 		newBuffDesc.MiscFlags = 0;
 		newBuffDesc.StructureByteStride = 0;
+		constantBuffers[b].ConstantBuffer = 0;
 		device->CreateBuffer(&newBuffDesc, 0, &constantBuffers[b].ConstantBuffer);
 
-		// Set up the data buffer for this constant buffer
+		// Point this buffer at its slice of the (already zeroed) block
 		constantBuffers[b].Size = bufferDesc.Size;
-		constantBuffers[b].LocalDataBuffer = new unsigned char[bufferDesc.Size];
-		ZeroMemory(constantBuffers[b].LocalDataBuffer, bufferDesc.Size);
+		constantBuffers[b].LocalDataBuffer = localData;
+		localData += (bufferDesc.Size + 15) & ~15;
 
 		// Loop through all variables in this buffer
-		for (unsigned int v = 0; v < bufferDesc.Variables; v++)
+		constantBuffers[b].Variables.reserve(bufferDesc.Variables.size());
+		for (unsigned int v = 0; v < bufferDesc.Variables.size(); v++)
 		{
-			// Get this variable
-			ID3D11ShaderReflectionVariable* var =
-				cb->GetVariableByIndex(v);
-			
-			// Get the description of the variable and its type
-			D3D11_SHADER_VARIABLE_DESC varDesc;
-			var->GetDesc(&varDesc);
-
 			// Create the variable struct
 			SimpleShaderVariable varStruct;
 			varStruct.ConstantBufferIndex = b;
-			varStruct.ByteOffset = varDesc.StartOffset;
-			varStruct.Size = varDesc.Size;
-			
-			// Get a string version
-			std::string varName(varDesc.Name);
+			varStruct.ByteOffset = bufferDesc.Variables[v].ByteOffset;
+			varStruct.Size = bufferDesc.Variables[v].Size;
 
 			// Add this variable to the table and the constant buffer
-			varTable.insert(std::pair<std::string, SimpleShaderVariable>(varName, varStruct));
+			varTable.insert(std::pair<std::string, SimpleShaderVariable>(bufferDesc.Variables[v].Name, varStruct));
 			constantBuffers[b].Variables.push_back(varStruct);
 		}
 	}
-
-	// All set
-	refl->Release();
-	return true;
 }
 
 // --------------------------------------------------------
@@ -446,6 +482,65 @@ bool ISimpleShader::SetMatrix4x4(std::string name, const DirectX::XMFLOAT4X4 dat
 	return this->SetData(name, &data, sizeof(float) * 16);
 }
 
+// --------------------------------------------------------
+// Copies an entire block of data into the start of a
+// constant buffer's local data buffer
+//
+// bufferName - The name of the constant buffer
+// data - The data to copy, laid out to match the cbuffer
+// size - The size of the data (can't be larger than the buffer)
+//
+// Returns true if data is copied, false if the buffer doesn't
+// exist or is too small
+// --------------------------------------------------------
+bool ISimpleShader::SetBufferData(std::string bufferName, const void* data, unsigned int size)
+{
+	// Look for the buffer and verify
+	SimpleConstantBuffer* cb = FindConstantBuffer(bufferName);
+	if (cb == 0 || size > cb->Size)
+		return false;
+
+	// Set the data in the local data buffer
+	memcpy(cb->LocalDataBuffer, data, size);
+
+	// Success
+	return true;
+}
+
+// --------------------------------------------------------
+// Verifies that a C++ constant buffer layout matches what
+// reflection says about the shader's cbuffer: every member
+// must exist in that buffer at the same offset and size.
+//
+// bufferName - The name of the constant buffer
+// members - The C++ struct's members
+// memberCount - Number of entries in members
+// size - sizeof() the C++ struct
+//
+// Returns true if the layouts match, false otherwise
+// --------------------------------------------------------
+bool ISimpleShader::ValidateBufferLayout(std::string bufferName, const HlslMemberInfo* members, unsigned int memberCount, unsigned int size)
+{
+	// Does the buffer exist and can it hold the struct?
+	SimpleConstantBuffer* cb = FindConstantBuffer(bufferName);
+	if (cb == 0 || size > cb->Size)
+		return false;
+
+	unsigned int cbIndex = (unsigned int)(cb - constantBuffers);
+	for (unsigned int i = 0; i < memberCount; i++)
+	{
+		SimpleShaderVariable* var = FindVariable(members[i].Name, -1);
+		if (var == 0 ||
+			var->ConstantBufferIndex != cbIndex ||
+			var->ByteOffset != members[i].ByteOffset ||
+			var->Size != members[i].Size)
+			return false;
+	}
+
+	// Everything lines up
+	return true;
+}
+
 // --------------------------------------------------------
 // Gets info about a shader variable, if it exists
 // --------------------------------------------------------
@@ -585,6 +680,8 @@ SimpleVertexShader::SimpleVertexShader(ID3D11Device* device, ID3D11DeviceContext
 	this->inputLayout = 0;
 	this->shader = 0;
 	this->perInstanceCompatible = false;
+	this->inputElements = 0;
+	this->inputElementCount = 0;
 }
 
 // --------------------------------------------------------
@@ -599,6 +696,8 @@ SimpleVertexShader::SimpleVertexShader(ID3D11Device * device, ID3D11DeviceContex
 	// Save the custom input layout
 	this->inputLayout = inputLayout;
 	this->shader = 0;
+	this->inputElements = 0;
+	this->inputElementCount = 0;
 
 	// Unable to determine from an input layout, require user to tell us
 	this->perInstanceCompatible = perInstanceCompatible;
@@ -651,85 +750,108 @@ bool SimpleVertexShader::CreateShader(ID3DBlob* shaderBlob)
 	if (inputLayout)
 		return true;
 
-	// Vertex shader was created successfully, so we now use the
-	// shader code to re-reflect and create an input layout that 
-	// matches what the vertex shader expects.  Code adapted from:
-	// https://takinginitiative.wordpress.com/2011/12/11/directx-1011-basic-shader-reflection-automatic-input-layout-creation/
-
-	// Reflect shader info
-	ID3D11ShaderReflection* refl;
-	D3DReflect(
-		shaderBlob->GetBufferPointer(),
-		shaderBlob->GetBufferSize(),
-		IID_ID3D11ShaderReflection,
-		(void**)&refl);
-	
-	// Get shader info
-	D3D11_SHADER_DESC shaderDesc;
-	refl->GetDesc(&shaderDesc);
-
-	// Read input layout description from shader info
+	// A layout given to SetInputElements() is used as is, since
+	// reflection can't tell packed formats (snorm, half) apart
 	std::vector<D3D11_INPUT_ELEMENT_DESC> inputLayoutDesc;
-	for (unsigned int i = 0; i< shaderDesc.InputParameters; i++)
+	if (inputElements)
 	{
-		D3D11_SIGNATURE_PARAMETER_DESC paramDesc;
-		refl->GetInputParameterDesc(i, &paramDesc);
-
-		// Check the semantic name for "_PER_INSTANCE"
-		std::string perInstanceStr = "_PER_INSTANCE";
-		std::string sem = paramDesc.SemanticName;
-		int lenDiff = sem.size() - perInstanceStr.size();
-		bool isPerInstance = 
-			lenDiff >= 0 &&
-			sem.compare(lenDiff, perInstanceStr.size(), perInstanceStr) == 0;
-
-		// Fill out input element desc
-		D3D11_INPUT_ELEMENT_DESC elementDesc;
-		elementDesc.SemanticName = paramDesc.SemanticName;
-		elementDesc.SemanticIndex = paramDesc.SemanticIndex;
-		elementDesc.InputSlot = 0;
-		elementDesc.AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
-		elementDesc.InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-		elementDesc.InstanceDataStepRate = 0;
-
-		// Replace anything affected by "per instance" data
-		if (isPerInstance)
-		{
-			elementDesc.InputSlot = 1; // Assume per instance data comes from another input slot!
-			elementDesc.InputSlotClass = D3D11_INPUT_PER_INSTANCE_DATA;
-			elementDesc.InstanceDataStepRate = 1;
+		inputLayoutDesc.assign(inputElements, inputElements + inputElementCount);
+	}
+	else
+	{
+		// Vertex shader was created successfully, so we now use the
+		// shader code to re-reflect and create an input layout that 
+		// matches what the vertex shader expects.  Code adapted from:
+		// https://takinginitiative.wordpress.com/2011/12/11/directx-1011-basic-shader-reflection-automatic-input-layout-creation/
 
-			perInstanceCompatible = true;
-		}
+		// The input signature comes from the reflection data gathered
+		// (or read from the cache) in LoadShaderFile()
+		const std::vector<CachedInputParameter>& inputParams = reflection->InputParameters;
 
-		// Determine DXGI format
-		if (paramDesc.Mask == 1)
+		for (unsigned int i = 0; i < inputParams.size(); i++)
 		{
-			if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_UINT32) elementDesc.Format = DXGI_FORMAT_R32_UINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_SINT32) elementDesc.Format = DXGI_FORMAT_R32_SINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_FLOAT32) elementDesc.Format = DXGI_FORMAT_R32_FLOAT;
-		}
-		else if (paramDesc.Mask <= 3)
-		{
-			if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_UINT32) elementDesc.Format = DXGI_FORMAT_R32G32_UINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_SINT32) elementDesc.Format = DXGI_FORMAT_R32G32_SINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_FLOAT32) elementDesc.Format = DXGI_FORMAT_R32G32_FLOAT;
-		}
-		else if (paramDesc.Mask <= 7)
-		{
-			if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_UINT32) elementDesc.Format = DXGI_FORMAT_R32G32B32_UINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_SINT32) elementDesc.Format = DXGI_FORMAT_R32G32B32_SINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_FLOAT32) elementDesc.Format = DXGI_FORMAT_R32G32B32_FLOAT;
-		}
-		else if (paramDesc.Mask <= 15)
-		{
-			if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_UINT32) elementDesc.Format = DXGI_FORMAT_R32G32B32A32_UINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_SINT32) elementDesc.Format = DXGI_FORMAT_R32G32B32A32_SINT;
-			else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_FLOAT32) elementDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+			const CachedInputParameter& paramDesc = inputParams[i];
+
+			// System values (SV_VertexID, etc.) are generated by the
+			// input assembler rather than read from a buffer
+			if (paramDesc.SemanticName.compare(0, 3, "SV_") == 0)
+				continue;
+
+			// Check the semantic name for "_PER_INSTANCE"
+			std::string perInstanceStr = "_PER_INSTANCE";
+			std::string sem = paramDesc.SemanticName;
+			int lenDiff = sem.size() - perInstanceStr.size();
+			bool isPerInstance = 
+				lenDiff >= 0 &&
+				sem.compare(lenDiff, perInstanceStr.size(), perInstanceStr) == 0;
+
+			// Fill out input element desc
+			D3D11_INPUT_ELEMENT_DESC elementDesc;
+			elementDesc.SemanticName = paramDesc.SemanticName.c_str();
+			elementDesc.SemanticIndex = paramDesc.SemanticIndex;
+			elementDesc.InputSlot = 0;
+			elementDesc.AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
+			elementDesc.InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+			elementDesc.InstanceDataStepRate = 0;
+
+			// Replace anything affected by "per instance" data
+			if (isPerInstance)
+			{
+				elementDesc.InputSlot = 1; // Assume per instance data comes from another input slot!
+				elementDesc.InputSlotClass = D3D11_INPUT_PER_INSTANCE_DATA;
+				elementDesc.InstanceDataStepRate = 1;
+
+				perInstanceCompatible = true;
+			}
+
+			// Determine DXGI format
+			if (paramDesc.Mask == 1)
+			{
+				if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_UINT32) elementDesc.Format = DXGI_FORMAT_R32_UINT;
+				else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_SINT32) elementDesc.Format = DXGI_FORMAT_R32_SINT;
+				else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_FLOAT32) elementDesc.Format = DXGI_FORMAT_R32_FLOAT;
+			}
+			else if (paramDesc.Mask <= 3)
+			{
+				if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_UINT32) elementDesc.Format = DXGI_FORMAT_R32G32_UINT;
+				else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_SINT32) elementDesc.Format = DXGI_FORMAT_R32G32_SINT;
+				else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_FLOAT32) elementDesc.Format = DXGI_FORMAT_R32G32_FLOAT;
+			}
+			else if (paramDesc.Mask <= 7)
+			{
+				if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_UINT32) elementDesc.Format = DXGI_FORMAT_R32G32B32_UINT;
+				else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_SINT32) elementDesc.Format = DXGI_FORMAT_R32G32B32_SINT;
+				else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_FLOAT32) elementDesc.Format = DXGI_FORMAT_R32G32B32_FLOAT;
+			}
+			else if (paramDesc.Mask <= 15)
+			{
+				if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_UINT32) elementDesc.Format = DXGI_FORMAT_R32G32B32A32_UINT;
+				else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_SINT32) elementDesc.Format = DXGI_FORMAT_R32G32B32A32_SINT;
+				else if (paramDesc.ComponentType == D3D_REGISTER_COMPONENT_FLOAT32) elementDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+			}
+
+			// Save element desc
+			inputLayoutDesc.push_back(elementDesc);
 		}
+	}
 
-		// Save element desc
-		inputLayoutDesc.push_back(elementDesc);
+	// Nothing to read from a buffer (a full screen pass that makes
+	// its own verticies, say) - no layout needed at all
+	if (inputLayoutDesc.empty())
+		return true;
+
+	// Shaders with the same signature share one layout from the
+	// cache.  We hold our own reference so CleanUp() works either way.
+	if (stateCache)
+	{
+		inputLayout = stateCache->GetInputLayout(
+			&inputLayoutDesc[0],
+			inputLayoutDesc.size(),
+			shaderBlob->GetBufferPointer(),
+			shaderBlob->GetBufferSize());
+		if (inputLayout)
+			inputLayout->AddRef();
+		return true;
 	}
 
 	// Try to create Input Layout
@@ -740,8 +862,7 @@ bool SimpleVertexShader::CreateShader(ID3DBlob* shaderBlob)
 		shaderBlob->GetBufferSize(),
 		&inputLayout);
 
-	// All done, clean up
-	refl->Release();
+	// All done
 	return true;
 }
 
@@ -1497,31 +1618,16 @@ bool SimpleComputeShader::CreateShader(ID3DBlob* shaderBlob)
 	if (result != S_OK)
 		return false;
 
-	// Set up shader reflection to get information about UAV's
-	ID3D11ShaderReflection* refl;
-	D3DReflect(
-		shaderBlob->GetBufferPointer(),
-		shaderBlob->GetBufferSize(),
-		IID_ID3D11ShaderReflection,
-		(void**)&refl);
-
-	// Get the description of the shader
-	D3D11_SHADER_DESC shaderDesc;
-	refl->GetDesc(&shaderDesc);
-	
-	// Grab the thread info
-	threadsTotal = refl->GetThreadGroupSize(
-		&threadsX,
-		&threadsY,
-		&threadsZ);
+	// Grab the thread info from the reflection data
+	threadsX = reflection->ThreadGroupSize[0];
+	threadsY = reflection->ThreadGroupSize[1];
+	threadsZ = reflection->ThreadGroupSize[2];
+	threadsTotal = threadsX * threadsY * threadsZ;
 
 	// Loop and get all UAV resources
-	unsigned int resourceCount = shaderDesc.BoundResources;
-	for (unsigned int r = 0; r < resourceCount; r++)
+	for (unsigned int r = 0; r < reflection->Resources.size(); r++)
 	{
-		// Get this resource's description
-		D3D11_SHADER_INPUT_BIND_DESC resourceDesc;
-		refl->GetResourceBindingDesc(r, &resourceDesc);
+		const CachedShaderResource& resourceDesc = reflection->Resources[r];
 
 		// Check the type, looking for any kind of UAV
 		switch (resourceDesc.Type)
@@ -1532,12 +1638,11 @@ bool SimpleComputeShader::CreateShader(ID3DBlob* shaderBlob)
 		case D3D_SIT_UAV_RWSTRUCTURED:
 		case D3D_SIT_UAV_RWSTRUCTURED_WITH_COUNTER:
 		case D3D_SIT_UAV_RWTYPED:
-			uavTable.insert(std::pair<std::string, unsigned int>(resourceDesc.Name, resourceDesc.BindPoint));
+			uavTable.insert(std::pair<std::string, unsigned int>(resourceDesc.Name, resourceDesc.BindIndex));
 		}
 	}
 
 	// All set
-	refl->Release();
 	return true;
 }
 
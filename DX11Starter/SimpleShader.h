@@ -10,6 +10,11 @@
 #include <vector>
 #include <string>
 
+#include "ShaderReflectionCache.h"
+#include "ConstantBufferLayout.h"
+
+class PipelineStateCache;
+
 // --------------------------------------------------------
 // Used by simple shaders to store information about
 // specific variables in constant buffers
@@ -90,6 +95,23 @@ public:
 	bool SetMatrix4x4(std::string name, const float data[16]);
 	bool SetMatrix4x4(std::string name, const DirectX::XMFLOAT4X4 data);
 
+	// Copies a whole typed struct (see ConstantBufferLayout.h) into
+	// its constant buffer in one go, instead of variable by variable
+	template <typename T> bool SetBufferData(const T& data)
+	{
+		return SetBufferData(ConstantBufferLayout<T>::BufferName(), &data, sizeof(T));
+	}
+	bool SetBufferData(std::string bufferName, const void* data, unsigned int size);
+
+	// Checks a typed struct's layout against this shader's reflection data
+	template <typename T> bool ValidateBufferLayout()
+	{
+		unsigned int count = 0;
+		const HlslMemberInfo* members = ConstantBufferLayout<T>::Members(&count);
+		return ValidateBufferLayout(ConstantBufferLayout<T>::BufferName(), members, count, sizeof(T));
+	}
+	bool ValidateBufferLayout(std::string bufferName, const HlslMemberInfo* members, unsigned int memberCount, unsigned int size);
+
 	// Setting shader resources
 	virtual bool SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv) = 0;
 	virtual bool SetSamplerState(std::string name, ID3D11SamplerState* samplerState) = 0;
@@ -114,16 +136,29 @@ public:
 	// Misc getters
 	ID3DBlob* GetShaderBlob() { return shaderBlob; }
 
+	// Shares state objects (like input layouts) with other shaders.
+	// Must be set before LoadShaderFile() to have any effect.
+	void SetStateCache(PipelineStateCache* cache) { stateCache = cache; }
+
 protected:
 	
 	bool shaderValid;
 	ID3DBlob* shaderBlob;
 	ID3D11Device* device;
 	ID3D11DeviceContext* deviceContext;
+	PipelineStateCache* stateCache;
 
 	// Resource counts
 	unsigned int constantBufferCount;
 	
+	// Single allocation holding every SRV and sampler info
+	// struct plus the local data for all constant buffers
+	unsigned char* reflectionBlock;
+
+	// Reflection results for the shader currently being loaded
+	// (only valid while inside LoadShaderFile)
+	const ShaderReflectionData* reflection;
+
 	// Maps for variables and buffers
 	SimpleConstantBuffer*		constantBuffers; // For index-based lookup
 	std::vector<SimpleSRV*>		shaderResourceViews;
@@ -139,6 +174,9 @@ protected:
 
 	virtual void CleanUp();
 
+	// Builds all lookup tables from reflection data
+	void BuildTables(const ShaderReflectionData& data);
+
 	// Helpers for finding data by name
 	SimpleShaderVariable* FindVariable(std::string name, int size);
 	SimpleConstantBuffer* FindConstantBuffer(std::string name);
@@ -160,9 +198,16 @@ public:
 	bool SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv);
 	bool SetSamplerState(std::string name, ID3D11SamplerState* samplerState);
 
+	// Uses this layout instead of one built from reflection.  The
+	// array isn't copied, so it must outlive the shader, and it must
+	// be set before LoadShaderFile() to have any effect.
+	void SetInputElements(const D3D11_INPUT_ELEMENT_DESC* elements, unsigned int count) { inputElements = elements; inputElementCount = count; }
+
 protected:
 	bool perInstanceCompatible;
 	ID3D11InputLayout* inputLayout;
+	const D3D11_INPUT_ELEMENT_DESC* inputElements;
+	unsigned int inputElementCount;
 	ID3D11VertexShader* shader;
 	bool CreateShader(ID3DBlob* shaderBlob);
 	void SetShaderAndCBs();
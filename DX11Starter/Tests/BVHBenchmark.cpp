@@ -0,0 +1,126 @@
+#include "BVH.h"
+#include "BenchmarkMeshes.h"
+#include <chrono>
+#include <cstdlib>
+#include <random>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Times TriangleBVH builds and ray queries, in rays per
+// second, on the bundled meshes and synthetic meshes of up
+// to millions of triangles.
+//
+// Two kinds of ray: "camera" rays from outside aimed at the
+// mesh (coherent, and most hit), and "random" rays between
+// two random points in the bounds (incoherent, like bake
+// or gameplay rays).
+//
+//   BVHBenchmark [rays per test] [largest synthetic triangle count]
+// --------------------------------------------------------
+
+static double Seconds(std::chrono::high_resolution_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// Closest-hit and any-hit throughput for one set of rays
+static void TimeRays(const TriangleBVH& bvh, const std::vector<Ray>& rays, double* closestMrays, double* anyMrays, double* hitRate)
+{
+	unsigned int hits = 0;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (unsigned int i = 0; i < rays.size(); i++)
+	{
+		RayHit hit;
+		if (bvh.IntersectClosest(rays[i], &hit))
+			hits++;
+	}
+	*closestMrays = rays.size() / Seconds(start) / 1e6;
+	*hitRate = 100.0 * hits / rays.size();
+
+	unsigned int anyHits = 0;
+	start = std::chrono::high_resolution_clock::now();
+	for (unsigned int i = 0; i < rays.size(); i++)
+	{
+		if (bvh.IntersectAny(rays[i]))
+			anyHits++;
+	}
+	*anyMrays = rays.size() / Seconds(start) / 1e6;
+
+	// Any-hit must agree with closest-hit about whether there was a hit
+	if (anyHits != hits)
+		printf("Any-hit found %u hits, closest-hit %u\n", anyHits, hits);
+}
+
+static void Run(const BenchmarkMesh& mesh, unsigned int rayCount)
+{
+	unsigned int triangles = (unsigned int)mesh.Indices.size() / 3;
+
+	TriangleBVH bvh;
+	auto start = std::chrono::high_resolution_clock::now();
+	bvh.Build(&mesh.Vertices[0], (unsigned int)mesh.Vertices.size(), &mesh.Indices[0], (unsigned int)mesh.Indices.size());
+	double buildSeconds = Seconds(start);
+
+	XMFLOAT3 boundsMin, boundsMax;
+	bvh.GetBounds(&boundsMin, &boundsMax);
+	XMVECTOR low = XMLoadFloat3(&boundsMin);
+	XMVECTOR high = XMLoadFloat3(&boundsMax);
+	XMVECTOR center = XMVectorScale(XMVectorAdd(low, high), 0.5f);
+	float size = XMVectorGetX(XMVector3Length(XMVectorSubtract(high, low)));
+
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	auto randomInBounds = [&]()
+	{
+		return XMVectorAdd(low, XMVectorMultiply(XMVectorSubtract(high, low), XMVectorSet(unit(random), unit(random), unit(random), 0.0f)));
+	};
+
+	// Camera rays: from a point on a sphere around the mesh
+	// towards a random point inside it
+	std::vector<Ray> cameraRays(rayCount);
+	for (unsigned int i = 0; i < rayCount; i++)
+	{
+		float z = unit(random) * 2.0f - 1.0f;
+		float angle = unit(random) * 6.2831853f;
+		float r = std::sqrt(1.0f - z * z);
+		XMVECTOR origin = XMVectorAdd(center, XMVectorScale(XMVectorSet(r * std::cos(angle), z, r * std::sin(angle), 0.0f), size));
+		XMStoreFloat3(&cameraRays[i].Origin, origin);
+		XMStoreFloat3(&cameraRays[i].Direction, XMVector3Normalize(XMVectorSubtract(randomInBounds(), origin)));
+		cameraRays[i].MaxDistance = size * 2.0f;
+	}
+
+	// Random rays: segment between two points inside the bounds
+	std::vector<Ray> randomRays(rayCount);
+	for (unsigned int i = 0; i < rayCount; i++)
+	{
+		XMVECTOR from = randomInBounds();
+		XMVECTOR to = randomInBounds();
+		XMStoreFloat3(&randomRays[i].Origin, from);
+		XMStoreFloat3(&randomRays[i].Direction, XMVector3Normalize(XMVectorSubtract(to, from)));
+		randomRays[i].MaxDistance = XMVectorGetX(XMVector3Length(XMVectorSubtract(to, from)));
+	}
+
+	double cameraClosest, cameraAny, cameraHits, randomClosest, randomAny, randomHits;
+	TimeRays(bvh, cameraRays, &cameraClosest, &cameraAny, &cameraHits);
+	TimeRays(bvh, randomRays, &randomClosest, &randomAny, &randomHits);
+
+	printf("%-16s %9u tris  build %9.2f ms  camera: closest %6.2f any %6.2f Mrays/s (%3.0f%% hit)  random: closest %6.2f any %6.2f Mrays/s (%3.0f%% hit)\n",
+		mesh.Name.c_str(), triangles, buildSeconds * 1e3,
+		cameraClosest, cameraAny, cameraHits,
+		randomClosest, randomAny, randomHits);
+}
+
+int main(int argc, char** argv)
+{
+	unsigned int rayCount = argc > 1 ? (unsigned int)atoi(argv[1]) : 500000;
+	unsigned int largest = argc > 2 ? (unsigned int)atoi(argv[2]) : 4000000;
+
+	std::vector<BenchmarkMesh> meshes = LoadBundledMeshes();
+	for (unsigned int i = 0; i < meshes.size(); i++)
+		Run(meshes[i], rayCount);
+
+	for (unsigned int triangles = 250000; triangles <= largest; triangles *= 4)
+		Run(MakeSyntheticMesh(triangles), rayCount);
+
+	return 0;
+}
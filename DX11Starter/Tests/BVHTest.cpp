@@ -0,0 +1,144 @@
+#include "BVH.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// A row of triangles facing down the x axis, one standing
+// at each of the given x positions.  A ray along the row
+// passes through every node's box, so traversal has to
+// hold a far sibling for each level it goes down.
+// --------------------------------------------------------
+struct TestMesh
+{
+	std::vector<Vertex> Vertices;
+	std::vector<int> Indices;
+};
+
+static TestMesh MakeRow(const std::vector<float>& centers)
+{
+	TestMesh mesh;
+	for (unsigned int i = 0; i < centers.size(); i++)
+	{
+		float x = centers[i];
+		Vertex corners[3] = {};
+		corners[0].Position = XMFLOAT3(x, -1.0f, -1.0f);
+		corners[1].Position = XMFLOAT3(x, 1.0f, -1.0f);
+		corners[2].Position = XMFLOAT3(x, 0.0f, 1.0f);
+		for (unsigned int k = 0; k < 3; k++)
+		{
+			mesh.Indices.push_back((int)mesh.Vertices.size());
+			mesh.Vertices.push_back(corners[k]);
+		}
+	}
+	return mesh;
+}
+
+static Ray RayAlongRow(float x, float direction)
+{
+	Ray ray;
+	ray.Origin = XMFLOAT3(x, 0.0f, 0.0f);
+	ray.Direction = XMFLOAT3(direction, 0.0f, 0.0f);
+	ray.MaxDistance = FLT_MAX;
+	return ray;
+}
+
+static bool HitsFirst(const TriangleBVH& bvh, const Ray& ray, unsigned int triangle, float distance)
+{
+	RayHit hit;
+	if (!bvh.IntersectClosest(ray, &hit) || !bvh.IntersectAny(ray))
+		return false;
+	return hit.Triangle == triangle * 3 && std::fabs(hit.Distance - distance) <= 1e-4f * (std::max)(distance, 1.0f);
+}
+
+// Starting halfway between each triangle and the one before
+// it (from either end), the ray finds that triangle first
+static void CheckRow(const std::vector<float>& centers)
+{
+	TestMesh mesh = MakeRow(centers);
+	TriangleBVH bvh;
+	CHECK(bvh.Build(&mesh.Vertices[0], (unsigned int)mesh.Vertices.size(), &mesh.Indices[0], (unsigned int)mesh.Indices.size()));
+
+	std::vector<float> sorted(centers);
+	std::sort(sorted.begin(), sorted.end());
+
+	unsigned int forward = 0, backward = 0;
+	for (unsigned int i = 0; i < centers.size(); i++)
+	{
+		float x = centers[i];
+		unsigned int rank = (unsigned int)(std::lower_bound(sorted.begin(), sorted.end(), x) - sorted.begin());
+		float before = rank > 0 ? sorted[rank - 1] : x - 1.0f;
+		float after = rank + 1 < sorted.size() ? sorted[rank + 1] : x + 1.0f;
+
+		float start = before + (x - before) * 0.5f;
+		if (HitsFirst(bvh, RayAlongRow(start, 1.0f), i, x - start))
+			forward++;
+		start = after - (after - x) * 0.5f;
+		if (HitsFirst(bvh, RayAlongRow(start, -1.0f), i, start - x))
+			backward++;
+	}
+	CHECK(forward == centers.size());
+	CHECK(backward == centers.size());
+
+	// Off to the side of the whole row
+	RayHit hit;
+	Ray miss = RayAlongRow(sorted[0] - 1.0f, 1.0f);
+	miss.Origin.y = 5.0f;
+	CHECK(!bvh.IntersectClosest(miss, &hit));
+	CHECK(!bvh.IntersectAny(miss));
+}
+
+// Evenly spaced: an ordinary, balanced tree
+static void TestEven()
+{
+	std::vector<float> centers;
+	for (unsigned int i = 0; i < 1000; i++)
+		centers.push_back(i * 1.0f);
+	CheckRow(centers);
+}
+
+// Each triangle a fifth again as far out as the last.  Binned
+// SAH splits off only the outermost one or two each level, so
+// left to itself the tree would go far deeper than the
+// traversal stack - nothing may be lost to that.
+static void TestDegenerate()
+{
+	std::vector<float> centers;
+	float x = 1.0f;
+	for (unsigned int i = 0; i < 200; i++)
+	{
+		centers.push_back(x);
+		x *= 1.2f;
+	}
+	CheckRow(centers);
+
+	// And mirrored, so the deep side is on the right
+	for (unsigned int i = 0; i < centers.size(); i++)
+		centers[i] = -centers[i];
+	CheckRow(centers);
+}
+
+// All in one spot: no split separates them
+static void TestCoincident()
+{
+	TestMesh mesh = MakeRow(std::vector<float>(500, 3.0f));
+	TriangleBVH bvh;
+	CHECK(bvh.Build(&mesh.Vertices[0], (unsigned int)mesh.Vertices.size(), &mesh.Indices[0], (unsigned int)mesh.Indices.size()));
+
+	RayHit hit;
+	CHECK(bvh.IntersectClosest(RayAlongRow(0.0f, 1.0f), &hit));
+	CHECK_NEAR(hit.Distance, 3.0f, 1e-4f);
+	CHECK(bvh.IntersectAny(RayAlongRow(6.0f, -1.0f)));
+}
+
+int main()
+{
+	TestEven();
+	TestDegenerate();
+	TestCoincident();
+	return TestResult();
+}
@@ -0,0 +1,90 @@
+#include "BVH.h"
+#include "OcclusionBaker.h"
+#include "ThreadPool.h"
+#include "BenchmarkMeshes.h"
+#include <cstdlib>
+#include <cstring>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Times vertex occlusion bakes, in rays per second, on the
+// bundled meshes and a large synthetic one, at 1, 2, 4 ...
+// up to 64 threads (the caller plus a pool of workers), and
+// how that scales against the single thread.
+//
+// Bakes are meant to come out the same on any number of
+// threads, so every result is also compared against the
+// single threaded one.  Thread counts past the machine's
+// core count only show the cost of oversubscribing it.
+//
+//   BakeBenchmark [rays per vertex] [synthetic triangle count] [most threads]
+// --------------------------------------------------------
+
+// False if a bake failed, or came out different on more threads
+static bool Run(const BenchmarkMesh& mesh, unsigned int raysPerVertex, unsigned int mostThreads)
+{
+	unsigned int vertexCount = (unsigned int)mesh.Vertices.size();
+
+	TriangleBVH bvh;
+	bvh.Build(&mesh.Vertices[0], vertexCount, &mesh.Indices[0], (unsigned int)mesh.Indices.size());
+
+	// Same settings Mesh::BakeOcclusion() uses
+	XMFLOAT3 boundsMin, boundsMax;
+	bvh.GetBounds(&boundsMin, &boundsMax);
+	float size = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&boundsMax), XMLoadFloat3(&boundsMin))));
+
+	OcclusionBakeSettings settings;
+	settings.RaysPerVertex = raysPerVertex;
+	settings.MaxDistance = size * 0.5f;
+	settings.Bias = size * 0.001f;
+
+	std::vector<OcclusionVertex> reference(vertexCount);
+	std::vector<OcclusionVertex> occlusion(vertexCount);
+	double singleRate = 0.0;
+	bool allSame = true;
+
+	printf("%s: %u verticies, %u triangles\n", mesh.Name.c_str(), vertexCount, (unsigned int)mesh.Indices.size() / 3);
+	for (unsigned int threads = 1; threads <= mostThreads; threads *= 2)
+	{
+		ThreadPool pool(threads - 1);
+		OcclusionBakeStats stats;
+		if (!BakeVertexOcclusion(bvh, &mesh.Vertices[0], vertexCount, settings, &pool, &occlusion[0], &stats))
+		{
+			printf("  Bake failed\n");
+			return false;
+		}
+
+		double rate = stats.Seconds > 0.0 ? stats.Rays / stats.Seconds / 1e6 : 0.0;
+		if (threads == 1)
+		{
+			singleRate = rate;
+			reference = occlusion;
+		}
+
+		bool same = memcmp(&reference[0], &occlusion[0], vertexCount * sizeof(OcclusionVertex)) == 0;
+		allSame = allSame && same;
+		printf("  %2u threads: %12llu rays in %9.2f ms  %8.3f Mrays/s  %5.2fx%s\n",
+			stats.Threads, stats.Rays, stats.Seconds * 1e3, rate,
+			singleRate > 0.0 ? rate / singleRate : 0.0,
+			same ? "" : "  (differs from 1 thread!)");
+	}
+	return allSame;
+}
+
+int main(int argc, char** argv)
+{
+	unsigned int raysPerVertex = argc > 1 ? (unsigned int)atoi(argv[1]) : 64;
+	unsigned int synthetic = argc > 2 ? (unsigned int)atoi(argv[2]) : 100000;
+	unsigned int mostThreads = argc > 3 ? (unsigned int)atoi(argv[3]) : 64;
+
+	bool passed = true;
+	std::vector<BenchmarkMesh> meshes = LoadBundledMeshes();
+	for (unsigned int i = 0; i < meshes.size(); i++)
+		passed &= Run(meshes[i], raysPerVertex, mostThreads);
+
+	if (synthetic > 0)
+		passed &= Run(MakeSyntheticMesh(synthetic), raysPerVertex, mostThreads);
+
+	return passed ? 0 : 1;
+}
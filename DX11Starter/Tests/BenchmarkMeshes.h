@@ -0,0 +1,151 @@
+#pragma once
+
+#include "Vertex.h"
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// --------------------------------------------------------
+// Meshes for the geometry benchmarks: the bundled models,
+// and synthetic ones as big as needed.
+// --------------------------------------------------------
+
+struct BenchmarkMesh
+{
+	std::string Name;
+	std::vector<Vertex> Vertices;
+	std::vector<int> Indices;
+};
+
+// Reads a bundled OBJ the way Mesh::LoadOBJ does (shared corners
+// become one vertex, same handedness flip), without needing a
+// GeometryPool
+inline bool LoadBenchmarkOBJ(const std::string& name, BenchmarkMesh* mesh)
+{
+	FILE* file = fopen((std::string(BENCHMARK_MODEL_DIR) + name).c_str(), "r");
+	if (!file)
+		return false;
+
+	std::vector<XMFLOAT3> positions, normals;
+	std::vector<XMFLOAT2> uvs;
+	std::unordered_map<unsigned long long, int> corners;
+	mesh->Name = name;
+	mesh->Vertices.clear();
+	mesh->Indices.clear();
+
+	char line[256];
+	while (fgets(line, sizeof(line), file))
+	{
+		XMFLOAT3 v;
+		XMFLOAT2 t;
+		unsigned int i[12];
+		if (sscanf(line, "vn %f %f %f", &v.x, &v.y, &v.z) == 3) normals.push_back(v);
+		else if (sscanf(line, "vt %f %f", &t.x, &t.y) == 2) uvs.push_back(t);
+		else if (sscanf(line, "v %f %f %f", &v.x, &v.y, &v.z) == 3) positions.push_back(v);
+		else if (line[0] == 'f')
+		{
+			int read = sscanf(line, "f %u/%u/%u %u/%u/%u %u/%u/%u %u/%u/%u",
+				&i[0], &i[1], &i[2], &i[3], &i[4], &i[5], &i[6], &i[7], &i[8], &i[9], &i[10], &i[11]);
+			if (read != 9 && read != 12)
+				continue;
+
+			int c[4];
+			for (int k = 0; k < read / 3; k++)
+			{
+				unsigned long long key = ((unsigned long long)i[k * 3] << 42) | ((unsigned long long)i[k * 3 + 1] << 21) | i[k * 3 + 2];
+				auto found = corners.find(key);
+				if (found != corners.end()) { c[k] = found->second; continue; }
+
+				Vertex vertex;
+				vertex.Position = positions[i[k * 3] - 1];
+				vertex.UV = uvs[i[k * 3 + 1] - 1];
+				vertex.Normal = normals[i[k * 3 + 2] - 1];
+				vertex.Position.z *= -1.0f;
+				vertex.Normal.z *= -1.0f;
+				vertex.UV.y = 1.0f - vertex.UV.y;
+				c[k] = (int)mesh->Vertices.size();
+				corners[key] = c[k];
+				mesh->Vertices.push_back(vertex);
+			}
+
+			int triangle[] = { c[0], c[2], c[1] };
+			mesh->Indices.insert(mesh->Indices.end(), triangle, triangle + 3);
+			if (read == 12)
+			{
+				int quad[] = { c[0], c[3], c[2] };
+				mesh->Indices.insert(mesh->Indices.end(), quad, quad + 3);
+			}
+		}
+	}
+	fclose(file);
+	return !mesh->Indices.empty();
+}
+
+inline std::vector<BenchmarkMesh> LoadBundledMeshes()
+{
+	const char* names[] = { "cube.obj", "cone.obj", "cylinder.obj", "sphere.obj", "torus.obj", "helix.obj" };
+	std::vector<BenchmarkMesh> meshes;
+	for (unsigned int i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+	{
+		BenchmarkMesh mesh;
+		if (LoadBenchmarkOBJ(names[i], &mesh))
+			meshes.push_back(mesh);
+		else
+			printf("Couldn't load %s\n", names[i]);
+	}
+	return meshes;
+}
+
+// A closed, lumpy sphere of roughly triangleCount triangles, in
+// a unit-ish radius.  The lumps give it concave areas, so it
+// has self occlusion and clusters facing every way.
+inline BenchmarkMesh MakeSyntheticMesh(unsigned int triangleCount)
+{
+	unsigned int rings = (unsigned int)std::sqrt(triangleCount / 4.0) + 2;
+	unsigned int segments = rings * 2;
+
+	BenchmarkMesh mesh;
+	char name[64];
+	snprintf(name, sizeof(name), "synthetic %.1fM", (rings - 1) * segments * 2 / 1e6);
+	mesh.Name = name;
+
+	for (unsigned int r = 0; r <= rings; r++)
+	{
+		float theta = 3.14159265f * r / rings;
+		for (unsigned int s = 0; s <= segments; s++)
+		{
+			float phi = 6.28318531f * s / segments;
+			XMFLOAT3 direction(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+			float radius = 1.0f + 0.15f * std::sin(7.0f * phi) * std::sin(5.0f * theta);
+
+			Vertex vertex;
+			vertex.Position = XMFLOAT3(direction.x * radius, direction.y * radius, direction.z * radius);
+			vertex.Normal = direction;
+			vertex.UV = XMFLOAT2((float)s / segments, (float)r / rings);
+			mesh.Vertices.push_back(vertex);
+		}
+	}
+
+	// Clockwise from outside, like the converted OBJs
+	for (unsigned int r = 0; r < rings; r++)
+	{
+		for (unsigned int s = 0; s < segments; s++)
+		{
+			int a = r * (segments + 1) + s;
+			int b = a + segments + 1;
+			if (r > 0)
+			{
+				int triangle[] = { a, a + 1, b };
+				mesh.Indices.insert(mesh.Indices.end(), triangle, triangle + 3);
+			}
+			if (r < rings - 1)
+			{
+				int triangle[] = { a + 1, b + 1, b };
+				mesh.Indices.insert(mesh.Indices.end(), triangle, triangle + 3);
+			}
+		}
+	}
+	return mesh;
+}
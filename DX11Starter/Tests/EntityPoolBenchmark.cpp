@@ -0,0 +1,137 @@
+#include "EntityStorage.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+
+// --------------------------------------------------------
+// Spawns and despawns a million entities in EntityStorage,
+// and in the vector of individually new'd entities Game
+// used before it, counting heap allocations for each.
+//
+//   EntityPoolBenchmark [entities] [rounds]
+// --------------------------------------------------------
+
+static unsigned long long allocations = 0;
+
+void* operator new(size_t size)
+{
+	allocations++;
+	void* memory = malloc(size ? size : 1);
+	if (!memory) throw std::bad_alloc();
+	return memory;
+}
+void operator delete(void* memory) noexcept { free(memory); }
+void operator delete(void* memory, size_t) noexcept { free(memory); }
+
+// Same size as a GameEntity (transforms, world matrix and
+// handles), without the D3D dependencies
+struct BenchEntity
+{
+	unsigned int Mesh;
+	unsigned int Material;
+	float Data[35];
+
+	BenchEntity(unsigned int mesh, unsigned int material) : Mesh(mesh), Material(material)
+	{
+		for (unsigned int i = 0; i < 35; i++)
+			Data[i] = 0.0f;
+	}
+};
+
+struct Result
+{
+	double Seconds;
+	unsigned long long Allocations;
+	unsigned long long Checksum;	// Keeps the work from being optimized away
+};
+
+// Spawn them all, despawn every one in a shuffled order, repeat
+static Result RunPool(unsigned int entityCount, unsigned int rounds, const std::vector<unsigned int>& order)
+{
+	Result result = {};
+	unsigned long long startAllocations = allocations;
+	auto start = std::chrono::high_resolution_clock::now();
+	{
+		EntityStorage<BenchEntity> pool;
+		std::vector<unsigned int> ids(entityCount);
+		for (unsigned int r = 0; r < rounds; r++)
+		{
+			for (unsigned int i = 0; i < entityCount; i++)
+				ids[i] = pool.Spawn(i, r);
+
+			pool.ForEach([&](BenchEntity* entity) { result.Checksum += entity->Mesh + (unsigned long long)entity->Data[0]; });
+
+			for (unsigned int i = 0; i < entityCount; i++)
+				pool.Despawn(ids[order[i]]);
+		}
+	}
+	result.Seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	result.Allocations = allocations - startAllocations;
+	return result;
+}
+
+// The old scheme: each entity new'd, the list a vector of
+// pointers, and a despawn a delete plus a swap-and-pop
+static Result RunVector(unsigned int entityCount, unsigned int rounds, const std::vector<unsigned int>& order)
+{
+	Result result = {};
+	unsigned long long startAllocations = allocations;
+	auto start = std::chrono::high_resolution_clock::now();
+	{
+		std::vector<BenchEntity*> entities;
+		std::vector<unsigned int> where(entityCount);	// Entity number -> position in the vector
+		std::vector<unsigned int> which;				// Position in the vector -> entity number
+		for (unsigned int r = 0; r < rounds; r++)
+		{
+			for (unsigned int i = 0; i < entityCount; i++)
+			{
+				where[i] = (unsigned int)entities.size();
+				which.push_back(i);
+				entities.push_back(new BenchEntity(i, r));
+			}
+
+			for (unsigned int i = 0; i < entities.size(); i++)
+				result.Checksum += entities[i]->Mesh + (unsigned long long)entities[i]->Data[0];
+
+			for (unsigned int i = 0; i < entityCount; i++)
+			{
+				unsigned int position = where[order[i]];
+				delete entities[position];
+				entities[position] = entities.back();
+				which[position] = which.back();
+				where[which[position]] = position;
+				entities.pop_back();
+				which.pop_back();
+			}
+		}
+	}
+	result.Seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	result.Allocations = allocations - startAllocations;
+	return result;
+}
+
+int main(int argc, char** argv)
+{
+	unsigned int entityCount = argc > 1 ? (unsigned int)atoi(argv[1]) : 1000000;
+	unsigned int rounds = argc > 2 ? (unsigned int)atoi(argv[2]) : 4;
+
+	std::vector<unsigned int> order(entityCount);
+	for (unsigned int i = 0; i < entityCount; i++)
+		order[i] = i;
+	std::shuffle(order.begin(), order.end(), std::mt19937(1234));
+
+	Result pool = RunPool(entityCount, rounds, order);
+	Result vector = RunVector(entityCount, rounds, order);
+
+	double operations = 2.0 * entityCount * rounds;
+	printf("%u entities of %u bytes, %u rounds of spawn all / iterate / despawn all (shuffled)\n",
+		entityCount, (unsigned int)sizeof(BenchEntity), rounds);
+	printf("EntityStorage:     %8.1f ms, %6.1f ns per spawn or despawn, %llu allocations\n",
+		pool.Seconds * 1e3, pool.Seconds / operations * 1e9, pool.Allocations);
+	printf("new + vector<T*>:  %8.1f ms, %6.1f ns per spawn or despawn, %llu allocations\n",
+		vector.Seconds * 1e3, vector.Seconds / operations * 1e9, vector.Allocations);
+	return pool.Checksum == vector.Checksum ? 0 : 1;
+}
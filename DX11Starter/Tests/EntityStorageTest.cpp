@@ -0,0 +1,97 @@
+#include "EntityStorage.h"
+#include "TestCheck.h"
+
+static int liveEntities = 0;
+
+struct TestEntity
+{
+	int Value;
+	TestEntity(int value) : Value(value) { liveEntities++; }
+	~TestEntity() { liveEntities--; }
+};
+
+static void TestSpawnAndGet()
+{
+	EntityStorage<TestEntity> pool;
+	unsigned int a = pool.Spawn(1);
+	unsigned int b = pool.Spawn(2);
+	CHECK(a != 0 && b != 0 && a != b);
+	CHECK(pool.GetCount() == 2);
+	CHECK(pool.Get(a) && pool.Get(a)->Value == 1);
+	CHECK(pool.Get(b) && pool.Get(b)->Value == 2);
+	CHECK(pool.Get(0) == 0);
+	CHECK(pool.Get(12345) == 0);
+}
+
+// A despawned entity's id must not find the entity that
+// reuses its slot, and despawning it again does nothing
+static void TestStaleIds()
+{
+	EntityStorage<TestEntity> pool;
+	unsigned int old = pool.Spawn(1);
+	pool.Despawn(old);
+	CHECK(pool.Get(old) == 0);
+
+	unsigned int reused = pool.Spawn(2);
+	CHECK((reused & ENTITY_INDEX_MASK) == (old & ENTITY_INDEX_MASK));
+	CHECK(reused != old);
+	CHECK(pool.Get(old) == 0);
+	CHECK(pool.Get(reused) && pool.Get(reused)->Value == 2);
+
+	pool.Despawn(old);
+	CHECK(pool.GetCount() == 1);
+	CHECK(pool.Get(reused) != 0);
+}
+
+// Reusing one slot until the generation wraps never hands out zero
+static void TestGenerationWrap()
+{
+	EntityStorage<TestEntity> pool;
+	unsigned int first = pool.Spawn(0);
+	unsigned int id = first;
+	for (unsigned int i = 0; i < ENTITY_GENERATION_MASK + 2; i++)
+	{
+		pool.Despawn(id);
+		id = pool.Spawn((int)i);
+		CHECK(id != 0);
+	}
+	CHECK(pool.Get(id) != 0);
+}
+
+static void TestIteration()
+{
+	liveEntities = 0;
+	{
+		EntityStorage<TestEntity> pool;
+		std::vector<unsigned int> ids;
+		for (int i = 0; i < 1000; i++)
+			ids.push_back(pool.Spawn(i));
+		for (int i = 0; i < 1000; i += 3)
+			pool.Despawn(ids[i]);
+
+		int visited = 0;
+		bool idsMatch = true;
+		pool.ForEachWithId([&](unsigned int id, TestEntity* entity)
+		{
+			visited++;
+			if (pool.Get(id) != entity || ids[entity->Value] != id)
+				idsMatch = false;
+		});
+		CHECK(visited == (int)pool.GetCount());
+		CHECK(visited == 1000 - 334);
+		CHECK(idsMatch);
+		CHECK(liveEntities == visited);
+	}
+
+	// The destructor destroys whatever was left
+	CHECK(liveEntities == 0);
+}
+
+int main()
+{
+	TestSpawnAndGet();
+	TestStaleIds();
+	TestGenerationWrap();
+	TestIteration();
+	return TestResult();
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "FixedTimestep.h"
+
+// --------------------------------------------------------
+// A GameClock that only moves when told to.  Sleeping
+// moves it too, by exactly as long as asked (plus however
+// late the test wants every wake-up to be), and so can
+// reading it, so anything spinning on Now() gets there.
+// --------------------------------------------------------
+class FakeClock : public GameClock
+{
+public:
+	FakeClock() : now(0.0), readCost(0.0), sleepOverrun(0.0), sleeps(0), slept(0.0) {}
+
+	double Now() override
+	{
+		double time = now;
+		now += readCost;
+		return time;
+	}
+	void SleepFor(double seconds) override
+	{
+		sleeps++;
+		slept += seconds;
+		now += seconds + sleepOverrun;
+	}
+
+	// Time spent working, between calls into whatever's under test
+	void Advance(double seconds) { now += seconds; }
+
+	double now;
+	double readCost;
+	double sleepOverrun;
+	unsigned int sleeps;
+	double slept;
+};
@@ -0,0 +1,180 @@
+#include "FixedTimestep.h"
+#include "FakeClock.h"
+#include "TestCheck.h"
+
+// Runs one frame of the game loop the way DXCore does,
+// returning how many ticks it took
+static unsigned int Frame(FixedTimestep& timestep, FakeClock& clock, double frameTime)
+{
+	clock.Advance(frameTime);
+	timestep.Advance(clock.Now());
+
+	unsigned int ticks = 0;
+	while (timestep.Tick())
+		ticks++;
+	return ticks;
+}
+
+// Frames exactly one tick long run exactly one tick each
+static void TestSteady()
+{
+	FakeClock clock;
+	FixedTimestep timestep(64.0f, 8);
+	timestep.Reset(clock.Now());
+
+	for (unsigned int i = 0; i < 640; i++)
+		CHECK(Frame(timestep, clock, 1.0 / 64.0) == 1);
+
+	CHECK(timestep.GetTickCount() == 640);
+	CHECK_NEAR(timestep.GetSimulatedTime(), 10.0, 1e-9);
+	CHECK_NEAR(timestep.GetInterpolation(), 0.0f, 1e-6);
+	CHECK(timestep.GetDroppedTime() == 0.0);
+}
+
+// Faster frames than ticks: most frames run none, and what's
+// left over comes out as the interpolation factor
+static void TestInterpolation()
+{
+	FakeClock clock;
+	FixedTimestep timestep(64.0f, 8);
+	timestep.Reset(clock.Now());
+
+	// Quarter-tick frames: a tick every fourth frame
+	float expected[] = { 0.25f, 0.5f, 0.75f, 0.0f };
+	for (unsigned int i = 0; i < 16; i++)
+	{
+		unsigned int ticks = Frame(timestep, clock, 1.0 / 256.0);
+		CHECK(ticks == (i % 4 == 3 ? 1u : 0u));
+		CHECK_NEAR(timestep.GetInterpolation(), expected[i % 4], 1e-6);
+	}
+	CHECK(timestep.GetTickCount() == 4);
+
+	// Two and a half ticks in one frame
+	CHECK(Frame(timestep, clock, 2.5 / 64.0) == 2);
+	CHECK_NEAR(timestep.GetInterpolation(), 0.5f, 1e-6);
+
+	// A 144Hz display over a 60Hz simulation: no more than one tick
+	// a frame, and the interpolation stays within [0, 1]
+	FixedTimestep sixty(60.0f, 8);
+	sixty.Reset(clock.Now());
+	unsigned int total = 0;
+	for (unsigned int i = 0; i < 144; i++)
+	{
+		unsigned int ticks = Frame(sixty, clock, 1.0 / 144.0);
+		CHECK(ticks <= 1);
+		CHECK(sixty.GetInterpolation() >= 0.0f && sixty.GetInterpolation() <= 1.0f);
+		total += ticks;
+	}
+	CHECK(total == 59 || total == 60);
+	CHECK_NEAR(sixty.GetSimulatedTime() + sixty.GetInterpolation() * sixty.GetTickLength(), 1.0, 1e-6);
+}
+
+// A long stall runs at most 8 ticks, drops the rest, and
+// leaves nothing behind to catch up on next frame
+static void TestClamp()
+{
+	FakeClock clock;
+	FixedTimestep timestep(64.0f, 8);
+	timestep.Reset(clock.Now());
+
+	CHECK(Frame(timestep, clock, 1.0) == 8);
+	CHECK_NEAR(timestep.GetDroppedTime(), 1.0 - 8.0 / 64.0, 1e-9);
+	CHECK_NEAR(timestep.GetInterpolation(), 0.0f, 1e-6);
+
+	// Back to normal straight away
+	CHECK(Frame(timestep, clock, 1.0 / 64.0) == 1);
+	CHECK_NEAR(timestep.GetDroppedTime(), 1.0 - 8.0 / 64.0, 1e-9);
+
+	// Exactly 8 ticks' worth is not clamped
+	CHECK(Frame(timestep, clock, 8.0 / 64.0) == 8);
+	CHECK_NEAR(timestep.GetDroppedTime(), 1.0 - 8.0 / 64.0, 1e-9);
+
+	// The limit can change; 0 still allows one tick
+	timestep.SetMaxTicksPerFrame(0);
+	CHECK(Frame(timestep, clock, 0.5) == 1);
+	CHECK_NEAR(timestep.GetInterpolation(), 0.0f, 1e-6);
+
+	// Simulated plus dropped time accounts for all of it
+	CHECK_NEAR(timestep.GetSimulatedTime() + timestep.GetDroppedTime(), clock.Now(), 1e-9);
+}
+
+// Time going backwards counts as none passing
+static void TestBackwards()
+{
+	FakeClock clock;
+	clock.now = 5.0;
+	FixedTimestep timestep(64.0f, 8);
+	timestep.Reset(clock.Now());
+
+	CHECK(Frame(timestep, clock, -1.0) == 0);
+	CHECK_NEAR(timestep.GetInterpolation(), 0.0f, 1e-6);
+
+	// ...and measuring restarts from where it went back to
+	CHECK(Frame(timestep, clock, 1.5 / 64.0) == 1);
+	CHECK_NEAR(timestep.GetInterpolation(), 0.5f, 1e-6);
+}
+
+// Changing rate keeps whatever time was left over
+static void TestRateChange()
+{
+	FakeClock clock;
+	FixedTimestep timestep(64.0f, 8);
+	timestep.Reset(clock.Now());
+
+	CHECK(Frame(timestep, clock, 1.5 / 64.0) == 1);
+	timestep.SetTicksPerSecond(128.0f);
+	CHECK_NEAR(timestep.GetInterpolation(), 1.0f, 1e-6);
+	CHECK(timestep.Tick());
+	CHECK(!timestep.Tick());
+	CHECK_NEAR(timestep.GetSimulatedTime(), 1.5 / 64.0, 1e-9);
+}
+
+// A timestep resumed from where another one was (as a replay
+// resumes from its recording) ticks on the same frames after,
+// and one simply reset doesn't
+static void TestResume()
+{
+	FakeClock clock;
+	FixedTimestep timestep(64.0f, 8);
+	timestep.Reset(clock.Now());
+
+	// Frames of 0.7 ticks leave something over most of the time
+	const double frameTime = 0.7 / 64.0;
+	for (unsigned int i = 0; i < 10; i++)
+		Frame(timestep, clock, frameTime);
+	double accumulated = timestep.GetAccumulatedTime();
+	double simulated = timestep.GetSimulatedTime();
+	CHECK(accumulated > 0.0);
+
+	FakeClock replayClock;
+	replayClock.now = 100.0;
+	FixedTimestep resumed(64.0f, 8);
+	resumed.Resume(replayClock.Now(), accumulated, simulated);
+
+	FakeClock resetClock;
+	FixedTimestep reset(64.0f, 8);
+	reset.Reset(resetClock.Now());
+
+	bool sameAsResumed = true, sameAsReset = true;
+	for (unsigned int i = 0; i < 20; i++)
+	{
+		unsigned int ticks = Frame(timestep, clock, frameTime);
+		sameAsResumed = sameAsResumed && Frame(resumed, replayClock, frameTime) == ticks;
+		sameAsReset = sameAsReset && Frame(reset, resetClock, frameTime) == ticks;
+	}
+	CHECK(sameAsResumed);
+	CHECK(!sameAsReset);
+	CHECK_NEAR(resumed.GetSimulatedTime(), timestep.GetSimulatedTime(), 1e-9);
+	CHECK_NEAR(resumed.GetInterpolation(), timestep.GetInterpolation(), 1e-6);
+}
+
+int main()
+{
+	TestSteady();
+	TestInterpolation();
+	TestClamp();
+	TestBackwards();
+	TestRateChange();
+	TestResume();
+	return TestResult();
+}
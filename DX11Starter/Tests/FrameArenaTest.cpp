@@ -0,0 +1,70 @@
+#include "FrameArena.h"
+#include "TestCheck.h"
+#include <cstdint>
+#include <cstring>
+
+static bool IsAligned(void* pointer, size_t alignment)
+{
+	return ((uintptr_t)pointer & (alignment - 1)) == 0;
+}
+
+// Alignments beyond what new[] guarantees, after odd-sized
+// allocations, must still land on aligned addresses
+static void TestAlignment()
+{
+	FrameArena arena(64 * 1024);
+	size_t alignments[] = { 1, 2, 4, 8, 16, 64, 256, 4096 };
+	for (unsigned int round = 0; round < 4; round++)
+	{
+		for (unsigned int a = 0; a < sizeof(alignments) / sizeof(alignments[0]); a++)
+		{
+			arena.Allocate(3, 1);
+			void* pointer = arena.Allocate(24, alignments[a]);
+			CHECK(pointer != 0);
+			CHECK(IsAligned(pointer, alignments[a]));
+			memset(pointer, 0xCD, 24);
+		}
+	}
+	arena.Reset();
+}
+
+// Allocations past the capacity come from the heap, still
+// aligned, and the arena grows to fit them at the next reset
+static void TestOverflow()
+{
+	FrameArena arena(1024);
+	for (unsigned int i = 0; i < 10; i++)
+	{
+		void* pointer = arena.Allocate(200, 64);
+		CHECK(IsAligned(pointer, 64));
+		memset(pointer, 0xAB, 200);
+	}
+	CHECK(arena.GetUsed() > 1024);
+
+	arena.Reset();
+	CHECK(arena.GetCapacity() >= arena.GetLastFrameHighWater());
+	CHECK(arena.GetUsed() == 0);
+
+	// A request bigger than the whole arena
+	void* pointer = arena.Allocate(1 << 20, 4096);
+	CHECK(IsAligned(pointer, 4096));
+	memset(pointer, 0, 1 << 20);
+}
+
+static void TestFrameVector()
+{
+	FrameArena arena(4096);
+	FrameVector<double> values{ FrameAllocator<double>(&arena) };
+	for (int i = 0; i < 100; i++)
+		values.push_back(i * 0.5);
+	CHECK(values[99] == 49.5);
+	CHECK(IsAligned(&values[0], alignof(double)));
+}
+
+int main()
+{
+	TestAlignment();
+	TestOverflow();
+	TestFrameVector();
+	return TestResult();
+}
@@ -0,0 +1,160 @@
+#include "FramePacer.h"
+#include "FakeClock.h"
+#include "TestCheck.h"
+#include <vector>
+
+// How close to its slot a frame must start.  Spinning reads
+// the fake clock in steps of readCost, so it can overshoot
+// by one step.
+#define READ_COST	1e-6
+#define ON_TIME		2e-6
+
+// Runs frames that each take "work" seconds, returning when
+// each one started
+static std::vector<double> RunFrames(FramePacer& pacer, FakeClock& clock, unsigned int count, double work)
+{
+	std::vector<double> starts;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		clock.Advance(work);
+		starts.push_back(pacer.WaitForNextFrame());
+	}
+	return starts;
+}
+
+// A new pacer has no stats to report
+static void TestNoFrames()
+{
+	FakeClock clock;
+	FramePacer pacer(&clock);
+
+	FrameTimeStats stats = pacer.TakeStats();
+	CHECK(stats.Frames == 0);
+	CHECK(stats.Mean == 0.0);
+	CHECK(stats.StdDev == 0.0);
+	CHECK(stats.Min == 0.0);
+	CHECK(stats.Max == 0.0);
+}
+
+// Short frames are held to the grid, sleeping most of the
+// wait and spinning the rest
+static void TestSteady()
+{
+	FakeClock clock;
+	clock.readCost = READ_COST;
+	clock.sleepOverrun = 0.0003;
+	FramePacer pacer(&clock);
+	pacer.SetTargetFPS(100.0f);
+	double reset = clock.Now();
+	pacer.Reset(reset);
+
+	// The first frame was due at Reset(), so starts as soon as it can
+	std::vector<double> starts = RunFrames(pacer, clock, 200, 0.004);
+	for (unsigned int i = 1; i < starts.size(); i++)
+		CHECK_NEAR(starts[i] - reset, i * 0.01, ON_TIME);
+
+	// Every wait but the first (due at once) slept
+	CHECK(clock.sleeps == 199);
+
+	pacer.TakeStats();
+	RunFrames(pacer, clock, 100, 0.004);
+	FrameTimeStats stats = pacer.TakeStats();
+	CHECK(stats.Frames == 100);
+	CHECK_NEAR(stats.Mean, 0.01, ON_TIME);
+	CHECK(stats.StdDev < ON_TIME);
+	CHECK_NEAR(stats.Min, 0.01, ON_TIME);
+	CHECK_NEAR(stats.Max, 0.01, ON_TIME);
+}
+
+// Sleeps that wake later than the spin time miss their slot
+// until the spin time grows to cover them
+static void TestLateWakes()
+{
+	FakeClock clock;
+	clock.readCost = READ_COST;
+	clock.sleepOverrun = 0.003;
+	FramePacer pacer(&clock);
+	pacer.SetTargetFPS(100.0f);
+	pacer.Reset(clock.Now());
+
+	RunFrames(pacer, clock, 2, 0.004);
+	CHECK(pacer.GetSpinTime() > 0.003);
+
+	std::vector<double> starts = RunFrames(pacer, clock, 50, 0.004);
+	for (unsigned int i = 1; i < starts.size(); i++)
+		CHECK_NEAR(starts[i] - starts[i - 1], 0.01, ON_TIME);
+}
+
+// A frame less than a whole frame late catches back up to
+// the grid; one more than a frame late starts a new grid
+// instead of rushing through short frames
+static void TestHitches()
+{
+	FakeClock clock;
+	clock.readCost = READ_COST;
+	FramePacer pacer(&clock);
+	pacer.SetTargetFPS(100.0f);
+	double gridStart = clock.Now();
+	pacer.Reset(gridStart);
+
+	std::vector<double> starts = RunFrames(pacer, clock, 10, 0.004);
+
+	// 3ms over: this frame starts late, the next one on the old grid
+	clock.Advance(0.013);
+	double late = pacer.WaitForNextFrame();
+	CHECK_NEAR(late - gridStart, 10 * 0.01 + 0.003, ON_TIME);
+	starts = RunFrames(pacer, clock, 5, 0.004);
+	for (unsigned int i = 0; i < starts.size(); i++)
+		CHECK_NEAR(starts[i] - gridStart, (11 + i) * 0.01, ON_TIME);
+
+	// 35ms: the next frame starts at once, and the ones after it a
+	// whole frame apart from there
+	clock.Advance(0.035);
+	double restart = pacer.WaitForNextFrame();
+	CHECK_NEAR(restart - starts.back(), 0.035, ON_TIME);
+	starts = RunFrames(pacer, clock, 5, 0.004);
+	for (unsigned int i = 0; i < starts.size(); i++)
+		CHECK_NEAR(starts[i] - restart, (i + 1) * 0.01, ON_TIME);
+
+	// The hitch shows up in the stats
+	FrameTimeStats stats = pacer.TakeStats();
+	CHECK(stats.Frames == 22);
+	CHECK_NEAR(stats.Max, 0.035, ON_TIME);
+}
+
+// With no target, frames start as soon as the last one ends
+// and nothing ever sleeps
+static void TestUnlimited()
+{
+	FakeClock clock;
+	clock.readCost = READ_COST;
+	FramePacer pacer(&clock);
+	CHECK(pacer.GetTargetFPS() == 0.0f);
+	pacer.Reset(clock.Now());
+
+	std::vector<double> starts = RunFrames(pacer, clock, 100, 0.004);
+	for (unsigned int i = 1; i < starts.size(); i++)
+		CHECK_NEAR(starts[i] - starts[i - 1], 0.004, ON_TIME);
+	CHECK(clock.sleeps == 0);
+
+	FrameTimeStats stats = pacer.TakeStats();
+	CHECK(stats.Frames == 100);
+	CHECK_NEAR(stats.Mean, 0.004, ON_TIME);
+
+	// Limiting and unlimiting again
+	pacer.SetTargetFPS(50.0f);
+	CHECK_NEAR(pacer.GetTargetFPS(), 50.0f, 1e-3);
+	pacer.SetTargetFPS(0.0f);
+	RunFrames(pacer, clock, 10, 0.004);
+	CHECK(clock.sleeps == 0);
+}
+
+int main()
+{
+	TestNoFrames();
+	TestSteady();
+	TestLateWakes();
+	TestHitches();
+	TestUnlimited();
+	return TestResult();
+}
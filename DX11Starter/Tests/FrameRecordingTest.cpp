@@ -0,0 +1,183 @@
+#include "FrameRecording.h"
+#include "TestCheck.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+// Written to (and removed from) wherever the test runs
+static const char* testPath = "FrameRecordingTest.rec";
+
+static std::vector<unsigned char> ReadFile(const char* path)
+{
+	std::ifstream file(path, std::ios::binary);
+	return std::vector<unsigned char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static void WriteFile(const char* path, const std::vector<unsigned char>& bytes)
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!bytes.empty())
+		file.write((const char*)&bytes[0], bytes.size());
+}
+
+static void Patch(std::vector<unsigned char>* bytes, size_t offset, unsigned int value)
+{
+	memcpy(&(*bytes)[offset], &value, sizeof(value));
+}
+
+static InputSnapshot MakeInput(unsigned int frame)
+{
+	InputSnapshot input = {};
+	for (unsigned int a = 0; a < ACTION_COUNT; a++)
+	{
+		input.Held[a] = (frame + a) % 3 == 0;
+		input.Pressed[a] = (frame + a) % 5 == 0;
+		input.Released[a] = (frame + a) % 7 == 0;
+		input.HeldTime[a] = input.Held[a] ? 0.001f * (a + 1) : 0.0f;
+	}
+	input.MouseX = (int)frame * 3;
+	input.MouseY = -(int)frame;
+	input.LookX = frame % 2 ? 100000 : -5;		// Stored as 16 bits, so clamped
+	input.LookY = 7;
+	input.Wheel = frame % 4 == 0 ? 1.0f : 0.0f;
+	return input;
+}
+
+static FrameRecording MakeRecording(unsigned int frameCount)
+{
+	FrameRecording recording;
+	for (unsigned int i = 0; i < frameCount; i++)
+		recording.AddFrame(1.0f / 60.0f + i * 0.0001f, MakeInput(i));
+
+	static const char state[] = "camera";
+	recording.GetStartState().assign(state, state + sizeof(state));
+	recording.SetStartTime(0.25 / 60.0, 12.5);
+	return recording;
+}
+
+// Everything saved comes back, except what the format clamps
+static void TestRoundTrip()
+{
+	FrameRecording saved = MakeRecording(50);
+	CHECK(saved.Save(testPath));
+
+	FrameRecording loaded;
+	CHECK(loaded.Load(testPath));
+	CHECK(loaded.GetFrameCount() == 50);
+	CHECK(loaded.GetStartState() == saved.GetStartState());
+	CHECK(loaded.GetStartAccumulated() == saved.GetStartAccumulated());
+	CHECK(loaded.GetStartSimulated() == saved.GetStartSimulated());
+	CHECK_NEAR(loaded.GetDuration(), saved.GetDuration(), 1e-6);
+
+	bool same = true;
+	for (unsigned int i = 0; i < loaded.GetFrameCount(); i++)
+	{
+		const RecordedFrame& a = saved.GetFrame(i);
+		const RecordedFrame& b = loaded.GetFrame(i);
+		same = same && a.DeltaTime == b.DeltaTime;
+		for (unsigned int k = 0; k < ACTION_COUNT; k++)
+		{
+			same = same && a.Input.Held[k] == b.Input.Held[k];
+			same = same && a.Input.Pressed[k] == b.Input.Pressed[k];
+			same = same && a.Input.Released[k] == b.Input.Released[k];
+			same = same && a.Input.HeldTime[k] == b.Input.HeldTime[k];
+		}
+		same = same && a.Input.MouseX == b.Input.MouseX && a.Input.MouseY == b.Input.MouseY;
+		same = same && b.Input.LookX == (a.Input.LookX > 32767 ? 32767 : a.Input.LookX);
+		same = same && a.Input.LookY == b.Input.LookY && a.Input.Wheel == b.Input.Wheel;
+	}
+	CHECK(same);
+
+	// An empty recording works too
+	FrameRecording empty;
+	CHECK(empty.Save(testPath));
+	CHECK(loaded.Load(testPath));
+	CHECK(loaded.GetFrameCount() == 0);
+	CHECK(loaded.GetStartState().empty());
+	CHECK(loaded.GetStartAccumulated() == 0.0);
+	CHECK(loaded.GetStartSimulated() == 0.0);
+}
+
+// A file cut short anywhere fails, and leaves what was
+// loaded before untouched
+static void TestTruncated()
+{
+	MakeRecording(20).Save(testPath);
+	std::vector<unsigned char> bytes = ReadFile(testPath);
+
+	FrameRecording loaded;
+	loaded.AddFrame(0.5f, MakeInput(1));
+
+	unsigned int loadedShort = 0;
+	for (size_t size = 0; size < bytes.size(); size++)
+	{
+		WriteFile(testPath, std::vector<unsigned char>(bytes.begin(), bytes.begin() + size));
+		if (loaded.Load(testPath))
+			loadedShort++;
+	}
+	CHECK(loadedShort == 0);
+	CHECK(loaded.GetFrameCount() == 1);
+	CHECK(loaded.GetFrame(0).DeltaTime == 0.5f);
+}
+
+// Sizes in the header bigger than the file are rejected
+// before anything is allocated for them
+static void TestCorruptSizes()
+{
+	FrameRecording recording = MakeRecording(20);
+	recording.Save(testPath);
+	std::vector<unsigned char> bytes = ReadFile(testPath);
+
+	// Magic, version, the start time, then the state size
+	size_t stateSizeOffset = 24;
+	size_t countOffset = 28 + recording.GetStartState().size();
+
+	FrameRecording loaded;
+	std::vector<unsigned char> corrupt = bytes;
+	Patch(&corrupt, stateSizeOffset, 0xFFFFFFF0u);
+	WriteFile(testPath, corrupt);
+	CHECK(!loaded.Load(testPath));
+
+	corrupt = bytes;
+	Patch(&corrupt, stateSizeOffset, (unsigned int)bytes.size());
+	WriteFile(testPath, corrupt);
+	CHECK(!loaded.Load(testPath));
+
+	corrupt = bytes;
+	Patch(&corrupt, countOffset, 0xFFFFFFFFu);
+	WriteFile(testPath, corrupt);
+	CHECK(!loaded.Load(testPath));
+
+	corrupt = bytes;
+	Patch(&corrupt, countOffset, 21);
+	WriteFile(testPath, corrupt);
+	CHECK(!loaded.Load(testPath));
+
+	// Wrong magic or version
+	corrupt = bytes;
+	corrupt[0] = 'X';
+	WriteFile(testPath, corrupt);
+	CHECK(!loaded.Load(testPath));
+
+	corrupt = bytes;
+	Patch(&corrupt, 4, 1);
+	WriteFile(testPath, corrupt);
+	CHECK(!loaded.Load(testPath));
+
+	// The untouched file still loads
+	WriteFile(testPath, bytes);
+	CHECK(loaded.Load(testPath));
+	CHECK(loaded.GetFrameCount() == 20);
+
+	CHECK(!loaded.Load("FrameRecordingTest.missing"));
+}
+
+int main()
+{
+	TestRoundTrip();
+	TestTruncated();
+	TestCorruptSizes();
+	remove(testPath);
+	return TestResult();
+}
@@ -0,0 +1,104 @@
+#include "Meshlets.h"
+#include "BenchmarkMeshes.h"
+#include <chrono>
+#include <cstdlib>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Times BuildMeshlets and CullMeshlets on the bundled meshes
+// and on synthetic meshes of millions of triangles.
+//
+// Culling is done from cameras circling the mesh at a few
+// distances, looking at it, so some clusters are off screen
+// and about half face away.
+//
+//   MeshletBenchmark [largest synthetic triangle count]
+// --------------------------------------------------------
+
+static double Seconds(std::chrono::high_resolution_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+static void Run(const BenchmarkMesh& mesh)
+{
+	unsigned int triangles = (unsigned int)mesh.Indices.size() / 3;
+
+	// Small meshes are built repeatedly, for a measurable time
+	unsigned int buildRepeats = (std::max)(1u, 2000000u / (std::max)(triangles, 1u));
+	std::vector<Meshlet> meshlets;
+	std::vector<int> meshletIndices;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (unsigned int r = 0; r < buildRepeats; r++)
+	{
+		meshlets.clear();
+		meshletIndices.clear();
+		BuildMeshlets(&mesh.Vertices[0], (unsigned int)mesh.Vertices.size(), &mesh.Indices[0], (unsigned int)mesh.Indices.size(), meshlets, meshletIndices);
+	}
+	double buildSeconds = Seconds(start) / buildRepeats;
+
+	unsigned long long meshletVertices = 0;
+	for (unsigned int i = 0; i < meshlets.size(); i++)
+		meshletVertices += meshlets[i].VertexCount;
+
+	// Cameras around the mesh's bounds
+	XMFLOAT3 boundsMin = mesh.Vertices[0].Position, boundsMax = boundsMin;
+	for (unsigned int i = 1; i < mesh.Vertices.size(); i++)
+	{
+		XMStoreFloat3(&boundsMin, XMVectorMin(XMLoadFloat3(&boundsMin), XMLoadFloat3(&mesh.Vertices[i].Position)));
+		XMStoreFloat3(&boundsMax, XMVectorMax(XMLoadFloat3(&boundsMax), XMLoadFloat3(&mesh.Vertices[i].Position)));
+	}
+	XMVECTOR center = XMVectorScale(XMVectorAdd(XMLoadFloat3(&boundsMin), XMLoadFloat3(&boundsMax)), 0.5f);
+	float size = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&boundsMax), XMLoadFloat3(&boundsMin))));
+
+	const unsigned int views = 64;
+	std::vector<MeshletFrustum> frustums(views);
+	for (unsigned int v = 0; v < views; v++)
+	{
+		float angle = 6.2831853f * v / views;
+		float distance = size * (0.4f + 0.3f * (v % 4));
+		XMVECTOR eye = XMVectorAdd(center, XMVectorSet(std::cos(angle) * distance, size * 0.2f, std::sin(angle) * distance, 0.0f));
+		XMMATRIX view = XMMatrixLookAtLH(eye, center, XMVectorSet(0, 1, 0, 0));
+		XMMATRIX projection = XMMatrixPerspectiveFovLH(0.8f, 16.0f / 9.0f, size * 0.01f, size * 10.0f);
+		frustums[v] = MakeMeshletFrustum(XMMatrixIdentity(), XMMatrixMultiply(view, projection), eye);
+	}
+
+	unsigned int cullRepeats = (std::max)(1u, 20000u / (std::max)((unsigned int)meshlets.size(), 1u));
+	std::vector<int> visibleIndices;
+	visibleIndices.reserve(mesh.Indices.size());
+	unsigned long long visibleMeshlets = 0, visibleTriangles = 0;
+	start = std::chrono::high_resolution_clock::now();
+	for (unsigned int r = 0; r < cullRepeats; r++)
+	{
+		for (unsigned int v = 0; v < views; v++)
+		{
+			visibleIndices.clear();
+			visibleMeshlets += CullMeshlets(&meshlets[0], (unsigned int)meshlets.size(), &meshletIndices[0], frustums[v], visibleIndices);
+			visibleTriangles += visibleIndices.size() / 3;
+		}
+	}
+	double cullSeconds = Seconds(start);
+	double culls = (double)cullRepeats * views;
+
+	printf("%-16s %9u tris %7u meshlets (%5.1f tris, %4.1f verts each)  build %9.3f ms (%6.2f Mtris/s)  cull %8.3f ms/view (%6.1f Mmeshlets/s), %4.1f%% of tris kept\n",
+		mesh.Name.c_str(), triangles, (unsigned int)meshlets.size(),
+		(double)triangles / meshlets.size(), (double)meshletVertices / meshlets.size(),
+		buildSeconds * 1e3, triangles / buildSeconds / 1e6,
+		cullSeconds / culls * 1e3, meshlets.size() * culls / cullSeconds / 1e6,
+		100.0 * visibleTriangles / (triangles * culls));
+}
+
+int main(int argc, char** argv)
+{
+	unsigned int largest = argc > 1 ? (unsigned int)atoi(argv[1]) : 4000000;
+
+	std::vector<BenchmarkMesh> meshes = LoadBundledMeshes();
+	for (unsigned int i = 0; i < meshes.size(); i++)
+		Run(meshes[i]);
+
+	for (unsigned int triangles = 250000; triangles <= largest; triangles *= 4)
+		Run(MakeSyntheticMesh(triangles));
+
+	return 0;
+}
@@ -0,0 +1,152 @@
+#include "OcclusionBaker.h"
+#include "TestCheck.h"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+using namespace DirectX;
+
+// Written to (and removed from) wherever the test runs
+static const char* testPath = "OcclusionCacheTest" OCCLUSION_CACHE_EXTENSION;
+
+// A strip of quads, and a made up bake for it (the cache
+// doesn't care where the values came from)
+struct TestBake
+{
+	std::vector<Vertex> Vertices;
+	std::vector<int> Indices;
+	OcclusionBakeSettings Settings;
+	std::vector<OcclusionVertex> Occlusion;
+};
+
+static TestBake MakeBake()
+{
+	TestBake bake;
+	for (unsigned int i = 0; i < 20; i++)
+	{
+		Vertex v = {};
+		v.Position = XMFLOAT3((float)(i / 2), (float)(i % 2), 0.0f);
+		v.Normal = XMFLOAT3(0.0f, 0.0f, -1.0f);
+		bake.Vertices.push_back(v);
+
+		OcclusionVertex o;
+		o.Occlusion = (unsigned char)(i * 13);
+		bake.Occlusion.push_back(o);
+	}
+	for (int q = 0; q < 9; q++)
+	{
+		int quad[6] = { q * 2, q * 2 + 1, q * 2 + 2, q * 2 + 2, q * 2 + 1, q * 2 + 3 };
+		bake.Indices.insert(bake.Indices.end(), quad, quad + 6);
+	}
+	bake.Settings.RaysPerVertex = 64;
+	bake.Settings.MaxDistance = 5.0f;
+	bake.Settings.Bias = 0.01f;
+	return bake;
+}
+
+static bool Load(const TestBake& bake, std::vector<OcclusionVertex>* occlusion)
+{
+	occlusion->assign(bake.Vertices.size(), OcclusionVertex());
+	for (unsigned int i = 0; i < occlusion->size(); i++)
+		(*occlusion)[i].Occlusion = 1;
+	return LoadVertexOcclusion(testPath,
+		&bake.Vertices[0], (unsigned int)bake.Vertices.size(), &bake.Indices[0], (unsigned int)bake.Indices.size(),
+		bake.Settings, &(*occlusion)[0]);
+}
+
+// Nothing is written over when a load fails
+static bool Untouched(const std::vector<OcclusionVertex>& occlusion)
+{
+	for (unsigned int i = 0; i < occlusion.size(); i++)
+	{
+		if (occlusion[i].Occlusion != 1)
+			return false;
+	}
+	return true;
+}
+
+static bool SameOcclusion(const std::vector<OcclusionVertex>& a, const std::vector<OcclusionVertex>& b)
+{
+	if (a.size() != b.size())
+		return false;
+	for (unsigned int i = 0; i < a.size(); i++)
+	{
+		if (a[i].Occlusion != b[i].Occlusion)
+			return false;
+	}
+	return true;
+}
+
+// Loads back for the same mesh and settings, and for nothing else
+static void TestRoundTrip()
+{
+	TestBake bake = MakeBake();
+	CHECK(SaveVertexOcclusion(testPath,
+		&bake.Vertices[0], (unsigned int)bake.Vertices.size(), &bake.Indices[0], (unsigned int)bake.Indices.size(),
+		bake.Settings, &bake.Occlusion[0]));
+
+	std::vector<OcclusionVertex> loaded;
+	CHECK(Load(bake, &loaded));
+	CHECK(SameOcclusion(loaded, bake.Occlusion));
+
+	TestBake changed = bake;
+	changed.Settings.RaysPerVertex = 128;
+	CHECK(!Load(changed, &loaded));
+	CHECK(Untouched(loaded));
+
+	changed = bake;
+	changed.Vertices[7].Position.z = 0.5f;
+	CHECK(!Load(changed, &loaded));
+	CHECK(Untouched(loaded));
+
+	changed = bake;
+	std::swap(changed.Indices[0], changed.Indices[1]);
+	CHECK(!Load(changed, &loaded));
+	CHECK(Untouched(loaded));
+
+	changed = bake;
+	changed.Vertices.pop_back();
+	changed.Indices.resize(changed.Indices.size() - 6);
+	CHECK(!Load(changed, &loaded));
+}
+
+// A file cut short anywhere fails
+static void TestTruncated()
+{
+	TestBake bake = MakeBake();
+	SaveVertexOcclusion(testPath,
+		&bake.Vertices[0], (unsigned int)bake.Vertices.size(), &bake.Indices[0], (unsigned int)bake.Indices.size(),
+		bake.Settings, &bake.Occlusion[0]);
+
+	std::ifstream in(testPath, std::ios::binary);
+	std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	in.close();
+
+	unsigned int loadedShort = 0;
+	bool untouched = true;
+	std::vector<OcclusionVertex> loaded;
+	for (size_t size = 0; size < bytes.size(); size++)
+	{
+		std::ofstream out(testPath, std::ios::binary | std::ios::trunc);
+		out.write(size > 0 ? &bytes[0] : 0, size);
+		out.close();
+		if (Load(bake, &loaded))
+			loadedShort++;
+		untouched = untouched && Untouched(loaded);
+	}
+	CHECK(loadedShort == 0);
+	CHECK(untouched);
+
+	remove(testPath);
+	CHECK(!Load(bake, &loaded));
+}
+
+int main()
+{
+	TestRoundTrip();
+	TestTruncated();
+	remove(testPath);
+	return TestResult();
+}
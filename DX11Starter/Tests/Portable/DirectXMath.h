@@ -0,0 +1,493 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// --------------------------------------------------------
+// Plain C++ stand-in for the parts of DirectXMath the
+// engine's portable code uses, so the tests and benchmarks
+// that need it build where the Windows SDK isn't around.
+// CMakeLists.txt only puts this directory on the include
+// path when not building for Windows; there the real
+// header is used.
+//
+// Same names, layouts and results as the real library
+// (within float rounding), but scalar: one float at a time
+// where DirectXMath uses SSE.  Numbers from benchmarks
+// built against this are slower than on Windows, most of
+// all for code that leans on vector math.
+//
+// Add to it as portable code needs more.
+// --------------------------------------------------------
+
+#define XM_CALLCONV
+
+namespace DirectX
+{
+	const float XM_PI		= 3.141592654f;
+	const float XM_2PI		= 6.283185307f;
+	const float XM_1DIVPI	= 0.318309886f;
+	const float XM_PIDIV2	= 1.570796327f;
+	const float XM_PIDIV4	= 0.785398163f;
+
+	inline float XMConvertToRadians(float degrees) { return degrees * (XM_PI / 180.0f); }
+	inline float XMConvertToDegrees(float radians) { return radians * (180.0f / XM_PI); }
+
+	struct alignas(16) XMVECTOR
+	{
+		float v[4];
+	};
+
+	typedef const XMVECTOR& FXMVECTOR;
+	typedef const XMVECTOR& GXMVECTOR;
+	typedef const XMVECTOR& HXMVECTOR;
+	typedef const XMVECTOR& CXMVECTOR;
+
+	// Rows, like the real one
+	struct alignas(16) XMMATRIX
+	{
+		XMVECTOR r[4];
+
+		XMMATRIX() = default;
+		XMMATRIX(float m00, float m01, float m02, float m03,
+			float m10, float m11, float m12, float m13,
+			float m20, float m21, float m22, float m23,
+			float m30, float m31, float m32, float m33)
+		{
+			r[0] = { { m00, m01, m02, m03 } };
+			r[1] = { { m10, m11, m12, m13 } };
+			r[2] = { { m20, m21, m22, m23 } };
+			r[3] = { { m30, m31, m32, m33 } };
+		}
+	};
+
+	typedef const XMMATRIX& FXMMATRIX;
+	typedef const XMMATRIX& CXMMATRIX;
+
+	struct XMFLOAT2
+	{
+		float x, y;
+
+		XMFLOAT2() = default;
+		XMFLOAT2(float x, float y) : x(x), y(y) {}
+	};
+
+	struct XMFLOAT3
+	{
+		float x, y, z;
+
+		XMFLOAT3() = default;
+		XMFLOAT3(float x, float y, float z) : x(x), y(y), z(z) {}
+	};
+
+	struct XMFLOAT4
+	{
+		float x, y, z, w;
+
+		XMFLOAT4() = default;
+		XMFLOAT4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+	};
+
+	struct XMFLOAT4X4
+	{
+		union
+		{
+			struct
+			{
+				float _11, _12, _13, _14;
+				float _21, _22, _23, _24;
+				float _31, _32, _33, _34;
+				float _41, _42, _43, _44;
+			};
+			float m[4][4];
+		};
+
+		XMFLOAT4X4() = default;
+		XMFLOAT4X4(float m00, float m01, float m02, float m03,
+			float m10, float m11, float m12, float m13,
+			float m20, float m21, float m22, float m23,
+			float m30, float m31, float m32, float m33)
+		{
+			const float values[16] = { m00, m01, m02, m03, m10, m11, m12, m13, m20, m21, m22, m23, m30, m31, m32, m33 };
+			memcpy(m, values, sizeof(m));
+		}
+
+		float operator()(size_t row, size_t column) const { return m[row][column]; }
+		float& operator()(size_t row, size_t column) { return m[row][column]; }
+	};
+
+	// --------------------------------------------------------
+	// Building and taking apart vectors
+	// --------------------------------------------------------
+	inline XMVECTOR XMVectorSet(float x, float y, float z, float w)
+	{
+		XMVECTOR result = { { x, y, z, w } };
+		return result;
+	}
+
+	inline XMVECTOR XMVectorReplicate(float value) { return XMVectorSet(value, value, value, value); }
+	inline XMVECTOR XMVectorZero() { return XMVectorReplicate(0.0f); }
+	inline XMVECTOR XMVectorSplatOne() { return XMVectorReplicate(1.0f); }
+	inline XMVECTOR XMVectorSplatX(FXMVECTOR v) { return XMVectorReplicate(v.v[0]); }
+	inline XMVECTOR XMVectorSplatY(FXMVECTOR v) { return XMVectorReplicate(v.v[1]); }
+	inline XMVECTOR XMVectorSplatZ(FXMVECTOR v) { return XMVectorReplicate(v.v[2]); }
+	inline XMVECTOR XMVectorSplatW(FXMVECTOR v) { return XMVectorReplicate(v.v[3]); }
+
+	inline float XMVectorGetX(FXMVECTOR v) { return v.v[0]; }
+	inline float XMVectorGetY(FXMVECTOR v) { return v.v[1]; }
+	inline float XMVectorGetZ(FXMVECTOR v) { return v.v[2]; }
+	inline float XMVectorGetW(FXMVECTOR v) { return v.v[3]; }
+
+	inline XMVECTOR XMVectorSetX(FXMVECTOR v, float x) { return XMVectorSet(x, v.v[1], v.v[2], v.v[3]); }
+	inline XMVECTOR XMVectorSetY(FXMVECTOR v, float y) { return XMVectorSet(v.v[0], y, v.v[2], v.v[3]); }
+	inline XMVECTOR XMVectorSetZ(FXMVECTOR v, float z) { return XMVectorSet(v.v[0], v.v[1], z, v.v[3]); }
+	inline XMVECTOR XMVectorSetW(FXMVECTOR v, float w) { return XMVectorSet(v.v[0], v.v[1], v.v[2], w); }
+
+	template <uint32_t X, uint32_t Y, uint32_t Z, uint32_t W> inline XMVECTOR XMVectorSwizzle(FXMVECTOR v)
+	{
+		static_assert(X < 4 && Y < 4 && Z < 4 && W < 4, "Swizzle indices out of range");
+		return XMVectorSet(v.v[X], v.v[Y], v.v[Z], v.v[W]);
+	}
+
+	inline XMVECTOR XMLoadFloat2(const XMFLOAT2* source) { return XMVectorSet(source->x, source->y, 0.0f, 0.0f); }
+	inline XMVECTOR XMLoadFloat3(const XMFLOAT3* source) { return XMVectorSet(source->x, source->y, source->z, 0.0f); }
+	inline XMVECTOR XMLoadFloat4(const XMFLOAT4* source) { return XMVectorSet(source->x, source->y, source->z, source->w); }
+
+	inline void XMStoreFloat(float* destination, FXMVECTOR v) { *destination = v.v[0]; }
+	inline void XMStoreFloat2(XMFLOAT2* destination, FXMVECTOR v) { destination->x = v.v[0]; destination->y = v.v[1]; }
+	inline void XMStoreFloat3(XMFLOAT3* destination, FXMVECTOR v) { destination->x = v.v[0]; destination->y = v.v[1]; destination->z = v.v[2]; }
+	inline void XMStoreFloat4(XMFLOAT4* destination, FXMVECTOR v) { destination->x = v.v[0]; destination->y = v.v[1]; destination->z = v.v[2]; destination->w = v.v[3]; }
+
+	// --------------------------------------------------------
+	// Per-component math
+	// --------------------------------------------------------
+	namespace Internal
+	{
+		inline uint32_t Bits(float value) { uint32_t bits; memcpy(&bits, &value, sizeof(bits)); return bits; }
+		inline float FromBits(uint32_t bits) { float value; memcpy(&value, &bits, sizeof(value)); return value; }
+		inline float Mask(bool set) { return FromBits(set ? 0xFFFFFFFFu : 0u); }
+	}
+
+	inline XMVECTOR XMVectorAdd(FXMVECTOR a, FXMVECTOR b) { return XMVectorSet(a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]); }
+	inline XMVECTOR XMVectorSubtract(FXMVECTOR a, FXMVECTOR b) { return XMVectorSet(a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]); }
+	inline XMVECTOR XMVectorMultiply(FXMVECTOR a, FXMVECTOR b) { return XMVectorSet(a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]); }
+	inline XMVECTOR XMVectorDivide(FXMVECTOR a, FXMVECTOR b) { return XMVectorSet(a.v[0] / b.v[0], a.v[1] / b.v[1], a.v[2] / b.v[2], a.v[3] / b.v[3]); }
+	inline XMVECTOR XMVectorMultiplyAdd(FXMVECTOR a, FXMVECTOR b, FXMVECTOR c) { return XMVectorAdd(XMVectorMultiply(a, b), c); }
+	inline XMVECTOR XMVectorScale(FXMVECTOR v, float scale) { return XMVectorMultiply(v, XMVectorReplicate(scale)); }
+	inline XMVECTOR XMVectorNegate(FXMVECTOR v) { return XMVectorSet(-v.v[0], -v.v[1], -v.v[2], -v.v[3]); }
+	inline XMVECTOR XMVectorReciprocal(FXMVECTOR v) { return XMVectorDivide(XMVectorSplatOne(), v); }
+	inline XMVECTOR XMVectorAbs(FXMVECTOR v) { return XMVectorSet(fabsf(v.v[0]), fabsf(v.v[1]), fabsf(v.v[2]), fabsf(v.v[3])); }
+	inline XMVECTOR XMVectorSqrt(FXMVECTOR v) { return XMVectorSet(sqrtf(v.v[0]), sqrtf(v.v[1]), sqrtf(v.v[2]), sqrtf(v.v[3])); }
+	inline XMVECTOR XMVectorFloor(FXMVECTOR v) { return XMVectorSet(floorf(v.v[0]), floorf(v.v[1]), floorf(v.v[2]), floorf(v.v[3])); }
+
+	inline XMVECTOR XMVectorLerp(FXMVECTOR a, FXMVECTOR b, float t)
+	{
+		return XMVectorAdd(a, XMVectorScale(XMVectorSubtract(b, a), t));
+	}
+
+	// Like SSE's min/max: b wins unless a is strictly smaller (larger)
+	inline XMVECTOR XMVectorMin(FXMVECTOR a, FXMVECTOR b)
+	{
+		return XMVectorSet(a.v[0] < b.v[0] ? a.v[0] : b.v[0], a.v[1] < b.v[1] ? a.v[1] : b.v[1], a.v[2] < b.v[2] ? a.v[2] : b.v[2], a.v[3] < b.v[3] ? a.v[3] : b.v[3]);
+	}
+
+	inline XMVECTOR XMVectorMax(FXMVECTOR a, FXMVECTOR b)
+	{
+		return XMVectorSet(a.v[0] > b.v[0] ? a.v[0] : b.v[0], a.v[1] > b.v[1] ? a.v[1] : b.v[1], a.v[2] > b.v[2] ? a.v[2] : b.v[2], a.v[3] > b.v[3] ? a.v[3] : b.v[3]);
+	}
+
+	inline XMVECTOR XMVectorClamp(FXMVECTOR v, FXMVECTOR low, FXMVECTOR high) { return XMVectorMin(XMVectorMax(v, low), high); }
+	inline XMVECTOR XMVectorSaturate(FXMVECTOR v) { return XMVectorClamp(v, XMVectorZero(), XMVectorSplatOne()); }
+
+	// Comparisons give all-ones or all-zeros per component, for
+	// XMVectorSelect and the Int functions
+	inline XMVECTOR XMVectorLess(FXMVECTOR a, FXMVECTOR b)
+	{
+		using Internal::Mask;
+		return XMVectorSet(Mask(a.v[0] < b.v[0]), Mask(a.v[1] < b.v[1]), Mask(a.v[2] < b.v[2]), Mask(a.v[3] < b.v[3]));
+	}
+
+	inline XMVECTOR XMVectorLessOrEqual(FXMVECTOR a, FXMVECTOR b)
+	{
+		using Internal::Mask;
+		return XMVectorSet(Mask(a.v[0] <= b.v[0]), Mask(a.v[1] <= b.v[1]), Mask(a.v[2] <= b.v[2]), Mask(a.v[3] <= b.v[3]));
+	}
+
+	inline XMVECTOR XMVectorGreater(FXMVECTOR a, FXMVECTOR b) { return XMVectorLess(b, a); }
+	inline XMVECTOR XMVectorGreaterOrEqual(FXMVECTOR a, FXMVECTOR b) { return XMVectorLessOrEqual(b, a); }
+
+	inline XMVECTOR XMVectorSelectControl(uint32_t x, uint32_t y, uint32_t z, uint32_t w)
+	{
+		using Internal::Mask;
+		return XMVectorSet(Mask(x != 0), Mask(y != 0), Mask(z != 0), Mask(w != 0));
+	}
+
+	inline XMVECTOR XMVectorAndInt(FXMVECTOR a, FXMVECTOR b)
+	{
+		XMVECTOR result;
+		for (int i = 0; i < 4; i++)
+			result.v[i] = Internal::FromBits(Internal::Bits(a.v[i]) & Internal::Bits(b.v[i]));
+		return result;
+	}
+
+	inline XMVECTOR XMVectorOrInt(FXMVECTOR a, FXMVECTOR b)
+	{
+		XMVECTOR result;
+		for (int i = 0; i < 4; i++)
+			result.v[i] = Internal::FromBits(Internal::Bits(a.v[i]) | Internal::Bits(b.v[i]));
+		return result;
+	}
+
+	// Each bit from b where control is set, a where it isn't
+	inline XMVECTOR XMVectorSelect(FXMVECTOR a, FXMVECTOR b, FXMVECTOR control)
+	{
+		XMVECTOR result;
+		for (int i = 0; i < 4; i++)
+		{
+			uint32_t mask = Internal::Bits(control.v[i]);
+			result.v[i] = Internal::FromBits((Internal::Bits(a.v[i]) & ~mask) | (Internal::Bits(b.v[i]) & mask));
+		}
+		return result;
+	}
+
+	inline XMVECTOR operator+(FXMVECTOR a, FXMVECTOR b) { return XMVectorAdd(a, b); }
+	inline XMVECTOR operator-(FXMVECTOR a, FXMVECTOR b) { return XMVectorSubtract(a, b); }
+	inline XMVECTOR operator*(FXMVECTOR a, FXMVECTOR b) { return XMVectorMultiply(a, b); }
+	inline XMVECTOR operator/(FXMVECTOR a, FXMVECTOR b) { return XMVectorDivide(a, b); }
+	inline XMVECTOR operator*(FXMVECTOR v, float scale) { return XMVectorScale(v, scale); }
+	inline XMVECTOR operator*(float scale, FXMVECTOR v) { return XMVectorScale(v, scale); }
+	inline XMVECTOR operator/(FXMVECTOR v, float scale) { return XMVectorScale(v, 1.0f / scale); }
+	inline XMVECTOR operator-(FXMVECTOR v) { return XMVectorNegate(v); }
+	inline XMVECTOR& operator+=(XMVECTOR& a, FXMVECTOR b) { a = XMVectorAdd(a, b); return a; }
+	inline XMVECTOR& operator-=(XMVECTOR& a, FXMVECTOR b) { a = XMVectorSubtract(a, b); return a; }
+	inline XMVECTOR& operator*=(XMVECTOR& a, FXMVECTOR b) { a = XMVectorMultiply(a, b); return a; }
+	inline XMVECTOR& operator*=(XMVECTOR& v, float scale) { v = XMVectorScale(v, scale); return v; }
+
+	// --------------------------------------------------------
+	// 3D vectors and planes.  Results are replicated into
+	// every component, as with the real functions.
+	// --------------------------------------------------------
+	inline XMVECTOR XMVector3Dot(FXMVECTOR a, FXMVECTOR b)
+	{
+		return XMVectorReplicate(a.v[0] * b.v[0] + a.v[1] * b.v[1] + a.v[2] * b.v[2]);
+	}
+
+	inline XMVECTOR XMVector4Dot(FXMVECTOR a, FXMVECTOR b)
+	{
+		return XMVectorReplicate(a.v[0] * b.v[0] + a.v[1] * b.v[1] + a.v[2] * b.v[2] + a.v[3] * b.v[3]);
+	}
+
+	inline XMVECTOR XMVector3LengthSq(FXMVECTOR v) { return XMVector3Dot(v, v); }
+	inline XMVECTOR XMVector3Length(FXMVECTOR v) { return XMVectorSqrt(XMVector3LengthSq(v)); }
+
+	// A zero vector stays zero
+	inline XMVECTOR XMVector3Normalize(FXMVECTOR v)
+	{
+		float length = XMVectorGetX(XMVector3Length(v));
+		return length > 0.0f ? XMVectorScale(v, 1.0f / length) : v;
+	}
+
+	inline XMVECTOR XMVector3Cross(FXMVECTOR a, FXMVECTOR b)
+	{
+		return XMVectorSet(
+			a.v[1] * b.v[2] - a.v[2] * b.v[1],
+			a.v[2] * b.v[0] - a.v[0] * b.v[2],
+			a.v[0] * b.v[1] - a.v[1] * b.v[0],
+			0.0f);
+	}
+
+	inline XMVECTOR XMPlaneNormalize(FXMVECTOR plane)
+	{
+		float length = XMVectorGetX(XMVector3Length(plane));
+		return length > 0.0f ? XMVectorScale(plane, 1.0f / length) : plane;
+	}
+
+	inline XMVECTOR XMPlaneDotCoord(FXMVECTOR plane, FXMVECTOR point)
+	{
+		return XMVectorReplicate(plane.v[0] * point.v[0] + plane.v[1] * point.v[1] + plane.v[2] * point.v[2] + plane.v[3]);
+	}
+
+	inline float XMScalarACos(float value) { return acosf(value < -1.0f ? -1.0f : value > 1.0f ? 1.0f : value); }
+
+	// --------------------------------------------------------
+	// Matrices (row vectors, as in DirectXMath: v * M)
+	// --------------------------------------------------------
+	inline XMVECTOR XMVector4Transform(FXMVECTOR v, FXMMATRIX m)
+	{
+		XMVECTOR result = XMVectorZero();
+		for (int row = 0; row < 4; row++)
+			result = XMVectorMultiplyAdd(XMVectorReplicate(v.v[row]), m.r[row], result);
+		return result;
+	}
+
+	inline XMVECTOR XMVector3TransformCoord(FXMVECTOR v, FXMMATRIX m)
+	{
+		XMVECTOR result = XMVector4Transform(XMVectorSetW(v, 1.0f), m);
+		return XMVectorScale(result, 1.0f / result.v[3]);
+	}
+
+	inline XMVECTOR XMVector3TransformNormal(FXMVECTOR v, FXMMATRIX m)
+	{
+		return XMVector4Transform(XMVectorSetW(v, 0.0f), m);
+	}
+
+	inline XMMATRIX XMMatrixIdentity()
+	{
+		return XMMATRIX(1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1);
+	}
+
+	inline XMMATRIX XMMatrixMultiply(FXMMATRIX a, CXMMATRIX b)
+	{
+		XMMATRIX result;
+		for (int row = 0; row < 4; row++)
+			result.r[row] = XMVector4Transform(a.r[row], b);
+		return result;
+	}
+
+	inline XMMATRIX operator*(FXMMATRIX a, CXMMATRIX b) { return XMMatrixMultiply(a, b); }
+
+	inline XMMATRIX XMMatrixTranspose(FXMMATRIX m)
+	{
+		XMMATRIX result;
+		for (int row = 0; row < 4; row++)
+		{
+			for (int column = 0; column < 4; column++)
+				result.r[row].v[column] = m.r[column].v[row];
+		}
+		return result;
+	}
+
+	// Gauss-Jordan with partial pivoting, in doubles.  A singular
+	// matrix gives a zero determinant (and a meaningless result).
+	inline XMMATRIX XMMatrixInverse(XMVECTOR* determinant, FXMMATRIX m)
+	{
+		double a[4][8];
+		for (int row = 0; row < 4; row++)
+		{
+			for (int column = 0; column < 4; column++)
+			{
+				a[row][column] = m.r[row].v[column];
+				a[row][column + 4] = row == column ? 1.0 : 0.0;
+			}
+		}
+
+		double det = 1.0;
+		for (int column = 0; column < 4; column++)
+		{
+			int pivot = column;
+			for (int row = column + 1; row < 4; row++)
+			{
+				if (fabs(a[row][column]) > fabs(a[pivot][column]))
+					pivot = row;
+			}
+			if (pivot != column)
+			{
+				for (int i = 0; i < 8; i++)
+				{
+					double swap = a[pivot][i];
+					a[pivot][i] = a[column][i];
+					a[column][i] = swap;
+				}
+				det = -det;
+			}
+
+			det *= a[column][column];
+			double scale = a[column][column] != 0.0 ? 1.0 / a[column][column] : 0.0;
+			for (int i = 0; i < 8; i++)
+				a[column][i] *= scale;
+
+			for (int row = 0; row < 4; row++)
+			{
+				if (row == column)
+					continue;
+				double factor = a[row][column];
+				for (int i = 0; i < 8; i++)
+					a[row][i] -= factor * a[column][i];
+			}
+		}
+
+		if (determinant)
+			*determinant = XMVectorReplicate((float)det);
+
+		XMMATRIX result;
+		for (int row = 0; row < 4; row++)
+		{
+			for (int column = 0; column < 4; column++)
+				result.r[row].v[column] = (float)a[row][column + 4];
+		}
+		return result;
+	}
+
+	inline XMMATRIX XMMatrixScaling(float x, float y, float z)
+	{
+		return XMMATRIX(x, 0, 0, 0, 0, y, 0, 0, 0, 0, z, 0, 0, 0, 0, 1);
+	}
+
+	inline XMMATRIX XMMatrixTranslation(float x, float y, float z)
+	{
+		return XMMATRIX(1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, x, y, z, 1);
+	}
+
+	inline XMMATRIX XMMatrixRotationX(float angle)
+	{
+		float s = sinf(angle), c = cosf(angle);
+		return XMMATRIX(1, 0, 0, 0, 0, c, s, 0, 0, -s, c, 0, 0, 0, 0, 1);
+	}
+
+	inline XMMATRIX XMMatrixRotationY(float angle)
+	{
+		float s = sinf(angle), c = cosf(angle);
+		return XMMATRIX(c, 0, -s, 0, 0, 1, 0, 0, s, 0, c, 0, 0, 0, 0, 1);
+	}
+
+	inline XMMATRIX XMMatrixRotationZ(float angle)
+	{
+		float s = sinf(angle), c = cosf(angle);
+		return XMMATRIX(c, s, 0, 0, -s, c, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1);
+	}
+
+	inline XMMATRIX XMMatrixRotationRollPitchYaw(float pitch, float yaw, float roll)
+	{
+		return XMMatrixRotationZ(roll) * XMMatrixRotationX(pitch) * XMMatrixRotationY(yaw);
+	}
+
+	inline XMMATRIX XMMatrixLookToLH(FXMVECTOR eye, FXMVECTOR direction, FXMVECTOR up)
+	{
+		XMVECTOR z = XMVector3Normalize(direction);
+		XMVECTOR x = XMVector3Normalize(XMVector3Cross(up, z));
+		XMVECTOR y = XMVector3Cross(z, x);
+		return XMMATRIX(
+			x.v[0], y.v[0], z.v[0], 0,
+			x.v[1], y.v[1], z.v[1], 0,
+			x.v[2], y.v[2], z.v[2], 0,
+			-XMVectorGetX(XMVector3Dot(x, eye)), -XMVectorGetX(XMVector3Dot(y, eye)), -XMVectorGetX(XMVector3Dot(z, eye)), 1);
+	}
+
+	inline XMMATRIX XMMatrixLookAtLH(FXMVECTOR eye, FXMVECTOR focus, FXMVECTOR up)
+	{
+		return XMMatrixLookToLH(eye, XMVectorSubtract(focus, eye), up);
+	}
+
+	inline XMMATRIX XMMatrixPerspectiveFovLH(float fovY, float aspect, float nearZ, float farZ)
+	{
+		float height = 1.0f / tanf(fovY * 0.5f);
+		float width = height / aspect;
+		float range = farZ / (farZ - nearZ);
+		return XMMATRIX(width, 0, 0, 0, 0, height, 0, 0, 0, 0, range, 1, 0, 0, -range * nearZ, 0);
+	}
+
+	inline XMMATRIX XMLoadFloat4x4(const XMFLOAT4X4* source)
+	{
+		XMMATRIX result;
+		for (int row = 0; row < 4; row++)
+			result.r[row] = XMVectorSet(source->m[row][0], source->m[row][1], source->m[row][2], source->m[row][3]);
+		return result;
+	}
+
+	inline void XMStoreFloat4x4(XMFLOAT4X4* destination, FXMMATRIX m)
+	{
+		for (int row = 0; row < 4; row++)
+			memcpy(destination->m[row], m.r[row].v, sizeof(destination->m[row]));
+	}
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "DirectXMath.h"
+
+// --------------------------------------------------------
+// The packed vertex types from DirectXPackedVector.h, and
+// the loads and stores that convert them (see
+// DirectXMath.h in this directory for why this exists).
+// --------------------------------------------------------
+
+namespace DirectX
+{
+	namespace PackedVector
+	{
+		typedef uint16_t HALF;
+
+		struct XMHALF2 { HALF x, y; };
+		struct XMHALF4 { HALF x, y, z, w; };
+		struct XMSHORTN2 { int16_t x, y; };
+		struct XMSHORTN4 { int16_t x, y, z, w; };
+		struct XMUBYTE4 { uint8_t x, y, z, w; };
+		struct XMUBYTEN4 { uint8_t x, y, z, w; };
+
+		// Round to nearest even, overflowing to the largest finite
+		// half (as the real one does) rather than to infinity
+		inline HALF XMConvertFloatToHalf(float value)
+		{
+			uint32_t bits = DirectX::Internal::Bits(value);
+			uint32_t sign = (bits >> 16) & 0x8000;
+			uint32_t exponent = (bits >> 23) & 0xFF;
+			uint32_t mantissa = bits & 0x7FFFFF;
+
+			if (exponent == 0xFF)
+				return (HALF)(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+
+			int halfExponent = (int)exponent - 127 + 15;
+			if (halfExponent >= 31)
+				return (HALF)(sign | 0x7BFF);
+
+			if (halfExponent <= 0)
+			{
+				// Denormal, or too small for even that
+				if (halfExponent < -10)
+					return (HALF)sign;
+				mantissa |= 0x800000;
+				uint32_t shift = (uint32_t)(14 - halfExponent);
+				uint32_t half = mantissa >> shift;
+				uint32_t rest = mantissa & ((1u << shift) - 1);
+				uint32_t midpoint = 1u << (shift - 1);
+				if (rest > midpoint || (rest == midpoint && (half & 1)))
+					half++;
+				return (HALF)(sign | half);
+			}
+
+			uint32_t half = ((uint32_t)halfExponent << 10) | (mantissa >> 13);
+			uint32_t rest = mantissa & 0x1FFF;
+			if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+				half++;
+			if (half >= 0x7C00)
+				half = 0x7BFF;
+			return (HALF)(sign | half);
+		}
+
+		inline float XMConvertHalfToFloat(HALF value)
+		{
+			uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+			uint32_t exponent = (value >> 10) & 0x1F;
+			uint32_t mantissa = value & 0x3FF;
+
+			if (exponent == 0)
+			{
+				float denormal = ldexpf((float)mantissa, -24);
+				return sign ? -denormal : denormal;
+			}
+			if (exponent == 31)
+				return DirectX::Internal::FromBits(sign | 0x7F800000 | (mantissa << 13));
+			return DirectX::Internal::FromBits(sign | ((exponent - 15 + 127) << 23) | (mantissa << 13));
+		}
+
+		namespace Internal
+		{
+			inline int16_t ToShortN(float value)
+			{
+				value = value < -1.0f ? -1.0f : value > 1.0f ? 1.0f : value;
+				return (int16_t)lrintf(value * 32767.0f);
+			}
+
+			// -32768 and -32767 both mean -1
+			inline float FromShortN(int16_t value)
+			{
+				return value == -32768 ? -1.0f : value / 32767.0f;
+			}
+		}
+
+		inline XMVECTOR XMLoadHalf2(const XMHALF2* source)
+		{
+			return XMVectorSet(XMConvertHalfToFloat(source->x), XMConvertHalfToFloat(source->y), 0.0f, 0.0f);
+		}
+
+		inline XMVECTOR XMLoadHalf4(const XMHALF4* source)
+		{
+			return XMVectorSet(XMConvertHalfToFloat(source->x), XMConvertHalfToFloat(source->y), XMConvertHalfToFloat(source->z), XMConvertHalfToFloat(source->w));
+		}
+
+		inline XMVECTOR XMLoadShortN2(const XMSHORTN2* source)
+		{
+			return XMVectorSet(Internal::FromShortN(source->x), Internal::FromShortN(source->y), 0.0f, 0.0f);
+		}
+
+		inline XMVECTOR XMLoadShortN4(const XMSHORTN4* source)
+		{
+			return XMVectorSet(Internal::FromShortN(source->x), Internal::FromShortN(source->y), Internal::FromShortN(source->z), Internal::FromShortN(source->w));
+		}
+
+		inline void XMStoreHalf2(XMHALF2* destination, FXMVECTOR v)
+		{
+			destination->x = XMConvertFloatToHalf(v.v[0]);
+			destination->y = XMConvertFloatToHalf(v.v[1]);
+		}
+
+		inline void XMStoreHalf4(XMHALF4* destination, FXMVECTOR v)
+		{
+			destination->x = XMConvertFloatToHalf(v.v[0]);
+			destination->y = XMConvertFloatToHalf(v.v[1]);
+			destination->z = XMConvertFloatToHalf(v.v[2]);
+			destination->w = XMConvertFloatToHalf(v.v[3]);
+		}
+
+		inline void XMStoreShortN2(XMSHORTN2* destination, FXMVECTOR v)
+		{
+			destination->x = Internal::ToShortN(v.v[0]);
+			destination->y = Internal::ToShortN(v.v[1]);
+		}
+
+		inline void XMStoreShortN4(XMSHORTN4* destination, FXMVECTOR v)
+		{
+			destination->x = Internal::ToShortN(v.v[0]);
+			destination->y = Internal::ToShortN(v.v[1]);
+			destination->z = Internal::ToShortN(v.v[2]);
+			destination->w = Internal::ToShortN(v.v[3]);
+		}
+	}
+}
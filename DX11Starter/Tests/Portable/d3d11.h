@@ -0,0 +1,44 @@
+#pragma once
+
+// --------------------------------------------------------
+// Just enough of d3d11.h for VertexFormat.h: the DXGI
+// formats vertices use and the input element description.
+// Values match the Windows SDK.  (See DirectXMath.h in
+// this directory for why this exists.)
+// --------------------------------------------------------
+
+enum DXGI_FORMAT
+{
+	DXGI_FORMAT_UNKNOWN				= 0,
+	DXGI_FORMAT_R32G32B32A32_FLOAT	= 2,
+	DXGI_FORMAT_R32G32B32_FLOAT		= 6,
+	DXGI_FORMAT_R16G16B16A16_FLOAT	= 10,
+	DXGI_FORMAT_R16G16B16A16_SNORM	= 13,
+	DXGI_FORMAT_R32G32_FLOAT		= 16,
+	DXGI_FORMAT_R8G8B8A8_UNORM		= 28,
+	DXGI_FORMAT_R8G8B8A8_UINT		= 30,
+	DXGI_FORMAT_R16G16_FLOAT		= 34,
+	DXGI_FORMAT_R16G16_SNORM		= 37,
+	DXGI_FORMAT_R32_FLOAT			= 41,
+	DXGI_FORMAT_R32_UINT			= 42,
+	DXGI_FORMAT_R8_UNORM			= 61,
+};
+
+enum D3D11_INPUT_CLASSIFICATION
+{
+	D3D11_INPUT_PER_VERTEX_DATA		= 0,
+	D3D11_INPUT_PER_INSTANCE_DATA	= 1,
+};
+
+#define D3D11_APPEND_ALIGNED_ELEMENT	(0xffffffff)
+
+struct D3D11_INPUT_ELEMENT_DESC
+{
+	const char* SemanticName;
+	unsigned int SemanticIndex;
+	DXGI_FORMAT Format;
+	unsigned int InputSlot;
+	unsigned int AlignedByteOffset;
+	D3D11_INPUT_CLASSIFICATION InputSlotClass;
+	unsigned int InstanceDataStepRate;
+};
@@ -0,0 +1,274 @@
+#include "EntityStorage.h"
+#include "LightProbes.h"
+#include "SceneRaycaster.h"
+#include "BenchmarkMeshes.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+// --------------------------------------------------------
+// Times baking the SH probe grid around each bundled model,
+// in probes and rays per second, across a thread pool with a
+// worker per core.
+//
+// Then times a frame's worth of per-entity work for 100k (by
+// default) entities, with the SH ambient light stored two
+// ways:
+//
+//  - In the entity (how it used to be): every tick writes
+//    144 bytes into each entity, and every frame drags them
+//    through the cache again while building the draw list.
+//  - Sampled per frame into an array next to the draw list
+//    (what Game::Draw does now), which leaves the entities
+//    at half the size.
+//
+// Both do the same sampling, world matrix and "upload" (a
+// copy into a staging cbuffer) for every entity.
+//
+//   ProbeSamplingBenchmark [entities] [frames] [rays per probe]
+// --------------------------------------------------------
+
+// LightProbes.cpp bakes against a SceneRaycaster, but building
+// one takes the game's entities (and so D3D).  The scene here
+// is one model at the origin, traced with its own TriangleBVH,
+// which is where SceneRaycaster's queries spend their time
+// too.
+static const TriangleBVH* benchmarkScene = 0;
+
+bool SceneRaycaster::Raycast(const Ray& ray, SceneHit* hit) const
+{
+	RayHit meshHit;
+	if (!benchmarkScene || !benchmarkScene->IntersectClosest(ray, &meshHit))
+		return false;
+
+	hit->Entity = 0;
+	hit->Distance = meshHit.Distance;
+	hit->Triangle = meshHit.Triangle;
+	XMStoreFloat3(&hit->Position, XMVectorMultiplyAdd(XMLoadFloat3(&ray.Direction), XMVectorReplicate(meshHit.Distance), XMLoadFloat3(&ray.Origin)));
+	hit->FrontFace = meshHit.FrontFace;
+	return true;
+}
+
+// --------------------------------------------------------
+// Bakes a grid the way Game::BakeProbes() does: 16x8x16
+// probes around the scene, with a margin, and rays reaching
+// half way across it
+// --------------------------------------------------------
+static void RunBake(const BenchmarkMesh& mesh, unsigned int raysPerProbe, ThreadPool* threads)
+{
+	TriangleBVH bvh;
+	bvh.Build(&mesh.Vertices[0], (unsigned int)mesh.Vertices.size(), &mesh.Indices[0], (unsigned int)mesh.Indices.size());
+	benchmarkScene = &bvh;
+
+	XMFLOAT3 sceneMin, sceneMax;
+	bvh.GetBounds(&sceneMin, &sceneMax);
+	XMVECTOR extent = XMVectorSubtract(XMLoadFloat3(&sceneMax), XMLoadFloat3(&sceneMin));
+	float size = XMVectorGetX(XMVector3Length(extent));
+	XMVECTOR margin = XMVectorReplicate(size * 0.1f);
+	XMStoreFloat3(&sceneMin, XMVectorSubtract(XMLoadFloat3(&sceneMin), margin));
+	XMStoreFloat3(&sceneMax, XMVectorAdd(XMLoadFloat3(&sceneMax), margin));
+	SHProbeGrid grid(sceneMin, sceneMax, 16, 8, 16);
+
+	SHBakeSettings settings;
+	settings.SkyColor = XMFLOAT3(0.4f, 0.5f, 0.7f);
+	settings.GroundColor = XMFLOAT3(0.2f, 0.25f, 0.35f);
+	settings.RaysPerProbe = raysPerProbe;
+	settings.MaxDistance = size * 0.5f;
+
+	auto start = std::chrono::high_resolution_clock::now();
+	grid.Bake(SceneRaycaster(), settings, threads);
+	double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	benchmarkScene = 0;
+
+	unsigned int probes = grid.GetProbeCount();
+	printf("Bake %-12s %7u tris  %u probes x %u rays  %8.2f ms on %u threads  %8.0f probes/s  %6.2f Mrays/s\n",
+		mesh.Name.c_str(), (unsigned int)mesh.Indices.size() / 3, probes, raysPerProbe,
+		seconds * 1e3, threads->GetThreadCount(), probes / seconds, (double)probes * raysPerProbe / seconds / 1e6);
+}
+
+// GameEntity's data, without its D3D dependencies
+struct SlimEntity
+{
+	XMFLOAT3 Position;
+	XMFLOAT3 Scalar;
+	XMFLOAT3 Rotation;
+	XMFLOAT3 PreviousPosition;
+	XMFLOAT3 PreviousScalar;
+	XMFLOAT3 PreviousRotation;
+	XMFLOAT4X4 World;
+	unsigned int Mesh;
+	unsigned int Material;
+	float AngleFromOrigin;
+};
+
+// ...and how it was, with its ambient light inside
+struct FatEntity : SlimEntity
+{
+	SHCoefficients Ambient;
+};
+
+template <typename EntityType> static void Place(EntityType* entity, std::mt19937& random, XMFLOAT3 size)
+{
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	entity->Position = XMFLOAT3(unit(random) * size.x, unit(random) * size.y, unit(random) * size.z);
+	entity->Scalar = XMFLOAT3(1, 1, 1);
+	entity->Rotation = XMFLOAT3(0, 0, unit(random) * 6.28f);
+	entity->PreviousPosition = entity->Position;
+	entity->PreviousScalar = entity->Scalar;
+	entity->PreviousRotation = entity->Rotation;
+	entity->Material = random() % 8;
+	entity->Mesh = random() % 4;
+	entity->AngleFromOrigin = 0.0f;
+}
+
+// Same as GameEntity::CalculateWorldMatrix() and GetWorldViewProj()
+static void WorldViewProj(SlimEntity* entity, float interpolation, const XMFLOAT4X4& viewProjection, XMFLOAT4X4* result)
+{
+	XMFLOAT3 position, scalar, rotation;
+	XMStoreFloat3(&position, XMVectorLerp(XMLoadFloat3(&entity->PreviousPosition), XMLoadFloat3(&entity->Position), interpolation));
+	XMStoreFloat3(&scalar, XMVectorLerp(XMLoadFloat3(&entity->PreviousScalar), XMLoadFloat3(&entity->Scalar), interpolation));
+	XMStoreFloat3(&rotation, XMVectorLerp(XMLoadFloat3(&entity->PreviousRotation), XMLoadFloat3(&entity->Rotation), interpolation));
+
+	XMMATRIX world = XMMatrixScaling(scalar.x, scalar.y, scalar.z) * XMMatrixRotationZ(rotation.z) * XMMatrixTranslation(position.x, position.y, position.z);
+	XMStoreFloat4x4(&entity->World, XMMatrixTranspose(world));
+	XMStoreFloat4x4(result, XMMatrixMultiply(XMLoadFloat4x4(&viewProjection), XMLoadFloat4x4(&entity->World)));
+}
+
+struct Result
+{
+	double Seconds;
+	double Checksum;	// Keeps the work from being optimized away
+};
+
+// Copies what the shaders would get, like SetBufferData()
+struct Staging
+{
+	XMFLOAT4X4 WorldViewProj;
+	SHCoefficients Ambient;
+	double Checksum;
+
+	void Upload(const XMFLOAT4X4& worldViewProj, const SHCoefficients& ambient)
+	{
+		memcpy(&WorldViewProj, &worldViewProj, sizeof(WorldViewProj));
+		memcpy(&Ambient, &ambient, sizeof(Ambient));
+		Checksum += WorldViewProj._14 + Ambient.C[0].x;
+	}
+};
+
+template <typename EntityType> static bool ByMaterial(EntityType* a, EntityType* b)
+{
+	return a->Material < b->Material;
+}
+
+// The old way: Update() samples into every entity, then Draw()
+// builds the sorted list and reads it back out of them
+static Result RunInEntity(unsigned int entityCount, unsigned int frames, const SHProbeGrid& grid, XMFLOAT3 size)
+{
+	EntityStorage<FatEntity> entities;
+	std::mt19937 random(99);
+	for (unsigned int i = 0; i < entityCount; i++)
+		Place(entities.Get(entities.Spawn()), random, size);
+
+	std::vector<FatEntity*> drawList;
+	std::vector<XMFLOAT4X4> worldViewProjs;
+	drawList.reserve(entityCount);
+	worldViewProjs.reserve(entityCount);
+	XMFLOAT4X4 viewProjection;
+	XMStoreFloat4x4(&viewProjection, XMMatrixIdentity());
+	Staging staging = {};
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for (unsigned int f = 0; f < frames; f++)
+	{
+		entities.ForEach([&](FatEntity* entity) { grid.Sample(XMLoadFloat3(&entity->Position), &entity->Ambient); });
+
+		drawList.clear();
+		worldViewProjs.clear();
+		entities.ForEach([&](FatEntity* entity) { drawList.push_back(entity); });
+		std::sort(drawList.begin(), drawList.end(), ByMaterial<FatEntity>);
+
+		worldViewProjs.resize(drawList.size());
+		for (unsigned int i = 0; i < drawList.size(); i++)
+			WorldViewProj(drawList[i], 0.5f, viewProjection, &worldViewProjs[i]);
+		for (unsigned int i = 0; i < drawList.size(); i++)
+			staging.Upload(worldViewProjs[i], drawList[i]->Ambient);
+	}
+
+	Result result;
+	result.Seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	result.Checksum = staging.Checksum;
+	return result;
+}
+
+// The new way: sampled alongside the world matrices, into an
+// array that only lasts the frame
+static Result RunPerFrame(unsigned int entityCount, unsigned int frames, const SHProbeGrid& grid, XMFLOAT3 size)
+{
+	EntityStorage<SlimEntity> entities;
+	std::mt19937 random(99);
+	for (unsigned int i = 0; i < entityCount; i++)
+		Place(entities.Get(entities.Spawn()), random, size);
+
+	std::vector<SlimEntity*> drawList;
+	std::vector<XMFLOAT4X4> worldViewProjs;
+	std::vector<SHCoefficients> ambients;
+	drawList.reserve(entityCount);
+	worldViewProjs.reserve(entityCount);
+	ambients.reserve(entityCount);
+	XMFLOAT4X4 viewProjection;
+	XMStoreFloat4x4(&viewProjection, XMMatrixIdentity());
+	Staging staging = {};
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for (unsigned int f = 0; f < frames; f++)
+	{
+		drawList.clear();
+		worldViewProjs.clear();
+		entities.ForEach([&](SlimEntity* entity) { drawList.push_back(entity); });
+		std::sort(drawList.begin(), drawList.end(), ByMaterial<SlimEntity>);
+
+		worldViewProjs.resize(drawList.size());
+		ambients.resize(drawList.size());
+		for (unsigned int i = 0; i < drawList.size(); i++)
+		{
+			WorldViewProj(drawList[i], 0.5f, viewProjection, &worldViewProjs[i]);
+			grid.Sample(XMLoadFloat3(&drawList[i]->Position), &ambients[i]);
+		}
+		for (unsigned int i = 0; i < drawList.size(); i++)
+			staging.Upload(worldViewProjs[i], ambients[i]);
+	}
+
+	Result result;
+	result.Seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	result.Checksum = staging.Checksum;
+	return result;
+}
+
+int main(int argc, char** argv)
+{
+	unsigned int entityCount = argc > 1 ? (unsigned int)atoi(argv[1]) : 100000;
+	unsigned int frames = argc > 2 ? (unsigned int)atoi(argv[2]) : 100;
+	unsigned int raysPerProbe = argc > 3 ? (unsigned int)atoi(argv[3]) : 256;
+
+	ThreadPool threads;
+	std::vector<BenchmarkMesh> meshes = LoadBundledMeshes();
+	for (unsigned int i = 0; i < meshes.size(); i++)
+		RunBake(meshes[i], raysPerProbe, &threads);
+
+	// Same grid resolution the game bakes.  Sampling costs the
+	// same whatever the probes hold, so this one isn't baked.
+	XMFLOAT3 size(200.0f, 50.0f, 200.0f);
+	SHProbeGrid grid(XMFLOAT3(0, 0, 0), size, 16, 8, 16);
+
+	Result inEntity = RunInEntity(entityCount, frames, grid, size);
+	Result perFrame = RunPerFrame(entityCount, frames, grid, size);
+
+	printf("%u entities, %u frames\n", entityCount, frames);
+	printf("Ambient in the entity (%3u bytes each): %7.3f ms per frame, %6.1f M entities/s\n",
+		(unsigned int)sizeof(FatEntity), inEntity.Seconds / frames * 1e3, entityCount * frames / inEntity.Seconds / 1e6);
+	printf("Ambient per frame     (%3u bytes each): %7.3f ms per frame, %6.1f M entities/s\n",
+		(unsigned int)sizeof(SlimEntity), perFrame.Seconds / frames * 1e3, entityCount * frames / perFrame.Seconds / 1e6);
+	return inEntity.Checksum == perFrame.Checksum ? 0 : 1;
+}
@@ -0,0 +1,110 @@
+#include "RangeAllocator.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+// --------------------------------------------------------
+// Churns a geometry-pool sized RangeAllocator the way mesh
+// streaming and hot reloading would: allocations of mixed
+// mesh sizes, freed in random order, with the pool kept at
+// a target occupancy.  Reports how fragmented free space
+// gets and how often a request fails even though there's
+// enough free space in total.
+//
+//   RangeAllocatorBenchmark [operations] [occupancy %]
+// --------------------------------------------------------
+
+struct Allocation
+{
+	unsigned int Offset;
+	unsigned int Count;
+};
+
+int main(int argc, char** argv)
+{
+	unsigned int operations = argc > 1 ? (unsigned int)atoi(argv[1]) : 1000000;
+	double occupancy = (argc > 2 ? atoi(argv[2]) : 80) / 100.0;
+	const unsigned int poolSize = 16 * 1024 * 1024;	// Vertices
+
+	RangeAllocator allocator(poolSize);
+	std::vector<Allocation> live;
+	std::mt19937 random(1234);
+
+	// Mostly small props, some larger meshes, the odd huge one
+	std::lognormal_distribution<double> meshSize(7.5, 1.5);
+
+	unsigned long long allocated = 0;
+	unsigned int allocations = 0, frees = 0, failures = 0, fragmentedFailures = 0;
+	unsigned int peakRanges = 0;
+	double worstFragmentation = 0.0, fragmentationSum = 0.0;
+	unsigned int samples = 0;
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for (unsigned int op = 0; op < operations; op++)
+	{
+		bool allocate = live.empty() || allocated < occupancy * poolSize;
+		if (allocate)
+		{
+			unsigned int count = (unsigned int)meshSize(random) + 1;
+			if (count > poolSize / 16) count = poolSize / 16;
+
+			Allocation a = { 0, count };
+			if (allocator.Allocate(count, &a.Offset))
+			{
+				live.push_back(a);
+				allocated += count;
+				allocations++;
+			}
+			else
+			{
+				failures++;
+				if (allocator.GetFreeTotal() >= count)
+					fragmentedFailures++;
+
+				// Make room, as a streamer would evict something
+				std::uniform_int_distribution<size_t> pick(0, live.size() - 1);
+				size_t victim = pick(random);
+				allocator.Free(live[victim].Offset, live[victim].Count);
+				allocated -= live[victim].Count;
+				live[victim] = live.back();
+				live.pop_back();
+				frees++;
+			}
+		}
+		else
+		{
+			std::uniform_int_distribution<size_t> pick(0, live.size() - 1);
+			size_t victim = pick(random);
+			allocator.Free(live[victim].Offset, live[victim].Count);
+			allocated -= live[victim].Count;
+			live[victim] = live.back();
+			live.pop_back();
+			frees++;
+		}
+
+		if (allocator.GetFreeRangeCount() > peakRanges)
+			peakRanges = allocator.GetFreeRangeCount();
+
+		// External fragmentation: how much of the free space
+		// isn't in the largest free range
+		if (op % 1000 == 999)
+		{
+			double freeTotal = allocator.GetFreeTotal();
+			double fragmentation = freeTotal > 0 ? 1.0 - allocator.GetLargestFree() / freeTotal : 0.0;
+			fragmentationSum += fragmentation;
+			if (fragmentation > worstFragmentation)
+				worstFragmentation = fragmentation;
+			samples++;
+		}
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+	printf("%u operations on a %u vertex pool at %.0f%% occupancy\n", operations, poolSize, occupancy * 100);
+	printf("%u allocations, %u frees, %.1f ns per operation\n", allocations, frees, seconds / operations * 1e9);
+	printf("%u failed allocations (%u with enough free space in total)\n", failures, fragmentedFailures);
+	printf("Free ranges: %u now, %u at peak, %u live allocations\n", allocator.GetFreeRangeCount(), peakRanges, (unsigned int)live.size());
+	printf("Fragmentation (1 - largest free / total free): mean %.3f, worst %.3f\n",
+		samples ? fragmentationSum / samples : 0.0, worstFragmentation);
+	return 0;
+}
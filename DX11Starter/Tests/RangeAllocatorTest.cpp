@@ -0,0 +1,75 @@
+#include "RangeAllocator.h"
+#include "TestCheck.h"
+
+static void TestAllocateAndFree()
+{
+	RangeAllocator allocator(100);
+	unsigned int a, b, c;
+	CHECK(allocator.Allocate(10, &a) && a == 0);
+	CHECK(allocator.Allocate(20, &b) && b == 10);
+	CHECK(allocator.Allocate(30, &c) && c == 30);
+	CHECK(allocator.GetFreeTotal() == 40);
+
+	unsigned int none;
+	CHECK(!allocator.Allocate(0, &none));
+	CHECK(!allocator.Allocate(41, &none));
+
+	// Freeing the middle leaves a hole, and freeing its
+	// neighbours merges everything back into one range
+	allocator.Free(b, 20);
+	CHECK(allocator.GetFreeRangeCount() == 2);
+	allocator.Free(a, 10);
+	CHECK(allocator.GetFreeRangeCount() == 2);
+	allocator.Free(c, 30);
+	CHECK(allocator.GetFreeRangeCount() == 1);
+	CHECK(allocator.GetLargestFree() == 100);
+}
+
+// The smallest hole that fits wins, not the first
+static void TestBestFit()
+{
+	RangeAllocator allocator(100);
+	unsigned int offsets[5];
+	for (unsigned int i = 0; i < 5; i++)
+		allocator.Allocate(10, &offsets[i]);
+
+	allocator.Free(offsets[0], 10);	// A hole of 10 at 0
+	allocator.Free(offsets[2], 10);	// And one of 10 at 20
+	allocator.Free(offsets[3], 10);	// ...which merges to 20 at 20
+
+	unsigned int offset;
+	CHECK(allocator.Allocate(8, &offset) && offset == 0);
+	CHECK(allocator.Allocate(15, &offset) && offset == 20);
+	CHECK(allocator.Allocate(50, &offset) && offset == 50);
+	CHECK(allocator.GetFreeTotal() == 100 - 50 - 10 - 8 - 15 - 10);
+}
+
+static void TestGrow()
+{
+	RangeAllocator allocator(0);
+	unsigned int offset;
+	CHECK(!allocator.Allocate(1, &offset));
+
+	allocator.Grow(16);
+	CHECK(allocator.Allocate(16, &offset) && offset == 0);
+	CHECK(allocator.GetFreeRangeCount() == 0);
+
+	// Growing adds one free range at the end, which merges
+	// with a free range already touching the old end
+	allocator.Free(8, 8);
+	allocator.Grow(32);
+	CHECK(allocator.GetSize() == 32);
+	CHECK(allocator.GetFreeRangeCount() == 1);
+	CHECK(allocator.Allocate(24, &offset) && offset == 8);
+
+	allocator.Grow(10);
+	CHECK(allocator.GetSize() == 32);
+}
+
+int main()
+{
+	TestAllocateAndFree();
+	TestBestFit();
+	TestGrow();
+	return TestResult();
+}
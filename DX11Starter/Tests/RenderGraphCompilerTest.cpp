@@ -0,0 +1,304 @@
+#include "RenderGraphCompiler.h"
+#include "TestCheck.h"
+#include <string>
+
+static const RenderTextureDesc colorDesc = { 1280, 720, 28, 0x28 };	// RGBA8, render target + shader resource
+static const RenderTextureDesc depthDesc = { 1280, 720, 40, 0x40 };	// D32, depth stencil
+static const RenderTextureDesc halfDesc = { 640, 360, 28, 0x28 };
+
+static bool Contains(const std::string& text, const std::string& part)
+{
+	return text.find(part) != std::string::npos;
+}
+
+// Passes added readers first still run writers first, and
+// passes that don't depend on each other keep the order
+// they were added in
+static void TestOrdering()
+{
+	RenderGraphCompiler graph;
+	unsigned int backBuffer = graph.ImportTexture("BackBuffer");
+	unsigned int color = graph.AddTexture("Color", colorDesc);
+	unsigned int depth = graph.AddTexture("Depth", depthDesc);
+
+	unsigned int upscale = graph.AddPass("Upscale");
+	graph.Read(upscale, color);
+	graph.Write(upscale, backBuffer);
+
+	unsigned int shading = graph.AddPass("Shading");
+	graph.Read(shading, depth);
+	graph.Write(shading, color);
+
+	unsigned int prepass = graph.AddPass("Prepass");
+	graph.Write(prepass, depth);
+
+	// Writes the back buffer after Upscale (added later)
+	unsigned int overlay = graph.AddPass("Overlay");
+	graph.Write(overlay, backBuffer);
+
+	CHECK(graph.Compile());
+	const std::vector<unsigned int>& schedule = graph.GetSchedule();
+	CHECK(schedule.size() == 4);
+	if (schedule.size() == 4)
+	{
+		// Each pass was added before the one it reads from; the
+		// back buffer's two writers run in the order they were added
+		CHECK(schedule[0] == prepass);
+		CHECK(schedule[1] == shading);
+		CHECK(schedule[2] == upscale);
+		CHECK(schedule[3] == overlay);
+	}
+
+	// Independent passes go by the order added
+	RenderGraphCompiler independent;
+	unsigned int target = independent.ImportTexture("Target");
+	unsigned int a = independent.AddPass("A");
+	unsigned int b = independent.AddPass("B");
+	unsigned int c = independent.AddPass("C");
+	unsigned int textures[3];
+	for (unsigned int i = 0; i < 3; i++)
+	{
+		textures[i] = independent.AddTexture("T", halfDesc);
+		independent.Write(a + i, textures[i]);
+	}
+	unsigned int combine = independent.AddPass("Combine");
+	for (unsigned int i = 0; i < 3; i++)
+		independent.Read(combine, textures[i]);
+	independent.Write(combine, target);
+
+	CHECK(independent.Compile());
+	CHECK(independent.GetSchedule().size() == 4);
+	if (independent.GetSchedule().size() == 4)
+	{
+		CHECK(independent.GetSchedule()[0] == a);
+		CHECK(independent.GetSchedule()[1] == b);
+		CHECK(independent.GetSchedule()[2] == c);
+		CHECK(independent.GetSchedule()[3] == combine);
+	}
+}
+
+// Every reader of a texture waits for all of its writers
+static void TestReadersWaitForLastWriter()
+{
+	RenderGraphCompiler graph;
+	unsigned int target = graph.ImportTexture("Target");
+	unsigned int color = graph.AddTexture("Color", colorDesc);
+
+	unsigned int clear = graph.AddPass("Clear");
+	graph.Write(clear, color);
+	unsigned int read = graph.AddPass("Read");
+	graph.Read(read, color);
+	graph.Write(read, target);
+	unsigned int draw = graph.AddPass("Draw");
+	graph.Write(draw, color);
+
+	CHECK(graph.Compile());
+	CHECK(graph.GetSchedule().size() == 3);
+	if (graph.GetSchedule().size() == 3)
+	{
+		CHECK(graph.GetSchedule()[0] == clear);
+		CHECK(graph.GetSchedule()[1] == draw);
+		CHECK(graph.GetSchedule()[2] == read);
+	}
+}
+
+// Only passes leading to an imported texture survive
+static void TestCulling()
+{
+	RenderGraphCompiler graph;
+	unsigned int backBuffer = graph.ImportTexture("BackBuffer");
+	unsigned int color = graph.AddTexture("Color", colorDesc);
+	unsigned int debug = graph.AddTexture("Debug", colorDesc);
+	unsigned int debugHalf = graph.AddTexture("DebugHalf", halfDesc);
+
+	unsigned int shading = graph.AddPass("Shading");
+	graph.Write(shading, color);
+
+	// A chain nothing reads in the end
+	unsigned int debugDraw = graph.AddPass("DebugDraw");
+	graph.Read(debugDraw, color);
+	graph.Write(debugDraw, debug);
+	unsigned int debugDown = graph.AddPass("DebugDownsample");
+	graph.Read(debugDown, debug);
+	graph.Write(debugDown, debugHalf);
+
+	unsigned int present = graph.AddPass("Present");
+	graph.Read(present, color);
+	graph.Write(present, backBuffer);
+
+	CHECK(graph.Compile());
+	CHECK(graph.GetSchedule().size() == 2);
+	CHECK(!graph.IsCulled(shading));
+	CHECK(!graph.IsCulled(present));
+	CHECK(graph.IsCulled(debugDraw));
+	CHECK(graph.IsCulled(debugDown));
+
+	// Textures only culled passes touched get nothing
+	CHECK(graph.GetFirstUse(debug) == RenderGraphCompiler::Unused);
+	CHECK(graph.GetPhysicalTexture(debug) == RenderGraphCompiler::Unused);
+	CHECK(graph.GetPhysicalTexture(debugHalf) == RenderGraphCompiler::Unused);
+	CHECK(graph.GetPhysicalTextureCount() == 1);
+
+	// Nothing imported means nothing to do
+	RenderGraphCompiler orphan;
+	unsigned int texture = orphan.AddTexture("Color", colorDesc);
+	orphan.Write(orphan.AddPass("Draw"), texture);
+	CHECK(orphan.Compile());
+	CHECK(orphan.GetSchedule().empty());
+	CHECK(orphan.IsCulled(0));
+}
+
+// Transient textures with matching descriptions and lifetimes
+// that don't overlap share memory; imported ones never do
+static void TestAliasing()
+{
+	RenderGraphCompiler graph;
+	unsigned int backBuffer = graph.ImportTexture("BackBuffer");
+	unsigned int t[4];
+	t[0] = graph.AddTexture("A", colorDesc);
+	t[1] = graph.AddTexture("B", colorDesc);
+	t[2] = graph.AddTexture("C", colorDesc);	// Same as A, after A's done
+	t[3] = graph.AddTexture("D", halfDesc);		// Free slot, but wrong size
+
+	// A -> B -> C -> D -> back buffer, each pass reading the last
+	unsigned int previous = RenderGraphCompiler::Unused;
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		unsigned int pass = graph.AddPass("Step");
+		if (previous != RenderGraphCompiler::Unused)
+			graph.Read(pass, previous);
+		graph.Write(pass, t[i]);
+		previous = t[i];
+	}
+	unsigned int present = graph.AddPass("Present");
+	graph.Read(present, previous);
+	graph.Write(present, backBuffer);
+
+	CHECK(graph.Compile());
+
+	// Lifetimes are schedule positions: written by one pass, read by the next
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		CHECK(graph.GetFirstUse(t[i]) == i);
+		CHECK(graph.GetLastUse(t[i]) == i + 1);
+	}
+
+	// A and B overlap (step 1 reads A and writes B), as do B and C,
+	// but A is done by the time C starts
+	CHECK(graph.GetPhysicalTexture(t[0]) != graph.GetPhysicalTexture(t[1]));
+	CHECK(graph.GetPhysicalTexture(t[1]) != graph.GetPhysicalTexture(t[2]));
+	CHECK(graph.GetPhysicalTexture(t[0]) == graph.GetPhysicalTexture(t[2]));
+	CHECK(graph.GetPhysicalTexture(t[3]) != graph.GetPhysicalTexture(t[0]));
+	CHECK(graph.GetPhysicalTexture(t[3]) != graph.GetPhysicalTexture(t[1]));
+	CHECK(graph.GetPhysicalTextureCount() == 3);
+	CHECK(graph.GetPhysicalDesc(graph.GetPhysicalTexture(t[3])) == halfDesc);
+
+	CHECK(graph.IsImported(backBuffer));
+	CHECK(graph.GetPhysicalTexture(backBuffer) == RenderGraphCompiler::Unused);
+}
+
+// Each pass needing the other can't be ordered
+static void TestCycle()
+{
+	RenderGraphCompiler graph;
+	unsigned int backBuffer = graph.ImportTexture("BackBuffer");
+	unsigned int a = graph.AddTexture("A", colorDesc);
+	unsigned int b = graph.AddTexture("B", colorDesc);
+
+	unsigned int first = graph.AddPass("First");
+	graph.Read(first, b);
+	graph.Write(first, a);
+	unsigned int second = graph.AddPass("Second");
+	graph.Read(second, a);
+	graph.Write(second, b);
+	graph.Write(second, backBuffer);
+
+	// Doesn't take part in the cycle, so isn't listed
+	unsigned int overlay = graph.AddPass("Overlay");
+	graph.Write(overlay, backBuffer);
+
+	CHECK(!graph.Compile());
+	CHECK(Contains(graph.GetError(), "cycle"));
+	CHECK(Contains(graph.GetError(), "First"));
+	CHECK(Contains(graph.GetError(), "Second"));
+	CHECK(!Contains(graph.GetError(), "Overlay"));
+	(void)overlay;
+}
+
+// A transient texture nobody writes has nothing in it to read.
+// Imported ones were filled outside the graph, so they're fine.
+static void TestUnwrittenRead()
+{
+	RenderGraphCompiler graph;
+	unsigned int backBuffer = graph.ImportTexture("BackBuffer");
+	unsigned int history = graph.ImportTexture("History");
+	unsigned int color = graph.AddTexture("Color", colorDesc);
+
+	unsigned int present = graph.AddPass("Present");
+	graph.Read(present, color);
+	graph.Read(present, history);
+	graph.Write(present, backBuffer);
+
+	CHECK(!graph.Compile());
+	CHECK(Contains(graph.GetError(), "Present"));
+	CHECK(Contains(graph.GetError(), "Color"));
+	CHECK(graph.GetSchedule().empty());
+
+	unsigned int draw = graph.AddPass("Draw");
+	graph.Write(draw, color);
+	CHECK(graph.Compile());
+	CHECK(graph.GetError().empty());
+	CHECK(graph.GetSchedule().size() == 2);
+}
+
+// The same frame described again after Reset() (as happens
+// every frame) compiles to the same thing
+static void TestReset()
+{
+	RenderGraphCompiler graph;
+	std::vector<unsigned int> firstSchedule;
+	unsigned int firstPhysicalCount = 0;
+	for (unsigned int frame = 0; frame < 3; frame++)
+	{
+		graph.Reset();
+		unsigned int backBuffer = graph.ImportTexture("BackBuffer");
+		unsigned int color = graph.AddTexture("Color", colorDesc);
+		unsigned int depth = graph.AddTexture("Depth", depthDesc);
+		unsigned int prepass = graph.AddPass("Prepass");
+		graph.Write(prepass, depth);
+		unsigned int shading = graph.AddPass("Shading");
+		graph.Read(shading, depth);
+		graph.Write(shading, color);
+		unsigned int present = graph.AddPass("Present");
+		graph.Read(present, color);
+		graph.Write(present, backBuffer);
+
+		CHECK(graph.GetPassCount() == 3);
+		CHECK(graph.GetTextureCount() == 3);
+		CHECK(graph.Compile());
+		CHECK(graph.Compile());		// Compiling twice changes nothing
+		if (frame == 0)
+		{
+			firstSchedule = graph.GetSchedule();
+			firstPhysicalCount = graph.GetPhysicalTextureCount();
+		}
+		CHECK(graph.GetSchedule() == firstSchedule);
+		CHECK(graph.GetPhysicalTextureCount() == firstPhysicalCount);
+		CHECK(std::string(graph.GetPassName(shading)) == "Shading");
+		CHECK(std::string(graph.GetTextureName(depth)) == "Depth");
+	}
+	CHECK(firstSchedule.size() == 3);
+	CHECK(firstPhysicalCount == 2);
+}
+
+int main()
+{
+	TestOrdering();
+	TestReadersWaitForLastWriter();
+	TestCulling();
+	TestAliasing();
+	TestCycle();
+	TestUnwrittenRead();
+	TestReset();
+	return TestResult();
+}
@@ -0,0 +1,244 @@
+#include "ResolutionGovernor.h"
+#include "TestCheck.h"
+#include <vector>
+
+// --------------------------------------------------------
+// Replays scene cost traces through the governor, closing
+// the loop with a simple GPU model: a frame costs a fixed
+// part plus a part that follows the pixel count.
+//
+// Traces are of the per-pixel part at native resolution,
+// so the frame time each scale produces comes from the
+// model rather than being baked into the trace.
+// --------------------------------------------------------
+
+#define FIXED_COST	0.0005f
+
+// What the game uses (Game::Init())
+static ResolutionGovernorSettings GameSettings()
+{
+	ResolutionGovernorSettings settings;
+	settings.MinScale = 0.5f;
+	settings.MaxScale = 1.0f;
+	settings.TargetFrameTime = 0.006f;
+	settings.Proportional = 0.5f;
+	settings.Integral = 0.1f;
+	settings.Derivative = 0.05f;
+	settings.Smoothing = 0.3f;
+	return settings;
+}
+
+struct Replay
+{
+	std::vector<float> Scales;
+	std::vector<float> FrameTimes;
+};
+
+static Replay Run(ResolutionGovernor& governor, const std::vector<float>& nativeCost)
+{
+	Replay replay;
+	for (unsigned int i = 0; i < nativeCost.size(); i++)
+	{
+		float scale = governor.GetScale();
+		float frameTime = FIXED_COST + nativeCost[i] * scale * scale;
+		replay.FrameTimes.push_back(frameTime);
+		replay.Scales.push_back(governor.Update(frameTime));
+	}
+	return replay;
+}
+
+// Segments of constant cost, one after another
+static void AddSegment(std::vector<float>* trace, float cost, unsigned int frames)
+{
+	trace->insert(trace->end(), frames, cost);
+}
+
+// Same noise every run (a small LCG, not rand())
+static void AddNoisySegment(std::vector<float>* trace, float cost, float noise, unsigned int frames)
+{
+	unsigned int state = 12345;
+	for (unsigned int i = 0; i < frames; i++)
+	{
+		state = state * 1664525u + 1013904223u;
+		float unit = (state >> 8) / 16777216.0f;
+		trace->push_back(cost * (1.0f + noise * (unit * 2.0f - 1.0f)));
+	}
+}
+
+// The scale at which the model exactly hits the target
+static float IdealScale(float nativeCost)
+{
+	return sqrtf((0.006f - FIXED_COST) / nativeCost);
+}
+
+// A scene that fits at native resolution never drops it
+static void TestLightScene()
+{
+	ResolutionGovernor governor(GameSettings());
+	std::vector<float> trace;
+	AddSegment(&trace, 0.003f, 300);
+
+	Replay replay = Run(governor, trace);
+	for (unsigned int i = 0; i < replay.Scales.size(); i++)
+		CHECK(replay.Scales[i] == 1.0f);
+}
+
+// Too heavy for native: settles where the budget is met,
+// without overshooting much on the way
+static void TestConverges()
+{
+	ResolutionGovernor governor(GameSettings());
+	std::vector<float> trace;
+	AddSegment(&trace, 0.009f, 300);
+
+	Replay replay = Run(governor, trace);
+	CHECK_NEAR(replay.Scales.back(), IdealScale(0.009f), 0.01f);
+	CHECK_NEAR(replay.FrameTimes.back(), 0.006f, 0.0002f);
+
+	// Within 3% of the target in a second (at 60fps) and staying there
+	for (unsigned int i = 60; i < replay.FrameTimes.size(); i++)
+		CHECK_NEAR(replay.FrameTimes[i], 0.006f, 0.006f * 0.03f);
+
+	// Never below where it ends up by more than a little
+	for (unsigned int i = 0; i < replay.Scales.size(); i++)
+		CHECK(replay.Scales[i] >= IdealScale(0.009f) - 0.05f);
+}
+
+// Load steps up then back down: the scale follows both ways
+static void TestSteps()
+{
+	ResolutionGovernor governor(GameSettings());
+	std::vector<float> trace;
+	AddSegment(&trace, 0.004f, 120);
+	AddSegment(&trace, 0.012f, 240);
+	AddSegment(&trace, 0.007f, 240);
+	AddSegment(&trace, 0.004f, 240);
+
+	Replay replay = Run(governor, trace);
+	CHECK(replay.Scales[119] == 1.0f);
+	CHECK_NEAR(replay.Scales[359], IdealScale(0.012f), 0.01f);
+	CHECK_NEAR(replay.Scales[599], IdealScale(0.007f), 0.01f);
+	CHECK_NEAR(replay.Scales[839], 1.0f, 0.001f);
+}
+
+// Far too heavy for even the smallest scale: pinned there.
+// The controller works on changes, so all that time spent
+// over budget doesn't wind up and hold the scale down once
+// the load goes away.
+static void TestNoWindup()
+{
+	ResolutionGovernor governor(GameSettings());
+	std::vector<float> trace;
+	AddSegment(&trace, 0.1f, 600);
+	AddSegment(&trace, 0.004f, 120);
+
+	Replay replay = Run(governor, trace);
+	CHECK(replay.Scales[599] == 0.5f);
+
+	unsigned int recovered = 0;
+	while (600 + recovered < replay.Scales.size() && replay.Scales[600 + recovered] < 0.99f)
+		recovered++;
+	CHECK(recovered < 60);
+}
+
+// A single long frame (a hitch, not a heavier scene) drops
+// the scale at once - the controller can't tell the two
+// apart yet - but it's back at native within a few frames
+static void TestSpike()
+{
+	ResolutionGovernor governor(GameSettings());
+	std::vector<float> trace;
+	AddSegment(&trace, 0.004f, 60);
+	AddSegment(&trace, 0.05f, 1);
+	AddSegment(&trace, 0.004f, 120);
+
+	Replay replay = Run(governor, trace);
+	CHECK(replay.Scales[59] == 1.0f);
+	CHECK(replay.Scales[60] < 1.0f);
+	for (unsigned int i = 66; i < replay.Scales.size(); i++)
+		CHECK(replay.Scales[i] == 1.0f);
+}
+
+// Noisy frame times: the filtered time holds near the target
+// and the scale doesn't swing with every frame
+static void TestNoise()
+{
+	ResolutionGovernor governor(GameSettings());
+	std::vector<float> trace;
+	AddNoisySegment(&trace, 0.009f, 0.2f, 1200);
+
+	Replay replay = Run(governor, trace);
+	float mean = 0.0f, lowest = 1.0f, highest = 0.0f;
+	for (unsigned int i = 120; i < replay.Scales.size(); i++)
+	{
+		mean += replay.FrameTimes[i];
+		if (replay.Scales[i] < lowest) lowest = replay.Scales[i];
+		if (replay.Scales[i] > highest) highest = replay.Scales[i];
+	}
+	mean /= replay.Scales.size() - 120;
+
+	CHECK_NEAR(mean, 0.006f, 0.006f * 0.03f);
+	CHECK(highest - lowest < 0.15f);
+}
+
+// The same trace gives exactly the same scales, including
+// after a Reset()
+static void TestDeterministic()
+{
+	std::vector<float> trace;
+	AddNoisySegment(&trace, 0.01f, 0.3f, 400);
+	AddSegment(&trace, 0.003f, 100);
+
+	ResolutionGovernor first(GameSettings());
+	ResolutionGovernor second(GameSettings());
+	Replay a = Run(first, trace);
+	Replay b = Run(second, trace);
+	first.Reset();
+	CHECK(first.GetScale() == 1.0f);
+	CHECK(first.GetFilteredFrameTime() == 0.0f);
+	Replay c = Run(first, trace);
+
+	bool same = true;
+	for (unsigned int i = 0; i < trace.size(); i++)
+		same = same && a.Scales[i] == b.Scales[i] && a.Scales[i] == c.Scales[i];
+	CHECK(same);
+}
+
+// Bad input is ignored, and bad limits fixed up
+static void TestEdgeCases()
+{
+	ResolutionGovernor governor(GameSettings());
+	CHECK(governor.Update(0.0f) == 1.0f);
+	CHECK(governor.Update(-1.0f) == 1.0f);
+	CHECK(governor.GetFilteredFrameTime() == 0.0f);
+
+	ResolutionGovernorSettings settings = GameSettings();
+	settings.MinScale = 0.0f;
+	settings.MaxScale = 0.05f;
+	ResolutionGovernor fixedUp(settings);
+	CHECK(fixedUp.GetSettings().MinScale > 0.0f);
+	CHECK(fixedUp.GetSettings().MaxScale >= fixedUp.GetSettings().MinScale);
+	CHECK(fixedUp.GetScale() == fixedUp.GetSettings().MaxScale);
+
+	// Equal limits (benchmark mode) never move
+	settings = GameSettings();
+	settings.MinScale = settings.MaxScale;
+	ResolutionGovernor pinned(settings);
+	std::vector<float> trace;
+	AddSegment(&trace, 0.02f, 60);
+	Replay replay = Run(pinned, trace);
+	CHECK(replay.Scales.back() == 1.0f);
+}
+
+int main()
+{
+	TestLightScene();
+	TestConverges();
+	TestSteps();
+	TestNoWindup();
+	TestSpike();
+	TestNoise();
+	TestDeterministic();
+	TestEdgeCases();
+	return TestResult();
+}
@@ -0,0 +1,126 @@
+#include "ShaderReflectionData.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+// --------------------------------------------------------
+// Times loading reflection sidecars for a large set of
+// shader permutations, the case the cache is there for:
+// each variant has its own .cso and .cso.refl.
+//
+//   ShaderReflectionBenchmark [permutations] [directory]
+// --------------------------------------------------------
+
+// Roughly what the engine's pixel shaders reflect to, with a
+// little variety per permutation
+static ShaderReflectionData MakePermutation(unsigned int seed)
+{
+	ShaderReflectionData data;
+	data.ConstantBuffers.resize(3 + seed % 2);
+	for (unsigned int b = 0; b < data.ConstantBuffers.size(); b++)
+	{
+		CachedConstantBuffer& cb = data.ConstantBuffers[b];
+		cb.Name = "buffer" + std::to_string(b);
+		cb.BindIndex = b;
+		cb.Variables.resize(6 + (seed + b) % 10);
+		for (unsigned int v = 0; v < cb.Variables.size(); v++)
+		{
+			cb.Variables[v].Name = "variable" + std::to_string(v);
+			cb.Variables[v].ByteOffset = v * 16;
+			cb.Variables[v].Size = 16;
+		}
+		cb.Size = (unsigned int)cb.Variables.size() * 16;
+	}
+
+	data.Resources.resize(4 + seed % 5);
+	for (unsigned int r = 0; r < data.Resources.size(); r++)
+	{
+		data.Resources[r].Name = "texture" + std::to_string(r);
+		data.Resources[r].Type = 2;
+		data.Resources[r].BindIndex = r;
+	}
+
+	const char* semantics[] = { "SV_POSITION", "NORMAL", "TEXCOORD", "TANGENT", "COLOR" };
+	data.InputParameters.resize(3 + seed % 3);
+	for (unsigned int i = 0; i < data.InputParameters.size(); i++)
+	{
+		data.InputParameters[i].SemanticName = semantics[i];
+		data.InputParameters[i].SemanticIndex = 0;
+		data.InputParameters[i].Mask = 15;
+		data.InputParameters[i].ComponentType = 3;
+	}
+
+	data.ThreadGroupSize[0] = data.ThreadGroupSize[1] = data.ThreadGroupSize[2] = 0;
+	return data;
+}
+
+static bool LoadFile(const std::string& path, std::vector<unsigned char>* bytes)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+		return false;
+	std::streamsize size = file.tellg();
+	if (size <= 0)
+		return false;
+	bytes->resize((size_t)size);
+	file.seekg(0, std::ios::beg);
+	return (bool)file.read((char*)&(*bytes)[0], size);
+}
+
+int main(int argc, char** argv)
+{
+	unsigned int permutations = argc > 1 ? (unsigned int)atoi(argv[1]) : 500;
+	std::string directory = argc > 2 ? argv[2] : ".";
+	const int passes = 5;
+
+	// Write every permutation's sidecar
+	size_t totalBytes = 0;
+	std::vector<unsigned char> bytes;
+	for (unsigned int p = 0; p < permutations; p++)
+	{
+		WriteReflectionSidecar(p, 1000 + p, MakePermutation(p), &bytes);
+		std::ofstream file(directory + "/perm" + std::to_string(p) + ".cso.refl", std::ios::binary | std::ios::trunc);
+		file.write((const char*)&bytes[0], bytes.size());
+		totalBytes += bytes.size();
+	}
+
+	// Parse only, from memory
+	WriteReflectionSidecar(0, 1000, MakePermutation(0), &bytes);
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int pass = 0; pass < passes; pass++)
+	{
+		for (unsigned int p = 0; p < permutations; p++)
+		{
+			ShaderReflectionData data;
+			if (!ParseReflectionSidecar(&bytes[0], bytes.size(), 0, 1000, &data))
+				return 1;
+		}
+	}
+	double parseSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+	// Read from disk and parse, as ShaderReflectionCache::Load does
+	start = std::chrono::high_resolution_clock::now();
+	for (int pass = 0; pass < passes; pass++)
+	{
+		for (unsigned int p = 0; p < permutations; p++)
+		{
+			ShaderReflectionData data;
+			std::vector<unsigned char> fileBytes;
+			if (!LoadFile(directory + "/perm" + std::to_string(p) + ".cso.refl", &fileBytes) ||
+				!ParseReflectionSidecar(&fileBytes[0], fileBytes.size(), p, 1000 + p, &data))
+				return 1;
+		}
+	}
+	double loadSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+	for (unsigned int p = 0; p < permutations; p++)
+		remove((directory + "/perm" + std::to_string(p) + ".cso.refl").c_str());
+
+	double loads = (double)permutations * passes;
+	printf("%u permutations, %.0f bytes per sidecar on average\n", permutations, (double)totalBytes / permutations);
+	printf("Parse only:  %8.2f us per sidecar\n", parseSeconds / loads * 1e6);
+	printf("Read+parse:  %8.2f us per sidecar, %.2f ms for all %u\n", loadSeconds / loads * 1e6, loadSeconds / passes * 1e3, permutations);
+	return 0;
+}
@@ -0,0 +1,144 @@
+#include "ShaderReflectionData.h"
+#include "TestCheck.h"
+#include <cstring>
+
+static ShaderReflectionData MakeSample()
+{
+	ShaderReflectionData data;
+	data.ConstantBuffers.resize(2);
+	data.ConstantBuffers[0].Name = "perFrame";
+	data.ConstantBuffers[0].Size = 64;
+	data.ConstantBuffers[0].BindIndex = 0;
+	data.ConstantBuffers[0].Variables.resize(2);
+	data.ConstantBuffers[0].Variables[0].Name = "view";
+	data.ConstantBuffers[0].Variables[0].ByteOffset = 0;
+	data.ConstantBuffers[0].Variables[0].Size = 48;
+	data.ConstantBuffers[0].Variables[1].Name = "time";
+	data.ConstantBuffers[0].Variables[1].ByteOffset = 48;
+	data.ConstantBuffers[0].Variables[1].Size = 4;
+	data.ConstantBuffers[1].Name = "empty";
+	data.ConstantBuffers[1].Size = 16;
+	data.ConstantBuffers[1].BindIndex = 3;
+
+	data.Resources.resize(1);
+	data.Resources[0].Name = "diffuseTexture";
+	data.Resources[0].Type = 2;
+	data.Resources[0].BindIndex = 1;
+
+	data.InputParameters.resize(2);
+	data.InputParameters[0].SemanticName = "POSITION";
+	data.InputParameters[0].SemanticIndex = 0;
+	data.InputParameters[0].Mask = 7;
+	data.InputParameters[0].ComponentType = 3;
+	data.InputParameters[1].SemanticName = "TEXCOORD";
+	data.InputParameters[1].SemanticIndex = 1;
+	data.InputParameters[1].Mask = 3;
+	data.InputParameters[1].ComponentType = 3;
+
+	data.ThreadGroupSize[0] = 8;
+	data.ThreadGroupSize[1] = 4;
+	data.ThreadGroupSize[2] = 1;
+	return data;
+}
+
+static void TestRoundTrip()
+{
+	ShaderReflectionData in = MakeSample();
+	std::vector<unsigned char> bytes;
+	WriteReflectionSidecar(0x1234567890ULL, 999, in, &bytes);
+
+	ShaderReflectionData out;
+	CHECK(ParseReflectionSidecar(&bytes[0], bytes.size(), 0x1234567890ULL, 999, &out));
+	CHECK(out.ConstantBuffers.size() == 2);
+	CHECK(out.ConstantBuffers[0].Name == "perFrame");
+	CHECK(out.ConstantBuffers[0].Variables.size() == 2);
+	CHECK(out.ConstantBuffers[0].Variables[1].Name == "time");
+	CHECK(out.ConstantBuffers[0].Variables[1].ByteOffset == 48);
+	CHECK(out.ConstantBuffers[1].BindIndex == 3);
+	CHECK(out.ConstantBuffers[1].Variables.empty());
+	CHECK(out.Resources.size() == 1);
+	CHECK(out.Resources[0].Name == "diffuseTexture");
+	CHECK(out.InputParameters.size() == 2);
+	CHECK(out.InputParameters[1].SemanticName == "TEXCOORD");
+	CHECK(out.InputParameters[1].SemanticIndex == 1);
+	CHECK(out.ThreadGroupSize[0] == 8 && out.ThreadGroupSize[1] == 4 && out.ThreadGroupSize[2] == 1);
+}
+
+// A sidecar for a different blob, or from another format version, is stale
+static void TestStaleSidecars()
+{
+	std::vector<unsigned char> bytes;
+	WriteReflectionSidecar(42, 100, MakeSample(), &bytes);
+
+	ShaderReflectionData out;
+	CHECK(!ParseReflectionSidecar(&bytes[0], bytes.size(), 43, 100, &out));
+	CHECK(!ParseReflectionSidecar(&bytes[0], bytes.size(), 42, 101, &out));
+
+	bytes[4]++; // Version
+	CHECK(!ParseReflectionSidecar(&bytes[0], bytes.size(), 42, 100, &out));
+}
+
+// Every truncation, and any trailing junk, must fail
+static void TestTruncation()
+{
+	std::vector<unsigned char> bytes;
+	WriteReflectionSidecar(7, 8, MakeSample(), &bytes);
+
+	for (size_t length = 0; length < bytes.size(); length++)
+	{
+		ShaderReflectionData out;
+		CHECK(!ParseReflectionSidecar(&bytes[0], length, 7, 8, &out));
+	}
+
+	bytes.push_back(0);
+	ShaderReflectionData out;
+	CHECK(!ParseReflectionSidecar(&bytes[0], bytes.size(), 7, 8, &out));
+}
+
+// Overwrites the uint at offset and makes sure parsing rejects
+// it (which, since counts are checked before resizing, also
+// means it didn't try to allocate billions of entries)
+static void CheckCorruptCount(std::vector<unsigned char> bytes, size_t offset, unsigned int value)
+{
+	memcpy(&bytes[offset], &value, sizeof(value));
+	ShaderReflectionData out;
+	CHECK(!ParseReflectionSidecar(&bytes[0], bytes.size(), 7, 8, &out));
+	CHECK(out.ConstantBuffers.size() <= 2);
+	CHECK(out.Resources.size() <= 1);
+	CHECK(out.InputParameters.size() <= 2);
+}
+
+static void TestCorruptCounts()
+{
+	std::vector<unsigned char> bytes;
+	WriteReflectionSidecar(7, 8, MakeSample(), &bytes);
+
+	// Header: magic, version, hash(8), size, then the three counts
+	const size_t cbCountOffset = 20;
+	const size_t resourceCountOffset = 24;
+	const size_t inputCountOffset = 28;
+	CheckCorruptCount(bytes, cbCountOffset, 0xFFFFFFFF);
+	CheckCorruptCount(bytes, resourceCountOffset, 0xFFFFFFFF);
+	CheckCorruptCount(bytes, inputCountOffset, 0xFFFFFFFF);
+	CheckCorruptCount(bytes, cbCountOffset, 100);
+
+	// First buffer's variable count: after the thread group size,
+	// the name ("perFrame"), size and bind index
+	const size_t varCountOffset = 44 + 4 + 8 + 4 + 4;
+	unsigned int varCount;
+	memcpy(&varCount, &bytes[varCountOffset], sizeof(varCount));
+	CHECK(varCount == 2);
+	CheckCorruptCount(bytes, varCountOffset, 0x7FFFFFFF);
+
+	// A huge string length
+	CheckCorruptCount(bytes, 44, 0xFFFFFFF0);
+}
+
+int main()
+{
+	TestRoundTrip();
+	TestStaleSidecars();
+	TestTruncation();
+	TestCorruptCounts();
+	return TestResult();
+}
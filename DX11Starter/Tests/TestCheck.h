@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+
+// --------------------------------------------------------
+// Just enough of a test harness for the headless tests:
+// CHECK and CHECK_NEAR print failures and keep going, and
+// main() returns TestResult() so ctest sees them.
+// --------------------------------------------------------
+static int testFailures = 0;
+
+#define CHECK(condition) \
+	do { if (!(condition)) { testFailures++; printf("%s(%d): CHECK failed: %s\n", __FILE__, __LINE__, #condition); } } while (0)
+
+#define CHECK_NEAR(a, b, tolerance) \
+	do { double checkA = (double)(a), checkB = (double)(b); \
+		if (!(std::fabs(checkA - checkB) <= (double)(tolerance))) { testFailures++; \
+			printf("%s(%d): CHECK_NEAR failed: %s = %g, %s = %g (tolerance %g)\n", __FILE__, __LINE__, #a, checkA, #b, checkB, (double)(tolerance)); } } while (0)
+
+static int TestResult()
+{
+	if (testFailures == 0) printf("All checks passed\n");
+	else printf("%d check(s) failed\n", testFailures);
+	return testFailures == 0 ? 0 : 1;
+}
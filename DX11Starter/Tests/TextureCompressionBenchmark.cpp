@@ -0,0 +1,79 @@
+#include "TextureCompression.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+// --------------------------------------------------------
+// Times CompressTexture (the whole mip chain) in each block
+// format, on one thread and on a pool with a worker per
+// core, and reports its quality as PSNR.
+//
+// The image is synthetic, so it's the same everywhere: soft
+// gradients for the low frequencies, noise for the high ones,
+// and hard edged shapes in color and alpha.  Throughput is
+// megabytes of uncompressed RGBA in per second.
+//
+//   TextureCompressionBenchmark [image size]
+// --------------------------------------------------------
+
+static void MakeImage(unsigned int size, TextureImage* image)
+{
+	std::mt19937 random(1);
+	image->Width = size;
+	image->Height = size;
+	image->Pixels.resize(size * size * 4);
+	for (unsigned int y = 0; y < size; y++)
+	{
+		for (unsigned int x = 0; x < size; x++)
+		{
+			float u = (float)x / size, v = (float)y / size;
+			bool inCircle = (u - 0.5f) * (u - 0.5f) + (v - 0.5f) * (v - 0.5f) < 0.1f;
+			bool inStripe = ((x / 16) & 1) != 0;
+			int noise = (int)(random() % 32) - 16;
+
+			unsigned char* pixel = &image->Pixels[(y * size + x) * 4];
+			pixel[0] = (unsigned char)(std::min)(255, (std::max)(0, (int)(u * 255) + noise));
+			pixel[1] = (unsigned char)(std::min)(255, (std::max)(0, (int)(128 + 127 * std::sin(v * 12.0f)) + noise));
+			pixel[2] = inCircle ? 230 : (inStripe ? 40 : 90);
+			pixel[3] = inCircle || inStripe ? 255 : 0;
+		}
+	}
+}
+
+static void Run(const TextureImage& image, BlockFormat format, const char* name)
+{
+	ThreadPool single(0);
+	ThreadPool pool;
+	ThreadPool* pools[] = { &single, &pool };
+	for (ThreadPool* threads : pools)
+	{
+		// One core: the pool is just the caller again
+		if (threads != &single && threads->GetThreadCount() == 1)
+			continue;
+
+		CompressedTexture texture;
+		TextureCompressionStats stats;
+		CompressTexture(image, format, false, threads, &texture, &stats);
+
+		double megabytes = stats.Pixels * 4.0 / (1024.0 * 1024.0);
+		printf("%-4s %5ux%-5u %2u threads  %8.1f ms  %8.2f MB/s  PSNR %6.2f dB\n",
+			name, image.Width, image.Height, stats.Threads,
+			stats.Seconds * 1e3, megabytes / stats.Seconds, stats.PSNR);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	unsigned int size = argc > 1 ? (unsigned int)atoi(argv[1]) : 2048;
+
+	TextureImage image;
+	MakeImage(size, &image);
+
+	Run(image, BLOCK_BC1, "BC1");
+	Run(image, BLOCK_BC3, "BC3");
+	Run(image, BLOCK_BC5, "BC5");
+	Run(image, BLOCK_BC7, "BC7");
+	return 0;
+}
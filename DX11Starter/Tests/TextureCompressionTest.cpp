@@ -0,0 +1,221 @@
+#include "TextureCompression.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+// Per format: how many leading channels it keeps, the largest
+// error allowed on a solid color block, and the RMS error
+// allowed on a smooth gradient across a block
+struct FormatBounds
+{
+	BlockFormat Format;
+	unsigned int Channels;
+	int SolidError;
+	double GradientRMSE;
+};
+
+static const FormatBounds formats[] =
+{
+	{ BLOCK_BC1, 3, 4, 10.0 },		// 565 endpoints, 4 colors
+	{ BLOCK_BC3, 4, 4, 10.0 },		// Same color, plus alpha
+	{ BLOCK_BC5, 2, 0, 5.0 },		// 8 bit endpoints, 8 levels
+	{ BLOCK_BC7, 4, 1, 2.5 },		// 7 bit endpoints plus a shared bit, 16 levels
+};
+
+static void RoundTrip(BlockFormat format, const unsigned char* pixels, unsigned char* decoded)
+{
+	unsigned char block[16];
+	CompressBlock(format, pixels, block);
+	DecompressBlock(format, block, decoded);
+}
+
+// The channels a format drops come back as 0 (or 255 for
+// alpha), whatever went in
+static bool DroppedChannelsDefault(const FormatBounds& bounds, const unsigned char* decoded)
+{
+	for (unsigned int i = 0; i < 16; i++)
+	{
+		for (unsigned int c = bounds.Channels; c < 4; c++)
+		{
+			if (decoded[i * 4 + c] != (c == 3 ? 255 : 0))
+				return false;
+		}
+	}
+	return true;
+}
+
+// Random solid colors, plus black, white, and each channel
+// alone at full
+static void TestSolidBlocks()
+{
+	std::mt19937 random(1);
+	for (const FormatBounds& bounds : formats)
+	{
+		int maxError = 0;
+		bool droppedOK = true;
+		for (unsigned int t = 0; t < 1000 + 6; t++)
+		{
+			unsigned char color[4];
+			for (unsigned int c = 0; c < 4; c++)
+			{
+				if (t < 2)
+					color[c] = t == 0 ? 0 : 255;
+				else if (t < 6)
+					color[c] = c == t - 2 ? 255 : 0;
+				else
+					color[c] = (unsigned char)(random() % 256);
+			}
+
+			unsigned char pixels[64], decoded[64];
+			for (unsigned int i = 0; i < 16; i++)
+			{
+				for (unsigned int c = 0; c < 4; c++)
+					pixels[i * 4 + c] = color[c];
+			}
+			RoundTrip(bounds.Format, pixels, decoded);
+
+			for (unsigned int i = 0; i < 16; i++)
+			{
+				for (unsigned int c = 0; c < bounds.Channels; c++)
+					maxError = (std::max)(maxError, std::abs(pixels[i * 4 + c] - decoded[i * 4 + c]));
+			}
+			droppedOK &= DroppedChannelsDefault(bounds, decoded);
+		}
+		CHECK(maxError <= bounds.SolidError);
+		CHECK(droppedOK);
+	}
+}
+
+// Every channel running diagonally between two random values
+static void TestGradientBlocks()
+{
+	std::mt19937 random(2);
+	for (const FormatBounds& bounds : formats)
+	{
+		double squaredError = 0.0;
+		unsigned int samples = 0;
+		for (unsigned int t = 0; t < 1000; t++)
+		{
+			int from[4], to[4];
+			for (unsigned int c = 0; c < 4; c++)
+			{
+				from[c] = (int)(random() % 256);
+				to[c] = (int)(random() % 256);
+			}
+
+			unsigned char pixels[64], decoded[64];
+			for (unsigned int i = 0; i < 16; i++)
+			{
+				float s = ((i & 3) + (i >> 2)) / 6.0f;
+				for (unsigned int c = 0; c < 4; c++)
+					pixels[i * 4 + c] = (unsigned char)(from[c] + (to[c] - from[c]) * s + 0.5f);
+			}
+			RoundTrip(bounds.Format, pixels, decoded);
+
+			for (unsigned int i = 0; i < 16; i++)
+			{
+				for (unsigned int c = 0; c < bounds.Channels; c++)
+				{
+					double d = pixels[i * 4 + c] - decoded[i * 4 + c];
+					squaredError += d * d;
+					samples++;
+				}
+			}
+		}
+		CHECK(std::sqrt(squaredError / samples) <= bounds.GradientRMSE);
+	}
+}
+
+// Cutouts: alpha that's only ever 0 or 255 has to stay that
+// way.  BC3 keeps alpha apart from color, so holds it under
+// any color.  BC7's mode 6 shares one set of indices between
+// color and alpha, so is only held to it over a flat color,
+// and shares a low bit with the color, so can be off by one.
+static void TestAlphaEdges()
+{
+	std::mt19937 random(3);
+	int bc3Error = 0, bc7Error = 0;
+	for (unsigned int t = 0; t < 1000; t++)
+	{
+		unsigned char pixels[64], decoded[64];
+		unsigned int edge = 1 + t % 3;
+		for (unsigned int i = 0; i < 16; i++)
+		{
+			for (unsigned int c = 0; c < 3; c++)
+				pixels[i * 4 + c] = (unsigned char)(random() % 256);
+			pixels[i * 4 + 3] = (i & 3) < edge ? 0 : 255;
+		}
+		RoundTrip(BLOCK_BC3, pixels, decoded);
+		for (unsigned int i = 0; i < 16; i++)
+			bc3Error = (std::max)(bc3Error, std::abs(pixels[i * 4 + 3] - decoded[i * 4 + 3]));
+
+		for (unsigned int i = 1; i < 16; i++)
+			memcpy(&pixels[i * 4], &pixels[0], 3);
+		RoundTrip(BLOCK_BC7, pixels, decoded);
+		for (unsigned int i = 0; i < 16; i++)
+			bc7Error = (std::max)(bc7Error, std::abs(pixels[i * 4 + 3] - decoded[i * 4 + 3]));
+	}
+	CHECK(bc3Error == 0);
+	CHECK(bc7Error <= 1);
+}
+
+// A whole texture whose size isn't a multiple of 4: the mip
+// chain goes down to 1x1, threads don't change the result, and
+// it decodes close to the source
+static void TestTexture()
+{
+	TextureImage image;
+	image.Width = 13;
+	image.Height = 7;
+	for (unsigned int y = 0; y < image.Height; y++)
+	{
+		for (unsigned int x = 0; x < image.Width; x++)
+		{
+			// A color ramp from dark blue to orange
+			unsigned int s = (x + y) * 255 / (image.Width + image.Height - 2);
+			image.Pixels.push_back((unsigned char)s);
+			image.Pixels.push_back((unsigned char)(40 + s / 2));
+			image.Pixels.push_back((unsigned char)(200 - s * 3 / 4));
+			image.Pixels.push_back(255);
+		}
+	}
+
+	ThreadPool threads(3);
+	for (const FormatBounds& bounds : formats)
+	{
+		CompressedTexture texture;
+		TextureCompressionStats stats;
+		CompressTexture(image, bounds.Format, false, &threads, &texture, &stats);
+
+		// 13x7, 6x3, 3x1, 1x1
+		CHECK(texture.Mips.size() == 4);
+		if (texture.Mips.size() == 4)
+		{
+			CHECK(texture.Mips[0].size() == 4 * 2 * GetBlockBytes(bounds.Format));
+			CHECK(texture.Mips[3].size() == GetBlockBytes(bounds.Format));
+		}
+		CHECK(stats.Pixels == 13 * 7 + 6 * 3 + 3 * 1 + 1);
+		CHECK(stats.PSNR > 30.0);
+
+		std::vector<unsigned char> singleThreaded;
+		CompressImage(bounds.Format, image, 0, &singleThreaded);
+		CHECK(singleThreaded == texture.Mips[0]);
+
+		TextureImage decoded;
+		DecompressImage(bounds.Format, &texture.Mips[0][0], image.Width, image.Height, &decoded);
+		CHECK(decoded.Width == image.Width && decoded.Height == image.Height);
+		CHECK(decoded.Pixels.size() == image.Pixels.size());
+	}
+}
+
+int main()
+{
+	TestSolidBlocks();
+	TestGradientBlocks();
+	TestAlphaEdges();
+	TestTexture();
+	return TestResult();
+}
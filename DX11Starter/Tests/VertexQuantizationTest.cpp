@@ -0,0 +1,178 @@
+#include "VertexQuantization.h"
+#include "TestCheck.h"
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+// Unit normals spread over the whole sphere (a Fibonacci
+// spiral), plus the axes and octant diagonals, which sit on
+// the octahedron's folds and corners
+static std::vector<XMFLOAT3> MakeNormals(unsigned int spiralCount)
+{
+	std::vector<XMFLOAT3> normals;
+	for (unsigned int i = 0; i < spiralCount; i++)
+	{
+		float z = 1.0f - 2.0f * (i + 0.5f) / spiralCount;
+		float r = std::sqrt(1.0f - z * z);
+		float angle = i * 2.39996323f;
+		normals.push_back(XMFLOAT3(r * std::cos(angle), r * std::sin(angle), z));
+	}
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		for (int sign = -1; sign <= 1; sign += 2)
+		{
+			XMFLOAT3 n(0, 0, 0);
+			(&n.x)[axis] = (float)sign;
+			normals.push_back(n);
+		}
+	}
+
+	float d = 1.0f / std::sqrt(3.0f);
+	for (int octant = 0; octant < 8; octant++)
+		normals.push_back(XMFLOAT3(octant & 1 ? -d : d, octant & 2 ? -d : d, octant & 4 ? -d : d));
+
+	return normals;
+}
+
+// From atan2 rather than acos, which can't resolve angles
+// this small in single precision
+static float AngleDegrees(FXMVECTOR a, FXMVECTOR b)
+{
+	float sine = XMVectorGetX(XMVector3Length(XMVector3Cross(a, b)));
+	float cosine = XMVectorGetX(XMVector3Dot(a, b));
+	return XMConvertToDegrees(std::atan2(sine, cosine));
+}
+
+// Encoded normals land in [-1, 1]^2 and decode back to
+// themselves, both at full float precision and after being
+// stored as two 16 bit snorms (as QuantizedVertex does)
+static void TestOctahedralBounds()
+{
+	std::vector<XMFLOAT3> normals = MakeNormals(100000);
+
+	float maxFloatError = 0.0f;
+	float maxSnormError = 0.0f;
+	float maxEncoded = 0.0f;
+	for (unsigned int i = 0; i < normals.size(); i++)
+	{
+		XMVECTOR normal = XMLoadFloat3(&normals[i]);
+		XMVECTOR encoded = EncodeOctahedral(normal);
+		maxEncoded = (std::max)(maxEncoded, (std::max)(std::fabs(XMVectorGetX(encoded)), std::fabs(XMVectorGetY(encoded))));
+
+		float floatError = AngleDegrees(DecodeOctahedral(encoded), normal);
+		maxFloatError = (std::max)(maxFloatError, floatError);
+
+		XMSHORTN2 packed;
+		XMStoreShortN2(&packed, encoded);
+		float snormError = AngleDegrees(DecodeOctahedral(XMLoadShortN2(&packed)), normal);
+		maxSnormError = (std::max)(maxSnormError, snormError);
+	}
+
+	printf("Octahedral: max error %g degrees in float, %g degrees as snorm16\n", maxFloatError, maxSnormError);
+	CHECK(maxEncoded <= 1.0f + 1e-6f);
+	CHECK(maxFloatError < 0.01f);
+
+	// A 16 bit step is 2/65535 of the square, which the octahedron
+	// stretches by at most about 2x, so errors stay around 0.004
+	// degrees.  0.01 leaves room without hiding a broken fold.
+	CHECK(maxSnormError < 0.01f);
+}
+
+// Round trips a random mesh and checks each vertex against
+// the 16 bit position and half float UV precision, and that
+// the reported bounds really are the worst case
+static void TestVertexRoundTrip()
+{
+	std::mt19937 random(42);
+	std::uniform_real_distribution<float> position(-37.0f, 53.0f);
+	std::uniform_real_distribution<float> uv(0.0f, 1.0f);
+	std::vector<XMFLOAT3> normals = MakeNormals(5000);
+
+	std::vector<Vertex> vertices(normals.size());
+	for (unsigned int i = 0; i < vertices.size(); i++)
+	{
+		vertices[i].Position = XMFLOAT3(position(random), position(random) * 0.1f, position(random) * 2.0f);
+		vertices[i].Normal = normals[i];
+		vertices[i].UV = XMFLOAT2(uv(random), uv(random));
+	}
+
+	std::vector<QuantizedVertex> quantized(vertices.size());
+	QuantizationInfo info;
+	QuantizeVertices(&vertices[0], (unsigned int)vertices.size(), &quantized[0], &info);
+
+	XMVECTOR center = XMLoadFloat3(&info.PositionCenter);
+	XMVECTOR extent = XMLoadFloat3(&info.PositionExtent);
+
+	// Half a snorm step per axis, across the box's diagonal
+	float step = 1.0f / 32767.0f;
+	XMVECTOR halfStep = XMVectorScale(extent, step * 0.5f);
+	float positionBound = XMVectorGetX(XMVector3Length(halfStep)) * 1.01f;
+
+	float maxPosition = 0.0f, maxNormal = 0.0f, maxUV = 0.0f;
+	for (unsigned int i = 0; i < vertices.size(); i++)
+	{
+		XMVECTOR original = XMLoadFloat3(&vertices[i].Position);
+		XMVECTOR decoded = XMVectorMultiplyAdd(XMLoadShortN4(&quantized[i].Position), extent, center);
+		maxPosition = (std::max)(maxPosition, XMVectorGetX(XMVector3Length(XMVectorSubtract(decoded, original))));
+
+		XMVECTOR normal = XMLoadFloat3(&vertices[i].Normal);
+		XMVECTOR decodedNormal = DecodeOctahedral(XMLoadShortN2(&quantized[i].Normal));
+		maxNormal = (std::max)(maxNormal, AngleDegrees(decodedNormal, normal));
+
+		XMVECTOR uvError = XMVectorAbs(XMVectorSubtract(XMLoadHalf2(&quantized[i].UV), XMLoadFloat2(&vertices[i].UV)));
+		maxUV = (std::max)(maxUV, (std::max)(XMVectorGetX(uvError), XMVectorGetY(uvError)));
+	}
+
+	printf("Vertices: position error %g (bound %g), normal %g degrees, uv %g\n", maxPosition, positionBound, maxNormal, maxUV);
+	CHECK(maxPosition <= positionBound);
+	CHECK(maxNormal < 0.01f);
+
+	// Half floats keep 11 significant bits, so in [0, 1] the
+	// error is at most half a step at the top: 2^-12
+	CHECK(maxUV <= 1.0f / 4096.0f);
+
+	// The reported bounds are what was measured
+	CHECK_NEAR(info.MaxPositionError, maxPosition, 1e-6);
+	CHECK_NEAR(info.MaxNormalError, maxNormal, 1e-4);
+	CHECK_NEAR(info.MaxUVError, maxUV, 1e-7);
+
+	// The box is the mesh's bounds, so the extremes hit +-1 exactly
+	bool touchesMax = false, touchesMin = false;
+	for (unsigned int i = 0; i < quantized.size(); i++)
+	{
+		touchesMax |= quantized[i].Position.x == 32767;
+		touchesMin |= quantized[i].Position.x == -32767;
+	}
+	CHECK(touchesMax && touchesMin);
+}
+
+// A flat mesh has no extent along one axis, which mustn't
+// divide by zero
+static void TestFlatMesh()
+{
+	Vertex vertices[3];
+	for (unsigned int i = 0; i < 3; i++)
+	{
+		vertices[i].Position = XMFLOAT3((float)i, 0.0f, 2.0f * i);
+		vertices[i].Normal = XMFLOAT3(0, 1, 0);
+		vertices[i].UV = XMFLOAT2(0.5f, 0.25f);
+	}
+
+	QuantizedVertex quantized[3];
+	QuantizationInfo info;
+	QuantizeVertices(vertices, 3, quantized, &info);
+	CHECK(info.MaxPositionError < 1e-3f);
+	CHECK(info.MaxNormalError < 0.01f);
+	CHECK(info.MaxUVError == 0.0f);
+}
+
+int main()
+{
+	TestOctahedralBounds();
+	TestVertexRoundTrip();
+	TestFlatMesh();
+	return TestResult();
+}
@@ -0,0 +1,912 @@
+#include "TextureCompression.h"
+#include <emmintrin.h>
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+// --------------------------------------------------------
+// A block pulled apart into one array per channel, so the
+// encoders can work on 4 pixels at once with SSE
+// --------------------------------------------------------
+struct BlockChannels
+{
+	alignas(16) float Channel[4][16];
+};
+
+static void SplitBlock(const unsigned char* pixels, BlockChannels* block)
+{
+	for (unsigned int i = 0; i < 16; i++)
+		for (unsigned int c = 0; c < 4; c++)
+			block->Channel[c][i] = pixels[i * 4 + c];
+}
+
+static float Sum(__m128 v)
+{
+	alignas(16) float lanes[4];
+	_mm_store_ps(lanes, v);
+	return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+static float Clamp255(float value)
+{
+	return value < 0.0f ? 0.0f : (value > 255.0f ? 255.0f : value);
+}
+
+// --------------------------------------------------------
+// Picks the closest palette entry for every pixel, over
+// channelCount channels starting at channels, and returns
+// the total squared error.  This is where encoding spends
+// its time, so it goes 4 pixels at a time.
+// --------------------------------------------------------
+static float FitIndices(const float (*channels)[16], unsigned int channelCount, const float (*palette)[4], unsigned int paletteSize, unsigned char* indices)
+{
+	__m128 total = _mm_setzero_ps();
+	for (unsigned int p = 0; p < 16; p += 4)
+	{
+		__m128 bestError = _mm_set1_ps(FLT_MAX);
+		__m128i bestIndex = _mm_setzero_si128();
+		for (unsigned int e = 0; e < paletteSize; e++)
+		{
+			__m128 error = _mm_setzero_ps();
+			for (unsigned int c = 0; c < channelCount; c++)
+			{
+				__m128 d = _mm_sub_ps(_mm_load_ps(&channels[c][p]), _mm_set1_ps(palette[e][c]));
+				error = _mm_add_ps(error, _mm_mul_ps(d, d));
+			}
+
+			__m128i closer = _mm_castps_si128(_mm_cmplt_ps(error, bestError));
+			bestError = _mm_min_ps(error, bestError);
+			bestIndex = _mm_or_si128(
+				_mm_and_si128(closer, _mm_set1_epi32((int)e)),
+				_mm_andnot_si128(closer, bestIndex));
+		}
+		total = _mm_add_ps(total, bestError);
+
+		alignas(16) int lanes[4];
+		_mm_store_si128((__m128i*)lanes, bestIndex);
+		for (unsigned int i = 0; i < 4; i++)
+			indices[p + i] = (unsigned char)lanes[i];
+	}
+	return Sum(total);
+}
+
+// --------------------------------------------------------
+// The line the block's pixels spread along the most: the
+// covariance's main eigenvector (by power iteration)
+// through the mean, cut off where it just covers every
+// pixel
+// --------------------------------------------------------
+static void FitLine(const BlockChannels& block, unsigned int channelCount, float* start, float* end)
+{
+	float mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	__m128 centered[4][4];
+	for (unsigned int c = 0; c < channelCount; c++)
+	{
+		const float* channel = block.Channel[c];
+		__m128 sum = _mm_add_ps(
+			_mm_add_ps(_mm_load_ps(channel), _mm_load_ps(channel + 4)),
+			_mm_add_ps(_mm_load_ps(channel + 8), _mm_load_ps(channel + 12)));
+		mean[c] = Sum(sum) / 16.0f;
+		for (unsigned int g = 0; g < 4; g++)
+			centered[c][g] = _mm_sub_ps(_mm_load_ps(channel + g * 4), _mm_set1_ps(mean[c]));
+	}
+
+	float covariance[4][4];
+	for (unsigned int i = 0; i < channelCount; i++)
+	{
+		for (unsigned int j = i; j < channelCount; j++)
+		{
+			__m128 sum = _mm_setzero_ps();
+			for (unsigned int g = 0; g < 4; g++)
+				sum = _mm_add_ps(sum, _mm_mul_ps(centered[i][g], centered[j][g]));
+			covariance[i][j] = covariance[j][i] = Sum(sum);
+		}
+	}
+
+	// Start from whichever channel varies most, since it's usually
+	// close already
+	float axis[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	unsigned int widest = 0;
+	for (unsigned int c = 1; c < channelCount; c++)
+		if (covariance[c][c] > covariance[widest][widest])
+			widest = c;
+	if (covariance[widest][widest] < 1.0f)
+	{
+		// Flat - one color covers it
+		for (unsigned int c = 0; c < channelCount; c++)
+			start[c] = end[c] = mean[c];
+		return;
+	}
+	axis[widest] = 1.0f;
+
+	for (unsigned int iteration = 0; iteration < 8; iteration++)
+	{
+		float next[4];
+		float largest = 0.0f;
+		for (unsigned int i = 0; i < channelCount; i++)
+		{
+			next[i] = 0.0f;
+			for (unsigned int j = 0; j < channelCount; j++)
+				next[i] += covariance[i][j] * axis[j];
+			largest = (std::max)(largest, fabsf(next[i]));
+		}
+		if (largest < 1e-6f)
+			break;
+		for (unsigned int c = 0; c < channelCount; c++)
+			axis[c] = next[c] / largest;
+	}
+
+	float length = 0.0f;
+	for (unsigned int c = 0; c < channelCount; c++)
+		length += axis[c] * axis[c];
+	length = sqrtf(length);
+	for (unsigned int c = 0; c < channelCount; c++)
+		axis[c] /= length;
+
+	__m128 lowest = _mm_set1_ps(FLT_MAX);
+	__m128 highest = _mm_set1_ps(-FLT_MAX);
+	for (unsigned int g = 0; g < 4; g++)
+	{
+		__m128 t = _mm_setzero_ps();
+		for (unsigned int c = 0; c < channelCount; c++)
+			t = _mm_add_ps(t, _mm_mul_ps(centered[c][g], _mm_set1_ps(axis[c])));
+		lowest = _mm_min_ps(lowest, t);
+		highest = _mm_max_ps(highest, t);
+	}
+
+	alignas(16) float low[4];
+	alignas(16) float high[4];
+	_mm_store_ps(low, lowest);
+	_mm_store_ps(high, highest);
+	float tMin = (std::min)((std::min)(low[0], low[1]), (std::min)(low[2], low[3]));
+	float tMax = (std::max)((std::max)(high[0], high[1]), (std::max)(high[2], high[3]));
+
+	for (unsigned int c = 0; c < channelCount; c++)
+	{
+		start[c] = Clamp255(mean[c] + axis[c] * tMin);
+		end[c] = Clamp255(mean[c] + axis[c] * tMax);
+	}
+}
+
+// --------------------------------------------------------
+// Given the entry each pixel chose, the endpoints that
+// minimise the squared error by least squares.  weights[i]
+// is how far from start to end entry i sits.  False if
+// every pixel chose the same weight, which pins down
+// nothing.
+// --------------------------------------------------------
+static bool RefineLine(const float (*channels)[16], unsigned int channelCount, const unsigned char* indices, const float* weights, float* start, float* end)
+{
+	float aa = 0.0f;
+	float bb = 0.0f;
+	float ab = 0.0f;
+	float ax[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	float bx[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	for (unsigned int i = 0; i < 16; i++)
+	{
+		float b = weights[indices[i]];
+		float a = 1.0f - b;
+		aa += a * a;
+		bb += b * b;
+		ab += a * b;
+		for (unsigned int c = 0; c < channelCount; c++)
+		{
+			ax[c] += a * channels[c][i];
+			bx[c] += b * channels[c][i];
+		}
+	}
+
+	float determinant = aa * bb - ab * ab;
+	if (fabsf(determinant) < 1e-6f)
+		return false;
+
+	for (unsigned int c = 0; c < channelCount; c++)
+	{
+		start[c] = Clamp255((ax[c] * bb - bx[c] * ab) / determinant);
+		end[c] = Clamp255((bx[c] * aa - ax[c] * ab) / determinant);
+	}
+	return true;
+}
+
+static unsigned int Quantize(float value, unsigned int maximum)
+{
+	return (unsigned int)(value * maximum / 255.0f + 0.5f);
+}
+
+// --------------------------------------------------------
+// BC1 color: two 5:6:5 endpoints and a 2 bit index a pixel.
+// With c0 > c1 there are 4 colors (the ends, and thirds
+// between them); otherwise 3 and black.  The color half of
+// BC3 always uses 4.
+// --------------------------------------------------------
+static unsigned short Pack565(const float* color)
+{
+	return (unsigned short)((Quantize(color[0], 31) << 11) | (Quantize(color[1], 63) << 5) | Quantize(color[2], 31));
+}
+
+static void Unpack565(unsigned short packed, int* color)
+{
+	int r = (packed >> 11) & 31;
+	int g = (packed >> 5) & 63;
+	int b = packed & 31;
+	color[0] = (r << 3) | (r >> 2);
+	color[1] = (g << 2) | (g >> 4);
+	color[2] = (b << 3) | (b >> 2);
+}
+
+static void ColorPalette(unsigned short c0, unsigned short c1, bool alwaysFourColors, float (*palette)[4])
+{
+	int a[3];
+	int b[3];
+	Unpack565(c0, a);
+	Unpack565(c1, b);
+
+	bool fourColors = alwaysFourColors || c0 > c1;
+	for (unsigned int c = 0; c < 3; c++)
+	{
+		palette[0][c] = (float)a[c];
+		palette[1][c] = (float)b[c];
+		if (fourColors)
+		{
+			palette[2][c] = (float)((2 * a[c] + b[c]) / 3);
+			palette[3][c] = (float)((a[c] + 2 * b[c]) / 3);
+		}
+		else
+		{
+			palette[2][c] = (float)((a[c] + b[c]) / 2);
+			palette[3][c] = 0.0f;
+		}
+	}
+	palette[0][3] = palette[1][3] = palette[2][3] = 255.0f;
+	palette[3][3] = fourColors ? 255.0f : 0.0f;
+}
+
+static void EncodeColorBlock(const BlockChannels& block, bool alwaysFourColors, unsigned char* out)
+{
+	static const float weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+	float start[4];
+	float end[4];
+	FitLine(block, 3, start, end);
+
+	float bestError = FLT_MAX;
+	unsigned short best0 = 0;
+	unsigned short best1 = 0;
+	unsigned char bestIndices[16] = {};
+
+	// Each round refits the endpoints to the last round's indices
+	for (unsigned int round = 0; round < 3; round++)
+	{
+		unsigned short c0 = Pack565(start);
+		unsigned short c1 = Pack565(end);
+		if (c0 < c1)
+			std::swap(c0, c1);
+
+		float palette[4][4];
+		unsigned char indices[16];
+		ColorPalette(c0, c1, alwaysFourColors, palette);
+		float error = FitIndices(block.Channel, 3, palette, 4, indices);
+		if (error < bestError)
+		{
+			bestError = error;
+			best0 = c0;
+			best1 = c1;
+			memcpy(bestIndices, indices, 16);
+		}
+
+		if (error == 0.0f || !RefineLine(block.Channel, 3, indices, weights, start, end))
+			break;
+	}
+
+	unsigned int bits = 0;
+	for (unsigned int i = 0; i < 16; i++)
+		bits |= (unsigned int)bestIndices[i] << (i * 2);
+
+	out[0] = (unsigned char)best0;
+	out[1] = (unsigned char)(best0 >> 8);
+	out[2] = (unsigned char)best1;
+	out[3] = (unsigned char)(best1 >> 8);
+	memcpy(out + 4, &bits, 4);
+}
+
+static void DecodeColorBlock(const unsigned char* in, bool alwaysFourColors, unsigned char* pixels)
+{
+	unsigned short c0 = (unsigned short)(in[0] | (in[1] << 8));
+	unsigned short c1 = (unsigned short)(in[2] | (in[3] << 8));
+	unsigned int bits;
+	memcpy(&bits, in + 4, 4);
+
+	float palette[4][4];
+	ColorPalette(c0, c1, alwaysFourColors, palette);
+	for (unsigned int i = 0; i < 16; i++)
+	{
+		unsigned int index = (bits >> (i * 2)) & 3;
+		for (unsigned int c = 0; c < 4; c++)
+			pixels[i * 4 + c] = (unsigned char)palette[index][c];
+	}
+}
+
+// --------------------------------------------------------
+// BC4 (one channel: BC3's alpha, or either half of BC5):
+// two 8 bit endpoints and a 3 bit index a pixel.  With
+// a0 > a1 there are 8 values (the ends, and sevenths
+// between them); otherwise 6, plus 0 and 255.
+// --------------------------------------------------------
+static void ChannelPalette(int a0, int a1, float (*palette)[4])
+{
+	palette[0][0] = (float)a0;
+	palette[1][0] = (float)a1;
+	if (a0 > a1)
+	{
+		for (int i = 2; i < 8; i++)
+			palette[i][0] = (float)(((8 - i) * a0 + (i - 1) * a1) / 7);
+	}
+	else
+	{
+		for (int i = 2; i < 6; i++)
+			palette[i][0] = (float)(((6 - i) * a0 + (i - 1) * a1) / 5);
+		palette[6][0] = 0.0f;
+		palette[7][0] = 255.0f;
+	}
+}
+
+static void EncodeChannelBlock(const BlockChannels& block, unsigned int channel, unsigned char* out)
+{
+	static const float weights[8] = { 0.0f, 1.0f, 1.0f / 7.0f, 2.0f / 7.0f, 3.0f / 7.0f, 4.0f / 7.0f, 5.0f / 7.0f, 6.0f / 7.0f };
+	const float (*channels)[16] = &block.Channel[channel];
+
+	float start = 0.0f;
+	float end = 255.0f;
+	for (unsigned int i = 0; i < 16; i++)
+	{
+		start = (std::max)(start, channels[0][i]);
+		end = (std::min)(end, channels[0][i]);
+	}
+
+	float bestError = FLT_MAX;
+	int best0 = (int)start;
+	int best1 = (int)end;
+	unsigned char bestIndices[16] = {};
+
+	// A flat channel is exact with every index on a0
+	if (start > end)
+	{
+		for (unsigned int round = 0; round < 3; round++)
+		{
+			int a0 = (int)(start + 0.5f);
+			int a1 = (int)(end + 0.5f);
+			if (a0 < a1)
+				std::swap(a0, a1);
+
+			// Keep to the 8 value mode, which refining assumes
+			if (a0 == a1)
+			{
+				if (a0 < 255) a0++;
+				else a1--;
+			}
+
+			float palette[8][4];
+			unsigned char indices[16];
+			ChannelPalette(a0, a1, palette);
+			float error = FitIndices(channels, 1, palette, 8, indices);
+			if (error < bestError)
+			{
+				bestError = error;
+				best0 = a0;
+				best1 = a1;
+				memcpy(bestIndices, indices, 16);
+			}
+
+			if (error == 0.0f || !RefineLine(channels, 1, indices, weights, &start, &end))
+				break;
+		}
+	}
+
+	unsigned long long bits = 0;
+	for (unsigned int i = 0; i < 16; i++)
+		bits |= (unsigned long long)bestIndices[i] << (i * 3);
+
+	out[0] = (unsigned char)best0;
+	out[1] = (unsigned char)best1;
+	for (unsigned int i = 0; i < 6; i++)
+		out[2 + i] = (unsigned char)(bits >> (i * 8));
+}
+
+static void DecodeChannelBlock(const unsigned char* in, unsigned int channel, unsigned char* pixels)
+{
+	unsigned long long bits = 0;
+	for (unsigned int i = 0; i < 6; i++)
+		bits |= (unsigned long long)in[2 + i] << (i * 8);
+
+	float palette[8][4];
+	ChannelPalette(in[0], in[1], palette);
+	for (unsigned int i = 0; i < 16; i++)
+		pixels[i * 4 + channel] = (unsigned char)palette[(bits >> (i * 3)) & 7][0];
+}
+
+// --------------------------------------------------------
+// BC7 mode 6: one RGBA line with 7 bit endpoints, each
+// with its own shared low bit (the "p-bit"), and a 4 bit
+// index a pixel.  Only mode 6 is ever written - it has no
+// partitions to search, and for texture content without
+// sharp multi-color edges it's close to the best BC7 does.
+//
+// Fields are packed from the lowest bit up.  The first
+// pixel's index drops its top bit, so it must be under 8.
+// --------------------------------------------------------
+static const unsigned int BC7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+struct BlockBits
+{
+	unsigned char* Data;
+	unsigned int Position;
+
+	void Write(unsigned int value, unsigned int count)
+	{
+		for (unsigned int i = 0; i < count; i++, Position++)
+			if ((value >> i) & 1)
+				Data[Position >> 3] |= (unsigned char)(1 << (Position & 7));
+	}
+
+	unsigned int Read(unsigned int count)
+	{
+		unsigned int value = 0;
+		for (unsigned int i = 0; i < count; i++, Position++)
+			value |= (unsigned int)((Data[Position >> 3] >> (Position & 7)) & 1) << i;
+		return value;
+	}
+};
+
+static void BC7Palette(const int* e0, const int* e1, float (*palette)[4])
+{
+	for (unsigned int i = 0; i < 16; i++)
+		for (unsigned int c = 0; c < 4; c++)
+			palette[i][c] = (float)(((64 - BC7Weights[i]) * e0[c] + BC7Weights[i] * e1[c] + 32) >> 6);
+}
+
+static int QuantizeBC7(float value, int pBit)
+{
+	int q = (int)floorf((value - pBit) / 2.0f + 0.5f);
+	return q < 0 ? 0 : (q > 127 ? 127 : q);
+}
+
+static int ChooseBC7PBit(const float* endpoint)
+{
+	float error[2] = { 0.0f, 0.0f };
+	for (int p = 0; p < 2; p++)
+	{
+		for (unsigned int c = 0; c < 4; c++)
+		{
+			float d = endpoint[c] - (float)((QuantizeBC7(endpoint[c], p) << 1) | p);
+			error[p] += d * d;
+		}
+	}
+	return error[1] < error[0] ? 1 : 0;
+}
+
+static void EncodeBC7Block(const BlockChannels& block, unsigned char* out)
+{
+	float weights[16];
+	for (unsigned int i = 0; i < 16; i++)
+		weights[i] = BC7Weights[i] / 64.0f;
+
+	float start[4];
+	float end[4];
+	FitLine(block, 4, start, end);
+
+	float bestError = FLT_MAX;
+	int best0[4] = {};
+	int best1[4] = {};
+	int bestP0 = 0;
+	int bestP1 = 0;
+	unsigned char bestIndices[16] = {};
+
+	for (unsigned int round = 0; round < 3; round++)
+	{
+		// Each end takes whichever p-bit lands its channels closest
+		int p0 = ChooseBC7PBit(start);
+		int p1 = ChooseBC7PBit(end);
+		int q0[4];
+		int q1[4];
+		int e0[4];
+		int e1[4];
+		for (unsigned int c = 0; c < 4; c++)
+		{
+			q0[c] = QuantizeBC7(start[c], p0);
+			q1[c] = QuantizeBC7(end[c], p1);
+			e0[c] = (q0[c] << 1) | p0;
+			e1[c] = (q1[c] << 1) | p1;
+		}
+
+		float palette[16][4];
+		unsigned char indices[16];
+		BC7Palette(e0, e1, palette);
+		float error = FitIndices(block.Channel, 4, palette, 16, indices);
+		if (error < bestError)
+		{
+			bestError = error;
+			memcpy(best0, q0, sizeof(q0));
+			memcpy(best1, q1, sizeof(q1));
+			bestP0 = p0;
+			bestP1 = p1;
+			memcpy(bestIndices, indices, 16);
+		}
+
+		if (error == 0.0f || !RefineLine(block.Channel, 4, indices, weights, start, end))
+			break;
+	}
+
+	// Flip the line around if the first index needs its top bit
+	if (bestIndices[0] >= 8)
+	{
+		for (unsigned int c = 0; c < 4; c++)
+			std::swap(best0[c], best1[c]);
+		std::swap(bestP0, bestP1);
+		for (unsigned int i = 0; i < 16; i++)
+			bestIndices[i] = (unsigned char)(15 - bestIndices[i]);
+	}
+
+	memset(out, 0, 16);
+	BlockBits bits = { out, 0 };
+	bits.Write(1 << 6, 7);
+	for (unsigned int c = 0; c < 4; c++)
+	{
+		bits.Write(best0[c], 7);
+		bits.Write(best1[c], 7);
+	}
+	bits.Write(bestP0, 1);
+	bits.Write(bestP1, 1);
+	bits.Write(bestIndices[0], 3);
+	for (unsigned int i = 1; i < 16; i++)
+		bits.Write(bestIndices[i], 4);
+}
+
+static void DecodeBC7Block(const unsigned char* in, unsigned char* pixels)
+{
+	BlockBits bits = { (unsigned char*)in, 0 };
+	if (bits.Read(7) != (1 << 6))
+	{
+		// Not mode 6 - not something we wrote
+		memset(pixels, 0, 64);
+		return;
+	}
+
+	int e0[4];
+	int e1[4];
+	for (unsigned int c = 0; c < 4; c++)
+	{
+		e0[c] = bits.Read(7) << 1;
+		e1[c] = bits.Read(7) << 1;
+	}
+	int p0 = bits.Read(1);
+	int p1 = bits.Read(1);
+	for (unsigned int c = 0; c < 4; c++)
+	{
+		e0[c] |= p0;
+		e1[c] |= p1;
+	}
+
+	float palette[16][4];
+	BC7Palette(e0, e1, palette);
+	for (unsigned int i = 0; i < 16; i++)
+	{
+		unsigned int index = bits.Read(i == 0 ? 3 : 4);
+		for (unsigned int c = 0; c < 4; c++)
+			pixels[i * 4 + c] = (unsigned char)palette[index][c];
+	}
+}
+
+unsigned int GetBlockBytes(BlockFormat format)
+{
+	return format == BLOCK_BC1 ? 8 : 16;
+}
+
+unsigned int GetBlockDXGIFormat(BlockFormat format, bool srgb)
+{
+	switch (format)
+	{
+	case BLOCK_BC1: return srgb ? 72 : 71;		// DXGI_FORMAT_BC1_UNORM(_SRGB)
+	case BLOCK_BC3: return srgb ? 78 : 77;		// DXGI_FORMAT_BC3_UNORM(_SRGB)
+	case BLOCK_BC5: return 83;					// DXGI_FORMAT_BC5_UNORM - data, never sRGB
+	case BLOCK_BC7: return srgb ? 99 : 98;		// DXGI_FORMAT_BC7_UNORM(_SRGB)
+	}
+	return 0;
+}
+
+// How many leading channels (of RGBA) a format keeps
+static unsigned int GetBlockChannels(BlockFormat format)
+{
+	switch (format)
+	{
+	case BLOCK_BC1: return 3;
+	case BLOCK_BC5: return 2;
+	default: return 4;
+	}
+}
+
+void DownsampleImage(const TextureImage& source, TextureImage* result)
+{
+	unsigned int width = source.Width > 1 ? source.Width / 2 : 1;
+	unsigned int height = source.Height > 1 ? source.Height / 2 : 1;
+	result->Width = width;
+	result->Height = height;
+	result->Pixels.resize(width * height * 4);
+
+	for (unsigned int y = 0; y < height; y++)
+	{
+		unsigned int y0 = (std::min)(y * 2, source.Height - 1);
+		unsigned int y1 = (std::min)(y * 2 + 1, source.Height - 1);
+		for (unsigned int x = 0; x < width; x++)
+		{
+			unsigned int x0 = (std::min)(x * 2, source.Width - 1);
+			unsigned int x1 = (std::min)(x * 2 + 1, source.Width - 1);
+			const unsigned char* a = &source.Pixels[(y0 * source.Width + x0) * 4];
+			const unsigned char* b = &source.Pixels[(y0 * source.Width + x1) * 4];
+			const unsigned char* c = &source.Pixels[(y1 * source.Width + x0) * 4];
+			const unsigned char* d = &source.Pixels[(y1 * source.Width + x1) * 4];
+			unsigned char* out = &result->Pixels[(y * width + x) * 4];
+			for (unsigned int i = 0; i < 4; i++)
+				out[i] = (unsigned char)((a[i] + b[i] + c[i] + d[i] + 2) / 4);
+		}
+	}
+}
+
+void CompressBlock(BlockFormat format, const unsigned char* pixels, unsigned char* block)
+{
+	BlockChannels channels;
+	SplitBlock(pixels, &channels);
+
+	switch (format)
+	{
+	case BLOCK_BC1:
+		EncodeColorBlock(channels, false, block);
+		break;
+	case BLOCK_BC3:
+		EncodeChannelBlock(channels, 3, block);
+		EncodeColorBlock(channels, true, block + 8);
+		break;
+	case BLOCK_BC5:
+		EncodeChannelBlock(channels, 0, block);
+		EncodeChannelBlock(channels, 1, block + 8);
+		break;
+	case BLOCK_BC7:
+		EncodeBC7Block(channels, block);
+		break;
+	}
+}
+
+void DecompressBlock(BlockFormat format, const unsigned char* block, unsigned char* pixels)
+{
+	switch (format)
+	{
+	case BLOCK_BC1:
+		DecodeColorBlock(block, false, pixels);
+		break;
+	case BLOCK_BC3:
+		DecodeColorBlock(block + 8, true, pixels);
+		DecodeChannelBlock(block, 3, pixels);
+		break;
+	case BLOCK_BC5:
+		for (unsigned int i = 0; i < 16; i++)
+		{
+			pixels[i * 4 + 2] = 0;
+			pixels[i * 4 + 3] = 255;
+		}
+		DecodeChannelBlock(block, 0, pixels);
+		DecodeChannelBlock(block + 8, 1, pixels);
+		break;
+	case BLOCK_BC7:
+		DecodeBC7Block(block, pixels);
+		break;
+	}
+}
+
+// --------------------------------------------------------
+// Blocks hanging off the right or bottom edge repeat the
+// edge pixels, which costs them no accuracy
+// --------------------------------------------------------
+void CompressImage(BlockFormat format, const TextureImage& image, ThreadPool* threads, std::vector<unsigned char>* blocks)
+{
+	unsigned int blocksX = (image.Width + 3) / 4;
+	unsigned int blocksY = (image.Height + 3) / 4;
+	unsigned int blockBytes = GetBlockBytes(format);
+	blocks->assign(blocksX * blocksY * blockBytes, 0);
+
+	auto compressBlocks = [&](unsigned int begin, unsigned int end)
+	{
+		unsigned char pixels[64];
+		for (unsigned int b = begin; b < end; b++)
+		{
+			unsigned int bx = b % blocksX;
+			unsigned int by = b / blocksX;
+			for (unsigned int i = 0; i < 16; i++)
+			{
+				unsigned int x = (std::min)(bx * 4 + (i & 3), image.Width - 1);
+				unsigned int y = (std::min)(by * 4 + (i >> 2), image.Height - 1);
+				memcpy(&pixels[i * 4], &image.Pixels[(y * image.Width + x) * 4], 4);
+			}
+			CompressBlock(format, pixels, &(*blocks)[b * blockBytes]);
+		}
+	};
+
+	if (threads)
+		threads->ParallelFor(blocksX * blocksY, 16, compressBlocks);
+	else
+		compressBlocks(0, blocksX * blocksY);
+}
+
+void DecompressImage(BlockFormat format, const unsigned char* blocks, unsigned int width, unsigned int height, TextureImage* image)
+{
+	unsigned int blocksX = (width + 3) / 4;
+	unsigned int blocksY = (height + 3) / 4;
+	unsigned int blockBytes = GetBlockBytes(format);
+	image->Width = width;
+	image->Height = height;
+	image->Pixels.resize(width * height * 4);
+
+	unsigned char pixels[64];
+	for (unsigned int by = 0; by < blocksY; by++)
+	{
+		for (unsigned int bx = 0; bx < blocksX; bx++)
+		{
+			DecompressBlock(format, blocks + (by * blocksX + bx) * blockBytes, pixels);
+			for (unsigned int i = 0; i < 16; i++)
+			{
+				unsigned int x = bx * 4 + (i & 3);
+				unsigned int y = by * 4 + (i >> 2);
+				if (x < width && y < height)
+					memcpy(&image->Pixels[(y * width + x) * 4], &pixels[i * 4], 4);
+			}
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Only building and compressing the mips is timed.  The
+// error is measured afterwards, by decompressing each one.
+// --------------------------------------------------------
+void CompressTexture(
+	const TextureImage& image,
+	BlockFormat format,
+	bool srgb,
+	ThreadPool* threads,
+	CompressedTexture* texture,
+	TextureCompressionStats* stats)
+{
+	texture->Format = format;
+	texture->SRGB = srgb;
+	texture->Width = image.Width;
+	texture->Height = image.Height;
+	texture->Mips.clear();
+
+	std::chrono::high_resolution_clock::duration elapsed(0);
+	unsigned long long pixels = 0;
+	double squaredError = 0.0;
+	unsigned long long samples = 0;
+	unsigned int channelCount = GetBlockChannels(format);
+
+	const TextureImage* level = &image;
+	TextureImage current;
+	TextureImage next;
+	TextureImage decompressed;
+	for (;;)
+	{
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		texture->Mips.push_back(std::vector<unsigned char>());
+		CompressImage(format, *level, threads, &texture->Mips.back());
+		bool last = level->Width == 1 && level->Height == 1;
+		if (!last)
+			DownsampleImage(*level, &next);
+		elapsed += std::chrono::high_resolution_clock::now() - start;
+		pixels += level->Width * level->Height;
+
+		if (stats)
+		{
+			DecompressImage(format, &texture->Mips.back()[0], level->Width, level->Height, &decompressed);
+			for (unsigned int i = 0; i < level->Width * level->Height; i++)
+			{
+				for (unsigned int c = 0; c < channelCount; c++)
+				{
+					double d = (double)level->Pixels[i * 4 + c] - decompressed.Pixels[i * 4 + c];
+					squaredError += d * d;
+				}
+			}
+			samples += level->Width * level->Height * channelCount;
+		}
+
+		if (last)
+			break;
+		current.Pixels.swap(next.Pixels);
+		current.Width = next.Width;
+		current.Height = next.Height;
+		level = &current;
+	}
+
+	if (stats)
+	{
+		double meanSquaredError = squaredError / samples;
+		stats->Pixels = pixels;
+		stats->Seconds = std::chrono::duration<double>(elapsed).count();
+		stats->Threads = threads ? threads->GetThreadCount() : 1;
+		stats->PSNR = meanSquaredError > 0.0 ?
+			10.0 * log10(255.0 * 255.0 / meanSquaredError) :
+			std::numeric_limits<double>::infinity();
+	}
+}
+
+// --------------------------------------------------------
+// The DDS layout, as DDSTextureLoader reads it: a magic
+// number, the classic header, then the DX10 extension
+// --------------------------------------------------------
+struct DDSPixelFormat
+{
+	unsigned int Size;
+	unsigned int Flags;
+	unsigned int FourCC;
+	unsigned int RGBBitCount;
+	unsigned int RBitMask;
+	unsigned int GBitMask;
+	unsigned int BBitMask;
+	unsigned int ABitMask;
+};
+
+struct DDSHeader
+{
+	unsigned int Size;
+	unsigned int Flags;
+	unsigned int Height;
+	unsigned int Width;
+	unsigned int PitchOrLinearSize;
+	unsigned int Depth;
+	unsigned int MipMapCount;
+	unsigned int Reserved1[11];
+	DDSPixelFormat PixelFormat;
+	unsigned int Caps;
+	unsigned int Caps2;
+	unsigned int Caps3;
+	unsigned int Caps4;
+	unsigned int Reserved2;
+};
+
+struct DDSHeaderDX10
+{
+	unsigned int DXGIFormat;
+	unsigned int ResourceDimension;
+	unsigned int MiscFlag;
+	unsigned int ArraySize;
+	unsigned int MiscFlags2;
+};
+
+static_assert(sizeof(DDSHeader) == 124, "DDS header must be 124 bytes");
+static_assert(sizeof(DDSHeaderDX10) == 20, "DDS DX10 header must be 20 bytes");
+
+void BuildDDSFile(const CompressedTexture& texture, std::vector<unsigned char>* file)
+{
+	DDSHeader header = {};
+	header.Size = sizeof(DDSHeader);
+	header.Flags = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000;	// Caps, height, width, pixel format, mip count, linear size
+	header.Height = texture.Height;
+	header.Width = texture.Width;
+	header.PitchOrLinearSize = texture.Mips.empty() ? 0 : (unsigned int)texture.Mips[0].size();
+	header.MipMapCount = (unsigned int)texture.Mips.size();
+	header.PixelFormat.Size = sizeof(DDSPixelFormat);
+	header.PixelFormat.Flags = 0x4;									// FourCC
+	header.PixelFormat.FourCC = 'D' | ('X' << 8) | ('1' << 16) | ('0' << 24);
+	header.Caps = 0x1000 | 0x400000 | 0x8;							// Texture, mipmap, complex
+
+	DDSHeaderDX10 extension = {};
+	extension.DXGIFormat = GetBlockDXGIFormat(texture.Format, texture.SRGB);
+	extension.ResourceDimension = 3;								// D3D11_RESOURCE_DIMENSION_TEXTURE2D
+	extension.ArraySize = 1;
+
+	const unsigned int magic = 0x20534444;							// "DDS "
+	file->clear();
+	file->insert(file->end(), (const unsigned char*)&magic, (const unsigned char*)&magic + sizeof(magic));
+	file->insert(file->end(), (const unsigned char*)&header, (const unsigned char*)&header + sizeof(header));
+	file->insert(file->end(), (const unsigned char*)&extension, (const unsigned char*)&extension + sizeof(extension));
+	for (unsigned int i = 0; i < texture.Mips.size(); i++)
+		file->insert(file->end(), texture.Mips[i].begin(), texture.Mips[i].end());
+}
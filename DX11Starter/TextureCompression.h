@@ -0,0 +1,85 @@
+#pragma once
+
+#include <vector>
+#include "ThreadPool.h"
+
+// --------------------------------------------------------
+// Which block compressed format to encode to.  Every one
+// packs a 4x4 block of pixels into a fixed number of bytes.
+// --------------------------------------------------------
+enum BlockFormat
+{
+	BLOCK_BC1,		// Opaque color, 8 bytes a block
+	BLOCK_BC3,		// Color plus smooth alpha, 16 bytes
+	BLOCK_BC5,		// Two independent channels (normal map X and Y), 16 bytes
+	BLOCK_BC7		// High quality color and alpha, 16 bytes
+};
+
+// --------------------------------------------------------
+// An uncompressed image, 4 bytes (RGBA) a pixel, rows
+// packed with no padding between them
+// --------------------------------------------------------
+struct TextureImage
+{
+	unsigned int Width;
+	unsigned int Height;
+	std::vector<unsigned char> Pixels;
+};
+
+// --------------------------------------------------------
+// A compressed texture with its whole mip chain, largest
+// first, each level's blocks in rows
+// --------------------------------------------------------
+struct CompressedTexture
+{
+	BlockFormat Format;
+	bool SRGB;
+	unsigned int Width;
+	unsigned int Height;
+	std::vector<std::vector<unsigned char> > Mips;
+};
+
+// --------------------------------------------------------
+// What a compression cost, and how close it came.  PSNR is
+// over the channels the format keeps, across every mip.
+// --------------------------------------------------------
+struct TextureCompressionStats
+{
+	unsigned long long Pixels;
+	double Seconds;
+	unsigned int Threads;
+	double PSNR;			// dB - infinite if it came out exact
+};
+
+unsigned int GetBlockBytes(BlockFormat format);
+
+// The matching DXGI_FORMAT value (as a plain number, so this
+// builds without the DirectX headers)
+unsigned int GetBlockDXGIFormat(BlockFormat format, bool srgb);
+
+// Halves an image (rounding odd sizes down) with a box filter
+void DownsampleImage(const TextureImage& source, TextureImage* result);
+
+// One 4x4 block: pixels is 16 RGBA pixels in rows, block is
+// GetBlockBytes() long.  Decompression only understands what
+// compression writes (BC7 only uses mode 6).
+void CompressBlock(BlockFormat format, const unsigned char* pixels, unsigned char* block);
+void DecompressBlock(BlockFormat format, const unsigned char* block, unsigned char* pixels);
+
+// Compresses one image, its blocks split across the pool
+void CompressImage(BlockFormat format, const TextureImage& image, ThreadPool* threads, std::vector<unsigned char>* blocks);
+void DecompressImage(BlockFormat format, const unsigned char* blocks, unsigned int width, unsigned int height, TextureImage* image);
+
+// Builds the full mip chain down to 1x1 and compresses all of
+// it.  stats is optional.
+void CompressTexture(
+	const TextureImage& image,
+	BlockFormat format,
+	bool srgb,
+	ThreadPool* threads,
+	CompressedTexture* texture,
+	TextureCompressionStats* stats);
+
+// The texture as a DDS file (with the DX10 header, which every
+// BC format needs to say exactly what it is)
+void BuildDDSFile(const CompressedTexture& texture, std::vector<unsigned char>* file);
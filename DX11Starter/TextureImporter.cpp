@@ -0,0 +1,176 @@
+#include "TextureImporter.h"
+#include "WICTextureLoader.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+using namespace DirectX;
+
+static const char* GetBlockFormatName(BlockFormat format)
+{
+	switch (format)
+	{
+	case BLOCK_BC1: return "BC1";
+	case BLOCK_BC3: return "BC3";
+	case BLOCK_BC5: return "BC5";
+	case BLOCK_BC7: return "BC7";
+	}
+	return "?";
+}
+
+TextureImporter::TextureImporter(ID3D11Device* device, ID3D11DeviceContext* context, ThreadPool* threads)
+{
+	this->device = device;
+	this->context = context;
+	this->threads = threads;
+}
+
+std::wstring TextureImporter::GetCompressedPath(const std::wstring& sourcePath)
+{
+	size_t dot = sourcePath.find_last_of(L'.');
+	size_t slash = sourcePath.find_last_of(L"/\\");
+	if (dot == std::wstring::npos || (slash != std::wstring::npos && dot < slash))
+		return sourcePath + L".dds";
+	return sourcePath.substr(0, dot) + L".dds";
+}
+
+// --------------------------------------------------------
+// A missing source leaves whatever .dds there is alone, so
+// a build can ship without its sources
+// --------------------------------------------------------
+bool TextureImporter::ImportIfStale(const std::wstring& sourcePath, BlockFormat format)
+{
+	WIN32_FILE_ATTRIBUTE_DATA source;
+	WIN32_FILE_ATTRIBUTE_DATA compressed;
+	bool haveSource = GetFileAttributesExW(sourcePath.c_str(), GetFileExInfoStandard, &source) != 0;
+	bool haveCompressed = GetFileAttributesExW(GetCompressedPath(sourcePath).c_str(), GetFileExInfoStandard, &compressed) != 0;
+
+	if (!haveSource)
+		return haveCompressed;
+	if (haveCompressed && CompareFileTime(&source.ftLastWriteTime, &compressed.ftLastWriteTime) <= 0)
+		return true;
+
+	return Import(sourcePath, format);
+}
+
+bool TextureImporter::Import(const std::wstring& sourcePath, BlockFormat format)
+{
+	ID3D11Resource* staging = 0;
+	if (FAILED(CreateWICTextureFromFileEx(
+		device, sourcePath.c_str(), 0, D3D11_USAGE_STAGING, 0, D3D11_CPU_ACCESS_READ, 0, WIC_LOADER_DEFAULT, &staging, 0)))
+	{
+		printf("Can't decode %ls\n", sourcePath.c_str());
+		return false;
+	}
+
+	bool result = Compress(sourcePath, staging, format);
+	staging->Release();
+	return result;
+}
+
+bool TextureImporter::Import(const std::wstring& sourcePath, const unsigned char* data, size_t size, BlockFormat format)
+{
+	ID3D11Resource* staging = 0;
+	if (FAILED(CreateWICTextureFromMemoryEx(
+		device, data, size, 0, D3D11_USAGE_STAGING, 0, D3D11_CPU_ACCESS_READ, 0, WIC_LOADER_DEFAULT, &staging, 0)))
+	{
+		printf("Can't decode %ls\n", sourcePath.c_str());
+		return false;
+	}
+
+	bool result = Compress(sourcePath, staging, format);
+	staging->Release();
+	return result;
+}
+
+// --------------------------------------------------------
+// Compresses the decoded image (and its mips) and writes
+// the .dds, reporting how fast and how accurately
+// --------------------------------------------------------
+bool TextureImporter::Compress(const std::wstring& sourcePath, ID3D11Resource* staging, BlockFormat format)
+{
+	TextureImage image;
+	bool srgb = false;
+	if (!ReadPixels(staging, &image, &srgb))
+	{
+		printf("Can't compress %ls - it didn't decode to 8 bit RGBA\n", sourcePath.c_str());
+		return false;
+	}
+
+	// D3D11 only takes block compressed textures in whole blocks
+	// (their mips can be any size)
+	if (image.Width % 4 != 0 || image.Height % 4 != 0)
+	{
+		printf("Can't compress %ls - %ux%u isn't a multiple of 4\n", sourcePath.c_str(), image.Width, image.Height);
+		return false;
+	}
+
+	CompressedTexture texture;
+	TextureCompressionStats stats;
+	CompressTexture(image, format, srgb, threads, &texture, &stats);
+
+	std::vector<unsigned char> file;
+	BuildDDSFile(texture, &file);
+
+	std::wstring compressedPath = GetCompressedPath(sourcePath);
+	std::ofstream out(compressedPath.c_str(), std::ios::binary | std::ios::trunc);
+	if (!out || !out.write((const char*)&file[0], file.size()))
+	{
+		printf("Can't write %ls\n", compressedPath.c_str());
+		return false;
+	}
+
+	printf("Compressed %ls to %s: %ux%u, %u mips, %.2fms (%.1f Mpixels/s on %u threads), PSNR %.2f dB\n",
+		sourcePath.c_str(),
+		GetBlockFormatName(format),
+		texture.Width, texture.Height, (unsigned int)texture.Mips.size(),
+		stats.Seconds * 1000.0,
+		stats.Seconds > 0.0 ? stats.Pixels / stats.Seconds / 1000000.0 : 0.0,
+		stats.Threads,
+		stats.PSNR);
+	return true;
+}
+
+// --------------------------------------------------------
+// WIC hands back RGBA or BGRA for ordinary 8 bit images.
+// Anything wider (16 bit PNGs, HDR) isn't handled.
+// --------------------------------------------------------
+bool TextureImporter::ReadPixels(ID3D11Resource* staging, TextureImage* image, bool* srgb)
+{
+	ID3D11Texture2D* texture = 0;
+	if (FAILED(staging->QueryInterface(__uuidof(ID3D11Texture2D), (void**)&texture)))
+		return false;
+
+	D3D11_TEXTURE2D_DESC desc;
+	texture->GetDesc(&desc);
+	texture->Release();
+
+	bool bgra = desc.Format == DXGI_FORMAT_B8G8R8A8_UNORM || desc.Format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
+	bool rgba = desc.Format == DXGI_FORMAT_R8G8B8A8_UNORM || desc.Format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+	if (!bgra && !rgba)
+		return false;
+	*srgb = desc.Format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB || desc.Format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+
+	D3D11_MAPPED_SUBRESOURCE mapped;
+	if (FAILED(context->Map(staging, 0, D3D11_MAP_READ, 0, &mapped)))
+		return false;
+
+	image->Width = desc.Width;
+	image->Height = desc.Height;
+	image->Pixels.resize(desc.Width * desc.Height * 4);
+	for (unsigned int y = 0; y < desc.Height; y++)
+	{
+		const unsigned char* row = (const unsigned char*)mapped.pData + y * mapped.RowPitch;
+		unsigned char* out = &image->Pixels[y * desc.Width * 4];
+		memcpy(out, row, desc.Width * 4);
+		if (bgra)
+		{
+			for (unsigned int x = 0; x < desc.Width; x++)
+				std::swap(out[x * 4], out[x * 4 + 2]);
+		}
+	}
+
+	context->Unmap(staging, 0);
+	return true;
+}
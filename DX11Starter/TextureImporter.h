@@ -0,0 +1,43 @@
+#pragma once
+
+#include <d3d11.h>
+#include <string>
+#include "TextureCompression.h"
+#include "ThreadPool.h"
+
+// --------------------------------------------------------
+// Turns source images into mipmapped, block compressed DDS
+// files, which CreateDDSTextureFromFile() copies straight
+// into VRAM - no decoding on load, and a quarter (BC3, BC5,
+// BC7) or an eighth (BC1) of the memory.
+//
+// WIC decodes the source into a staging texture that's read
+// back, so anything it understands can be imported.  The
+// .dds sits next to its source, and is only rebuilt once
+// the source is newer.
+// --------------------------------------------------------
+class TextureImporter
+{
+public:
+	TextureImporter(ID3D11Device* device, ID3D11DeviceContext* context, ThreadPool* threads);
+
+	// Where a source's compressed copy goes - the same path, ending .dds
+	static std::wstring GetCompressedPath(const std::wstring& sourcePath);
+
+	// Builds the compressed copy unless it's already newer than the
+	// source.  False if there's none and it can't be built.
+	bool ImportIfStale(const std::wstring& sourcePath, BlockFormat format);
+
+	// Always rebuilds, from the file or from its contents (a hot reload
+	// has already read them)
+	bool Import(const std::wstring& sourcePath, BlockFormat format);
+	bool Import(const std::wstring& sourcePath, const unsigned char* data, size_t size, BlockFormat format);
+
+private:
+	ID3D11Device* device;
+	ID3D11DeviceContext* context;
+	ThreadPool* threads;
+
+	bool Compress(const std::wstring& sourcePath, ID3D11Resource* staging, BlockFormat format);
+	bool ReadPixels(ID3D11Resource* staging, TextureImage* image, bool* srgb);
+};
@@ -0,0 +1,196 @@
+#include "ThreadPool.h"
+#include <cstdint>
+#include <new>
+
+static unsigned long long PackRange(unsigned int begin, unsigned int end)
+{
+	return ((unsigned long long)begin << 32) | end;
+}
+
+// --------------------------------------------------------
+// Constructor - Starts the workers, which sleep until the
+// first ParallelFor()
+// --------------------------------------------------------
+ThreadPool::ThreadPool(unsigned int workerCount)
+{
+	if (workerCount == THREAD_POOL_ONE_PER_CORE)
+	{
+		unsigned int cores = std::thread::hardware_concurrency();
+		workerCount = cores > 1 ? cores - 1 : 0;
+	}
+
+	// new[] only has to honor alignments up to the fundamental one
+	// (16 bytes) before C++17, so the slots are lined up by hand
+	slotCount = workerCount + 1;
+	slotMemory = new unsigned char[slotCount * sizeof(Slot) + alignof(Slot) - 1];
+	uintptr_t address = ((uintptr_t)slotMemory + alignof(Slot) - 1) & ~(uintptr_t)(alignof(Slot) - 1);
+	slots = (Slot*)address;
+	for (unsigned int i = 0; i < slotCount; i++)
+	{
+		new (&slots[i]) Slot();
+		slots[i].Range.store(0);
+	}
+
+	job = 0;
+	grain = 1;
+	generation = 0;
+	busy = 0;
+	quit = false;
+
+	for (unsigned int i = 0; i < workerCount; i++)
+		workers.push_back(std::thread(&ThreadPool::WorkerLoop, this, i + 1));
+}
+
+// --------------------------------------------------------
+// Destructor - Wakes every worker to tell it to exit
+// --------------------------------------------------------
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	wake.notify_all();
+
+	for (unsigned int i = 0; i < workers.size(); i++)
+		workers[i].join();
+
+	for (unsigned int i = 0; i < slotCount; i++)
+		slots[i].~Slot();
+	delete[] slotMemory;
+}
+
+// --------------------------------------------------------
+// Splits the loop evenly, starts the workers on it, and
+// helps out until there's nothing left to take or steal
+// --------------------------------------------------------
+void ThreadPool::ParallelFor(unsigned int count, unsigned int grainSize, const std::function<void(unsigned int, unsigned int)>& func)
+{
+	if (count == 0)
+		return;
+	if (grainSize == 0)
+		grainSize = 1;
+
+	// Nothing to share it with
+	if (workers.empty())
+	{
+		for (unsigned int begin = 0; begin < count; begin += grainSize)
+			func(begin, count - begin < grainSize ? count : begin + grainSize);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (unsigned int i = 0; i < slotCount; i++)
+		{
+			unsigned int begin = (unsigned int)((unsigned long long)count * i / slotCount);
+			unsigned int end = (unsigned int)((unsigned long long)count * (i + 1) / slotCount);
+			slots[i].Range.store(PackRange(begin, end));
+		}
+
+		job = &func;
+		grain = grainSize;
+		busy = workers.size();
+		generation++;
+	}
+	wake.notify_all();
+
+	Run(0);
+
+	// Every chunk has been claimed, but workers may still be running theirs
+	std::unique_lock<std::mutex> lock(mutex);
+	done.wait(lock, [this]() { return busy == 0; });
+	job = 0;
+}
+
+void ThreadPool::WorkerLoop(unsigned int slot)
+{
+	unsigned int seen = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [&]() { return quit || generation != seen; });
+			if (quit)
+				return;
+			seen = generation;
+		}
+
+		Run(slot);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if (--busy == 0)
+			done.notify_one();
+	}
+}
+
+// --------------------------------------------------------
+// Works through our own slice, then steals until there's
+// nothing left anywhere
+// --------------------------------------------------------
+void ThreadPool::Run(unsigned int slot)
+{
+	unsigned int begin, end;
+	for (;;)
+	{
+		while (TakeFront(slot, &begin, &end))
+			(*job)(begin, end);
+
+		// Our slice is empty (so no one else will touch it) -
+		// whatever we steal becomes our new slice
+		bool stole = false;
+		for (unsigned int i = 1; i < slotCount && !stole; i++)
+			stole = StealBack((slot + i) % slotCount, &begin, &end);
+
+		if (!stole)
+			return;
+		slots[slot].Range.store(PackRange(begin, end));
+	}
+}
+
+// --------------------------------------------------------
+// Claims the next chunk of a slice (the owner's end)
+// --------------------------------------------------------
+bool ThreadPool::TakeFront(unsigned int slot, unsigned int* begin, unsigned int* end)
+{
+	unsigned long long range = slots[slot].Range.load();
+	for (;;)
+	{
+		unsigned int first = (unsigned int)(range >> 32);
+		unsigned int last = (unsigned int)range;
+		if (first >= last)
+			return false;
+
+		unsigned int next = last - first > grain ? first + grain : last;
+		if (slots[slot].Range.compare_exchange_weak(range, PackRange(next, last)))
+		{
+			*begin = first;
+			*end = next;
+			return true;
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Takes the back half of someone else's slice.  A slice
+// with a chunk or less left is left to its owner.
+// --------------------------------------------------------
+bool ThreadPool::StealBack(unsigned int slot, unsigned int* begin, unsigned int* end)
+{
+	unsigned long long range = slots[slot].Range.load();
+	for (;;)
+	{
+		unsigned int first = (unsigned int)(range >> 32);
+		unsigned int last = (unsigned int)range;
+		if (first >= last || last - first <= grain)
+			return false;
+
+		unsigned int middle = first + (last - first) / 2;
+		if (slots[slot].Range.compare_exchange_weak(range, PackRange(first, middle)))
+		{
+			*begin = middle;
+			*end = last;
+			return true;
+		}
+	}
+}
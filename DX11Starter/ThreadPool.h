@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// --------------------------------------------------------
+// A fixed set of worker threads for splitting big loops
+// (baking, mostly) across every core.
+//
+// ParallelFor() hands each thread an equal slice of the
+// loop.  Threads take work off the front of their own slice
+// a chunk at a time, and once it's empty, steal the back
+// half of whichever other slice they find first.  Uneven
+// work (some vertices cost far more rays than others) ends
+// up spread out without any central queue to fight over.
+//
+// The calling thread works too, so a pool of N threads
+// runs on N + 1 cores.
+// --------------------------------------------------------
+// Asks for one worker per core besides the caller's
+#define THREAD_POOL_ONE_PER_CORE 0xFFFFFFFF
+
+class ThreadPool
+{
+public:
+	// 0 runs everything on the calling thread
+	ThreadPool(unsigned int workerCount = THREAD_POOL_ONE_PER_CORE);
+	~ThreadPool();
+
+	// Calls func(begin, end) over [0, count) in chunks of at most
+	// grainSize, and returns once all of them have run.  func is
+	// called from many threads at once.
+	void ParallelFor(unsigned int count, unsigned int grainSize, const std::function<void(unsigned int, unsigned int)>& func);
+
+	// Including the calling thread
+	unsigned int GetThreadCount() { return slotCount; }
+
+private:
+	// One thread's remaining work, packed as (begin << 32) | end so
+	// the owner and thieves can both update it with one CAS.  Each
+	// is on its own cache line, since they're all hammered at once.
+	struct alignas(64) Slot
+	{
+		std::atomic<unsigned long long> Range;
+	};
+
+	std::vector<std::thread> workers;
+	Slot* slots;					// Caller uses slot 0, worker i slot i + 1
+	unsigned char* slotMemory;		// What slots is aligned within
+	unsigned int slotCount;
+
+	// The current loop
+	const std::function<void(unsigned int, unsigned int)>* job;
+	unsigned int grain;
+
+	std::mutex mutex;
+	std::condition_variable wake;	// Workers wait here for a loop
+	std::condition_variable done;	// The caller waits here for workers
+	unsigned int generation;		// Bumped for every loop
+	unsigned int busy;				// Workers still on the current loop
+	bool quit;
+
+	void WorkerLoop(unsigned int slot);
+	void Run(unsigned int slot);
+	bool TakeFront(unsigned int slot, unsigned int* begin, unsigned int* end);
+	bool StealBack(unsigned int slot, unsigned int* begin, unsigned int* end);
+};
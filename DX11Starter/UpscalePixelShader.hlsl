@@ -0,0 +1,25 @@
+
+// Stretches the scaled down scene (which only fills the top
+// left corner of its texture) over the whole back buffer
+cbuffer upscaleData : register(b0)
+{
+	float2 uvScale;		// The fraction of the texture the scene fills
+	float2 uvMax;		// Half a texel in from its far edges
+};
+
+struct VertexToPixel
+{
+	float4 position		: SV_POSITION;
+	float2 uv			: TEXCOORD;
+};
+
+Texture2D sceneTexture : register(t0);
+SamplerState linearClamp : register(s0);
+
+float4 main(VertexToPixel input) : SV_TARGET
+{
+	// Clamped, so bilinear filtering never reaches past the
+	// scene into whatever the unused part of the texture holds
+	float2 uv = min(input.uv * uvScale, uvMax);
+	return sceneTexture.Sample(linearClamp, uv);
+}
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <DirectXMath.h>
+#include <DirectXPackedVector.h>
+#include "VertexFormat.h"
 
 using namespace DirectX;
 
@@ -8,13 +10,49 @@ using namespace DirectX;
 // A custom vertex definition
 //
 // You will eventually ADD TO this, and/or make more of these!
+// The input layout comes from this list too (see VertexFormat.h),
+// so it must match VertexShaderInput in VertexShader.hlsl.
 // --------------------------------------------------------
-struct Vertex
-{
-	XMFLOAT3 Position;	    // The position of the vertex
-	XMFLOAT3 Normal;
-	XMFLOAT2 UV;
+#define VERTEX_ELEMENTS(ELEMENT) \
+	ELEMENT(XMFLOAT3, Position,	POSITION,	0, DXGI_FORMAT_R32G32B32_FLOAT)	/* The position of the vertex */ \
+	ELEMENT(XMFLOAT3, Normal,	NORMAL,		0, DXGI_FORMAT_R32G32B32_FLOAT) \
+	ELEMENT(XMFLOAT2, UV,		TEXCOORD,	0, DXGI_FORMAT_R32G32_FLOAT)
 
-	// Used for simple gemetric shapes but not applicable to 3D models.
-	//DirectX::XMFLOAT4 Color;        // The color of the vertex
-};
\ No newline at end of file
+// Used for simple gemetric shapes but not applicable to 3D models.
+//	ELEMENT(XMFLOAT4, Color,	COLOR,		0, DXGI_FORMAT_R32G32B32A32_FLOAT)	// The color of the vertex
+
+DECLARE_VERTEX_FORMAT(Vertex, VERTEX_ELEMENTS);
+
+// --------------------------------------------------------
+// Just the position, for passes that only write depth
+// (a depth prepass or shadow map).  A quarter of the bytes
+// of a full Vertex per vertex fetched.
+// --------------------------------------------------------
+#define POSITION_VERTEX_ELEMENTS(ELEMENT) \
+	ELEMENT(XMFLOAT3, Position,	POSITION,	0, DXGI_FORMAT_R32G32B32_FLOAT)
+
+DECLARE_VERTEX_FORMAT(PositionVertex, POSITION_VERTEX_ELEMENTS);
+
+// --------------------------------------------------------
+// Baked ambient occlusion (see OcclusionBaker.h).  Kept in
+// its own stream next to whichever format the pool uses,
+// so bakes can be written after the mesh is uploaded.
+// 255 is fully open, 0 fully occluded.
+// --------------------------------------------------------
+#define OCCLUSION_VERTEX_ELEMENTS(ELEMENT) \
+	ELEMENT(unsigned char, Occlusion,	OCCLUSION,	0, DXGI_FORMAT_R8_UNORM)
+
+DECLARE_VERTEX_FORMAT(OcclusionVertex, OCCLUSION_VERTEX_ELEMENTS);
+
+// --------------------------------------------------------
+// A full vertex plus up to four bone influences, with the
+// weights stored as unorm bytes (summing to 255)
+// --------------------------------------------------------
+#define SKINNED_VERTEX_ELEMENTS(ELEMENT) \
+	ELEMENT(XMFLOAT3,					Position,		POSITION,		0, DXGI_FORMAT_R32G32B32_FLOAT) \
+	ELEMENT(XMFLOAT3,					Normal,			NORMAL,			0, DXGI_FORMAT_R32G32B32_FLOAT) \
+	ELEMENT(XMFLOAT2,					UV,				TEXCOORD,		0, DXGI_FORMAT_R32G32_FLOAT) \
+	ELEMENT(PackedVector::XMUBYTE4,		BlendIndices,	BLENDINDICES,	0, DXGI_FORMAT_R8G8B8A8_UINT) \
+	ELEMENT(PackedVector::XMUBYTEN4,	BlendWeights,	BLENDWEIGHT,	0, DXGI_FORMAT_R8G8B8A8_UNORM)
+
+DECLARE_VERTEX_FORMAT(SkinnedVertex, SKINNED_VERTEX_ELEMENTS);
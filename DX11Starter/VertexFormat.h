@@ -0,0 +1,107 @@
+#pragma once
+
+#include <d3d11.h>
+
+// --------------------------------------------------------
+// Compile-time vertex format declarations.
+//
+// A format is written once, as a list of elements (in a block
+// comment, since a // line ending in a backslash would carry
+// on into the next):
+/*
+	#define MY_VERTEX_ELEMENTS(ELEMENT) \
+		ELEMENT(XMFLOAT3, Position, POSITION, 0, DXGI_FORMAT_R32G32B32_FLOAT) \
+		ELEMENT(XMFLOAT2, UV, TEXCOORD, 0, DXGI_FORMAT_R32G32_FLOAT)
+	DECLARE_VERTEX_FORMAT(MyVertex, MY_VERTEX_ELEMENTS);
+*/
+// and DECLARE_VERTEX_FORMAT expands that into both the C++
+// struct and VertexFormat<MyVertex>, which holds its stride
+// and D3D11 input layout.  static_asserts check that every
+// member is exactly the size of its DXGI format and that
+// the struct has no padding, so the two can't drift apart.
+// --------------------------------------------------------
+
+// Size in bytes of each DXGI format usable in a vertex.
+// Left undefined so unsupported formats fail to compile.
+template <DXGI_FORMAT Format> struct DxgiFormatSize;
+
+template <> struct DxgiFormatSize<DXGI_FORMAT_R32G32B32A32_FLOAT>	{ static const unsigned int Value = 16; };
+template <> struct DxgiFormatSize<DXGI_FORMAT_R32G32B32_FLOAT>		{ static const unsigned int Value = 12; };
+template <> struct DxgiFormatSize<DXGI_FORMAT_R32G32_FLOAT>			{ static const unsigned int Value = 8; };
+template <> struct DxgiFormatSize<DXGI_FORMAT_R32_FLOAT>			{ static const unsigned int Value = 4; };
+template <> struct DxgiFormatSize<DXGI_FORMAT_R32_UINT>				{ static const unsigned int Value = 4; };
+template <> struct DxgiFormatSize<DXGI_FORMAT_R16G16B16A16_FLOAT>	{ static const unsigned int Value = 8; };
+template <> struct DxgiFormatSize<DXGI_FORMAT_R16G16B16A16_SNORM>	{ static const unsigned int Value = 8; };
+template <> struct DxgiFormatSize<DXGI_FORMAT_R16G16_FLOAT>			{ static const unsigned int Value = 4; };
+template <> struct DxgiFormatSize<DXGI_FORMAT_R16G16_SNORM>			{ static const unsigned int Value = 4; };
+template <> struct DxgiFormatSize<DXGI_FORMAT_R8G8B8A8_UNORM>		{ static const unsigned int Value = 4; };
+template <> struct DxgiFormatSize<DXGI_FORMAT_R8G8B8A8_UINT>		{ static const unsigned int Value = 4; };
+template <> struct DxgiFormatSize<DXGI_FORMAT_R8_UNORM>				{ static const unsigned int Value = 1; };
+
+// Stride and input layout of a vertex struct.  Only defined
+// for structs declared with DECLARE_VERTEX_FORMAT.
+template <typename VertexType> struct VertexFormat;
+
+// Per-element expansions used by DECLARE_VERTEX_FORMAT
+#define VERTEX_FORMAT_MEMBER(type, name, semantic, index, format) \
+	type name;
+#define VERTEX_FORMAT_INPUT_ELEMENT(type, name, semantic, index, format) \
+	{ #semantic, index, format, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+#define VERTEX_FORMAT_SIZE(type, name, semantic, index, format) \
+	+ DxgiFormatSize<format>::Value
+#define VERTEX_FORMAT_COUNT(type, name, semantic, index, format) \
+	+ 1
+#define VERTEX_FORMAT_CHECK(type, name, semantic, index, format) \
+	static_assert(sizeof(type) == DxgiFormatSize<format>::Value, #name " is not the size of " #format);
+
+// Declares the struct "Name" and its VertexFormat<Name>
+#define DECLARE_VERTEX_FORMAT(Name, ELEMENTS) \
+	struct Name \
+	{ \
+		ELEMENTS(VERTEX_FORMAT_MEMBER) \
+	}; \
+	template <> struct VertexFormat<Name> \
+	{ \
+		static const unsigned int Stride = 0 ELEMENTS(VERTEX_FORMAT_SIZE); \
+		static const unsigned int ElementCount = 0 ELEMENTS(VERTEX_FORMAT_COUNT); \
+		static const D3D11_INPUT_ELEMENT_DESC* Elements() \
+		{ \
+			static const D3D11_INPUT_ELEMENT_DESC elements[] = { ELEMENTS(VERTEX_FORMAT_INPUT_ELEMENT) }; \
+			return elements; \
+		} \
+	}; \
+	ELEMENTS(VERTEX_FORMAT_CHECK) \
+	static_assert(sizeof(Name) == VertexFormat<Name>::Stride, #Name " has padding its input layout doesn't")
+
+
+// --------------------------------------------------------
+// Input layout for a vertex format in slot 0 plus a second
+// format in slot 1, for data kept in its own vertex buffer
+// (so it can be written without touching the main one).
+// --------------------------------------------------------
+template <typename VertexType, typename StreamType> struct VertexStreams
+{
+	static const unsigned int ElementCount = VertexFormat<VertexType>::ElementCount + VertexFormat<StreamType>::ElementCount;
+	static const D3D11_INPUT_ELEMENT_DESC* Elements()
+	{
+		static D3D11_INPUT_ELEMENT_DESC elements[ElementCount];
+		static bool built = Build(elements);
+		(void)built;
+		return elements;
+	}
+
+private:
+	static bool Build(D3D11_INPUT_ELEMENT_DESC* elements)
+	{
+		unsigned int count = 0;
+		for (unsigned int i = 0; i < VertexFormat<VertexType>::ElementCount; i++)
+			elements[count++] = VertexFormat<VertexType>::Elements()[i];
+
+		for (unsigned int i = 0; i < VertexFormat<StreamType>::ElementCount; i++)
+		{
+			elements[count] = VertexFormat<StreamType>::Elements()[i];
+			elements[count++].InputSlot = 1;
+		}
+		return true;
+	}
+};
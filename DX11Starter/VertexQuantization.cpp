@@ -0,0 +1,121 @@
+#include "VertexQuantization.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+// --------------------------------------------------------
+// Positions are scaled to fill the mesh's bounding box, so
+// the 16 bits are spent where the mesh actually is.
+//
+// Everything is done four floats at a time with DirectXMath,
+// and the packed stores convert straight from registers.
+// --------------------------------------------------------
+void QuantizeVertices(const Vertex* vertices, unsigned int count, QuantizedVertex* quantized, QuantizationInfo* info)
+{
+	if (count == 0)
+	{
+		*info = {};
+		return;
+	}
+
+	// Bounding box
+	XMVECTOR minPosition = XMLoadFloat3(&vertices[0].Position);
+	XMVECTOR maxPosition = minPosition;
+	for (unsigned int i = 1; i < count; i++)
+	{
+		XMVECTOR position = XMLoadFloat3(&vertices[i].Position);
+		minPosition = XMVectorMin(minPosition, position);
+		maxPosition = XMVectorMax(maxPosition, position);
+	}
+
+	// Flat meshes (like our triangles) have no extent along one
+	// axis, so keep the scale away from zero
+	XMVECTOR center = XMVectorScale(XMVectorAdd(minPosition, maxPosition), 0.5f);
+	XMVECTOR extent = XMVectorScale(XMVectorSubtract(maxPosition, minPosition), 0.5f);
+	extent = XMVectorMax(extent, XMVectorReplicate(1e-6f));
+	XMVECTOR invExtent = XMVectorReciprocal(extent);
+	XMStoreFloat3(&info->PositionCenter, center);
+	XMStoreFloat3(&info->PositionExtent, extent);
+
+	XMVECTOR maxPositionError = XMVectorZero();
+	XMVECTOR minNormalCos = XMVectorSplatOne();
+	XMVECTOR maxNormalSin = XMVectorZero();
+	XMVECTOR maxUVError = XMVectorZero();
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		XMVECTOR position = XMLoadFloat3(&vertices[i].Position);
+		XMVECTOR normal = XMVector3Normalize(XMLoadFloat3(&vertices[i].Normal));
+		XMVECTOR uv = XMLoadFloat2(&vertices[i].UV);
+
+		XMStoreShortN4(&quantized[i].Position, XMVectorMultiply(XMVectorSubtract(position, center), invExtent));
+		XMStoreShortN2(&quantized[i].Normal, EncodeOctahedral(normal));
+		XMStoreHalf2(&quantized[i].UV, uv);
+
+		// Decode again to see what we lost
+		XMVECTOR decodedPosition = XMVectorMultiplyAdd(XMLoadShortN4(&quantized[i].Position), extent, center);
+		XMVECTOR decodedNormal = DecodeOctahedral(XMLoadShortN2(&quantized[i].Normal));
+		XMVECTOR decodedUV = XMLoadHalf2(&quantized[i].UV);
+
+		maxPositionError = XMVectorMax(maxPositionError, XMVector3Length(XMVectorSubtract(decodedPosition, position)));
+		minNormalCos = XMVectorMin(minNormalCos, XMVector3Dot(decodedNormal, normal));
+		maxNormalSin = XMVectorMax(maxNormalSin, XMVector3Length(XMVector3Cross(decodedNormal, normal)));
+		maxUVError = XMVectorMax(maxUVError, XMVectorAbs(XMVectorSubtract(decodedUV, uv)));
+	}
+
+	// Zero length normals decode as +Z, so don't let them blow up acos
+	float normalCos = XMVectorGetX(XMVectorClamp(minNormalCos, XMVectorNegate(XMVectorSplatOne()), XMVectorSplatOne()));
+	float normalSin = (std::min)(XMVectorGetX(maxNormalSin), 1.0f);
+
+	// Single precision acos can't resolve angles much under a
+	// tenth of a degree, so small errors come from the sine
+	info->MaxPositionError = XMVectorGetX(maxPositionError);
+	info->MaxNormalError = XMConvertToDegrees(normalCos >= 0.0f ? std::asin(normalSin) : XMScalarACos(normalCos));
+	info->MaxUVError = XMVectorGetX(XMVectorMax(maxUVError, XMVectorSplatY(maxUVError)));
+}
+
+// --------------------------------------------------------
+// Projects the normal onto the octahedron |x|+|y|+|z| = 1,
+// then folds the lower half out over the diagonals so the
+// whole sphere fits in the XY square.  Error is spread much
+// more evenly than with plain XY (or spherical) encodings.
+// --------------------------------------------------------
+XMVECTOR XM_CALLCONV EncodeOctahedral(FXMVECTOR normal)
+{
+	const XMVECTOR one = XMVectorSplatOne();
+	const XMVECTOR zero = XMVectorZero();
+
+	XMVECTOR l1 = XMVector3Dot(XMVectorAbs(normal), one);
+	XMVECTOR p = XMVectorDivide(normal, XMVectorMax(l1, XMVectorReplicate(1e-20f)));
+
+	// Lower half: (1 - |yx|) * sign(xy)
+	XMVECTOR sign = XMVectorSelect(XMVectorNegate(one), one, XMVectorGreaterOrEqual(p, zero));
+	XMVECTOR folded = XMVectorMultiply(XMVectorSubtract(one, XMVectorAbs(XMVectorSwizzle<1, 0, 2, 3>(p))), sign);
+
+	return XMVectorSelect(p, folded, XMVectorLess(XMVectorSplatZ(p), zero));
+}
+
+// --------------------------------------------------------
+// Inverse of EncodeOctahedral (only XY are read).  Matches
+// the decode in QuantizedVertexShader.hlsl.
+// --------------------------------------------------------
+XMVECTOR XM_CALLCONV DecodeOctahedral(FXMVECTOR encoded)
+{
+	const XMVECTOR one = XMVectorSplatOne();
+	const XMVECTOR zero = XMVectorZero();
+	const XMVECTOR selectXY = XMVectorSelectControl(1, 1, 0, 0);
+
+	// z = 1 - |x| - |y|
+	XMVECTOR absEncoded = XMVectorAbs(encoded);
+	XMVECTOR z = XMVectorSubtract(XMVectorSubtract(one, XMVectorSplatX(absEncoded)), XMVectorSplatY(absEncoded));
+	XMVECTOR n = XMVectorSelect(z, encoded, selectXY);
+
+	// Unfold the lower half: xy += (xy >= 0) ? -t : t
+	XMVECTOR t = XMVectorSaturate(XMVectorNegate(z));
+	XMVECTOR offset = XMVectorSelect(t, XMVectorNegate(t), XMVectorGreaterOrEqual(n, zero));
+	n = XMVectorSelect(n, XMVectorAdd(n, offset), selectXY);
+
+	return XMVector3Normalize(n);
+}
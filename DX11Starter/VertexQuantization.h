@@ -0,0 +1,56 @@
+#pragma once
+
+#include <d3d11.h>
+#include <DirectXMath.h>
+#include <DirectXPackedVector.h>
+#include "Vertex.h"
+#include "VertexFormat.h"
+
+// --------------------------------------------------------
+// A compressed vertex, half the size of a full Vertex:
+//  - Position: 16 bit snorm, relative to the mesh's bounds
+//  - Normal:   octahedral encoded into two 16 bit snorms
+//  - UV:       two half floats
+//
+// QuantizedVertexShader.hlsl decodes these, using the mesh's
+// QuantizationInfo to put positions back in model space.
+// --------------------------------------------------------
+#define QUANTIZED_VERTEX_ELEMENTS(ELEMENT) \
+	ELEMENT(DirectX::PackedVector::XMSHORTN4,	Position,	POSITION,	0, DXGI_FORMAT_R16G16B16A16_SNORM)	/* W is unused padding */ \
+	ELEMENT(DirectX::PackedVector::XMSHORTN2,	Normal,		NORMAL,		0, DXGI_FORMAT_R16G16_SNORM) \
+	ELEMENT(DirectX::PackedVector::XMHALF2,		UV,			TEXCOORD,	0, DXGI_FORMAT_R16G16_FLOAT)
+
+DECLARE_VERTEX_FORMAT(QuantizedVertex, QUANTIZED_VERTEX_ELEMENTS);
+
+static_assert(sizeof(QuantizedVertex) == 16, "QuantizedVertex should be 16 bytes");
+
+// --------------------------------------------------------
+// Just a QuantizedVertex's position (see PositionVertex)
+// --------------------------------------------------------
+#define QUANTIZED_POSITION_VERTEX_ELEMENTS(ELEMENT) \
+	ELEMENT(DirectX::PackedVector::XMSHORTN4,	Position,	POSITION,	0, DXGI_FORMAT_R16G16B16A16_SNORM)
+
+DECLARE_VERTEX_FORMAT(QuantizedPositionVertex, QUANTIZED_POSITION_VERTEX_ELEMENTS);
+
+// --------------------------------------------------------
+// How a mesh was quantized, and how much precision it lost
+// --------------------------------------------------------
+struct QuantizationInfo
+{
+	// Model space position = snorm position * Extent + Center
+	XMFLOAT3 PositionCenter;
+	XMFLOAT3 PositionExtent;
+
+	// Largest round trip error over every vertex
+	float MaxPositionError;		// Model space units
+	float MaxNormalError;		// Degrees
+	float MaxUVError;			// Texture coordinate units
+};
+
+// Compresses "count" vertices into "quantized", filling in info.
+// The error bounds are measured by decoding every vertex again.
+void QuantizeVertices(const Vertex* vertices, unsigned int count, QuantizedVertex* quantized, QuantizationInfo* info);
+
+// Octahedral mapping of a unit normal onto [-1, 1]^2 (in XY) and back
+DirectX::XMVECTOR XM_CALLCONV EncodeOctahedral(DirectX::FXMVECTOR normal);
+DirectX::XMVECTOR XM_CALLCONV DecodeOctahedral(DirectX::FXMVECTOR encoded);
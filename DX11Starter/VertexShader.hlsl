@@ -8,12 +8,12 @@
 cbuffer externalData : register(b0)
 {
 	matrix world;
-	matrix view;
-	matrix projection;
+	matrix worldViewProj;		// world * view * projection, from the CPU
 };
 
 // Struct representing a single vertex worth of data
-// - This should match the vertex definition in our C++ code
+// - This should match the vertex definition in our C++ code (VERTEX_ELEMENTS
+//    in Vertex.h), which is also where the input layout comes from
 // - By "match", I mean the size, order and number of members
 // - The name of the struct itself is unimportant, but should be descriptive
 // - Each variable must have a semantic, which defines its usage
@@ -27,6 +27,7 @@ struct VertexShaderInput
 	float3 position		: POSITION;     // XYZ position
 	float3 normal       : NORMAL;
 	float2 uv           : TEXCOORD;
+	float occlusion     : OCCLUSION;    // Baked, from its own stream (slot 1)
 	//float4 color		: COLOR;        // RGBA color
 };
 
@@ -45,6 +46,7 @@ struct VertexToPixel
 	float4 position		: SV_POSITION;	// XYZW position (System Value Position)
 	float3 normal       : NORMAL;
 	float2 uv           : TEXCOORD;
+	float occlusion     : OCCLUSION;
 	//float4 color		: COLOR;        // RGBA color
 };
 
@@ -63,18 +65,20 @@ VertexToPixel main( VertexShaderInput input )
 	// The vertex's position (input.position) must be converted to world space,
 	// then camera space (relative to our 3D camera), then to proper homogenous 
 	// screen-space coordinates.  This is taken care of by our world, view and
-	// projection matrices.  
+	// projection matrices, which the CPU has already multiplied together into
+	// a single matrix (once per object, rather than once per vertex).
 	//
-	// First we multiply them together to get a single matrix which represents
-	// all of those transformations (world to view to projection space)
-	matrix worldViewProj = mul(mul(world, view), projection);
-
-	// Then we convert our 3-component position vector to a 4-component vector
-	// and multiply it by our final 4x4 matrix.
+	// We convert our 3-component position vector to a 4-component vector
+	// and multiply it by that 4x4 matrix.
 	//
 	// The result is essentially the position (XY) of the vertex on our 2D 
 	// screen and the distance (Z) from the camera (the "depth" of the pixel)
-	output.position = mul(float4(input.position, 1.0f), worldViewProj);
+	//
+	// It's precise so it comes out bit for bit the same as in
+	// DepthPrepassVertexShader.hlsl, which the depth test relies on when
+	// drawing over a depth prepass
+	precise float4 position = mul(float4(input.position, 1.0f), worldViewProj);
+	output.position = position;
 
 	// Pass the normal through to PixelShader
 	output.normal = mul(input.normal, (float3x3)world);
@@ -82,6 +86,9 @@ VertexToPixel main( VertexShaderInput input )
 	// Pass the uv coordinates on to the pixel shader
 	output.uv = input.uv;
 
+	// And how much ambient light reaches this vertex
+	output.occlusion = input.occlusion;
+
 
 	// Pass the color through 
 	// - The values will be interpolated per-pixel by the rasterizer